@@ -94,3 +94,11 @@
 #elif !defined(__GNUC__) && (defined(_M_X64) || defined(_M_IX86))
 # define _M_SSE 0x402
 #endif
+
+// Marks a function using AVX2 intrinsics, to be picked at runtime based on cpu_info.bAVX2.
+// GCC and Clang need the target enabled per function, MSVC allows the intrinsics anywhere.
+#if defined(_M_SSE) && (defined(__GNUC__) || defined(__clang__))
+#define AVX2_FUNC __attribute__((target("avx2")))
+#elif defined(_M_SSE)
+#define AVX2_FUNC
+#endif
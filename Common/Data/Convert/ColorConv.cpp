@@ -31,6 +31,10 @@
 #include <smmintrin.h>
 #endif
 
+#ifdef AVX2_FUNC
+#include <immintrin.h>
+#endif
+
 inline u16 RGBA8888toRGB565(u32 px) {
 	return ((px >> 3) & 0x001F) | ((px >> 5) & 0x07E0) | ((px >> 8) & 0xF800);
 }
@@ -295,7 +299,7 @@ void ConvertRGBA8888ToRGB888(u8 *dst, const u32 *src, u32 numPixels) {
 	}
 }
 
-void ConvertRGB565ToRGBA8888(u32 *dst32, const u16 *src, u32 numPixels) {
+void ConvertRGB565ToRGBA8888Basic(u32 *dst32, const u16 *src, u32 numPixels) {
 #ifdef _M_SSE
 	const __m128i mask5 = _mm_set1_epi16(0x001f);
 	const __m128i mask6 = _mm_set1_epi16(0x003f);
@@ -349,7 +353,7 @@ void ConvertRGB565ToRGBA8888(u32 *dst32, const u16 *src, u32 numPixels) {
 	}
 }
 
-void ConvertRGBA5551ToRGBA8888(u32 *dst32, const u16 *src, u32 numPixels) {
+void ConvertRGBA5551ToRGBA8888Basic(u32 *dst32, const u16 *src, u32 numPixels) {
 #ifdef _M_SSE
 	const __m128i mask5 = _mm_set1_epi16(0x001f);
 	const __m128i mask8 = _mm_set1_epi16(0x00ff);
@@ -403,7 +407,7 @@ void ConvertRGBA5551ToRGBA8888(u32 *dst32, const u16 *src, u32 numPixels) {
 	}
 }
 
-void ConvertRGBA4444ToRGBA8888(u32 *dst32, const u16 *src, u32 numPixels) {
+void ConvertRGBA4444ToRGBA8888Basic(u32 *dst32, const u16 *src, u32 numPixels) {
 #ifdef _M_SSE
 	const __m128i mask4 = _mm_set1_epi16(0x000f);
 
@@ -667,12 +671,144 @@ void ConvertBGRA5551ToABGR1555(u16 *dst, const u16 *src, u32 numPixels) {
 	}
 }
 
+#ifdef AVX2_FUNC
+// Same math as the SSE2 paths, 16 pixels at a time.  Unaligned is fine, the rest is left to the basic version.
+AVX2_FUNC static void ConvertRGB565ToRGBA8888AVX2(u32 *dst32, const u16 *src, u32 numPixels) {
+	const __m256i mask5 = _mm256_set1_epi16(0x001f);
+	const __m256i mask6 = _mm256_set1_epi16(0x003f);
+	const __m256i mask8 = _mm256_set1_epi16(0x00ff);
+	const __m256i a = _mm256_set1_epi16((short)0xff00);
+
+	u32 i = 0;
+	for (; i + 16 <= numPixels; i += 16) {
+		const __m256i c = _mm256_loadu_si256((const __m256i *)(src + i));
+
+		__m256i r = _mm256_and_si256(c, mask5);
+		r = _mm256_and_si256(_mm256_or_si256(_mm256_slli_epi16(r, 3), _mm256_srli_epi16(r, 2)), mask8);
+		__m256i g = _mm256_and_si256(_mm256_srli_epi16(c, 5), mask6);
+		g = _mm256_slli_epi16(_mm256_or_si256(_mm256_slli_epi16(g, 2), _mm256_srli_epi16(g, 4)), 8);
+		__m256i b = _mm256_and_si256(_mm256_srli_epi16(c, 11), mask5);
+		b = _mm256_and_si256(_mm256_or_si256(_mm256_slli_epi16(b, 3), _mm256_srli_epi16(b, 2)), mask8);
+
+		// Unpack works within each 128-bit half, so put the halves back in order when storing.
+		const __m256i rg = _mm256_or_si256(r, g);
+		const __m256i ba = _mm256_or_si256(b, a);
+		const __m256i lo = _mm256_unpacklo_epi16(rg, ba);
+		const __m256i hi = _mm256_unpackhi_epi16(rg, ba);
+		_mm256_storeu_si256((__m256i *)(dst32 + i), _mm256_permute2x128_si256(lo, hi, 0x20));
+		_mm256_storeu_si256((__m256i *)(dst32 + i + 8), _mm256_permute2x128_si256(lo, hi, 0x31));
+	}
+	ConvertRGB565ToRGBA8888Basic(dst32 + i, src + i, numPixels - i);
+}
+
+AVX2_FUNC static void ConvertRGBA5551ToRGBA8888AVX2(u32 *dst32, const u16 *src, u32 numPixels) {
+	const __m256i mask5 = _mm256_set1_epi16(0x001f);
+	const __m256i mask8 = _mm256_set1_epi16(0x00ff);
+
+	u32 i = 0;
+	for (; i + 16 <= numPixels; i += 16) {
+		const __m256i c = _mm256_loadu_si256((const __m256i *)(src + i));
+
+		__m256i r = _mm256_and_si256(c, mask5);
+		r = _mm256_and_si256(_mm256_or_si256(_mm256_slli_epi16(r, 3), _mm256_srli_epi16(r, 2)), mask8);
+		__m256i g = _mm256_and_si256(_mm256_srli_epi16(c, 5), mask5);
+		g = _mm256_slli_epi16(_mm256_or_si256(_mm256_slli_epi16(g, 3), _mm256_srli_epi16(g, 2)), 8);
+		__m256i b = _mm256_and_si256(_mm256_srli_epi16(c, 10), mask5);
+		b = _mm256_and_si256(_mm256_or_si256(_mm256_slli_epi16(b, 3), _mm256_srli_epi16(b, 2)), mask8);
+		const __m256i a = _mm256_slli_epi16(_mm256_srai_epi16(c, 15), 8);
+
+		const __m256i rg = _mm256_or_si256(r, g);
+		const __m256i ba = _mm256_or_si256(b, a);
+		const __m256i lo = _mm256_unpacklo_epi16(rg, ba);
+		const __m256i hi = _mm256_unpackhi_epi16(rg, ba);
+		_mm256_storeu_si256((__m256i *)(dst32 + i), _mm256_permute2x128_si256(lo, hi, 0x20));
+		_mm256_storeu_si256((__m256i *)(dst32 + i + 8), _mm256_permute2x128_si256(lo, hi, 0x31));
+	}
+	ConvertRGBA5551ToRGBA8888Basic(dst32 + i, src + i, numPixels - i);
+}
+
+AVX2_FUNC static void ConvertRGBA4444ToRGBA8888AVX2(u32 *dst32, const u16 *src, u32 numPixels) {
+	const __m256i mask4 = _mm256_set1_epi16(0x000f);
+
+	u32 i = 0;
+	for (; i + 16 <= numPixels; i += 16) {
+		const __m256i c = _mm256_loadu_si256((const __m256i *)(src + i));
+
+		const __m256i r = _mm256_and_si256(c, mask4);
+		const __m256i g = _mm256_slli_epi16(_mm256_and_si256(_mm256_srli_epi16(c, 4), mask4), 8);
+		const __m256i b = _mm256_and_si256(_mm256_srli_epi16(c, 8), mask4);
+		const __m256i a = _mm256_slli_epi16(_mm256_srli_epi16(c, 12), 8);
+
+		__m256i rg = _mm256_or_si256(r, g);
+		__m256i ba = _mm256_or_si256(b, a);
+		rg = _mm256_or_si256(rg, _mm256_slli_epi16(rg, 4));
+		ba = _mm256_or_si256(ba, _mm256_slli_epi16(ba, 4));
+
+		const __m256i lo = _mm256_unpacklo_epi16(rg, ba);
+		const __m256i hi = _mm256_unpackhi_epi16(rg, ba);
+		_mm256_storeu_si256((__m256i *)(dst32 + i), _mm256_permute2x128_si256(lo, hi, 0x20));
+		_mm256_storeu_si256((__m256i *)(dst32 + i + 8), _mm256_permute2x128_si256(lo, hi, 0x31));
+	}
+	ConvertRGBA4444ToRGBA8888Basic(dst32 + i, src + i, numPixels - i);
+}
+
+AVX2_FUNC static void ConvertRGBA4444ToABGR4444AVX2(u16 *dst, const u16 *src, u32 numPixels) {
+	const __m256i mask0040 = _mm256_set1_epi16(0x00F0);
+
+	u32 i = 0;
+	for (; i + 16 <= numPixels; i += 16) {
+		const __m256i c = _mm256_loadu_si256((const __m256i *)(src + i));
+		__m256i v = _mm256_srli_epi16(c, 12);
+		v = _mm256_or_si256(v, _mm256_and_si256(_mm256_srli_epi16(c, 4), mask0040));
+		v = _mm256_or_si256(v, _mm256_slli_epi16(_mm256_and_si256(c, mask0040), 4));
+		v = _mm256_or_si256(v, _mm256_slli_epi16(c, 12));
+		_mm256_storeu_si256((__m256i *)(dst + i), v);
+	}
+	ConvertRGBA4444ToABGR4444Basic(dst + i, src + i, numPixels - i);
+}
+
+AVX2_FUNC static void ConvertRGBA5551ToABGR1555AVX2(u16 *dst, const u16 *src, u32 numPixels) {
+	const __m256i maskB = _mm256_set1_epi16(0x003E);
+	const __m256i maskG = _mm256_set1_epi16(0x07C0);
+
+	u32 i = 0;
+	for (; i + 16 <= numPixels; i += 16) {
+		const __m256i c = _mm256_loadu_si256((const __m256i *)(src + i));
+		__m256i v = _mm256_srli_epi16(c, 15);
+		v = _mm256_or_si256(v, _mm256_and_si256(_mm256_srli_epi16(c, 9), maskB));
+		v = _mm256_or_si256(v, _mm256_and_si256(_mm256_slli_epi16(c, 1), maskG));
+		v = _mm256_or_si256(v, _mm256_slli_epi16(c, 11));
+		_mm256_storeu_si256((__m256i *)(dst + i), v);
+	}
+	ConvertRGBA5551ToABGR1555Basic(dst + i, src + i, numPixels - i);
+}
+
+AVX2_FUNC static void ConvertRGB565ToBGR565AVX2(u16 *dst, const u16 *src, u32 numPixels) {
+	const __m256i maskG = _mm256_set1_epi16(0x07E0);
+
+	u32 i = 0;
+	for (; i + 16 <= numPixels; i += 16) {
+		const __m256i c = _mm256_loadu_si256((const __m256i *)(src + i));
+		__m256i v = _mm256_srli_epi16(c, 11);
+		v = _mm256_or_si256(v, _mm256_and_si256(c, maskG));
+		v = _mm256_or_si256(v, _mm256_slli_epi16(c, 11));
+		_mm256_storeu_si256((__m256i *)(dst + i), v);
+	}
+	ConvertRGB565ToBGR565Basic(dst + i, src + i, numPixels - i);
+}
+#endif
+
 // Reuse the logic from the header - if these aren't defined, we need externs.
 #ifndef ConvertRGBA4444ToABGR4444
 Convert16bppTo16bppFunc ConvertRGBA4444ToABGR4444 = &ConvertRGBA4444ToABGR4444Basic;
 Convert16bppTo16bppFunc ConvertRGBA5551ToABGR1555 = &ConvertRGBA5551ToABGR1555Basic;
 Convert16bppTo16bppFunc ConvertRGB565ToBGR565 = &ConvertRGB565ToBGR565Basic;
 #endif
+#ifndef ConvertRGB565ToRGBA8888
+Convert16bppTo32bppFunc ConvertRGB565ToRGBA8888 = &ConvertRGB565ToRGBA8888Basic;
+Convert16bppTo32bppFunc ConvertRGBA5551ToRGBA8888 = &ConvertRGBA5551ToRGBA8888Basic;
+Convert16bppTo32bppFunc ConvertRGBA4444ToRGBA8888 = &ConvertRGBA4444ToRGBA8888Basic;
+#endif
 
 void SetupColorConv() {
 #if PPSSPP_ARCH(ARM_NEON) && !PPSSPP_ARCH(ARM64)
@@ -682,4 +818,14 @@ void SetupColorConv() {
 		ConvertRGB565ToBGR565 = &ConvertRGB565ToBGR565NEON;
 	}
 #endif
+#ifdef AVX2_FUNC
+	if (cpu_info.bAVX2) {
+		ConvertRGB565ToRGBA8888 = &ConvertRGB565ToRGBA8888AVX2;
+		ConvertRGBA5551ToRGBA8888 = &ConvertRGBA5551ToRGBA8888AVX2;
+		ConvertRGBA4444ToRGBA8888 = &ConvertRGBA4444ToRGBA8888AVX2;
+		ConvertRGBA4444ToABGR4444 = &ConvertRGBA4444ToABGR4444AVX2;
+		ConvertRGBA5551ToABGR1555 = &ConvertRGBA5551ToABGR1555AVX2;
+		ConvertRGB565ToBGR565 = &ConvertRGB565ToBGR565AVX2;
+	}
+#endif
 }
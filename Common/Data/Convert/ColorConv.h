@@ -121,9 +121,20 @@ void ConvertBGRA8888ToRGBA5551(u16 *dst, const u32 *src, u32 numPixels);
 void ConvertBGRA8888ToRGB565(u16 *dst, const u32 *src, u32 numPixels);
 void ConvertBGRA8888ToRGBA4444(u16 *dst, const u32 *src, u32 numPixels);
 
-void ConvertRGB565ToRGBA8888(u32 *dst, const u16 *src, u32 numPixels);
-void ConvertRGBA5551ToRGBA8888(u32 *dst, const u16 *src, u32 numPixels);
-void ConvertRGBA4444ToRGBA8888(u32 *dst, const u16 *src, u32 numPixels);
+void ConvertRGB565ToRGBA8888Basic(u32 *dst, const u16 *src, u32 numPixels);
+void ConvertRGBA5551ToRGBA8888Basic(u32 *dst, const u16 *src, u32 numPixels);
+void ConvertRGBA4444ToRGBA8888Basic(u32 *dst, const u16 *src, u32 numPixels);
+
+// On x86, these switch to AVX2 in SetupColorConv() when available.
+#if PPSSPP_ARCH(X86) || PPSSPP_ARCH(AMD64)
+extern Convert16bppTo32bppFunc ConvertRGB565ToRGBA8888;
+extern Convert16bppTo32bppFunc ConvertRGBA5551ToRGBA8888;
+extern Convert16bppTo32bppFunc ConvertRGBA4444ToRGBA8888;
+#else
+#define ConvertRGB565ToRGBA8888 ConvertRGB565ToRGBA8888Basic
+#define ConvertRGBA5551ToRGBA8888 ConvertRGBA5551ToRGBA8888Basic
+#define ConvertRGBA4444ToRGBA8888 ConvertRGBA4444ToRGBA8888Basic
+#endif
 
 void ConvertBGR565ToRGBA8888(u32 *dst, const u16 *src, u32 numPixels);
 void ConvertABGR1555ToRGBA8888(u32 *dst, const u16 *src, u32 numPixels);
@@ -140,7 +151,7 @@ void ConvertBGRA5551ToABGR1555(u16 *dst, const u16 *src, u32 numPixels);
 
 #if PPSSPP_ARCH(ARM64)
 #define ConvertRGBA4444ToABGR4444 ConvertRGBA4444ToABGR4444NEON
-#elif !PPSSPP_ARCH(ARM)
+#elif !PPSSPP_ARCH(ARM) && !PPSSPP_ARCH(X86) && !PPSSPP_ARCH(AMD64)
 #define ConvertRGBA4444ToABGR4444 ConvertRGBA4444ToABGR4444Basic
 #else
 extern Convert16bppTo16bppFunc ConvertRGBA4444ToABGR4444;
@@ -148,7 +159,7 @@ extern Convert16bppTo16bppFunc ConvertRGBA4444ToABGR4444;
 
 #if PPSSPP_ARCH(ARM64)
 #define ConvertRGBA5551ToABGR1555 ConvertRGBA5551ToABGR1555NEON
-#elif !PPSSPP_ARCH(ARM)
+#elif !PPSSPP_ARCH(ARM) && !PPSSPP_ARCH(X86) && !PPSSPP_ARCH(AMD64)
 #define ConvertRGBA5551ToABGR1555 ConvertRGBA5551ToABGR1555Basic
 #else
 extern Convert16bppTo16bppFunc ConvertRGBA5551ToABGR1555;
@@ -156,7 +167,7 @@ extern Convert16bppTo16bppFunc ConvertRGBA5551ToABGR1555;
 
 #if PPSSPP_ARCH(ARM64)
 #define ConvertRGB565ToBGR565 ConvertRGB565ToBGR565NEON
-#elif !PPSSPP_ARCH(ARM)
+#elif !PPSSPP_ARCH(ARM) && !PPSSPP_ARCH(X86) && !PPSSPP_ARCH(AMD64)
 #define ConvertRGB565ToBGR565 ConvertRGB565ToBGR565Basic
 #else
 extern Convert16bppTo16bppFunc ConvertRGB565ToBGR565;
@@ -55,6 +55,8 @@ http::Downloader g_DownloadManager;
 Config g_Config;
 
 bool jitForcedOff;
+// Which of the jit cores was forced off, to put it back in the ini.
+static int jitForcedOffCore = (int)CPUCore::JIT;
 
 #ifdef _DEBUG
 static const char *logSectionName = "LogDebug";
@@ -610,6 +612,8 @@ static ConfigSetting cpuSettings[] = {
 	ConfigSetting("HideSlowWarnings", &g_Config.bHideSlowWarnings, false, true, false),
 	ConfigSetting("HideStateWarnings", &g_Config.bHideStateWarnings, false, true, false),
 	ConfigSetting("PreloadFunctions", &g_Config.bPreloadFunctions, false, true, true),
+	ConfigSetting("PersistentJitCache", &g_Config.bPersistentJitCache, false, true, true),
+	ConfigSetting("JitBackgroundCompile", &g_Config.bJitBackgroundCompile, true, true, true),
 	ConfigSetting("JitDisableFlags", &g_Config.uJitDisableFlags, (uint32_t)0, true, true),
 	ReportedConfigSetting("CPUSpeed", &g_Config.iLockedCPUSpeed, 0, true, true),
 
@@ -867,8 +871,10 @@ static ConfigSetting graphicsSettings[] = {
 	ConfigSetting("AnisotropyLevel", &g_Config.iAnisotropyLevel, 4, true, true),
 
 	ReportedConfigSetting("VertexDecCache", &g_Config.bVertexCache, false, true, true),
+	ReportedConfigSetting("ThreadedGE", &g_Config.bThreadedGE, false, true, true),
 	ReportedConfigSetting("TextureBackoffCache", &g_Config.bTextureBackoffCache, false, true, true),
 	ReportedConfigSetting("TextureSecondaryCache", &g_Config.bTextureSecondaryCache, false, true, true),
+	ReportedConfigSetting("AsyncTextureDecode", &g_Config.bAsyncTextureDecode, false, true, true),
 	ReportedConfigSetting("VertexDecJit", &g_Config.bVertexDecoderJit, &DefaultCodeGen, false),
 
 #ifndef MOBILE_DEVICE
@@ -1425,8 +1431,11 @@ void Config::Load(const char *iniFileName, const char *controllerIniFilename) {
 	}
 
 	// Override ppsspp.ini JIT value to prevent crashing
-	if (DefaultCpuCore() != (int)CPUCore::JIT && g_Config.iCpuCore == (int)CPUCore::JIT) {
+	// Both jit cores generate code, so neither can run where the default isn't the jit.
+	bool usingJit = g_Config.iCpuCore == (int)CPUCore::JIT || g_Config.iCpuCore == (int)CPUCore::JIT_IR;
+	if (DefaultCpuCore() != (int)CPUCore::JIT && usingJit) {
 		jitForcedOff = true;
+		jitForcedOffCore = g_Config.iCpuCore;
 		g_Config.iCpuCore = (int)CPUCore::INTERPRETER;
 	}
 
@@ -1460,7 +1469,7 @@ bool Config::Save(const char *saveReason) {
 
 	if (jitForcedOff) {
 		// if JIT has been forced off, we don't want to screw up the user's ppsspp.ini
-		g_Config.iCpuCore = (int)CPUCore::JIT;
+		g_Config.iCpuCore = jitForcedOffCore;
 	}
 	if (!iniFilename_.empty() && g_Config.bSaveSettings) {
 		saveGameConfig(gameId_, gameIdTitle_);
@@ -115,6 +115,8 @@ struct Config {
 	bool bHideSlowWarnings;
 	bool bHideStateWarnings;
 	bool bPreloadFunctions;
+	bool bPersistentJitCache;
+	bool bJitBackgroundCompile;
 	uint32_t uJitDisableFlags;
 
 	bool bSeparateSASThread;
@@ -186,8 +188,10 @@ struct Config {
 	int iWindowHeight;
 
 	bool bVertexCache;
+	bool bThreadedGE;  // runs display lists on a separate thread from the CPU core
 	bool bTextureBackoffCache;
 	bool bTextureSecondaryCache;
+	bool bAsyncTextureDecode;  // decodes large changed textures on a worker, drawing the old one meanwhile
 	bool bVertexDecoderJit;
 	bool bFullScreen;
 	bool bFullScreenMulti;
@@ -58,6 +58,7 @@
 #include "Core/Debugger/WebSocket/GPUStatsSubscriber.h"
 #include "Core/Debugger/WebSocket/HLESubscriber.h"
 #include "Core/Debugger/WebSocket/InputSubscriber.h"
+#include "Core/Debugger/WebSocket/JitProfileSubscriber.h"
 #include "Core/Debugger/WebSocket/MemoryInfoSubscriber.h"
 #include "Core/Debugger/WebSocket/MemorySubscriber.h"
 #include "Core/Debugger/WebSocket/ReplaySubscriber.h"
@@ -74,6 +75,7 @@ static const std::vector<SubscriberInit> subscribers({
 	&WebSocketGPUStatsInit,
 	&WebSocketHLEInit,
 	&WebSocketInputInit,
+	&WebSocketJitProfileInit,
 	&WebSocketMemoryInfoInit,
 	&WebSocketMemoryInit,
 	&WebSocketReplayInit,
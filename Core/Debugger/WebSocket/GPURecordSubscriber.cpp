@@ -30,6 +30,7 @@ struct WebSocketGPURecordState : public DebuggerSubscriber {
 
 protected:
 	bool pending_ = false;
+	bool failed_ = false;
 	std::string lastTicket_;
 	Path lastFilename_;
 };
@@ -54,6 +55,8 @@ WebSocketGPURecordState::~WebSocketGPURecordState() {
 // Response (same event name):
 //  - uri: data: URI containing debug dump data.
 //
+// If the recording can't be written, an error event is sent instead.
+//
 // Note: recording may take a moment.
 void WebSocketGPURecordState::Dump(DebuggerRequest &req) {
 	if (!PSP_IsInited())
@@ -65,6 +68,7 @@ void WebSocketGPURecordState::Dump(DebuggerRequest &req) {
 	pending_ = true;
 	GPURecord::SetCallback([=](const Path &filename) {
 		lastFilename_ = filename;
+		failed_ = filename.empty();
 		pending_ = false;
 	});
 
@@ -74,10 +78,25 @@ void WebSocketGPURecordState::Dump(DebuggerRequest &req) {
 
 // This handles the asynchronous gpu.record.dump response.
 void WebSocketGPURecordState::Broadcast(net::WebSocketServer *ws) {
+	if (failed_) {
+		DebuggerErrorEvent error("Unable to write GPU recording", LogTypes::LERROR);
+		error.ticketRaw = lastTicket_;
+		ws->Send(error);
+
+		failed_ = false;
+		lastTicket_.clear();
+		return;
+	}
+
 	if (!lastFilename_.empty()) {
 		FILE *fp = File::OpenCFile(lastFilename_, "rb");
 		if (!fp) {
+			DebuggerErrorEvent error("Unable to read GPU recording", LogTypes::LERROR);
+			error.ticketRaw = lastTicket_;
+			ws->Send(error);
+
 			lastFilename_.clear();
+			lastTicket_.clear();
 			return;
 		}
 
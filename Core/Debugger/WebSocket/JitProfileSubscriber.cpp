@@ -0,0 +1,121 @@
+// Copyright (c) 2021- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include "Core/Core.h"
+#include "Core/Debugger/WebSocket/JitProfileSubscriber.h"
+#include "Core/Debugger/WebSocket/WebSocketUtils.h"
+#include "Core/MIPS/JitCommon/JitBlockCache.h"
+#include "Core/MIPS/JitCommon/JitCommon.h"
+#include "Core/System.h"
+
+DebuggerSubscriber *WebSocketJitProfileInit(DebuggerEventHandlerMap &map) {
+	map["jit.profile.enable"] = &WebSocketJitProfileEnable;
+	map["jit.profile.reset"] = &WebSocketJitProfileReset;
+	map["jit.profile.top"] = &WebSocketJitProfileTop;
+
+	return nullptr;
+}
+
+static JitBlockCacheDebugInterface *ProfilerFromRequest(DebuggerRequest &req) {
+	if (!PSP_IsInited() || !MIPSComp::jit) {
+		req.Fail("CPU not started or not using a jit");
+		return nullptr;
+	}
+
+	JitBlockCacheDebugInterface *blockCache = MIPSComp::jit->GetBlockCacheDebugInterface();
+	if (!blockCache || !blockCache->SupportsProfiling()) {
+		req.Fail("Current CPU core does not support profiling");
+		return nullptr;
+	}
+	return blockCache;
+}
+
+// Enable or disable block profiling (jit.profile.enable)
+//
+// Parameters:
+//  - enable: optional boolean, pass false to stop profiling.
+//
+// Response (same event name) with no extra data.
+//
+// Note: profiling is slow, and may change which blocks run natively.
+void WebSocketJitProfileEnable(DebuggerRequest &req) {
+	JitBlockCacheDebugInterface *blockCache = ProfilerFromRequest(req);
+	if (!blockCache)
+		return;
+
+	bool enable = true;
+	if (!req.ParamBool("enable", &enable, DebuggerParamType::OPTIONAL))
+		return;
+
+	blockCache->SetProfiling(enable);
+	req.Respond();
+}
+
+// Clear collected block counts and times (jit.profile.reset)
+//
+// No parameters.
+//
+// Response (same event name) with no extra data.
+void WebSocketJitProfileReset(DebuggerRequest &req) {
+	JitBlockCacheDebugInterface *blockCache = ProfilerFromRequest(req);
+	if (!blockCache)
+		return;
+	if (!Core_IsStepping())
+		return req.Fail("CPU currently running (cpu.stepping first)");
+
+	blockCache->ResetProfile();
+	req.Respond();
+}
+
+// List the blocks with the most time spent in them (jit.profile.top)
+//
+// Parameters:
+//  - count: optional number of blocks to return, defaults to 20.
+//
+// Response (same event name):
+//  - enabled: boolean, whether profiling is currently on.
+//  - blocks: array of objects, most time first, each with properties:
+//     - address: unsigned integer address of the start of the block.
+//     - size: unsigned integer size of the block's MIPS code in bytes.
+//     - symbol: function name and offset, or just the address if unknown.
+//     - executions: number of times the block was entered.
+//     - hostTime: number of seconds spent running the block.
+void WebSocketJitProfileTop(DebuggerRequest &req) {
+	JitBlockCacheDebugInterface *blockCache = ProfilerFromRequest(req);
+	if (!blockCache)
+		return;
+	if (!Core_IsStepping())
+		return req.Fail("CPU currently running (cpu.stepping first)");
+
+	uint32_t count = 20;
+	if (!req.ParamU32("count", &count, false, DebuggerParamType::OPTIONAL))
+		return;
+
+	JsonWriter &json = req.Respond();
+	json.writeBool("enabled", blockCache->IsProfiling());
+	json.pushArray("blocks");
+	for (const JitBlockProfileResult &result : JitBlockProfileTop(blockCache, (int)count)) {
+		json.pushDict();
+		json.writeUint("address", result.stats.originalAddress);
+		json.writeUint("size", result.stats.originalSize);
+		json.writeString("symbol", result.symbol);
+		json.writeFloat("executions", (double)result.stats.executions);
+		json.writeFloat("hostTime", result.stats.hostTime);
+		json.pop();
+	}
+	json.pop();
+}
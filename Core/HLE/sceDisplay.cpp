@@ -334,6 +334,7 @@ void __DisplayDoState(PointerWrap &p) {
 		Do(p, nextFlipCycles);
 	}
 
+	gpu->SyncThread();
 	gpu->DoState(p);
 
 	if (p.mode == p.MODE_READ) {
@@ -702,6 +703,9 @@ void hleEnterVblank(u64 userdata, int cyclesLate) {
 	}
 	frameStartTicks = CoreTiming::GetTicks();
 
+	// With a GE thread, this is where its finished lists get noticed, at the latest.
+	gpu->SyncThread();
+
 	CoreTiming::ScheduleEvent(msToCycles(vblankMs) - cyclesLate, leaveVblankEvent, vbCount + 1);
 
 	// Trigger VBlank interrupt handlers.
@@ -859,6 +863,7 @@ void __DisplayFlip(int cyclesLate) {
 }
 
 void hleAfterFlip(u64 userdata, int cyclesLate) {
+	gpu->SyncThread();
 	gpu->BeginFrame();  // doesn't really matter if begin or end of frame.
 	PPGeNotifyFrame();
 
@@ -950,6 +955,7 @@ static u32 sceDisplaySetMode(int displayMode, int displayWidth, int displayHeigh
 	}
 
 	if (!hasSetMode) {
+		gpu->SyncThread();
 		gpu->InitClear();
 		hasSetMode = true;
 	}
@@ -963,6 +969,7 @@ static u32 sceDisplaySetMode(int displayMode, int displayWidth, int displayHeigh
 }
 
 void __DisplaySetFramebuf(u32 topaddr, int linesize, int pixelFormat, int sync) {
+	gpu->SyncThread();
 	FrameBufferState fbstate = {0};
 	fbstate.topaddr = topaddr;
 	fbstate.fmt = (GEBufferFormat)pixelFormat;
@@ -532,6 +532,7 @@ static int sceGeGetMtx(int type, u32 matrixPtr) {
 	}
 
 	INFO_LOG(SCEGE, "sceGeGetMtx(%d, %08x)", type, matrixPtr);
+	gpu->SyncThread();
 	switch (type) {
 	case GE_MTX_BONE0:
 	case GE_MTX_BONE1:
@@ -566,6 +567,7 @@ static int sceGeGetMtx(int type, u32 matrixPtr) {
 
 static u32 sceGeGetCmd(int cmd) {
 	if (cmd >= 0 && cmd < (int)ARRAY_SIZE(gstate.cmdmem)) {
+		gpu->SyncThread();
 		// Does not mask away the high bits.
 		return hleLogSuccessInfoX(SCEGE, gstate.cmdmem[cmd]);
 	}
@@ -1906,7 +1906,8 @@ void __KernelGPUReplay() {
 		Core_Stop();
 	}
 
-	if (PSP_CoreParameter().headLess && !PSP_CoreParameter().startBreak) {
+	// When benchmarking, keep replaying until enough frames were measured.
+	if (PSP_CoreParameter().headLess && !PSP_CoreParameter().startBreak && !GPURecord::IsReplayBenchmarkRunning()) {
 		PSPPointer<u8> topaddr;
 		u32 linesize = 512;
 		__DisplayGetFramebuf(&topaddr, &linesize, nullptr, 0);
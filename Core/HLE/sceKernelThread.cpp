@@ -49,6 +49,7 @@
 #include "Core/HLE/KernelThreadDebugInterface.h"
 #include "Core/HLE/KernelWaitHelpers.h"
 #include "Core/HLE/ThreadQueueList.h"
+#include "GPU/GPUInterface.h"
 
 struct WaitTypeNames {
 	WaitType type;
@@ -1161,6 +1162,10 @@ void __KernelIdle()
 	// Don't skip 0xDEADBEEF here, this is called directly bypassing CallSyscall().
 	// That means the hle flag would stick around until the next call.
 
+	// With the GE thread, list syncs and interrupts are only scheduled once it's done.
+	// Do that now, so idling doesn't skip past their ticks.
+	if (gpu)
+		gpu->SyncThread();
 	CoreTiming::Idle();
 	// We Advance within __KernelReSchedule(), so anything that has now happened after idle
 	// will be triggered properly upon reschedule.
@@ -54,6 +54,15 @@ using namespace MIPSAnalyst;
 namespace MIPSComp
 {
 
+bool IRFrontend::IsSpinWaitBranch(u32 targetAddr) {
+	if (opts.disableFlags & (uint32_t)JitDisable::IDLE_LOOP)
+		return false;
+	// The whole loop must be this block, or we'd skip code before the branch.
+	if (targetAddr != js.blockStart || js.lastContinuedPC != 0 || traceSegments_.size() != 1)
+		return false;
+	return MIPSAnalyst::IsSpinWaitLoop(targetAddr, GetCompilerPC());
+}
+
 void IRFrontend::BranchRSRTComp(MIPSOpcode op, IRComparison cc, bool likely) {
 	if (js.inDelaySlot) {
 		ERROR_LOG_REPORT(JIT, "Branch in RSRTComp delay slot at %08x in block starting at %08x", GetCompilerPC(), js.blockStart);
@@ -105,6 +114,8 @@ void IRFrontend::BranchRSRTComp(MIPSOpcode op, IRComparison cc, bool likely) {
 		CompileDelaySlot();
 
 	FlushAll();
+	if (IsSpinWaitBranch(targetAddr))
+		ir.Write(IROp::Idle);
 	ir.Write(IROp::ExitToConst, ir.AddConstant(targetAddr));
 
 	// Account for the delay slot.
@@ -146,6 +157,8 @@ void IRFrontend::BranchRSZeroComp(MIPSOpcode op, IRComparison cc, bool andLink,
 		CompileDelaySlot();
 	// Taken
 	FlushAll();
+	if (IsSpinWaitBranch(targetAddr))
+		ir.Write(IROp::Idle);
 	ir.Write(IROp::ExitToConst, ir.AddConstant(targetAddr));
 
 	// Account for the delay slot.
@@ -214,6 +227,8 @@ void IRFrontend::BranchFPFlag(MIPSOpcode op, IRComparison cc, bool likely) {
 	if (likely)
 		CompileDelaySlot();
 	FlushAll();
+	if (IsSpinWaitBranch(targetAddr))
+		ir.Write(IROp::Idle);
 	ir.Write(IROp::ExitToConst, ir.AddConstant(targetAddr));
 
 	// Account for the delay slot.
@@ -273,6 +288,8 @@ void IRFrontend::BranchVFPUFlag(MIPSOpcode op, IRComparison cc, bool likely) {
 
 	// Taken
 	FlushAll();
+	if (IsSpinWaitBranch(targetAddr))
+		ir.Write(IROp::Idle);
 	ir.Write(IROp::ExitToConst, ir.AddConstant(targetAddr));
 
 	// Account for the delay slot.
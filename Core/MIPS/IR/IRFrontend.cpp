@@ -15,6 +15,8 @@
 // Official git repository and contact information can be found at
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
+#include <algorithm>
+
 #include "Common/Log.h"
 #include "Common/Serialize/Serializer.h"
 #include "Common/Serialize/SerializeFuncs.h"
@@ -221,7 +223,64 @@ MIPSOpcode IRFrontend::GetOffsetInstruction(int offset) {
 	return Memory::Read_Instruction(GetCompilerPC() + 4 * offset);
 }
 
-void IRFrontend::DoJit(u32 em_address, std::vector<IRInst> &instructions, u32 &mipsBytes, bool preload) {
+// Traces must stay within this many bytes after their start, so invalidation can use a single range.
+static const u32 MAX_TRACE_SPAN = 0x1000;
+static const int MAX_TRACE_INSTRUCTIONS = 300;
+
+static bool InvertExitCondition(IRInst &inst) {
+	switch (inst.op) {
+	case IROp::ExitToConstIfEq: inst.op = IROp::ExitToConstIfNeq; return true;
+	case IROp::ExitToConstIfNeq: inst.op = IROp::ExitToConstIfEq; return true;
+	case IROp::ExitToConstIfGtZ: inst.op = IROp::ExitToConstIfLeZ; return true;
+	case IROp::ExitToConstIfLeZ: inst.op = IROp::ExitToConstIfGtZ; return true;
+	case IROp::ExitToConstIfGeZ: inst.op = IROp::ExitToConstIfLtZ; return true;
+	case IROp::ExitToConstIfLtZ: inst.op = IROp::ExitToConstIfGeZ; return true;
+	default:
+		return false;
+	}
+}
+
+bool IRFrontend::ContinueTrace(const IRTraceChooser &chooseExit) {
+	const std::vector<IRInst> &insts = ir.GetInstructions();
+	if (js.cancel || js.hadBreakpoints || js.numInstructions >= MAX_TRACE_INSTRUCTIONS)
+		return false;
+	if (insts.empty() || insts.back().op != IROp::ExitToConst)
+		return false;
+
+	u32 taken = insts.back().constant;
+	u32 notTaken = 0;
+	// Only when nothing (like a likely delay slot) sits between the exits, so the condition can simply be flipped.
+	if (insts.size() >= 2) {
+		IRInst cond = insts[insts.size() - 2];
+		if (InvertExitCondition(cond))
+			notTaken = cond.constant;
+	}
+
+	u32 next = chooseExit(taken, notTaken);
+	if (next == 0 || (next != taken && next != notTaken))
+		return false;
+	if (next <= js.blockStart || next >= js.blockStart + MAX_TRACE_SPAN || !Memory::IsValidAddress(next))
+		return false;
+	for (const auto &segment : traceSegments_) {
+		// Loops go back through the dispatcher, so downcount still gets checked.
+		if (next >= segment.first && next < segment.second)
+			return false;
+	}
+
+	ir.PopBack();
+	if (next == notTaken) {
+		IRInst &cond = ir.Back();
+		InvertExitCondition(cond);
+		cond.constant = taken;
+	}
+
+	js.compilerPC = next;
+	js.compiling = true;
+	traceSegments_.push_back(std::make_pair(next, next));
+	return true;
+}
+
+void IRFrontend::DoJit(u32 em_address, std::vector<IRInst> &instructions, u32 &mipsBytes, bool preload, const IRTraceChooser *chooseTraceExit) {
 	js.cancel = false;
 	js.preloading = preload;
 	js.blockStart = em_address;
@@ -238,23 +297,30 @@ void IRFrontend::DoJit(u32 em_address, std::vector<IRInst> &instructions, u32 &m
 	ir.Clear();
 
 	js.numInstructions = 0;
-	while (js.compiling) {
-		// Jit breakpoints are quite fast, so let's do them in release too.
-		CheckBreakpoint(GetCompilerPC());
-
-		MIPSOpcode inst = Memory::Read_Opcode_JIT(GetCompilerPC());
-		js.downcountAmount += MIPSGetInstructionCycleEstimate(inst);
-		MIPSCompileOp(inst, this);
-		js.compilerPC += 4;
-		js.numInstructions++;
-	}
+	traceSegments_.clear();
+	traceSegments_.push_back(std::make_pair(em_address, em_address));
+	u32 endAddress = em_address;
+	do {
+		while (js.compiling) {
+			// Jit breakpoints are quite fast, so let's do them in release too.
+			CheckBreakpoint(GetCompilerPC());
+
+			MIPSOpcode inst = Memory::Read_Opcode_JIT(GetCompilerPC());
+			js.downcountAmount += MIPSGetInstructionCycleEstimate(inst);
+			MIPSCompileOp(inst, this);
+			js.compilerPC += 4;
+			js.numInstructions++;
+		}
+		traceSegments_.back().second = js.compilerPC;
+		endAddress = std::max(endAddress, js.compilerPC);
+	} while (chooseTraceExit && !preload && ContinueTrace(*chooseTraceExit));
 
 	if (js.cancel) {
 		// Clear the instructions to signal this was not compiled.
 		ir.Clear();
 	}
 
-	mipsBytes = js.compilerPC - em_address;
+	mipsBytes = endAddress - em_address;
 
 	IRWriter simplified;
 	IRWriter *code = &ir;
@@ -263,7 +329,11 @@ void IRFrontend::DoJit(u32 em_address, std::vector<IRInst> &instructions, u32 &m
 			&RemoveLoadStoreLeftRight,
 			&OptimizeFPMoves,
 			&PropagateConstants,
+			&EliminateCommonSubexpressions,
+			&FoldVFPUPrefixes,
 			&PurgeTemps,
+			&RemoveDeadStores,
+			&ReduceLoads,
 			// &ReorderLoadStore,
 			// &MergeLoadStore,
 			// &ThreeOpToTwoOp,
@@ -280,7 +350,7 @@ void IRFrontend::DoJit(u32 em_address, std::vector<IRInst> &instructions, u32 &m
 	if (logBlocks > 0 && dontLogBlocks == 0) {
 		char temp2[256];
 		NOTICE_LOG(JIT, "=============== mips %08x ===============", em_address);
-		for (u32 cpc = em_address; cpc != GetCompilerPC(); cpc += 4) {
+		for (u32 cpc = em_address; cpc != em_address + mipsBytes; cpc += 4) {
 			temp2[0] = 0;
 			MIPSDisAsm(Memory::Read_Opcode_JIT(cpc), cpc, temp2, true);
 			NOTICE_LOG(JIT, "M: %08x   %s", cpc, temp2);
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <functional>
+#include <vector>
+
 #include "Common/CommonTypes.h"
 #include "Core/MIPS/JitCommon/JitCommon.h"
 #include "Core/MIPS/JitCommon/JitState.h"
@@ -8,6 +11,10 @@
 
 namespace MIPSComp {
 
+// When forming a trace, picks which exit of the block so far to keep compiling into.
+// notTaken is 0 if there's no conditional exit to invert.  Return 0 to end the trace.
+typedef std::function<u32(u32 taken, u32 notTaken)> IRTraceChooser;
+
 class IRFrontend : public MIPSFrontendInterface {
 public:
 	IRFrontend(bool startDefaultPrefix);
@@ -88,7 +95,8 @@ class IRFrontend : public MIPSFrontendInterface {
 	void DoState(PointerWrap &p);
 	bool CheckRounding(u32 blockAddress);  // returns true if we need a do-over
 
-	void DoJit(u32 em_address, std::vector<IRInst> &instructions, u32 &mipsBytes, bool preload);
+	// With chooseTraceExit, follows hot exits into a single superblock.  mipsBytes then covers all of it.
+	void DoJit(u32 em_address, std::vector<IRInst> &instructions, u32 &mipsBytes, bool preload, const IRTraceChooser *chooseTraceExit = nullptr);
 
 	void EatPrefix() override {
 		js.EatPrefix();
@@ -108,6 +116,7 @@ class IRFrontend : public MIPSFrontendInterface {
 
 	u32 GetCompilerPC();
 	void CompileDelaySlot();
+	bool ContinueTrace(const IRTraceChooser &chooseExit);
 	void EatInstruction(MIPSOpcode op);
 	MIPSOpcode GetOffsetInstruction(int offset);
 
@@ -119,6 +128,7 @@ class IRFrontend : public MIPSFrontendInterface {
 	void BranchVFPUFlag(MIPSOpcode op, IRComparison cc, bool likely);
 	void BranchRSZeroComp(MIPSOpcode op, IRComparison cc, bool andLink, bool likely);
 	void BranchRSRTComp(MIPSOpcode op, IRComparison cc, bool likely);
+	bool IsSpinWaitBranch(u32 targetAddr);
 
 	// Utilities to reduce duplicated code
 	void CompShiftImm(MIPSOpcode op, IROp shiftType, int sa);
@@ -139,6 +149,9 @@ class IRFrontend : public MIPSFrontendInterface {
 
 	int dontLogBlocks = 0;
 	int logBlocks = 0;
+
+	// Start and end of each piece of MIPS code in the current trace.
+	std::vector<std::pair<u32, u32>> traceSegments_;
 };
 
 }  // namespace
@@ -193,6 +193,8 @@ enum class IROp : u8 {
 	// Emit this before you exit. Semantic is to set the downcount
 	// that will be used at the actual exit.
 	Downcount,  // src1 + (src2<<8)
+	// Skips the rest of the downcount ahead to the next event, for spin wait loops.
+	Idle,
 
 	// End-of-basic-block.
 	ExitToConst,   // 0, const, downcount
@@ -361,6 +363,14 @@ class IRWriter {
 		insts_.clear();
 	}
 
+	// Used to stitch blocks together into traces.
+	IRInst &Back() {
+		return insts_.back();
+	}
+	void PopBack() {
+		insts_.pop_back();
+	}
+
 	const std::vector<IRInst> &GetInstructions() const { return insts_; }
 
 private:
@@ -21,3 +21,12 @@ inline static u32 ReverseBits32(u32 v) {
 }
 
 u32 IRInterpret(MIPSState *ms, const IRInst *inst, int count);
+// Runs just one instruction, used by native backends for ops they don't implement.
+// Returns the new PC if the instruction exited the block, otherwise 0.
+u32 IRInterpretSingle(MIPSState *ms, const IRInst *inst);
+
+// Fills handlers (count + 1 entries) with a pre-decoded form of the block for IRInterpretThreaded().
+// Returns false if the compiler doesn't support threaded dispatch, use IRInterpret() then.
+bool IRPredecodeThreaded(const IRInst *inst, int count, const void **handlers);
+// Same result as IRInterpret(), but dispatches with one indirect jump per instruction.
+u32 IRInterpretThreaded(MIPSState *ms, const IRInst *inst, int count, const void *const *handlers);
@@ -15,14 +15,19 @@
 // Official git repository and contact information can be found at
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
+#include <algorithm>
 #include <set>
 
 #include "ext/xxhash.h"
 #include "Common/Profiler/Profiler.h"
 
+#include "Common/File/FileUtil.h"
 #include "Common/Log.h"
+#include "Common/MemoryUtil.h"
 #include "Common/Serialize/Serializer.h"
 #include "Common/StringUtils.h"
+#include "Common/Thread/ThreadManager.h"
+#include "Common/TimeUtil.h"
 
 #include "Core/Core.h"
 #include "Core/CoreTiming.h"
@@ -41,7 +46,10 @@
 
 namespace MIPSComp {
 
-IRJit::IRJit(MIPSState *mipsState) : frontend_(mipsState->HasDefaultPrefix()), mips_(mipsState) {
+// Blocks run this many times get rebuilt as traces through their hot exits.
+static const u32 TRACE_THRESHOLD = 1000;
+
+IRJit::IRJit(MIPSState *mipsState, IRToNativeInterface *native) : frontend_(mipsState->HasDefaultPrefix()), native_(native), mips_(mipsState) {
 	// u32 size = 128 * 1024;
 	// blTrampolines_ = kernelMemory.Alloc(size, true, "trampoline");
 	InitIR();
@@ -50,9 +58,17 @@ IRJit::IRJit(MIPSState *mipsState) : frontend_(mipsState->HasDefaultPrefix()), m
 	opts.disableFlags = g_Config.uJitDisableFlags;
 	opts.unalignedLoadStore = opts.disableFlags & (uint32_t)JitDisable::LSU_UNALIGNED;
 	frontend_.SetOptions(opts);
+	if (native_)
+		native_->SetLookupPages(blocks_.GetLookupPages());
+
+	// Can't write code while it's executable on W^X platforms, so no compiling while the dispatcher runs.
+	asyncNative_ = native_ && g_Config.bJitBackgroundCompile && !PlatformIsWXExclusive() && g_threadManager.IsInitialized();
 }
 
 IRJit::~IRJit() {
+	// Tasks refer to us, so they have to be done first.
+	std::unique_lock<std::mutex> guard(resultsLock_);
+	resultsCond_.wait(guard, [&] { return nativePending_ == 0; });
 }
 
 void IRJit::DoState(PointerWrap &p) {
@@ -64,7 +80,15 @@ void IRJit::UpdateFCR31() {
 
 void IRJit::ClearCache() {
 	INFO_LOG(JIT, "IRJit: Clearing the cache!");
-	blocks_.Clear();
+	if (native_) {
+		// Queued compiles point into the blocks, so they must see the new epoch before those are freed.
+		std::lock_guard<std::mutex> guard(nativeLock_);
+		nativeEpoch_++;
+		native_->ClearAllBlocks();
+		blocks_.Clear();
+	} else {
+		blocks_.Clear();
+	}
 }
 
 void IRJit::InvalidateCacheAt(u32 em_address, int length) {
@@ -78,10 +102,8 @@ void IRJit::Compile(u32 em_address) {
 		// Look to see if we've preloaded this block.
 		int block_num = blocks_.FindPreloadBlock(em_address);
 		if (block_num != -1) {
-			IRBlock *b = blocks_.GetBlock(block_num);
 			// Okay, let's link and finalize the block now.
-			b->Finalize(block_num);
-			if (b->IsValid()) {
+			if (blocks_.FinalizePreloadedBlock(block_num)) {
 				// Success, we're done.
 				return;
 			}
@@ -121,23 +143,172 @@ bool IRJit::CompileBlock(u32 em_address, std::vector<IRInst> &instructions, u32
 	IRBlock *b = blocks_.GetBlock(block_num);
 	b->SetInstructions(instructions);
 	b->SetOriginalSize(mipsBytes);
+	if (!CompileNativeBlock(block_num)) {
+		// Out of native code space.  Caller will handle, same as running out of block numbers.
+		return false;
+	}
 	if (preload) {
 		// Hash, then only update page stats, don't link yet.
 		b->UpdateHash();
 		blocks_.FinalizeBlock(block_num, true);
 	} else {
-		// Overwrites the first instruction, and also updates stats.
-		// TODO: Should we always hash?  Then we can reuse blocks.
+		// The block cache needs the hash of the code this was compiled from, not whatever's there when saving.
+		if (g_Config.bPersistentJitCache)
+			b->UpdateHash();
+		// Makes it reachable through the lookup table, and also updates stats.
 		blocks_.FinalizeBlock(block_num);
 	}
 
 	return true;
 }
 
+bool IRJit::CompileTrace(int block_num) {
+	PROFILE_THIS_SCOPE("jitc");
+
+	u32 em_address, origSize;
+	blocks_.GetBlock(block_num)->GetRange(em_address, origSize);
+	const u32 headExecutions = blocks_.GetBlock(block_num)->GetExecutionCount();
+
+	auto executionsAt = [this](u32 addr) -> u32 {
+		if (addr == 0)
+			return 0;
+		const IRBlock *b = blocks_.GetBlock(blocks_.GetBlockNumberFromStartAddress(addr));
+		return b && b->IsValid() ? b->GetExecutionCount() : 0;
+	};
+	IRTraceChooser chooseExit = [&](u32 taken, u32 notTaken) -> u32 {
+		u32 takenCount = executionsAt(taken);
+		u32 notTakenCount = executionsAt(notTaken);
+		// Only follow exits that run about as often as the start of the trace.
+		u32 minCount = std::max(headExecutions / 2, 1U);
+		if (takenCount >= notTakenCount)
+			return takenCount >= minCount ? taken : 0;
+		return notTakenCount >= minCount ? notTaken : 0;
+	};
+
+	std::vector<IRInst> instructions;
+	u32 mipsBytes;
+	frontend_.DoJit(em_address, instructions, mipsBytes, false, &chooseExit);
+	if (frontend_.CheckRounding(em_address)) {
+		// Everything will get rebuilt with the right rounding checks.
+		ClearCache();
+		return true;
+	}
+	if (instructions.empty() || mipsBytes <= origSize) {
+		// Nothing hot to continue into, so just keep the original block.
+		return true;
+	}
+
+	int trace_num = blocks_.AllocateBlock(em_address);
+	if ((trace_num & ~MIPS_EMUHACK_VALUE_MASK) != 0) {
+		// Out of block numbers.  Caller will handle.
+		return false;
+	}
+	// The trace takes over the entry point.
+	blocks_.DestroyBlock(block_num);
+
+	IRBlock *b = blocks_.GetBlock(trace_num);
+	b->SetInstructions(instructions);
+	b->SetOriginalSize(mipsBytes);
+	b->SetIsTrace(true);
+	if (g_Config.bPersistentJitCache)
+		b->UpdateHash();
+	if (!CompileNativeBlock(trace_num)) {
+		return false;
+	}
+	blocks_.FinalizeBlock(trace_num);
+	return true;
+}
+
+class IRNativeCompileTask : public Task {
+public:
+	IRNativeCompileTask(IRJit *jit, int blockNum, const IRInst *instructions, int count, u32 epoch)
+		: jit_(jit), blockNum_(blockNum), instructions_(instructions), count_(count), epoch_(epoch), queuedTime_(time_now_d()) {
+	}
+
+	void Run() override {
+		jit_->RunNativeCompile(blockNum_, instructions_, count_, epoch_, queuedTime_);
+	}
+
+private:
+	IRJit *jit_;
+	int blockNum_;
+	const IRInst *instructions_;
+	int count_;
+	u32 epoch_;
+	double queuedTime_;
+};
+
+bool IRJit::CompileNativeBlock(int block_num) {
+	if (!native_)
+		return true;
+
+	const IRBlock *b = blocks_.GetBlock(block_num);
+	if (asyncNative_) {
+		// The native code keeps pointers to these (for fallbacks), so it must use the block's own array.
+		// That stays put even if blocks_ grows, and is only freed by ClearCache(), which bumps the epoch.
+		nativePending_++;
+		blocks_.SetCompileQueueDepth(nativePending_);
+		g_threadManager.EnqueueTask(new IRNativeCompileTask(this, block_num, b->GetInstructions(), b->GetNumInstructions(), nativeEpoch_), TaskType::CPU_COMPUTE);
+		return true;
+	}
+
+	std::lock_guard<std::mutex> guard(nativeLock_);
+	return native_->CompileBlock(block_num, b->GetInstructions(), b->GetNumInstructions());
+}
+
+void IRJit::RunNativeCompile(int block_num, const IRInst *instructions, int count, u32 epoch, double queuedTime) {
+	NativeResult result{ block_num, nullptr, epoch, queuedTime };
+	bool keep = false;
+	{
+		std::lock_guard<std::mutex> guard(nativeLock_);
+		// Don't bother if the cache was cleared in the meantime, the instructions are gone too.
+		if (epoch == nativeEpoch_) {
+			result.entry = native_->EmitBlock(instructions, count);
+			keep = true;
+		}
+	}
+
+	std::lock_guard<std::mutex> guard(resultsLock_);
+	if (keep) {
+		nativeResults_.push_back(result);
+		nativeResultsReady_ = true;
+	}
+	nativePending_--;
+	resultsCond_.notify_all();
+}
+
+void IRJit::LinkNativeBlocks() {
+	std::vector<NativeResult> results;
+	{
+		std::lock_guard<std::mutex> guard(resultsLock_);
+		results.swap(nativeResults_);
+		nativeResultsReady_ = false;
+	}
+
+	bool outOfSpace = false;
+	double now = time_now_d();
+	for (const NativeResult &result : results) {
+		if (result.epoch != nativeEpoch_)
+			continue;
+		if (!result.entry) {
+			outOfSpace = true;
+			continue;
+		}
+		native_->SetBlockEntry(result.blockNum, result.entry);
+		blocks_.RecordCompileLatency(now - result.queuedTime);
+	}
+	blocks_.SetCompileQueueDepth(nativePending_);
+
+	if (outOfSpace) {
+		ERROR_LOG(JIT, "Out of native code space, clearing cache");
+		ClearCache();
+	}
+}
+
 void IRJit::CompileFunction(u32 start_address, u32 length) {
 	PROFILE_THIS_SCOPE("jitc");
 
-	// Note: we don't actually write emuhacks yet, so we can validate hashes.
+	// Note: we don't make the blocks reachable yet, so we can validate hashes.
 	// This way, if the game changes the code afterward, we'll catch even without icache invalidation.
 
 	// We may go up and down from branches, so track all block starts done here.
@@ -149,8 +320,7 @@ void IRJit::CompileFunction(u32 start_address, u32 length) {
 		pendingAddresses.pop_back();
 
 		// To be safe, also check if a real block is there.  This can be a runtime module load.
-		u32 inst = Memory::ReadUnchecked_U32(em_address);
-		if (MIPS_IS_RUNBLOCK(inst) || doneAddresses.find(em_address) != doneAddresses.end()) {
+		if (blocks_.LookupBlock(em_address) != -1 || doneAddresses.find(em_address) != doneAddresses.end()) {
 			// Already compiled this address.
 			continue;
 		}
@@ -221,12 +391,47 @@ void IRJit::RunLoopUntil(u64 globalticks) {
 			break;
 		}
 		while (mips_->downcount >= 0) {
-			u32 inst = Memory::ReadUnchecked_U32(mips_->pc);
-			u32 opcode = inst & 0xFF000000;
-			if (opcode == MIPS_EMUHACK_OPCODE) {
-				u32 data = inst & 0xFFFFFF;
+			if (nativeResultsReady_) {
+				LinkNativeBlocks();
+			}
+			const bool profiling = blocks_.IsProfiling();
+			if (native_) {
+				// The dispatcher times native blocks itself, the rest are timed below.
+				native_->SetProfiling(profiling ? &blocks_ : nullptr);
+				// Runs native blocks for as long as it can, and comes back here for anything else.
+				native_->RunDispatcher();
+				if (mips_->downcount < 0 || coreState == CORE_RUNTIME_ERROR) {
+					break;
+				}
+				if (!Memory::IsValidAddress(mips_->pc)) {
+					Core_ExecException(mips_->pc, mips_->pc, ExecExceptionType::JUMP);
+					break;
+				}
+			}
+
+			int data = blocks_.LookupBlock(mips_->pc);
+			if (data != -1) {
 				IRBlock *block = blocks_.GetBlock(data);
-				mips_->pc = IRInterpret(mips_, block->GetInstructions(), block->GetNumInstructions());
+				if (block->CountExecution() == TRACE_THRESHOLD && !block->IsTrace()) {
+					if (!CompileTrace(data)) {
+						ERROR_LOG(JIT, "Ran out of block numbers, clearing cache");
+						ClearCache();
+					}
+					// The block may have been replaced, so look it up again.
+					continue;
+				}
+				guestInstructions_ += block->GetOriginalSize() / 4;
+				double startTime = profiling ? time_now_d() : 0.0;
+				if (threadedDispatch_ && block->GetThreadedHandlers())
+					mips_->pc = IRInterpretThreaded(mips_, block->GetInstructions(), block->GetNumInstructions(), block->GetThreadedHandlers());
+				else
+					mips_->pc = IRInterpret(mips_, block->GetInstructions(), block->GetNumInstructions());
+				if (profiling) {
+					// Syscalls may have cleared the cache, so look it up again.
+					block = blocks_.GetBlock(data);
+					if (block)
+						block->AddProfileSample(time_now_d() - startTime);
+				}
 				if (!Memory::IsValidAddress(mips_->pc)) {
 					Core_ExecException(mips_->pc, mips_->pc, ExecExceptionType::JUMP);
 					break;
@@ -242,8 +447,145 @@ void IRJit::RunLoopUntil(u64 globalticks) {
 	// RestoreRoundingMode(true);
 }
 
+#define BLOCK_CACHE_MAGIC 0x43425249
+// Bump whenever IROps or the frontend's output change.
+#define BLOCK_CACHE_VERSION 3
+
+struct BlockCacheHeader {
+	u32 magic;
+	u32 version;
+	u32 jitDisableFlags;
+	u32 numBlocks;
+};
+
+struct BlockCacheEntry {
+	u32 address;
+	u32 size;
+	u64 hash;
+	u32 numInstructions;
+	u32 isTrace;
+};
+
+static u64 HashMIPSRange(u32 addr, u32 size);
+
+bool IRJit::SaveBlockCache(const Path &filename) {
+	std::vector<int> saved;
+	for (int i = 0; i < blocks_.GetNumBlocks(); ++i) {
+		const IRBlock *b = blocks_.GetBlock(i);
+		if (!b->IsValid())
+			continue;
+		// If the code changed since it was compiled, the IR is stale, even if it wasn't invalidated yet.
+		u32 start, size;
+		b->GetRange(start, size);
+		if (blocks_.LookupBlock(start) != i || !b->HashMatches())
+			continue;
+
+		// Breakpoint checks are compiled in, don't keep them around.
+		bool skip = false;
+		for (int j = 0; j < b->GetNumInstructions(); ++j) {
+			IROp op = b->GetInstructions()[j].op;
+			if (op == IROp::Breakpoint || op == IROp::MemoryCheck)
+				skip = true;
+		}
+		if (!skip)
+			saved.push_back(i);
+	}
+	if (saved.empty())
+		return false;
+
+	FILE *f = File::OpenCFile(filename, "wb");
+	if (!f) {
+		WARN_LOG(JIT, "Could not store jit block cache: %s", filename.c_str());
+		return false;
+	}
+
+	BlockCacheHeader header;
+	header.magic = BLOCK_CACHE_MAGIC;
+	header.version = BLOCK_CACHE_VERSION;
+	header.jitDisableFlags = g_Config.uJitDisableFlags;
+	header.numBlocks = (u32)saved.size();
+	bool success = fwrite(&header, sizeof(header), 1, f) == 1;
+
+	for (int i : saved) {
+		IRBlock *b = blocks_.GetBlock(i);
+		BlockCacheEntry entry;
+		b->GetRange(entry.address, entry.size);
+		entry.hash = b->GetHash();
+		entry.numInstructions = b->GetNumInstructions();
+		entry.isTrace = b->IsTrace() ? 1 : 0;
+		success = success && fwrite(&entry, sizeof(entry), 1, f) == 1;
+		success = success && fwrite(b->GetInstructions(), sizeof(IRInst), entry.numInstructions, f) == entry.numInstructions;
+	}
+	fclose(f);
+
+	if (!success) {
+		WARN_LOG(JIT, "Could not store jit block cache: %s", filename.c_str());
+		File::Delete(filename);
+		return false;
+	}
+	INFO_LOG(JIT, "Stored %d blocks to jit block cache", (int)saved.size());
+	return true;
+}
+
+bool IRJit::LoadBlockCache(const Path &filename) {
+	File::IOFile f(filename, "rb");
+	if (!f.IsOpen())
+		return false;
+
+	BlockCacheHeader header;
+	if (!f.ReadArray(&header, 1))
+		return false;
+	if (header.magic != BLOCK_CACHE_MAGIC || header.version != BLOCK_CACHE_VERSION || header.jitDisableFlags != g_Config.uJitDisableFlags)
+		return false;
+
+	int loaded = 0;
+	std::vector<IRInst> instructions;
+	for (u32 i = 0; i < header.numBlocks; ++i) {
+		BlockCacheEntry entry;
+		if (!f.ReadArray(&entry, 1) || entry.numInstructions == 0 || entry.numInstructions > 0xFFFF) {
+			ERROR_LOG(JIT, "Corrupt jit block cache, aborting.");
+			break;
+		}
+		instructions.resize(entry.numInstructions);
+		if (!f.ReadArray(&instructions[0], entry.numInstructions)) {
+			ERROR_LOG(JIT, "Corrupt jit block cache, aborting.");
+			break;
+		}
+
+		// Other modules may live here now, or it may already be compiled.
+		if (!Memory::IsValidRange(entry.address, entry.size) || blocks_.LookupBlock(entry.address) != -1)
+			continue;
+		if (HashMIPSRange(entry.address, entry.size) != entry.hash)
+			continue;
+
+		int block_num = blocks_.AllocateBlock(entry.address);
+		if ((block_num & ~MIPS_EMUHACK_VALUE_MASK) != 0) {
+			// Out of block numbers.  The rest will just get compiled as normal.
+			ClearCache();
+			return false;
+		}
+
+		IRBlock *b = blocks_.GetBlock(block_num);
+		b->SetInstructions(instructions);
+		b->SetOriginalSize(entry.size);
+		b->SetIsTrace(entry.isTrace != 0);
+		b->UpdateHash();
+		if (!CompileNativeBlock(block_num)) {
+			ClearCache();
+			return false;
+		}
+		blocks_.FinalizeBlock(block_num);
+		loaded++;
+	}
+
+	INFO_LOG(JIT, "Loaded %d of %d blocks from jit block cache", loaded, (int)header.numBlocks);
+	return loaded != 0;
+}
+
 bool IRJit::DescribeCodePtr(const u8 *ptr, std::string &name) {
 	// Used in target disassembly viewer.
+	if (native_)
+		return native_->DescribeCodePtr(ptr, name);
 	return false;
 }
 
@@ -260,12 +602,52 @@ bool IRJit::ReplaceJalTo(u32 dest) {
 	return false;
 }
 
+IRBlockCache::IRBlockCache() {
+	lookupPages_ = new LookupEntry *[LOOKUP_PAGE_COUNT]();
+}
+
+IRBlockCache::~IRBlockCache() {
+	ClearLookupPages();
+	delete [] lookupPages_;
+}
+
 void IRBlockCache::Clear() {
-	for (int i = 0; i < (int)blocks_.size(); ++i) {
-		blocks_[i].Destroy(i);
-	}
 	blocks_.clear();
 	byPage_.clear();
+	ClearLookupPages();
+}
+
+void IRBlockCache::ClearLookupPages() {
+	for (int i = 0; i < LOOKUP_PAGE_COUNT; ++i) {
+		delete [] lookupPages_[i];
+		lookupPages_[i] = nullptr;
+	}
+}
+
+void IRBlockCache::SetLookupEntry(u32 em_address, int blockNum, u32 firstOp) {
+	const u32 pAddr = em_address & 0x1FFFFFFF;
+	LookupEntry *&page = lookupPages_[pAddr >> LOOKUP_PAGE_SHIFT];
+	if (!page) {
+		if (blockNum < 0)
+			return;
+		page = new LookupEntry[LOOKUP_PAGE_ENTRIES];
+		for (int i = 0; i < LOOKUP_PAGE_ENTRIES; ++i)
+			page[i] = { -1, 0 };
+	}
+	page[(pAddr & LOOKUP_PAGE_MASK) >> 2] = { blockNum, firstOp };
+}
+
+void IRBlockCache::DestroyBlock(int i) {
+	u32 start, size;
+	blocks_[i].GetRange(start, size);
+	if (start == 0)
+		return;
+
+	const u32 pAddr = start & 0x1FFFFFFF;
+	const LookupEntry *page = lookupPages_[pAddr >> LOOKUP_PAGE_SHIFT];
+	if (page && page[(pAddr & LOOKUP_PAGE_MASK) >> 2].blockNum == i)
+		SetLookupEntry(start, -1, 0);
+	blocks_[i].Destroy();
 }
 
 void IRBlockCache::InvalidateICache(u32 address, u32 length) {
@@ -281,7 +663,7 @@ void IRBlockCache::InvalidateICache(u32 address, u32 length) {
 		for (int i : blocksInPage) {
 			if (blocks_[i].OverlapsRange(address, length)) {
 				// Not removing from the page, hopefully doesn't build up with small recompiles.
-				blocks_[i].Destroy(i);
+				DestroyBlock(i);
 			}
 		}
 	}
@@ -289,7 +671,7 @@ void IRBlockCache::InvalidateICache(u32 address, u32 length) {
 
 void IRBlockCache::FinalizeBlock(int i, bool preload) {
 	if (!preload) {
-		blocks_[i].Finalize(i);
+		FinalizePreloadedBlock(i);
 	}
 
 	u32 startAddr, size;
@@ -303,6 +685,18 @@ void IRBlockCache::FinalizeBlock(int i, bool preload) {
 	}
 }
 
+bool IRBlockCache::FinalizePreloadedBlock(int i) {
+	IRBlock &b = blocks_[i];
+	b.Finalize();
+	if (!b.IsValid())
+		return false;
+
+	u32 start, size;
+	b.GetRange(start, size);
+	SetLookupEntry(start, i, b.GetOriginalFirstOp().encoding);
+	return true;
+}
+
 u32 IRBlockCache::AddressToPage(u32 addr) const {
 	// Use relatively small pages since basic blocks are typically small.
 	return (addr & 0x3FFFFFFF) >> 10;
@@ -329,37 +723,6 @@ int IRBlockCache::FindPreloadBlock(u32 em_address) {
 	return -1;
 }
 
-std::vector<u32> IRBlockCache::SaveAndClearEmuHackOps() {
-	std::vector<u32> result;
-	result.resize(blocks_.size());
-
-	for (int number = 0; number < (int)blocks_.size(); ++number) {
-		IRBlock &b = blocks_[number];
-		if (b.IsValid() && b.RestoreOriginalFirstOp(number)) {
-			result[number] = number;
-		} else {
-			result[number] = 0;
-		}
-	}
-
-	return result;
-}
-
-void IRBlockCache::RestoreSavedEmuHackOps(std::vector<u32> saved) {
-	if ((int)blocks_.size() != (int)saved.size()) {
-		ERROR_LOG(JIT, "RestoreSavedEmuHackOps: Wrong saved block size.");
-		return;
-	}
-
-	for (int number = 0; number < (int)blocks_.size(); ++number) {
-		IRBlock &b = blocks_[number];
-		// Only if we restored it, write it back.
-		if (b.IsValid() && saved[number] != 0 && b.HasOriginalFirstOp()) {
-			b.Finalize(number);
-		}
-	}
-}
-
 JitBlockDebugInfo IRBlockCache::GetBlockDebugInfo(int blockNum) const {
 	const IRBlock &ir = blocks_[blockNum];
 	JitBlockDebugInfo debugInfo{};
@@ -383,6 +746,30 @@ JitBlockDebugInfo IRBlockCache::GetBlockDebugInfo(int blockNum) const {
 	return debugInfo;
 }
 
+void IRBlockCache::ResetProfile() {
+	for (IRBlock &b : blocks_) {
+		b.ResetProfile();
+	}
+}
+
+JitBlockProfileStats IRBlockCache::GetBlockProfileStats(int blockNum) const {
+	JitBlockProfileStats stats{};
+	if (blockNum < 0 || blockNum >= (int)blocks_.size())
+		return stats;
+
+	const IRBlock &b = blocks_[blockNum];
+	b.GetRange(stats.originalAddress, stats.originalSize);
+	stats.executions = b.GetProfileExecutions();
+	stats.hostTime = b.GetProfileTime();
+	return stats;
+}
+
+void IRBlockCache::RecordCompileLatency(double seconds) {
+	compileCount_++;
+	totalCompileLatency_ += seconds;
+	maxCompileLatency_ = std::max(maxCompileLatency_, seconds);
+}
+
 void IRBlockCache::ComputeStats(BlockCacheStats &bcStats) const {
 	double totalBloat = 0.0;
 	double maxBloat = 0.0;
@@ -411,9 +798,17 @@ void IRBlockCache::ComputeStats(BlockCacheStats &bcStats) const {
 	bcStats.minBloat = minBloat;
 	bcStats.maxBloat = maxBloat;
 	bcStats.avgBloat = totalBloat / (double)blocks_.size();
+	bcStats.compileQueueDepth = compileQueueDepth_;
+	bcStats.avgCompileLatency = compileCount_ ? totalCompileLatency_ / compileCount_ : 0.0;
+	bcStats.maxCompileLatency = maxCompileLatency_;
 }
 
 int IRBlockCache::GetBlockNumberFromStartAddress(u32 em_address, bool realBlocksOnly) const {
+	int linked = LookupBlock(em_address);
+	if (linked != -1)
+		return linked;
+
+	// Otherwise, look for preloaded or invalidated blocks.
 	u32 page = AddressToPage(em_address);
 
 	const auto iter = byPage_.find(page);
@@ -435,53 +830,37 @@ int IRBlockCache::GetBlockNumberFromStartAddress(u32 em_address, bool realBlocks
 	return best;
 }
 
-bool IRBlock::HasOriginalFirstOp() const {
-	return Memory::ReadUnchecked_U32(origAddr_) == origFirstOpcode_.encoding;
-}
-
-bool IRBlock::RestoreOriginalFirstOp(int number) {
-	const u32 emuhack = MIPS_EMUHACK_OPCODE | number;
-	if (Memory::ReadUnchecked_U32(origAddr_) == emuhack) {
-		Memory::Write_Opcode_JIT(origAddr_, origFirstOpcode_);
-		return true;
-	}
-	return false;
-}
-
-void IRBlock::Finalize(int number) {
+void IRBlock::Finalize() {
 	// Check it wasn't invalidated, in case this is after preload.
 	// TODO: Allow reusing blocks when the code matches hash_ again, instead.
 	if (origAddr_) {
-		origFirstOpcode_ = Memory::Read_Opcode_JIT(origAddr_);
-		MIPSOpcode opcode = MIPSOpcode(MIPS_EMUHACK_OPCODE | number);
-		Memory::Write_Opcode_JIT(origAddr_, opcode);
+		// Replacement emuhacks stay as they are, the lookup checks for exactly this value.
+		origFirstOpcode_ = MIPSOpcode(Memory::ReadUnchecked_U32(origAddr_));
 	}
 }
 
-void IRBlock::Destroy(int number) {
-	if (origAddr_) {
-		MIPSOpcode opcode = MIPSOpcode(MIPS_EMUHACK_OPCODE | number);
-		if (Memory::ReadUnchecked_U32(origAddr_) == opcode.encoding)
-			Memory::Write_Opcode_JIT(origAddr_, origFirstOpcode_);
+void IRBlock::Destroy() {
+	// Let's mark this invalid so we don't try to clear it again.
+	origAddr_ = 0;
+}
 
-		// Let's mark this invalid so we don't try to clear it again.
-		origAddr_ = 0;
+static u64 HashMIPSRange(u32 addr, u32 size) {
+	// This is unfortunate.  In case of emuhacks, we have to make a copy.
+	std::vector<u32> buffer;
+	buffer.resize(size / 4);
+	size_t pos = 0;
+	for (u32 off = 0; off < size; off += 4) {
+		// Let's actually hash the replacement, if any.
+		MIPSOpcode instr = Memory::ReadUnchecked_Instruction(addr + off, false);
+		buffer[pos++] = instr.encoding;
 	}
+
+	return XXH3_64bits(&buffer[0], size);
 }
 
 u64 IRBlock::CalculateHash() const {
 	if (origAddr_) {
-		// This is unfortunate.  In case of emuhacks, we have to make a copy.
-		std::vector<u32> buffer;
-		buffer.resize(origSize_ / 4);
-		size_t pos = 0;
-		for (u32 off = 0; off < origSize_; off += 4) {
-			// Let's actually hash the replacement, if any.
-			MIPSOpcode instr = Memory::ReadUnchecked_Instruction(origAddr_ + off, false);
-			buffer[pos++] = instr.encoding;
-		}
-
-		return XXH3_64bits(&buffer[0], origSize_);
+		return HashMIPSRange(origAddr_, origSize_);
 	}
 
 	return 0;
@@ -494,10 +873,7 @@ bool IRBlock::OverlapsRange(u32 addr, u32 size) const {
 }
 
 MIPSOpcode IRJit::GetOriginalOp(MIPSOpcode op) {
-	IRBlock *b = blocks_.GetBlock(op.encoding & 0xFFFFFF);
-	if (b) {
-		return b->GetOriginalFirstOp();
-	}
+	// We never write block emuhacks, so this is the real op.
 	return op;
 }
 
@@ -17,16 +17,22 @@
 
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
 #include <cstring>
+#include <memory>
+#include <mutex>
 #include <unordered_map>
 
 #include "Common/Common.h"
 #include "Common/CPUDetect.h"
+#include "Core/MemMap.h"
 #include "Core/MIPS/JitCommon/JitBlockCache.h"
 #include "Core/MIPS/JitCommon/JitCommon.h"
 #include "Core/MIPS/IR/IRRegCache.h"
 #include "Core/MIPS/IR/IRInst.h"
 #include "Core/MIPS/IR/IRFrontend.h"
+#include "Core/MIPS/IR/IRInterpreter.h"
 #include "Core/MIPS/MIPSVFPUUtils.h"
 
 #ifndef offsetof
@@ -38,20 +44,27 @@ namespace MIPSComp {
 // TODO : Use arena allocators. For now let's just malloc.
 class IRBlock {
 public:
-	IRBlock() : instr_(nullptr), numInstructions_(0), origAddr_(0), origSize_(0) {}
-	IRBlock(u32 emAddr) : instr_(nullptr), numInstructions_(0), origAddr_(emAddr), origSize_(0) {}
+	IRBlock() : instr_(nullptr), handlers_(nullptr), numInstructions_(0), origAddr_(0), origSize_(0) {}
+	IRBlock(u32 emAddr) : instr_(nullptr), handlers_(nullptr), numInstructions_(0), origAddr_(emAddr), origSize_(0) {}
 	IRBlock(IRBlock &&b) {
 		instr_ = b.instr_;
+		handlers_ = b.handlers_;
 		numInstructions_ = b.numInstructions_;
 		origAddr_ = b.origAddr_;
 		origSize_ = b.origSize_;
 		origFirstOpcode_ = b.origFirstOpcode_;
 		hash_ = b.hash_;
+		executions_ = b.executions_;
+		isTrace_ = b.isTrace_;
+		profileExecutions_ = b.profileExecutions_;
+		profileTime_ = b.profileTime_;
 		b.instr_ = nullptr;
+		b.handlers_ = nullptr;
 	}
 
 	~IRBlock() {
 		delete[] instr_;
+		delete[] handlers_;
 	}
 
 	void SetInstructions(const std::vector<IRInst> &inst) {
@@ -60,50 +73,99 @@ class IRBlock {
 		if (!inst.empty()) {
 			memcpy(instr_, &inst[0], sizeof(IRInst) * inst.size());
 		}
+		// Pre-decode once here, so threaded dispatch doesn't need to look at the op at all.
+		handlers_ = new const void *[inst.size() + 1];
+		if (!IRPredecodeThreaded(instr_, numInstructions_, handlers_)) {
+			delete[] handlers_;
+			handlers_ = nullptr;
+		}
 	}
 
 	const IRInst *GetInstructions() const { return instr_; }
+	const void *const *GetThreadedHandlers() const { return handlers_; }
 	int GetNumInstructions() const { return numInstructions_; }
 	MIPSOpcode GetOriginalFirstOp() const { return origFirstOpcode_; }
-	bool HasOriginalFirstOp() const;
-	bool RestoreOriginalFirstOp(int number);
 	bool IsValid() const { return origAddr_ != 0 && origFirstOpcode_.encoding != 0x68FFFFFF; }
 	void SetOriginalSize(u32 size) {
 		origSize_ = size;
 	}
+	u32 GetOriginalSize() const {
+		return origSize_;
+	}
 	void UpdateHash() {
 		hash_ = CalculateHash();
 	}
+	u64 GetHash() const {
+		return hash_;
+	}
 	bool HashMatches() const {
 		return origAddr_ && hash_ == CalculateHash();
 	}
 	bool OverlapsRange(u32 addr, u32 size) const;
 
+	// Returns the new count.  Used to find hot blocks to build traces from.
+	u32 CountExecution() {
+		return ++executions_;
+	}
+	u32 GetExecutionCount() const {
+		return executions_;
+	}
+	void SetIsTrace(bool trace) {
+		isTrace_ = trace;
+	}
+	bool IsTrace() const {
+		return isTrace_;
+	}
+
+	void AddProfileSample(double seconds) {
+		profileExecutions_++;
+		profileTime_ += seconds;
+	}
+	void ResetProfile() {
+		profileExecutions_ = 0;
+		profileTime_ = 0.0;
+	}
+	u64 GetProfileExecutions() const {
+		return profileExecutions_;
+	}
+	double GetProfileTime() const {
+		return profileTime_;
+	}
+
 	void GetRange(u32 &start, u32 &size) const {
 		start = origAddr_;
 		size = origSize_;
 	}
 
-	void Finalize(int number);
-	void Destroy(int number);
+	void Finalize();
+	void Destroy();
 
 private:
 	u64 CalculateHash() const;
 
 	IRInst *instr_;
+	const void **handlers_;
 	u16 numInstructions_;
 	u32 origAddr_;
 	u32 origSize_;
 	u64 hash_ = 0;
+	u32 executions_ = 0;
+	bool isTrace_ = false;
+	u64 profileExecutions_ = 0;
+	double profileTime_ = 0.0;
 	MIPSOpcode origFirstOpcode_ = MIPSOpcode(0x68FFFFFF);
 };
 
 class IRBlockCache : public JitBlockCacheDebugInterface {
 public:
-	IRBlockCache() {}
+	IRBlockCache();
+	~IRBlockCache();
 	void Clear();
 	void InvalidateICache(u32 address, u32 length);
 	void FinalizeBlock(int i, bool preload = false);
+	// Makes a preloaded block runnable.  Returns false if it was invalidated meanwhile.
+	bool FinalizePreloadedBlock(int i);
+	void DestroyBlock(int i);
 	int GetNumBlocks() const override { return (int)blocks_.size(); }
 	int AllocateBlock(int emAddr) {
 		blocks_.push_back(IRBlock(emAddr));
@@ -119,23 +181,104 @@ class IRBlockCache : public JitBlockCacheDebugInterface {
 
 	int FindPreloadBlock(u32 em_address);
 
-	std::vector<u32> SaveAndClearEmuHackOps();
-	void RestoreSavedEmuHackOps(std::vector<u32> saved);
+	// The block to run at this address, or -1 if none (or the code there changed.)
+	int LookupBlock(u32 em_address) const {
+		const u32 pAddr = em_address & 0x1FFFFFFF;
+		const LookupEntry *page = lookupPages_[pAddr >> LOOKUP_PAGE_SHIFT];
+		if (!page)
+			return -1;
+		const LookupEntry &entry = page[(pAddr & LOOKUP_PAGE_MASK) >> 2];
+		if (entry.blockNum < 0 || Memory::ReadUnchecked_U32(em_address) != entry.firstOp)
+			return -1;
+		return entry.blockNum;
+	}
+
+	// Two level direct map of physical start address -> block, allocated per page on demand.
+	// Blocks are entered through this instead of writing emuhack ops into guest memory.
+	enum {
+		LOOKUP_PAGE_SHIFT = 14,
+		LOOKUP_PAGE_MASK = (1 << LOOKUP_PAGE_SHIFT) - 1,
+		LOOKUP_PAGE_ENTRIES = 1 << (LOOKUP_PAGE_SHIFT - 2),
+		LOOKUP_PAGE_COUNT = 0x20000000 >> LOOKUP_PAGE_SHIFT,
+	};
+	struct LookupEntry {
+		s32 blockNum;
+		// What was in memory when the block was compiled.  If the game overwrites it, the block is skipped.
+		u32 firstOp;
+	};
+	// The native dispatchers read this directly.  The array itself never moves.
+	const LookupEntry *const *GetLookupPages() const { return lookupPages_; }
+
+	// For the debugger, updated from the emu thread.
+	void SetCompileQueueDepth(int depth) {
+		compileQueueDepth_ = depth;
+	}
+	void RecordCompileLatency(double seconds);
 
 	JitBlockDebugInfo GetBlockDebugInfo(int blockNum) const override;
 	void ComputeStats(BlockCacheStats &bcStats) const override;
 	int GetBlockNumberFromStartAddress(u32 em_address, bool realBlocksOnly = true) const override;
 
+	bool SupportsProfiling() const override { return true; }
+	void SetProfiling(bool enable) override { profiling_ = enable; }
+	bool IsProfiling() const override { return profiling_; }
+	void ResetProfile() override;
+	JitBlockProfileStats GetBlockProfileStats(int blockNum) const override;
+
 private:
 	u32 AddressToPage(u32 addr) const;
+	void SetLookupEntry(u32 em_address, int blockNum, u32 firstOp);
+	void ClearLookupPages();
 
 	std::vector<IRBlock> blocks_;
 	std::unordered_map<u32, std::vector<int>> byPage_;
+	LookupEntry **lookupPages_ = nullptr;
+
+	// Set from the debugger thread.
+	std::atomic<bool> profiling_{};
+
+	int compileQueueDepth_ = 0;
+	int compileCount_ = 0;
+	double totalCompileLatency_ = 0.0;
+	double maxCompileLatency_ = 0.0;
+};
+
+// Optional backend that converts finished IR blocks to host code.
+class IRToNativeInterface {
+public:
+	virtual ~IRToNativeInterface() {}
+
+	// Returns false when out of code space, and the cache needs to be cleared.
+	bool CompileBlock(int blockNum, const IRInst *instructions, int count) {
+		const u8 *entry = EmitBlock(instructions, count);
+		if (!entry)
+			return false;
+		SetBlockEntry(blockNum, entry);
+		return true;
+	}
+
+	// Writes the code without making it reachable yet, so it can run while the dispatcher does.
+	// Returns nullptr when out of code space.  Calls must not overlap each other or ClearAllBlocks().
+	virtual const u8 *EmitBlock(const IRInst *instructions, int count) = 0;
+	// Only safe from the thread that runs the dispatcher.
+	virtual void SetBlockEntry(int blockNum, const u8 *entry) = 0;
+	virtual void ClearAllBlocks() = 0;
+	// Runs native blocks until downcount runs out, or a block must be compiled or interpreted.
+	virtual void RunDispatcher() = 0;
+	// Where the dispatcher finds the block number for an address, see IRBlockCache::LookupBlock().
+	virtual void SetLookupPages(const IRBlockCache::LookupEntry *const *pages) = 0;
+	// While set, each block entered by the dispatcher is timed into its IRBlock.
+	virtual void SetProfiling(IRBlockCache *blocks) = 0;
+
+	virtual bool CodeInRange(const u8 *ptr) const = 0;
+	virtual bool DescribeCodePtr(const u8 *ptr, std::string &name) const = 0;
+	virtual const u8 *GetDispatcher() const = 0;
+	virtual const u8 *GetCrashHandler() const = 0;
 };
 
 class IRJit : public JitInterface {
 public:
-	IRJit(MIPSState *mipsState);
+	IRJit(MIPSState *mipsState, IRToNativeInterface *native = nullptr);
 	virtual ~IRJit();
 
 	void DoState(PointerWrap &p) override;
@@ -153,34 +296,71 @@ class IRJit : public JitInterface {
 	JitBlockCacheDebugInterface *GetBlockCacheDebugInterface() override { return &blocks_; }
 	MIPSOpcode GetOriginalOp(MIPSOpcode op) override;
 
-	std::vector<u32> SaveAndClearEmuHackOps() override { return blocks_.SaveAndClearEmuHackOps(); }
-	void RestoreSavedEmuHackOps(std::vector<u32> saved) override { blocks_.RestoreSavedEmuHackOps(saved); }
+	// Blocks are found through IRBlockCache's lookup table, so guest memory is never patched.
+	std::vector<u32> SaveAndClearEmuHackOps() override { return std::vector<u32>(); }
+	void RestoreSavedEmuHackOps(std::vector<u32> saved) override {}
 
 	void ClearCache() override;
 	void InvalidateCacheAt(u32 em_address, int length = 4) override;
 	void UpdateFCR31() override;
 
 	bool CodeInRange(const u8 *ptr) const override {
-		return false;
+		return native_ && native_->CodeInRange(ptr);
 	}
 
-	const u8 *GetDispatcher() const override { return nullptr; }
-	const u8 *GetCrashHandler() const override { return nullptr; }
+	const u8 *GetDispatcher() const override { return native_ ? native_->GetDispatcher() : nullptr; }
+	const u8 *GetCrashHandler() const override { return native_ ? native_->GetCrashHandler() : nullptr; }
 
 	void LinkBlock(u8 *exitPoint, const u8 *checkedEntry) override;
 	void UnlinkBlock(u8 *checkedEntry, u32 originalAddress) override;
 
+	bool LoadBlockCache(const Path &filename) override;
+	bool SaveBlockCache(const Path &filename) override;
+
+	// Threaded dispatch is the default where the compiler supports it. Mainly a switch for benchmarking.
+	void SetThreadedDispatch(bool enable) { threadedDispatch_ = enable; }
+	// Approximate, counts whole blocks as they are entered.
+	u64 GetGuestInstructionCount() const { return guestInstructions_; }
+
 private:
 	bool CompileBlock(u32 em_address, std::vector<IRInst> &instructions, u32 &mipsBytes, bool preload);
+	bool CompileTrace(int block_num);
+	bool CompileNativeBlock(int block_num);
+	void RunNativeCompile(int block_num, const IRInst *instructions, int count, u32 epoch, double queuedTime);
+	void LinkNativeBlocks();
+
+	friend class IRNativeCompileTask;
 	bool ReplaceJalTo(u32 dest);
 
 	JitOptions jo;
 
 	IRFrontend frontend_;
 	IRBlockCache blocks_;
+	std::unique_ptr<IRToNativeInterface> native_;
 
 	MIPSState *mips_;
 
+	// Native code is compiled on the thread manager when possible, blocks run in the interpreter meanwhile.
+	struct NativeResult {
+		int blockNum;
+		const u8 *entry;
+		u32 epoch;
+		double queuedTime;
+	};
+	bool asyncNative_ = false;
+	// Held while emitting or clearing native code.
+	std::mutex nativeLock_;
+	std::mutex resultsLock_;
+	std::condition_variable resultsCond_;
+	std::vector<NativeResult> nativeResults_;
+	std::atomic<bool> nativeResultsReady_{};
+	std::atomic<int> nativePending_{};
+	// Bumped on every clear, so stale results get dropped.
+	std::atomic<u32> nativeEpoch_{};
+
+	bool threadedDispatch_ = true;
+	u64 guestInstructions_ = 0;
+
 	// where to write branch-likely trampolines. not used atm
 	// u32 blTrampolines_;
 	// int blTrampolineCount_;
@@ -614,6 +614,7 @@ bool PropagateConstants(const IRWriter &in, IRWriter &out, const IROptions &opts
 			break;
 
 		case IROp::Downcount:
+		case IROp::Idle:
 		case IROp::SetPCConst:
 			goto doDefault;
 
@@ -1385,3 +1386,520 @@ bool MergeLoadStore(const IRWriter &in, IRWriter &out, const IROptions &opts) {
 	}
 	return logBlocks;
 }
+
+// For liveness, registers are numbered as u32 offsets from MIPSState::r.
+// That way GPRs, FPRs, VFPU regs, temps, and the control regs all share one space.
+enum {
+	IRLIVE_FPR_BASE = 32,
+	IRLIVE_COUNT = 32 + 256,
+};
+
+static bool IsLivenessTemp(int reg) {
+	// GPR temps (t[]) and VFPU temps (vt[]) don't survive past the end of the block.
+	return (reg >= IRTEMP_0 && reg < IRREG_VFPU_CTRL_BASE) || (reg >= IRLIVE_FPR_BASE + IRVTEMP_PFX_S && reg < IRLIVE_FPR_BASE + IRVTEMP_PFX_S + 16);
+}
+
+static void AddLivenessRegs(char type, int reg, int *regs, int &count) {
+	switch (type) {
+	case 'G':
+		regs[count++] = reg;
+		break;
+	case 'F':
+		regs[count++] = IRLIVE_FPR_BASE + reg;
+		break;
+	case '2':
+		for (int i = 0; i < 2; ++i)
+			regs[count++] = IRLIVE_FPR_BASE + reg + i;
+		break;
+	case 'V':
+		for (int i = 0; i < 4; ++i)
+			regs[count++] = IRLIVE_FPR_BASE + reg + i;
+		break;
+	case 'T':
+		regs[count++] = IRREG_VFPU_CTRL_BASE + reg;
+		break;
+	default:
+		break;
+	}
+}
+
+bool RemoveDeadStores(const IRWriter &in, IRWriter &out, const IROptions &opts) {
+	CONDITIONAL_DISABLE;
+	const std::vector<IRInst> &insts = in.GetInstructions();
+	std::vector<bool> keep(insts.size(), true);
+
+	// Walking backwards, a register is live if something later may read it.
+	// Everything but temps is read by whatever runs after the block.
+	bool live[IRLIVE_COUNT];
+	for (int r = 0; r < IRLIVE_COUNT; ++r)
+		live[r] = !IsLivenessTemp(r);
+
+	for (int i = (int)insts.size() - 1; i >= 0; --i) {
+		const IRInst &inst = insts[i];
+		const IRMeta *m = GetIRMeta(inst.op);
+
+		int reads[16];
+		int numReads = 0;
+		int writes[4];
+		int numWrites = 0;
+		// Only instructions whose sole effect is writing their dest can be removed.
+		bool removable = (m->flags & (IRFLAG_SRC3 | IRFLAG_EXIT)) == 0;
+		bool barrier = (m->flags & IRFLAG_EXIT) != 0;
+
+		if ((m->flags & IRFLAG_SRC3) != 0) {
+			AddLivenessRegs(m->types[0], inst.src3, reads, numReads);
+		} else {
+			AddLivenessRegs(m->types[0], inst.dest, writes, numWrites);
+			if ((m->flags & IRFLAG_SRC3DST) != 0)
+				AddLivenessRegs(m->types[0], inst.dest, reads, numReads);
+		}
+		AddLivenessRegs(m->types[1], inst.src1, reads, numReads);
+		AddLivenessRegs(m->types[2], inst.src2, reads, numReads);
+
+		// Now the state these ops touch that isn't in their operands.
+		switch (inst.op) {
+		case IROp::MfLo:
+			reads[numReads++] = IRREG_LO;
+			break;
+		case IROp::MfHi:
+			reads[numReads++] = IRREG_HI;
+			break;
+		case IROp::FpCondToReg:
+			reads[numReads++] = IRREG_FPCOND;
+			break;
+		case IROp::VfpuCtrlToReg:
+			reads[numReads++] = IRREG_VFPU_CTRL_BASE + inst.src1;
+			break;
+		case IROp::FCvtWS:
+			reads[numReads++] = IRREG_FCR31;
+			break;
+		case IROp::FCmovVfpuCC:
+			// Only conditionally writes dest.
+			reads[numReads++] = IRREG_VFPU_CC;
+			reads[numReads++] = IRLIVE_FPR_BASE + inst.dest;
+			break;
+		case IROp::Madd:
+		case IROp::MaddU:
+		case IROp::Msub:
+		case IROp::MsubU:
+			reads[numReads++] = IRREG_LO;
+			reads[numReads++] = IRREG_HI;
+			break;
+		case IROp::FCmpVfpuBit:
+		case IROp::FCmpVfpuAggregate:
+			reads[numReads++] = IRREG_VFPU_CC;
+			break;
+		case IROp::RestoreRoundingMode:
+		case IROp::ApplyRoundingMode:
+		case IROp::UpdateRoundingMode:
+			reads[numReads++] = IRREG_FCR31;
+			break;
+
+		case IROp::Interpret:
+		case IROp::CallReplacement:
+		case IROp::Syscall:
+		case IROp::SetPC:
+		case IROp::SetPCConst:
+		case IROp::Downcount:
+			barrier = true;
+			break;
+
+		default:
+			break;
+		}
+
+		// These write state we don't track (like lo/hi or fpcond), so they must stay.
+		if (numWrites == 0)
+			removable = false;
+
+		if (removable) {
+			bool anyLive = false;
+			for (int j = 0; j < numWrites; ++j)
+				anyLive = anyLive || live[writes[j]];
+			if (!anyLive) {
+				keep[i] = false;
+				continue;
+			}
+		}
+
+		for (int j = 0; j < numWrites; ++j)
+			live[writes[j]] = false;
+		for (int j = 0; j < numReads; ++j)
+			live[reads[j]] = true;
+		if (barrier) {
+			// Anything could read the architectural state here, just not temps.
+			for (int r = 0; r < IRLIVE_COUNT; ++r)
+				live[r] = live[r] || !IsLivenessTemp(r);
+		}
+	}
+
+	for (size_t i = 0; i < insts.size(); ++i) {
+		if (keep[i])
+			out.Write(insts[i]);
+	}
+	return false;
+}
+
+// These may write any register, so nothing known about register values survives them.
+static bool IRClobbersAllRegs(IROp op) {
+	return op == IROp::Interpret || op == IROp::CallReplacement || op == IROp::Syscall;
+}
+
+static bool IsCSECandidate(IROp op) {
+	switch (op) {
+	case IROp::Add:
+	case IROp::Sub:
+	case IROp::And:
+	case IROp::Or:
+	case IROp::Xor:
+	case IROp::AddConst:
+	case IROp::SubConst:
+	case IROp::AndConst:
+	case IROp::OrConst:
+	case IROp::XorConst:
+	case IROp::Shl:
+	case IROp::Shr:
+	case IROp::Sar:
+	case IROp::ShlImm:
+	case IROp::ShrImm:
+	case IROp::SarImm:
+	case IROp::Slt:
+	case IROp::SltU:
+	case IROp::SltConst:
+	case IROp::SltUConst:
+		return true;
+	default:
+		return false;
+	}
+}
+
+static bool IsCommutative(IROp op) {
+	return op == IROp::Add || op == IROp::And || op == IROp::Or || op == IROp::Xor;
+}
+
+bool EliminateCommonSubexpressions(const IRWriter &in, IRWriter &out, const IROptions &opts) {
+	CONDITIONAL_DISABLE;
+
+	// Local value numbering: each GPR holds a numbered value, and each computed expression
+	// is keyed on the value numbers of its sources, so copies and in-place updates still match.
+	struct Expr {
+		IROp op;
+		u32 src1;
+		u32 src2;
+		u32 constant;
+		u32 result;
+	};
+	std::vector<Expr> exprs;
+	u32 valueOf[256];
+	for (int r = 0; r < 256; ++r)
+		valueOf[r] = r;
+	u32 nextValue = 256;
+
+	bool logBlocks = false;
+	for (IRInst inst : in.GetInstructions()) {
+		const IRMeta *m = GetIRMeta(inst.op);
+
+		if (IRClobbersAllRegs(inst.op)) {
+			exprs.clear();
+			for (int r = 0; r < 256; ++r)
+				valueOf[r] = nextValue++;
+			out.Write(inst);
+			continue;
+		}
+
+		int dest = IRDestGPR(inst);
+		if (inst.op == IROp::Mov && dest != MIPS_REG_ZERO) {
+			valueOf[dest] = valueOf[inst.src1];
+			out.Write(inst);
+			continue;
+		}
+		if (!IsCSECandidate(inst.op) || dest == MIPS_REG_ZERO) {
+			if (dest >= 0)
+				valueOf[dest] = nextValue++;
+			out.Write(inst);
+			continue;
+		}
+
+		Expr key{ inst.op, valueOf[inst.src1], 0, 0, 0 };
+		if (m->types[2] == 'G')
+			key.src2 = valueOf[inst.src2];
+		else if (m->types[2] == 'I')
+			key.src2 = inst.src2;
+		else if (m->types[2] == 'C')
+			key.constant = inst.constant;
+		if (IsCommutative(inst.op) && key.src1 > key.src2)
+			std::swap(key.src1, key.src2);
+
+		const Expr *found = nullptr;
+		for (const Expr &e : exprs) {
+			if (e.op == key.op && e.src1 == key.src1 && e.src2 == key.src2 && e.constant == key.constant) {
+				found = &e;
+				break;
+			}
+		}
+
+		if (!found) {
+			key.result = nextValue++;
+			exprs.push_back(key);
+			valueOf[dest] = key.result;
+			out.Write(inst);
+			continue;
+		}
+
+		if (valueOf[dest] == found->result) {
+			// Already holds this value, nothing to do.
+			continue;
+		}
+
+		// If some register still holds the value, just copy it.
+		int holder = -1;
+		for (int r = 0; r < 256; ++r) {
+			if (valueOf[r] == found->result) {
+				holder = r;
+				break;
+			}
+		}
+		if (holder >= 0) {
+			inst.op = IROp::Mov;
+			inst.src1 = holder;
+			inst.src2 = 0;
+			inst.constant = 0;
+		}
+		valueOf[dest] = found->result;
+		out.Write(inst);
+	}
+	return logBlocks;
+}
+
+// What a VFPU prefix temp lane is known to hold, relative to a source FPR.
+enum class PrefixForm : u8 {
+	UNKNOWN,
+	COPY,
+	NEG,
+	ABS,
+};
+
+struct PrefixLane {
+	PrefixForm form;
+	u8 src;
+};
+
+static bool IsPrefixTemp(int freg) {
+	return freg >= IRVTEMP_PFX_S && freg < IRVTEMP_PFX_D + 4;
+}
+
+bool FoldVFPUPrefixes(const IRWriter &in, IRWriter &out, const IROptions &opts) {
+	CONDITIONAL_DISABLE;
+
+	// The S and T prefixes are applied by writing to temps before the op reads them.
+	// We track what those temps hold, and read the originals directly where we can.
+	// The temp writes themselves are left for RemoveDeadStores to clean up.
+	PrefixLane lanes[IRVTEMP_PFX_D + 4 - IRVTEMP_PFX_S]{};
+	auto laneOf = [&](int freg) -> PrefixLane {
+		if (!IsPrefixTemp(freg))
+			return PrefixLane{ PrefixForm::UNKNOWN, 0 };
+		return lanes[freg - IRVTEMP_PFX_S];
+	};
+
+	// Returns true if all four lanes have the same form, with sources in one aligned vector.
+	auto vecOf = [&](int freg, PrefixForm &form, u8 &src) {
+		PrefixLane first = laneOf(freg);
+		if (first.form == PrefixForm::UNKNOWN || (first.src & 3) != 0)
+			return false;
+		for (int i = 1; i < 4; ++i) {
+			PrefixLane lane = laneOf(freg + i);
+			if (lane.form != first.form || lane.src != first.src + i)
+				return false;
+		}
+		form = first.form;
+		src = first.src;
+		return true;
+	};
+
+	// Returns the original if freg is a known copy.
+	auto copySrc = [&](u8 freg) -> u8 {
+		PrefixLane lane = laneOf(freg);
+		return lane.form == PrefixForm::COPY ? lane.src : freg;
+	};
+	auto copySrcVec = [&](u8 freg) -> u8 {
+		PrefixForm form;
+		u8 src;
+		if (IsPrefixTemp(freg) && vecOf(freg, form, src) && form == PrefixForm::COPY)
+			return src;
+		return freg;
+	};
+
+	bool logBlocks = false;
+	for (IRInst inst : in.GetInstructions()) {
+		const IRMeta *m = GetIRMeta(inst.op);
+
+		// First, substitute plain copies for any operand.
+		if (m->types[1] == 'F')
+			inst.src1 = copySrc(inst.src1);
+		else if (m->types[1] == 'V')
+			inst.src1 = copySrcVec(inst.src1);
+		if (m->types[2] == 'F')
+			inst.src2 = copySrc(inst.src2);
+		else if (m->types[2] == 'V')
+			inst.src2 = copySrcVec(inst.src2);
+		if ((m->flags & IRFLAG_SRC3) != 0 && m->types[0] == 'F')
+			inst.src3 = copySrc(inst.src3);
+		else if ((m->flags & IRFLAG_SRC3) != 0 && m->types[0] == 'V')
+			inst.src3 = copySrcVec(inst.src3);
+
+		// Then fold negate and abs into the op reading them.
+		PrefixLane lane1 = laneOf(inst.src1);
+		PrefixLane lane2 = laneOf(inst.src2);
+		PrefixForm vform1 = PrefixForm::UNKNOWN, vform2 = PrefixForm::UNKNOWN;
+		u8 vsrc1 = 0, vsrc2 = 0;
+		if (m->types[1] == 'V')
+			vecOf(inst.src1, vform1, vsrc1);
+		if (m->types[2] == 'V')
+			vecOf(inst.src2, vform2, vsrc2);
+
+		switch (inst.op) {
+		case IROp::FAdd:
+			// x + -y = x - y, either way around.
+			if (lane2.form == PrefixForm::NEG && lane1.form != PrefixForm::NEG) {
+				inst.op = IROp::FSub;
+				inst.src2 = lane2.src;
+			} else if (lane1.form == PrefixForm::NEG && lane2.form != PrefixForm::NEG) {
+				inst.op = IROp::FSub;
+				inst.src1 = inst.src2;
+				inst.src2 = lane1.src;
+			}
+			break;
+		case IROp::FSub:
+			if (lane2.form == PrefixForm::NEG) {
+				inst.op = IROp::FAdd;
+				inst.src2 = lane2.src;
+			}
+			break;
+		case IROp::FMov:
+			if (lane1.form == PrefixForm::NEG) {
+				inst.op = IROp::FNeg;
+				inst.src1 = lane1.src;
+			} else if (lane1.form == PrefixForm::ABS) {
+				inst.op = IROp::FAbs;
+				inst.src1 = lane1.src;
+			}
+			break;
+		case IROp::FNeg:
+			if (lane1.form == PrefixForm::NEG) {
+				inst.op = IROp::FMov;
+				inst.src1 = lane1.src;
+			}
+			break;
+		case IROp::Vec4Add:
+			if (vform2 == PrefixForm::NEG && vform1 != PrefixForm::NEG) {
+				inst.op = IROp::Vec4Sub;
+				inst.src2 = vsrc2;
+			} else if (vform1 == PrefixForm::NEG && vform2 != PrefixForm::NEG) {
+				inst.op = IROp::Vec4Sub;
+				inst.src1 = inst.src2;
+				inst.src2 = vsrc1;
+			}
+			break;
+		case IROp::Vec4Sub:
+			if (vform2 == PrefixForm::NEG) {
+				inst.op = IROp::Vec4Add;
+				inst.src2 = vsrc2;
+			}
+			break;
+		case IROp::Vec4Mov:
+			if (vform1 == PrefixForm::NEG) {
+				inst.op = IROp::Vec4Neg;
+				inst.src1 = vsrc1;
+			} else if (vform1 == PrefixForm::ABS) {
+				inst.op = IROp::Vec4Abs;
+				inst.src1 = vsrc1;
+			} else if (vform1 == PrefixForm::UNKNOWN && IsPrefixTemp(inst.src1)) {
+				// Maybe it's a swizzle of a single vector, which we can do in one go.
+				u8 shuffle = 0;
+				u8 base = laneOf(inst.src1).src & ~3;
+				// Vec4Shuffle writes lanes as it goes, so it can't read the vector it's writing.
+				bool canShuffle = inst.dest + 4 <= base || inst.dest >= base + 4;
+				for (int i = 0; canShuffle && i < 4; ++i) {
+					PrefixLane lane = laneOf(inst.src1 + i);
+					if (lane.form != PrefixForm::COPY || (lane.src & ~3) != base) {
+						canShuffle = false;
+						break;
+					}
+					shuffle |= (lane.src & 3) << (i * 2);
+				}
+				if (canShuffle) {
+					inst.op = IROp::Vec4Shuffle;
+					inst.src1 = base;
+					inst.src2 = shuffle;
+				}
+			}
+			break;
+		case IROp::Vec4Neg:
+			if (vform1 == PrefixForm::NEG) {
+				inst.op = IROp::Vec4Mov;
+				inst.src1 = vsrc1;
+			}
+			break;
+		default:
+			break;
+		}
+
+		// Forget anything that depends on a register this writes.
+		int firstWrite = -1;
+		int numWrites = 0;
+		if ((m->flags & IRFLAG_SRC3) == 0) {
+			switch (m->types[0]) {
+			case 'F': firstWrite = inst.dest; numWrites = 1; break;
+			case '2': firstWrite = inst.dest; numWrites = 2; break;
+			case 'V': firstWrite = inst.dest; numWrites = 4; break;
+			default: break;
+			}
+		}
+		if (IRClobbersAllRegs(inst.op)) {
+			for (PrefixLane &lane : lanes)
+				lane.form = PrefixForm::UNKNOWN;
+		}
+		for (int w = firstWrite; w < firstWrite + numWrites; ++w) {
+			for (int t = 0; t < (int)ARRAY_SIZE(lanes); ++t) {
+				if (IRVTEMP_PFX_S + t == w || (lanes[t].form != PrefixForm::UNKNOWN && lanes[t].src == w))
+					lanes[t].form = PrefixForm::UNKNOWN;
+			}
+		}
+
+		// And finally, remember what a prefix temp now holds.
+		if (numWrites != 0 && IsPrefixTemp(inst.dest)) {
+			int base = inst.dest - IRVTEMP_PFX_S;
+			switch (inst.op) {
+			case IROp::FMov:
+			case IROp::FNeg:
+			case IROp::FAbs:
+				if (inst.src1 != inst.dest) {
+					PrefixForm form = inst.op == IROp::FMov ? PrefixForm::COPY : (inst.op == IROp::FNeg ? PrefixForm::NEG : PrefixForm::ABS);
+					lanes[base] = PrefixLane{ form, inst.src1 };
+				}
+				break;
+			case IROp::Vec4Mov:
+			case IROp::Vec4Neg:
+			case IROp::Vec4Abs:
+			case IROp::Vec4Shuffle:
+				if (inst.src1 + 3 < inst.dest || inst.src1 > inst.dest + 3) {
+					PrefixForm form = PrefixForm::COPY;
+					if (inst.op == IROp::Vec4Neg)
+						form = PrefixForm::NEG;
+					else if (inst.op == IROp::Vec4Abs)
+						form = PrefixForm::ABS;
+					for (int i = 0; i < 4 && base + i < (int)ARRAY_SIZE(lanes); ++i) {
+						int sel = inst.op == IROp::Vec4Shuffle ? (inst.src2 >> (i * 2)) & 3 : i;
+						lanes[base + i] = PrefixLane{ form, (u8)(inst.src1 + sel) };
+					}
+				}
+				break;
+			default:
+				break;
+			}
+		}
+
+		out.Write(inst);
+	}
+	return logBlocks;
+}
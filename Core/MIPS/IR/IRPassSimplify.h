@@ -14,3 +14,6 @@ bool ThreeOpToTwoOp(const IRWriter &in, IRWriter &out, const IROptions &opts);
 bool OptimizeFPMoves(const IRWriter &in, IRWriter &out, const IROptions &opts);
 bool ReorderLoadStore(const IRWriter &in, IRWriter &out, const IROptions &opts);
 bool MergeLoadStore(const IRWriter &in, IRWriter &out, const IROptions &opts);
+bool RemoveDeadStores(const IRWriter &in, IRWriter &out, const IROptions &opts);
+bool EliminateCommonSubexpressions(const IRWriter &in, IRWriter &out, const IROptions &opts);
+bool FoldVFPUPrefixes(const IRWriter &in, IRWriter &out, const IROptions &opts);
@@ -30,6 +30,8 @@
 #include "Core/CoreTiming.h"
 #include "Core/Reporting.h"
 
+#include "Common/StringUtils.h"
+#include "Core/Debugger/SymbolMap.h"
 #include "Core/MIPS/MIPS.h"
 #include "Core/MIPS/MIPSTables.h"
 #include "Core/MIPS/MIPSAnalyst.h"
@@ -82,6 +84,7 @@ void JitBlockCache::Init() {
 	agent = op_open_agent();
 #endif
 	blocks_ = new JitBlock[MAX_NUM_BLOCKS];
+	lookupPages_ = new LookupPage *[LOOKUP_PAGE_COUNT]();
 	Clear();
 }
 
@@ -89,6 +92,8 @@ void JitBlockCache::Shutdown() {
 	Clear(); // Make sure proxy block links are deleted
 	delete [] blocks_;
 	blocks_ = 0;
+	delete [] lookupPages_;
+	lookupPages_ = nullptr;
 	num_blocks_ = 0;
 #if defined USE_OPROFILE && USE_OPROFILE
 	op_close_agent(agent);
@@ -108,6 +113,7 @@ void JitBlockCache::Clear() {
 		DestroyBlock(i, DestroyType::CLEAR);
 	links_to_.clear();
 	num_blocks_ = 0;
+	ClearLookupPages();
 
 	blockMemRanges_[JITBLOCK_RANGE_SCRATCH] = std::make_pair(0xFFFFFFFF, 0x00000000);
 	blockMemRanges_[JITBLOCK_RANGE_RAMBOTTOM] = std::make_pair(0xFFFFFFFF, 0x00000000);
@@ -198,7 +204,10 @@ void JitBlockCache::AddBlockMap(int block_num) {
 	// Convert the logical address to a physical address for the block map
 	// Yeah, this'll work fine for PSP too I think.
 	u32 pAddr = b.originalAddress & 0x1FFFFFFF;
-	block_map_[std::make_pair(pAddr + 4 * b.originalSize, pAddr)] = block_num;
+	auto key = std::make_pair(pAddr + 4 * b.originalSize, pAddr);
+	if (block_map_.find(key) == block_map_.end())
+		AdjustLookupBlockCounts(key.second, key.first, 1);
+	block_map_[key] = block_num;
 }
 
 void JitBlockCache::RemoveBlockMap(int block_num) {
@@ -210,11 +219,13 @@ void JitBlockCache::RemoveBlockMap(int block_num) {
 	const u32 pAddr = b.originalAddress & 0x1FFFFFFF;
 	auto it = block_map_.find(std::make_pair(pAddr + 4 * b.originalSize, pAddr));
 	if (it != block_map_.end() && it->second == (u32)block_num) {
+		AdjustLookupBlockCounts(it->first.second, it->first.first, -1);
 		block_map_.erase(it);
 	} else {
 		// It wasn't in there, or it has the wrong key.  Let's search...
 		for (auto it = block_map_.begin(); it != block_map_.end(); ++it) {
 			if (it->second == (u32)block_num) {
+				AdjustLookupBlockCounts(it->first.second, it->first.first, -1);
 				block_map_.erase(it);
 				break;
 			}
@@ -222,6 +233,60 @@ void JitBlockCache::RemoveBlockMap(int block_num) {
 	}
 }
 
+JitBlockCache::LookupPage *JitBlockCache::GetLookupPage(u32 pAddr, bool create) {
+	u32 index = (pAddr & 0x1FFFFFFF) >> LOOKUP_PAGE_SHIFT;
+	LookupPage *page = lookupPages_[index];
+	if (!page && create) {
+		page = new LookupPage;
+		std::fill(page->blockNum, page->blockNum + LOOKUP_PAGE_WORDS, -1);
+		page->numBlocks = 0;
+		lookupPages_[index] = page;
+	}
+	return page;
+}
+
+int JitBlockCache::LookupBlockNum(u32 em_address) const {
+	const u32 pAddr = em_address & 0x1FFFFFFF;
+	const LookupPage *page = lookupPages_[pAddr >> LOOKUP_PAGE_SHIFT];
+	if (!page)
+		return -1;
+	return page->blockNum[(pAddr & ((1 << LOOKUP_PAGE_SHIFT) - 1)) >> 2];
+}
+
+void JitBlockCache::SetLookupBlockNum(u32 em_address, int block_num) {
+	const u32 pAddr = em_address & 0x1FFFFFFF;
+	LookupPage *page = GetLookupPage(pAddr, block_num >= 0);
+	if (page)
+		page->blockNum[(pAddr & ((1 << LOOKUP_PAGE_SHIFT) - 1)) >> 2] = block_num;
+}
+
+void JitBlockCache::AdjustLookupBlockCounts(u32 pStart, u32 pEnd, int delta) {
+	const u32 last = std::min((pEnd > pStart ? pEnd - 1 : pStart) >> LOOKUP_PAGE_SHIFT, (u32)LOOKUP_PAGE_COUNT - 1);
+	for (u32 index = pStart >> LOOKUP_PAGE_SHIFT; index <= last; ++index) {
+		LookupPage *page = GetLookupPage(index << LOOKUP_PAGE_SHIFT, true);
+		page->numBlocks += delta;
+	}
+}
+
+bool JitBlockCache::RangeHasBlocks(u32 pStart, u32 pEnd) const {
+	const u32 last = std::min((pEnd > pStart ? pEnd - 1 : pStart) >> LOOKUP_PAGE_SHIFT, (u32)LOOKUP_PAGE_COUNT - 1);
+	for (u32 index = pStart >> LOOKUP_PAGE_SHIFT; index <= last; ++index) {
+		const LookupPage *page = lookupPages_[index];
+		if (page && page->numBlocks != 0)
+			return true;
+	}
+	return false;
+}
+
+void JitBlockCache::ClearLookupPages() {
+	if (!lookupPages_)
+		return;
+	for (int i = 0; i < LOOKUP_PAGE_COUNT; ++i) {
+		delete lookupPages_[i];
+		lookupPages_[i] = nullptr;
+	}
+}
+
 static void ExpandRange(std::pair<u32, u32> &range, u32 newStart, u32 newEnd) {
 	range.first = std::min(range.first, newStart);
 	range.second = std::max(range.second, newEnd);
@@ -233,6 +298,7 @@ void JitBlockCache::FinalizeBlock(int block_num, bool block_link) {
 	b.originalFirstOpcode = Memory::Read_Opcode_JIT(b.originalAddress);
 	MIPSOpcode opcode = GetEmuHackOpForBlock(block_num);
 	Memory::Write_Opcode_JIT(b.originalAddress, opcode);
+	SetLookupBlockNum(b.originalAddress, block_num);
 
 	AddBlockMap(block_num);
 
@@ -334,8 +400,10 @@ int JitBlockCache::GetBlockNumberFromStartAddress(u32 addr, bool realBlocksOnly)
 	if (!blocks_ || !Memory::IsValidAddress(addr))
 		return -1;
 
-	MIPSOpcode inst = MIPSOpcode(Memory::Read_U32(addr));
-	int bl = GetBlockNumberFromEmuHackOp(inst);
+	int bl = LookupBlockNum(addr);
+	// The dispatchers still enter through the emuhack op, so if that was overwritten, the block is gone.
+	if (bl >= 0 && (blocks_[bl].invalid || Memory::ReadUnchecked_U32(addr) != GetEmuHackOpForBlock(bl).encoding))
+		bl = -1;
 	if (bl < 0) {
 		if (!realBlocksOnly) {
 			// Wasn't an emu hack op, look through proxyBlockMap_.
@@ -526,6 +594,8 @@ void JitBlockCache::DestroyBlock(int block_num, DestroyType type) {
 	if (!b->IsPureProxy()) {
 		if (Memory::ReadUnchecked_U32(b->originalAddress) == GetEmuHackOpForBlock(block_num).encoding)
 			Memory::Write_Opcode_JIT(b->originalAddress, b->originalFirstOpcode);
+		if (LookupBlockNum(b->originalAddress) == block_num)
+			SetLookupBlockNum(b->originalAddress, -1);
 	}
 
 	// It's not safe to set normalEntry to 0 here, since we use a binary search
@@ -564,20 +634,25 @@ void JitBlockCache::InvalidateICache(u32 address, const u32 length) {
 		return;
 	}
 
+	// Most invalidations (like DMA and file reads) hit pages without any code.
+	if (!RangeHasBlocks(pAddr, pEnd))
+		return;
+
 	// Blocks may start and end in overlapping ways, and destroying one invalidates iterators.
-	// So after destroying one, we start over.
+	// So after destroying one, we search again from where it was.
+	std::pair<u32, u32> from = std::make_pair(pAddr, 0);
 	do {
 	restart:
-		auto next = block_map_.lower_bound(std::make_pair(pAddr, 0));
+		auto next = block_map_.lower_bound(from);
 		auto last = block_map_.upper_bound(std::make_pair(pEnd + MAX_BLOCK_INSTRUCTIONS, 0));
 		// Note that if next is end(), last will be end() too (equal.)
 		for (; next != last; ++next) {
 			const u32 blockStart = next->first.second;
 			const u32 blockEnd = next->first.first;
 			if (blockStart < pEnd && blockEnd > pAddr) {
+				from = next->first;
 				DestroyBlock(next->second, DestroyType::INVALIDATE);
 				// Our iterator is now invalid.  Break and search again.
-				// Most of the time there shouldn't be a bunch of matching blocks.
 				goto restart;
 			}
 		}
@@ -664,3 +739,34 @@ JitBlockDebugInfo JitBlockCache::GetBlockDebugInfo(int blockNum) const {
 
 	return debugInfo;
 }
+
+std::vector<JitBlockProfileResult> JitBlockProfileTop(const JitBlockCacheDebugInterface *blockCache, int count) {
+	std::vector<JitBlockProfileResult> results;
+	if (!blockCache || !blockCache->SupportsProfiling())
+		return results;
+
+	for (int i = 0; i < blockCache->GetNumBlocks(); ++i) {
+		JitBlockProfileStats stats = blockCache->GetBlockProfileStats(i);
+		if (stats.executions != 0)
+			results.push_back({ i, stats, "" });
+	}
+
+	size_t n = std::min((size_t)std::max(count, 0), results.size());
+	std::partial_sort(results.begin(), results.begin() + n, results.end(), [](const JitBlockProfileResult &a, const JitBlockProfileResult &b) {
+		return a.stats.hostTime > b.stats.hostTime;
+	});
+	results.resize(n);
+
+	for (JitBlockProfileResult &result : results) {
+		u32 addr = result.stats.originalAddress;
+		u32 funcStart = g_symbolMap ? g_symbolMap->GetFunctionStart(addr) : SymbolMap::INVALID_ADDRESS;
+		if (funcStart == SymbolMap::INVALID_ADDRESS) {
+			result.symbol = StringFromFormat("%08x", addr);
+		} else if (funcStart == addr) {
+			result.symbol = g_symbolMap->GetLabelString(funcStart);
+		} else {
+			result.symbol = StringFromFormat("%s+0x%x", g_symbolMap->GetLabelString(funcStart).c_str(), addr - funcStart);
+		}
+	}
+	return results;
+}
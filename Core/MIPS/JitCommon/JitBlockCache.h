@@ -42,6 +42,10 @@ struct BlockCacheStats {
 	float maxBloat;
 	u32 maxBloatBlock;
 	std::map<float, u32> bloatMap;
+	// Only for jits that compile in the background.
+	int compileQueueDepth = 0;
+	double avgCompileLatency = 0.0;
+	double maxCompileLatency = 0.0;
 };
 
 enum class DestroyType {
@@ -101,6 +105,14 @@ struct JitBlockDebugInfo {
 	std::vector<std::string> targetDisasm;
 };
 
+struct JitBlockProfileStats {
+	u32 originalAddress;
+	u32 originalSize;
+	u64 executions;
+	// In seconds, includes the profiling overhead.
+	double hostTime;
+};
+
 class JitBlockCacheDebugInterface {
 public:
 	virtual int GetNumBlocks() const = 0;
@@ -108,9 +120,26 @@ class JitBlockCacheDebugInterface {
 	virtual JitBlockDebugInfo GetBlockDebugInfo(int blockNum) const = 0;
 	virtual void ComputeStats(BlockCacheStats &bcStats) const = 0;
 
+	// Optional instrumentation, counts block entries and time spent while enabled.
+	virtual bool SupportsProfiling() const { return false; }
+	virtual void SetProfiling(bool enable) {}
+	virtual bool IsProfiling() const { return false; }
+	virtual void ResetProfile() {}
+	virtual JitBlockProfileStats GetBlockProfileStats(int blockNum) const { return JitBlockProfileStats{}; }
+
 	virtual ~JitBlockCacheDebugInterface() {}
 };
 
+struct JitBlockProfileResult {
+	int blockNum;
+	JitBlockProfileStats stats;
+	// Containing function and offset, from the symbol map.
+	std::string symbol;
+};
+
+// Hottest blocks by host time first.
+std::vector<JitBlockProfileResult> JitBlockProfileTop(const JitBlockCacheDebugInterface *blockCache, int count);
+
 class JitBlockCache : public JitBlockCacheDebugInterface {
 public:
 	JitBlockCache(MIPSState *mipsState, CodeBlockCommon *codeBlock);
@@ -177,6 +206,14 @@ class JitBlockCache : public JitBlockCacheDebugInterface {
 	void AddBlockMap(int block_num);
 	void RemoveBlockMap(int block_num);
 
+	struct LookupPage;
+	LookupPage *GetLookupPage(u32 pAddr, bool create);
+	int LookupBlockNum(u32 em_address) const;
+	void SetLookupBlockNum(u32 em_address, int block_num);
+	void AdjustLookupBlockCounts(u32 pStart, u32 pEnd, int delta);
+	bool RangeHasBlocks(u32 pStart, u32 pEnd) const;
+	void ClearLookupPages();
+
 	MIPSOpcode GetEmuHackOpForBlock(int block_num) const;
 
 	CodeBlockCommon *codeBlock_;
@@ -195,6 +232,19 @@ class JitBlockCache : public JitBlockCacheDebugInterface {
 	};
 	std::pair<u32, u32> blockMemRanges_[3];
 
+	// Two level direct map of physical start address -> block number, allocated per page on demand.
+	enum {
+		LOOKUP_PAGE_SHIFT = 14,
+		LOOKUP_PAGE_WORDS = 1 << (LOOKUP_PAGE_SHIFT - 2),
+		LOOKUP_PAGE_COUNT = 0x20000000 >> LOOKUP_PAGE_SHIFT,
+	};
+	struct LookupPage {
+		s32 blockNum[LOOKUP_PAGE_WORDS];
+		// Blocks (and proxies) overlapping this page, so invalidation can skip untouched ranges.
+		int numBlocks;
+	};
+	LookupPage **lookupPages_ = nullptr;
+
 	enum {
 		MAX_NUM_BLOCKS = 65536*2
 	};
@@ -38,6 +38,7 @@
 #include "../ARM64/Arm64Jit.h"
 #elif PPSSPP_ARCH(X86) || PPSSPP_ARCH(AMD64)
 #include "../x86/Jit.h"
+#include "../x86/IRToX86.h"
 #elif PPSSPP_ARCH(MIPS)
 #include "../MIPS/MipsJit.h"
 #else
@@ -78,6 +79,14 @@ namespace MIPSComp {
 #endif
 	}
 
+	JitInterface *CreateNativeIRJit(MIPSState *mipsState) {
+#if PPSSPP_ARCH(AMD64)
+		return new MIPSComp::IRJit(mipsState, new MIPSComp::IRToX86(mipsState));
+#else
+		return new MIPSComp::IRJit(mipsState);
+#endif
+	}
+
 }
 #if PPSSPP_PLATFORM(WINDOWS) && !defined(__LIBRETRO__)
 #define DISASM_ALL 1
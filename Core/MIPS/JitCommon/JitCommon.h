@@ -32,6 +32,7 @@ std::vector<std::string> DisassembleX86(const u8 *data, int size);
 struct JitBlock;
 class JitBlockCache;
 class JitBlockCacheDebugInterface;
+class Path;
 class PointerWrap;
 
 #ifdef USING_QT_UI
@@ -139,6 +140,11 @@ namespace MIPSComp {
 		virtual void UpdateFCR31() = 0;
 		virtual MIPSOpcode GetOriginalOp(MIPSOpcode op) = 0;
 
+		// Persistent cache of compiled blocks.  Blocks are only used if they still match memory.
+		// Returns false if not supported or the file couldn't be used.
+		virtual bool LoadBlockCache(const Path &filename) { return false; }
+		virtual bool SaveBlockCache(const Path &filename) { return false; }
+
 		// No jit operations may be run between these calls.
 		// Meant to be used to make memory safe for savestates, memcpy, etc.
 		virtual std::vector<u32> SaveAndClearEmuHackOps() = 0;
@@ -158,4 +164,6 @@ namespace MIPSComp {
 	void DoDummyJitState(PointerWrap &p);
 
 	JitInterface *CreateNativeJit(MIPSState *mipsState);
+	// IR frontend with a native backend where available, otherwise just the IR interpreter.
+	JitInterface *CreateNativeIRJit(MIPSState *mipsState);
 }
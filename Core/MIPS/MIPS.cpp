@@ -213,6 +213,8 @@ void MIPSState::Init() {
 		MIPSComp::jit = MIPSComp::CreateNativeJit(this);
 	} else if (PSP_CoreParameter().cpuCore == CPUCore::IR_JIT) {
 		MIPSComp::jit = new MIPSComp::IRJit(this);
+	} else if (PSP_CoreParameter().cpuCore == CPUCore::JIT_IR) {
+		MIPSComp::jit = MIPSComp::CreateNativeIRJit(this);
 	} else {
 		MIPSComp::jit = nullptr;
 	}
@@ -245,6 +247,14 @@ void MIPSState::UpdateCore(CPUCore desired) {
 		MIPSComp::jit = new MIPSComp::IRJit(this);
 		break;
 
+	case CPUCore::JIT_IR:
+		INFO_LOG(CPU, "Switching to JIT using IR");
+		if (MIPSComp::jit) {
+			delete MIPSComp::jit;
+		}
+		MIPSComp::jit = MIPSComp::CreateNativeIRJit(this);
+		break;
+
 	case CPUCore::INTERPRETER:
 		INFO_LOG(CPU, "Switching to interpreter");
 		delete MIPSComp::jit;
@@ -313,6 +323,7 @@ int MIPSState::RunLoopUntil(u64 globalTicks) {
 	switch (PSP_CoreParameter().cpuCore) {
 	case CPUCore::JIT:
 	case CPUCore::IR_JIT:
+	case CPUCore::JIT_IR:
 		while (inDelaySlot) {
 			// We must get out of the delay slot before going into jit.
 			SingleStep();
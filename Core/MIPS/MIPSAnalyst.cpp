@@ -29,6 +29,7 @@
 #include "Common/Log.h"
 #include "Common/TimeUtil.h"
 #include "Core/Config.h"
+#include "Core/ELF/ParamSFO.h"
 #include "Core/MemMap.h"
 #include "Core/System.h"
 #include "Core/MIPS/MIPS.h"
@@ -36,6 +37,7 @@
 #include "Core/MIPS/MIPSTables.h"
 #include "Core/MIPS/MIPSAnalyst.h"
 #include "Core/MIPS/MIPSCodeUtils.h"
+#include "Core/MIPS/JitCommon/JitCommon.h"
 #include "Core/Debugger/SymbolMap.h"
 #include "Core/Debugger/DebugInterface.h"
 #include "Core/HLE/ReplaceTables.h"
@@ -576,6 +578,65 @@ namespace MIPSAnalyst {
 		return (op >> 26) == 0 && (op & 0x3f) == 12;
 	}
 
+	bool IsSpinWaitLoop(u32 loopStart, u32 branchAddr) {
+		// Anything longer is unlikely to just be a flag or vcount poll.
+		const u32 MAX_SPIN_INSTRUCTIONS = 8;
+		if (branchAddr < loopStart || (branchAddr - loopStart) / 4 >= MAX_SPIN_INSTRUCTIONS)
+			return false;
+
+		MIPSOpcode branchOp = Memory::Read_Instruction(branchAddr, true);
+		MIPSInfo branchInfo = MIPSGetInfo(branchOp);
+		if ((branchInfo & IS_CONDBRANCH) == 0 || (branchInfo & OUT_RA) != 0)
+			return false;
+		if (GetBranchTargetNoRA(branchAddr, branchOp) != loopStart)
+			return false;
+
+		const u32 endAddr = branchAddr + 4;
+		u32 written = 0;
+		for (u32 addr = loopStart; addr <= endAddr; addr += 4) {
+			MIPSGPReg out = GetOutGPReg(Memory::Read_Instruction(addr, true));
+			if (out != MIPS_REG_INVALID && out != MIPS_REG_ZERO)
+				written |= 1 << out;
+		}
+
+		// Everything besides the branch may only be a load or plain ALU op.
+		const u64 unsafeFlags = BAD_INSTRUCTION | IS_CONDBRANCH | IS_JUMP | OUT_MEM | IN_OTHER | OUT_OTHER | IS_FPU | IS_VFPU | IN_LO | IN_HI | OUT_LO | OUT_HI | OUT_FPUFLAG | OUT_VFPU_CC;
+		bool hasLoad = false;
+		u32 writtenSoFar = 0;
+		// A register read before this pass writes it carries state between passes, like a counter.
+		auto carried = [&](MIPSGPReg reg) {
+			return reg != MIPS_REG_ZERO && (written & (1 << reg)) != 0 && (writtenSoFar & (1 << reg)) == 0;
+		};
+		for (u32 addr = loopStart; addr <= endAddr; addr += 4) {
+			MIPSOpcode op = Memory::Read_Instruction(addr, true);
+			MIPSInfo info = MIPSGetInfo(op);
+			if (addr != branchAddr) {
+				if ((info & unsafeFlags) != 0 || IsSyscall(op))
+					return false;
+				if ((info & IN_MEM) != 0) {
+					// Like cache, which can invalidate code.
+					if ((info & OUT_RT) == 0)
+						return false;
+					hasLoad = true;
+				}
+			}
+
+			if ((info & IN_RS) != 0 && carried(MIPS_GET_RS(op)))
+				return false;
+			if ((info & IN_RT) != 0 && carried(MIPS_GET_RT(op)))
+				return false;
+			if ((info & IS_CONDMOVE) != 0 && carried(MIPS_GET_RD(op)))
+				return false;
+
+			MIPSGPReg out = GetOutGPReg(op);
+			if (out != MIPS_REG_INVALID && out != MIPS_REG_ZERO)
+				writtenSoFar |= 1 << out;
+		}
+
+		// Without a load, nothing could ever change the outcome.  Leave that to the game.
+		return hasLoad;
+	}
+
 	static bool IsSWInstr(MIPSOpcode op) {
 		return (op & MIPSTABLE_IMM_MASK) == 0xAC000000;
 	}
@@ -923,13 +984,14 @@ namespace MIPSAnalyst {
 	}
 
 	void PrecompileFunctions() {
+		// Whatever still matches from last time doesn't need to be compiled at all.
+		LoadJitBlockCache();
+
 		if (!g_Config.bPreloadFunctions) {
 			return;
 		}
 		std::lock_guard<std::recursive_mutex> guard(functions_lock);
 
-		// TODO: Load from cache file if available instead.
-
 		double st = time_now_d();
 		for (auto iter = functions.begin(), end = functions.end(); iter != end; iter++) {
 			const AnalyzedFunction &f = *iter;
@@ -1343,6 +1405,37 @@ namespace MIPSAnalyst {
 		fclose(file);
 	}
 
+	static Path JitBlockCacheFilename() {
+		std::string discID = g_paramSFO.GetDiscID();
+		if (discID.empty())
+			return Path();
+		return GetSysDirectory(DIRECTORY_APP_CACHE) / (discID + ".jitblockcache");
+	}
+
+	void LoadJitBlockCache() {
+		if (!MIPSComp::jit || !g_Config.bPersistentJitCache)
+			return;
+		Path filename = JitBlockCacheFilename();
+		if (filename.empty())
+			return;
+
+		double st = time_now_d();
+		if (MIPSComp::jit->LoadBlockCache(filename)) {
+			INFO_LOG(JIT, "Loaded jit block cache %s in %0.2f milliseconds", filename.c_str(), (time_now_d() - st) * 1000.0);
+		}
+	}
+
+	void StoreJitBlockCache() {
+		if (!MIPSComp::jit || !g_Config.bPersistentJitCache)
+			return;
+		Path filename = JitBlockCacheFilename();
+		if (filename.empty())
+			return;
+
+		File::CreateFullPath(GetSysDirectory(DIRECTORY_APP_CACHE));
+		MIPSComp::jit->SaveBlockCache(filename);
+	}
+
 	void ApplyHashMap() {
 		UpdateHashToFunctionMap();
 
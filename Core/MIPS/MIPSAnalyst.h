@@ -118,6 +118,10 @@ namespace MIPSAnalyst
 	void LoadHashMap(const Path &filename);
 	void StoreHashMap(Path filename = Path());
 
+	// Per-game cache of jit blocks, stored next to the shader caches.
+	void LoadJitBlockCache();
+	void StoreJitBlockCache();
+
 	const char *LookupHash(u64 hash, u32 funcSize);
 	void ReplaceFunctions();
 
@@ -133,6 +137,9 @@ namespace MIPSAnalyst
 	bool IsDelaySlotNiceVFPU(MIPSOpcode branchOp, MIPSOpcode op);
 	bool IsDelaySlotNiceFPU(MIPSOpcode branchOp, MIPSOpcode op);
 	bool IsSyscall(MIPSOpcode op);
+	// True if loopStart..branchAddr (plus delay slot) only polls memory without changing anything,
+	// so each pass is identical until an interrupt or another thread changes what it reads.
+	bool IsSpinWaitLoop(u32 loopStart, u32 branchAddr);
 
 	bool OpWouldChangeMemory(u32 pc, u32 addr, u32 size);
 	int OpMemoryAccessSize(u32 pc);
@@ -476,6 +476,10 @@ namespace MIPSInt
 
 		// TODO: Always use the more accurate path in interpreter?
 		bool useAccurateDot = USE_VFPU_DOT || PSP_CoreParameter().compat.flags().MoreAccurateVMMUL;
+		if (!useAccurateDot) {
+			// Everything but the last element, which needs prefixes, can be done in one go.
+			vfpu_mmul_sequential(d, s, t, n);
+		}
 		for (int a = 0; a < n; a++) {
 			for (int b = 0; b < n; b++) {
 				union { float f; uint32_t u; } sum = { 0.0f };
@@ -492,16 +496,12 @@ namespace MIPSInt
 					} else if ((sum.u & 0x7F800000) == 0) {
 						sum.u &= 0xFF800000;
 					}
-				} else {
-					if (a == n - 1 && b == n - 1) {
-						for (int c = 0; c < 4; c++) {
-							sum.f += s[b * 4 + c] * t[a * 4 + c];
-						}
-					} else {
-						for (int c = 0; c < n; c++) {
-							sum.f += s[b * 4 + c] * t[a * 4 + c];
-						}
+				} else if (a == n - 1 && b == n - 1) {
+					for (int c = 0; c < 4; c++) {
+						sum.f += s[b * 4 + c] * t[a * 4 + c];
 					}
+				} else {
+					continue;
 				}
 
 				d[a * 4 + b] = sum.f;
@@ -1165,10 +1165,8 @@ namespace MIPSInt
 				d.u &= 0xFF800000;
 			}
 		} else {
-			d.f = 0.0f;
-			for (int i = 0; i < 4; i++) {
-				d.f += s[i] * t[i];
-			}
+			// Adding to +0.0 first only changes the sign of a zero result.
+			d.f = 0.0f + vfpu_dot_sequential(s, t);
 		}
 
 		ApplyPrefixD(&d.f, V_Single);
@@ -1654,15 +1652,8 @@ namespace MIPSInt
 				}
 			}
 		} else {
-			for (int i = 0; i < ins; i++) {
-				d.f[i] = s[i * 4] * t[0];
-				for (int k = 1; k < tn; k++) {
-					d.f[i] += s[i * 4 + k] * t[k];
-				}
-				if (ins >= n) {
-					d.f[i] += s[i * 4 + ins];
-				}
-			}
+			// This computes all rows, but the last is overwritten below.
+			vfpu_mvmul_sequential(d.f, s, t, tn, ins >= n ? ins : -1);
 		}
 
 		// S and T prefixes apply for the final row only.
@@ -20,12 +20,26 @@
 #include <cstdio>
 #include <cstring>
 
+#include "ppsspp_config.h"
 #include "Common/BitScan.h"
+#include "Common/Common.h"
 #include "Common/CommonFuncs.h"
 #include "Core/Reporting.h"
 #include "Core/MIPS/MIPS.h"
 #include "Core/MIPS/MIPSVFPUUtils.h"
 
+#ifdef _M_SSE
+#include <emmintrin.h>
+#endif
+
+#if PPSSPP_ARCH(ARM64)
+#if defined(_MSC_VER)
+#include <arm64_neon.h>
+#else
+#include <arm_neon.h>
+#endif
+#endif
+
 #define V(i)   (currentMIPS->v[voffset[i]])
 #define VI(i)  (currentMIPS->vi[voffset[i]])
 
@@ -787,6 +801,99 @@ float vfpu_dot(float a[4], float b[4]) {
 	return result.f;
 }
 
+// Like IRInterpreter, NEON is only used on ARM64 where it's guaranteed.
+float vfpu_dot_sequential(const float a[4], const float b[4]) {
+#if defined(_M_SSE)
+	__m128 p = _mm_mul_ps(_mm_loadu_ps(a), _mm_loadu_ps(b));
+	__m128 sum = _mm_add_ss(p, _mm_shuffle_ps(p, p, _MM_SHUFFLE(1, 1, 1, 1)));
+	sum = _mm_add_ss(sum, _mm_shuffle_ps(p, p, _MM_SHUFFLE(2, 2, 2, 2)));
+	sum = _mm_add_ss(sum, _mm_shuffle_ps(p, p, _MM_SHUFFLE(3, 3, 3, 3)));
+	return _mm_cvtss_f32(sum);
+#elif PPSSPP_ARCH(ARM64)
+	float32x4_t p = vmulq_f32(vld1q_f32(a), vld1q_f32(b));
+	float sum = vgetq_lane_f32(p, 0) + vgetq_lane_f32(p, 1);
+	sum += vgetq_lane_f32(p, 2);
+	return sum + vgetq_lane_f32(p, 3);
+#else
+	float sum = a[0] * b[0];
+	for (int i = 1; i < 4; i++)
+		sum += a[i] * b[i];
+	return sum;
+#endif
+}
+
+void vfpu_mmul_sequential(float d[16], const float s[16], const float t[16], int n) {
+#if defined(_M_SSE)
+	// Each lane is one row of s, so we need its columns.
+	__m128 col0 = _mm_loadu_ps(&s[0]);
+	__m128 col1 = _mm_loadu_ps(&s[4]);
+	__m128 col2 = _mm_loadu_ps(&s[8]);
+	__m128 col3 = _mm_loadu_ps(&s[12]);
+	_MM_TRANSPOSE4_PS(col0, col1, col2, col3);
+	const __m128 cols[4] = { col0, col1, col2, col3 };
+
+	for (int a = 0; a < n; a++) {
+		__m128 sum = _mm_setzero_ps();
+		for (int c = 0; c < n; c++)
+			sum = _mm_add_ps(sum, _mm_mul_ps(cols[c], _mm_set1_ps(t[a * 4 + c])));
+		_mm_storeu_ps(&d[a * 4], sum);
+	}
+#elif PPSSPP_ARCH(ARM64)
+	// vld4 deinterleaves, which is exactly a transpose.
+	float32x4x4_t cols = vld4q_f32(s);
+	for (int a = 0; a < n; a++) {
+		float32x4_t sum = vdupq_n_f32(0.0f);
+		for (int c = 0; c < n; c++)
+			sum = vaddq_f32(sum, vmulq_n_f32(cols.val[c], t[a * 4 + c]));
+		vst1q_f32(&d[a * 4], sum);
+	}
+#else
+	for (int a = 0; a < n; a++) {
+		for (int b = 0; b < 4; b++) {
+			float sum = 0.0f;
+			for (int c = 0; c < n; c++)
+				sum += s[b * 4 + c] * t[a * 4 + c];
+			d[a * 4 + b] = sum;
+		}
+	}
+#endif
+}
+
+void vfpu_mvmul_sequential(float d[4], const float s[16], const float t[4], int tn, int extraCol) {
+#if defined(_M_SSE)
+	__m128 col0 = _mm_loadu_ps(&s[0]);
+	__m128 col1 = _mm_loadu_ps(&s[4]);
+	__m128 col2 = _mm_loadu_ps(&s[8]);
+	__m128 col3 = _mm_loadu_ps(&s[12]);
+	_MM_TRANSPOSE4_PS(col0, col1, col2, col3);
+	const __m128 cols[4] = { col0, col1, col2, col3 };
+
+	__m128 sum = _mm_mul_ps(cols[0], _mm_set1_ps(t[0]));
+	for (int k = 1; k < tn; k++)
+		sum = _mm_add_ps(sum, _mm_mul_ps(cols[k], _mm_set1_ps(t[k])));
+	if (extraCol >= 0)
+		sum = _mm_add_ps(sum, cols[extraCol]);
+	_mm_storeu_ps(d, sum);
+#elif PPSSPP_ARCH(ARM64)
+	float32x4x4_t cols = vld4q_f32(s);
+	float32x4_t sum = vmulq_n_f32(cols.val[0], t[0]);
+	for (int k = 1; k < tn; k++)
+		sum = vaddq_f32(sum, vmulq_n_f32(cols.val[k], t[k]));
+	if (extraCol >= 0)
+		sum = vaddq_f32(sum, cols.val[extraCol]);
+	vst1q_f32(d, sum);
+#else
+	for (int i = 0; i < 4; i++) {
+		float sum = s[i * 4] * t[0];
+		for (int k = 1; k < tn; k++)
+			sum += s[i * 4 + k] * t[k];
+		if (extraCol >= 0)
+			sum += s[i * 4 + extraCol];
+		d[i] = sum;
+	}
+#endif
+}
+
 // TODO: This is still not completely accurate compared to the PSP's vsqrt.
 float vfpu_sqrt(float a) {
 	float2int val;
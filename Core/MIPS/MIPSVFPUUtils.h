@@ -64,6 +64,15 @@ inline float vfpu_clamp(float v, float min, float max) {
 }
 
 float vfpu_dot(float a[4], float b[4]);
+
+// These give bit-identical results to the plain float loops in the interpreter, adding in the
+// same order. Only the independent multiplies and rows/columns are done in parallel with SIMD.
+// ((a0 * b0 + a1 * b1) + a2 * b2) + a3 * b3.
+float vfpu_dot_sequential(const float a[4], const float b[4]);
+// d[a * 4 + b] = 0 + s[b * 4 + 0] * t[a * 4 + 0] + ... for c < n, all 4 b for each a < n.
+void vfpu_mmul_sequential(float d[16], const float s[16], const float t[16], int n);
+// d[i] = s[i * 4 + 0] * t[0] + ... for k < tn, plus s[i * 4 + extraCol] if extraCol >= 0.
+void vfpu_mvmul_sequential(float d[4], const float s[16], const float t[4], int tn, int extraCol);
 float vfpu_sqrt(float a);
 float vfpu_rsqrt(float a);
 
@@ -23,6 +23,7 @@
 
 #include "Core/Config.h"
 #include "Core/Core.h"
+#include "Core/CoreTiming.h"
 #include "Core/Reporting.h"
 #include "Core/HLE/HLE.h"
 #include "Core/HLE/HLETables.h"
@@ -197,6 +198,18 @@ bool Jit::PredictTakeBranch(u32 targetAddr, bool likely) {
 	return targetAddr > GetCompilerPC();
 }
 
+void Jit::WriteIdleIfSpinWait(u32 targetAddr) {
+	if (jo.Disabled(JitDisable::IDLE_LOOP))
+		return;
+	// The whole loop must be this block, or we'd skip code before the branch.
+	if (targetAddr != js.blockStart || js.lastContinuedPC != 0)
+		return;
+	if (MIPSAnalyst::IsSpinWaitLoop(targetAddr, GetCompilerPC())) {
+		// Everything is flushed here, and the downcount for this pass is still subtracted on exit.
+		ABI_CallFunctionC((const void *)&CoreTiming::Idle, 0);
+	}
+}
+
 void Jit::CompBranchExits(CCFlags cc, u32 targetAddr, u32 notTakenAddr, bool delaySlotIsNice, bool likely, bool andLink) {
 	if (andLink)
 		gpr.SetImm(MIPS_REG_RA, GetCompilerPC() + 8);
@@ -256,6 +269,7 @@ void Jit::CompBranchExits(CCFlags cc, u32 targetAddr, u32 notTakenAddr, bool del
 		{
 			// Take the branch
 			CONDITIONAL_LOG_EXIT(targetAddr);
+			WriteIdleIfSpinWait(targetAddr);
 			WriteExit(targetAddr, js.nextExit++);
 
 			// Not taken
@@ -289,6 +303,7 @@ void Jit::CompBranchExits(CCFlags cc, u32 targetAddr, u32 notTakenAddr, bool del
 
 		// Take the branch
 		CONDITIONAL_LOG_EXIT(targetAddr);
+		WriteIdleIfSpinWait(targetAddr);
 		WriteExit(targetAddr, js.nextExit++);
 
 		// Not taken
@@ -1,299 +1,798 @@
-#include "ppsspp_config.h"
-#if PPSSPP_ARCH(X86) || PPSSPP_ARCH(AMD64)
+// Copyright (c) 2016- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
 
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include "ppsspp_config.h"
+#if PPSSPP_ARCH(AMD64)
+
+#include <cstddef>
+
+#include "Common/ABI.h"
+#include "Common/Log.h"
+#include "Common/StringUtils.h"
+#include "Common/TimeUtil.h"
+#include "Core/Core.h"
+#include "Core/CoreTiming.h"
+#include "Core/MemMap.h"
+#include "Core/MIPS/MIPS.h"
+#include "Core/MIPS/MIPSCodeUtils.h"
+#include "Core/MIPS/IR/IRInterpreter.h"
 #include "Core/MIPS/x86/IRToX86.h"
+#include "Core/MIPS/x86/RegCache.h"
+
+using namespace Gen;
+using namespace X64JitConstants;
 
 namespace MIPSComp {
 
-// Initial attempt at converting IR directly to x86.
-// This is intended to be an easy way to benefit from the IR with the current infrastructure.
-// Later tries may go across multiple blocks and a different representation.
+// Static allocations, same as the regular x86 jit:
+// RBX - Base pointer of PSP memory
+// R14 - Pointer to MIPSState (offset to f[0], see MIPSSTATE_VAR)
+// RAX, RCX, RDX, XMM0, XMM1 - scratch, nothing is kept in registers between IR instructions.
+
+#define GPR(reg) MIPSSTATE_VAR_ELEM32(r, (reg))
+#define FPR(reg) MIPSSTATE_VAR_ELEM32(f, (reg))
+
+alignas(16) static const float vec4InitValues[8][4] = {
+	{ 0.0f, 0.0f, 0.0f, 0.0f },
+	{ 1.0f, 1.0f, 1.0f, 1.0f },
+	{ -1.0f, -1.0f, -1.0f, -1.0f },
+	{ 1.0f, 0.0f, 0.0f, 0.0f },
+	{ 0.0f, 1.0f, 0.0f, 0.0f },
+	{ 0.0f, 0.0f, 1.0f, 0.0f },
+	{ 0.0f, 0.0f, 0.0f, 1.0f },
+};
 
-struct GPRMapping {
-	Gen::OpArg dest;
-	Gen::OpArg src1;
-	Gen::OpArg src2;
+alignas(16) static const u32 signBits[4] = {
+	0x80000000, 0x80000000, 0x80000000, 0x80000000,
 };
 
-struct FPRMapping {
-	Gen::OpArg dest;
-	Gen::OpArg src1;
-	Gen::OpArg src2;
+alignas(16) static const u32 noSignMask[4] = {
+	0x7FFFFFFF, 0x7FFFFFFF, 0x7FFFFFFF, 0x7FFFFFFF,
 };
 
+// Generous upper bound on emitted bytes per IR instruction (fallbacks with a slow path are the largest.)
+static const size_t MAX_BYTES_PER_INST = 160;
 
-class GreedyRegallocGPR {
-public:
-	GPRMapping Map(IRInst inst, const IRMeta &meta);
+IRToX86::IRToX86(MIPSState *mipsState) : mips_(mipsState) {
+	AllocCodeSpace(1024 * 1024 * 16);
+	GenerateFixedCode();
+}
 
-private:
-	
-};
+void IRToX86::GenerateFixedCode() {
+	BeginWrite();
+
+	enterDispatcher_ = AlignCode16();
+	ABI_PushAllCalleeSavedRegsAndAdjustStack();
+	MOV(64, R(MEMBASEREG), ImmPtr(Memory::base));
+	MOV(64, R(CTXREG), ImmPtr(&mips_->f[0]));
+
+	dispatcher_ = GetCodePtr();
+	// Go back to IRJit to run CoreTiming once the slice is up.
+	CMP(32, MIPSSTATE_VAR(downcount), Imm8(0));
+	FixupBranch bailDowncount = J_CC(CC_L, true);
+
+	// Only RAM is handled here, IRJit checks anything else (and complains about bad jumps.)
+	MOV(32, R(EAX), MIPSSTATE_VAR(pc));
+	MOV(32, R(EDX), R(EAX));
+	AND(32, R(EDX), Imm32(0x3E000000));
+	CMP(32, R(EDX), Imm32(0x08000000));
+	FixupBranch bailAddress = J_CC(CC_NE, true);
+
+	// Same as IRBlockCache::LookupBlock(), all RAM mirrors share the physical address.
+	AND(32, R(EAX), Imm32(0x1FFFFFFF));
+	MOV(64, R(RDX), ImmPtr(&table_));
+	MOV(64, R(RDX), MDisp(RDX, (int)offsetof(EntryTable, lookupPages)));
+	MOV(32, R(ECX), R(EAX));
+	SHR(32, R(ECX), Imm8(IRBlockCache::LOOKUP_PAGE_SHIFT));
+	MOV(64, R(RDX), MComplex(RDX, RCX, SCALE_8, 0));
+	TEST(64, R(RDX), R(RDX));
+	FixupBranch bailNoPage = J_CC(CC_Z, true);
+	static_assert(sizeof(IRBlockCache::LookupEntry) == 8, "Entries are indexed by word offset * 2");
+	MOV(32, R(ECX), R(EAX));
+	AND(32, R(ECX), Imm32(IRBlockCache::LOOKUP_PAGE_MASK));
+	LEA(64, RDX, MComplex(RDX, RCX, SCALE_2, 0));
+	// If the game overwrote the first op, the block is stale and IRJit compiles a new one.
+	MOV(32, R(ECX), MComplex(MEMBASEREG, RAX, SCALE_1, 0));
+	CMP(32, R(ECX), MDisp(RDX, (int)offsetof(IRBlockCache::LookupEntry, firstOp)));
+	FixupBranch bailNotCompiled = J_CC(CC_NE, true);
+
+	// An empty entry is -1, which fails the range check.
+	MOV(32, R(EAX), MDisp(RDX, (int)offsetof(IRBlockCache::LookupEntry, blockNum)));
+	MOV(64, R(RDX), ImmPtr(&table_));
+	CMP(32, R(EAX), MDisp(RDX, (int)offsetof(EntryTable, count)));
+	FixupBranch bailRange = J_CC(CC_AE, true);
+	CMP(32, MDisp(RDX, (int)offsetof(EntryTable, profiling)), Imm8(0));
+	FixupBranch profile = J_CC(CC_NZ, true);
+	MOV(64, R(RDX), MDisp(RDX, (int)offsetof(EntryTable, entries)));
+	MOV(64, R(RAX), MComplex(RDX, RAX, SCALE_8, 0));
+	TEST(64, R(RAX), R(RAX));
+	FixupBranch bailNoEntry = J_CC(CC_Z, true);
+	JMPptr(R(RAX));
+
+	// Profiling closes the previous block's sample and looks up the entry in C++.
+	SetJumpTarget(profile);
+	MOV(32, R(ABI_PARAM2), R(EAX));
+	MOV(64, R(ABI_PARAM1), ImmPtr(this));
+	ABI_CallFunction((const void *)&ProfileEnterBlock);
+	TEST(64, R(RAX), R(RAX));
+	FixupBranch bailNoProfiledEntry = J_CC(CC_Z, true);
+	JMPptr(R(RAX));
+
+	SetJumpTarget(bailDowncount);
+	SetJumpTarget(bailAddress);
+	SetJumpTarget(bailNoPage);
+	SetJumpTarget(bailNotCompiled);
+	SetJumpTarget(bailRange);
+	SetJumpTarget(bailNoEntry);
+	SetJumpTarget(bailNoProfiledEntry);
+	quitLoop_ = GetCodePtr();
+	ABI_PopAllCalleeSavedRegsAndAdjustStack();
+	RET();
+
+	crashHandler_ = GetCodePtr();
+	if (RipAccessible((const void *)&coreState)) {
+		MOV(32, M(&coreState), Imm32(CORE_RUNTIME_ERROR));
+	} else {
+		MOV(PTRBITS, R(RAX), ImmPtr((const void *)&coreState));
+		MOV(32, MatR(RAX), Imm32(CORE_RUNTIME_ERROR));
+	}
+	JMP(quitLoop_, true);
 
+	// Let's spare the pre-generated code from unprotect-reprotect.
+	AlignCodePage();
+	blocksStartOffset_ = (int)(GetCodePtr() - region);
+	EndWrite();
+}
 
-GPRMapping GreedyRegallocGPR::Map(IRInst inst, const IRMeta &meta) {
-	GPRMapping mapping;
-	if (meta.types[0] == 'G') {
+void IRToX86::RunDispatcher() {
+	((void (*)())enterDispatcher_)();
+	// The last block ran until we got back here.
+	EndProfileSample();
+}
 
-	}
-	// etc..
-	return mapping;
+void IRToX86::ClearAllBlocks() {
+	ClearCodeSpace(blocksStartOffset_);
+	entries_.clear();
+	UpdateEntryTable();
+	// The block numbers are about to be reused, so drop the open sample.
+	profileBlock_ = -1;
 }
 
-// Every 4 registers can also be mapped into an SSE register.
-// When changing from single to vec4 mapping, we'll just flush, for now.
-class GreedyRegallocFPR {
-public:
-	FPRMapping Map(IRInst inst, const IRMeta &meta);
-};
+void IRToX86::UpdateEntryTable() {
+	table_.entries = entries_.data();
+	table_.count = (u32)entries_.size();
+}
 
-FPRMapping GreedyRegallocFPR::Map(IRInst inst, const IRMeta &meta) {
-	FPRMapping mapping;
+void IRToX86::SetLookupPages(const IRBlockCache::LookupEntry *const *pages) {
+	table_.lookupPages = pages;
+}
 
-	return mapping;
+void IRToX86::SetProfiling(IRBlockCache *blocks) {
+	if (blocks == profileBlocks_)
+		return;
+	EndProfileSample();
+	profileBlocks_ = blocks;
+	table_.profiling = blocks ? 1 : 0;
 }
 
+void IRToX86::EndProfileSample() {
+	if (profileBlock_ == -1)
+		return;
+	IRBlock *block = profileBlocks_ ? profileBlocks_->GetBlock(profileBlock_) : nullptr;
+	if (block)
+		block->AddProfileSample(time_now_d() - profileStart_);
+	profileBlock_ = -1;
+}
 
-// This requires that ThreeOpToTwoOp has been run as the last pass.
-void IRToX86::ConvertIRToNative(const IRInst *instructions, int count, const u32 *constants) {
-	// Set up regcaches
-	using namespace Gen;
+const u8 *IRToX86::ProfileEnterBlock(IRToX86 *self, u32 blockNum) {
+	// Blocks always exit through the dispatcher, so the previous one ends here.
+	double now = time_now_d();
+	IRBlock *prev = self->profileBlock_ == -1 ? nullptr : self->profileBlocks_->GetBlock(self->profileBlock_);
+	if (prev)
+		prev->AddProfileSample(now - self->profileStart_);
+	self->profileBlock_ = -1;
+
+	const u8 *entry = self->entries_[blockNum];
+	if (entry) {
+		self->profileBlock_ = (int)blockNum;
+		self->profileStart_ = now;
+	}
+	return entry;
+}
 
-	GreedyRegallocGPR gprAlloc;
-	GreedyRegallocFPR fprAlloc;
+const u8 *IRToX86::EmitBlock(const IRInst *instructions, int count) {
+	size_t estimate = count * MAX_BYTES_PER_INST + 64;
+	if (GetSpaceLeft() < estimate) {
+		return nullptr;
+	}
 
-	// Loop through all the instructions, emitting code as we go.
-	// Note that we do need to implement them all - fallbacks are not permitted.
+	BeginWrite(estimate);
+	const u8 *start = AlignCode16();
 	for (int i = 0; i < count; i++) {
-		const IRInst *inst = &instructions[i];
-		const IRMeta &meta = *GetIRMeta(inst->op);
-		GPRMapping gpr = gprAlloc.Map(*inst, meta);
-		FPRMapping fpr = fprAlloc.Map(*inst, meta);
+		CompileInstruction(&instructions[i]);
+	}
+	// A well formed block always exits before this, same assumption as IRInterpret().
+	JMP(crashHandler_, true);
+	EndWrite();
+	return start;
+}
+
+void IRToX86::SetBlockEntry(int blockNum, const u8 *entry) {
+	if (blockNum >= (int)entries_.size()) {
+		entries_.resize(blockNum + 1, nullptr);
+	}
+	entries_[blockNum] = entry;
+	UpdateEntryTable();
+}
+
+bool IRToX86::DescribeCodePtr(const u8 *ptr, std::string &name) const {
+	if (!IsInSpace(ptr))
+		return false;
+
+	if (ptr == enterDispatcher_) {
+		name = "enterDispatcher";
+	} else if (ptr == dispatcher_) {
+		name = "dispatcher";
+	} else if (ptr == crashHandler_) {
+		name = "crashHandler";
+	} else if (ptr < region + blocksStartOffset_) {
+		name = "fixedCode";
+	} else {
+		// Blocks are emitted in increasing address order, so the closest preceding entry owns the pointer.
+		int best = -1;
+		for (size_t i = 0; i < entries_.size(); ++i) {
+			if (entries_[i] && entries_[i] <= ptr && (best == -1 || entries_[i] > entries_[best]))
+				best = (int)i;
+		}
+		if (best == -1)
+			name = "UnknownOrDeletedBlock";
+		else
+			name = StringFromFormat("IR block %d", best);
+	}
+	return true;
+}
+
+void IRToX86::CompileExitToConst(u32 pc) {
+	MOV(32, MIPSSTATE_VAR(pc), Imm32(pc));
+	JMP(dispatcher_, true);
+}
+
+// Leaves the host address offset in RAX, use with MComplex(MEMBASEREG, RAX, SCALE_1, 0).
+void IRToX86::CompileAddress(const IRInst *inst) {
+	MOV(32, R(EAX), GPR(inst->src1));
+	if (inst->constant != 0)
+		ADD(32, R(EAX), Imm32(inst->constant));
+#ifdef MASKED_PSP_MEMORY
+	AND(32, R(EAX), Imm32(Memory::MEMVIEW32_MASK));
+#endif
+}
+
+void IRToX86::CompileFallback(const IRInst *inst, bool checkExit) {
+	// Nothing lives in host registers between instructions, so no flushing needed.
+	MOV(64, R(ABI_PARAM1), ImmPtr(mips_));
+	MOV(64, R(ABI_PARAM2), ImmPtr(inst));
+	ABI_CallFunction((const void *)&IRInterpretSingle);
+	if (checkExit) {
+		TEST(32, R(EAX), R(EAX));
+		FixupBranch noExit = J_CC(CC_Z);
+		MOV(32, MIPSSTATE_VAR(pc), R(EAX));
+		JMP(dispatcher_, true);
+		SetJumpTarget(noExit);
+	}
+}
 
-		bool symmetric = false;
+void IRToX86::CompileInstruction(const IRInst *inst) {
+	const OpArg mem = MComplex(MEMBASEREG, RAX, SCALE_1, 0);
+
+	switch (inst->op) {
+	case IROp::Nop:
+		break;
+
+	case IROp::SetConst:
+		MOV(32, GPR(inst->dest), Imm32(inst->constant));
+		break;
+	case IROp::SetConstF:
+		MOV(32, FPR(inst->dest), Imm32(inst->constant));
+		break;
+
+	case IROp::Mov:
+		MOV(32, R(EAX), GPR(inst->src1));
+		MOV(32, GPR(inst->dest), R(EAX));
+		break;
+
+	case IROp::Add:
+	case IROp::Sub:
+	case IROp::And:
+	case IROp::Or:
+	case IROp::Xor:
+		MOV(32, R(EAX), GPR(inst->src1));
 		switch (inst->op) {
-		case IROp::Nop:
-			_assert_(false);
-			break;
-
-			// Output-only
-		case IROp::SetConst:
-			code_->MOV(32, gpr.dest, Imm32(constants[inst->src1]));
-			break;
-		case IROp::SetConstF:
-			code_->MOV(32, gpr.dest, Imm32(constants[inst->src1]));
-			break;
-
-			// Add gets to be special cased because we have LEA.
-		case IROp::Add:
-			if (gpr.dest.IsSimpleReg() && gpr.src1.IsSimpleReg() && gpr.src2.IsSimpleReg()) {
-				code_->LEA(32, gpr.dest.GetSimpleReg(), MRegSum(gpr.src1.GetSimpleReg(), gpr.src2.GetSimpleReg()));
-				break;
-			}
-			// Else fall through.
-			// 3-op arithmetic that directly corresponds to x86
-			// (often 2-op in practice if src1 == dst). x86 only does 2-op though so some of these will need splitting.
-		case IROp::Sub:
-		case IROp::And:
-		case IROp::Or:
-		case IROp::Xor:
-			if (inst->src1 != inst->dest) {
-				code_->MOV(32, gpr.dest, gpr.src1);
-			}
-			// Emit directly
+		case IROp::Add: ADD(32, R(EAX), GPR(inst->src2)); break;
+		case IROp::Sub: SUB(32, R(EAX), GPR(inst->src2)); break;
+		case IROp::And: AND(32, R(EAX), GPR(inst->src2)); break;
+		case IROp::Or: OR(32, R(EAX), GPR(inst->src2)); break;
+		case IROp::Xor: XOR(32, R(EAX), GPR(inst->src2)); break;
+		default: break;
+		}
+		MOV(32, GPR(inst->dest), R(EAX));
+		break;
+
+	case IROp::AddConst:
+	case IROp::SubConst:
+	case IROp::AndConst:
+	case IROp::OrConst:
+	case IROp::XorConst:
+	{
+		// Operate on memory directly when updating in place, common for sp and loop counters.
+		OpArg dest = GPR(inst->dest);
+		if (inst->src1 != inst->dest) {
+			MOV(32, R(EAX), GPR(inst->src1));
+			dest = R(EAX);
+		}
+		switch (inst->op) {
+		case IROp::AddConst: ADD(32, dest, Imm32(inst->constant)); break;
+		case IROp::SubConst: SUB(32, dest, Imm32(inst->constant)); break;
+		case IROp::AndConst: AND(32, dest, Imm32(inst->constant)); break;
+		case IROp::OrConst: OR(32, dest, Imm32(inst->constant)); break;
+		case IROp::XorConst: XOR(32, dest, Imm32(inst->constant)); break;
+		default: break;
+		}
+		if (inst->src1 != inst->dest)
+			MOV(32, GPR(inst->dest), R(EAX));
+		break;
+	}
+
+	case IROp::Neg:
+		MOV(32, R(EAX), GPR(inst->src1));
+		NEG(32, R(EAX));
+		MOV(32, GPR(inst->dest), R(EAX));
+		break;
+	case IROp::Not:
+		MOV(32, R(EAX), GPR(inst->src1));
+		NOT(32, R(EAX));
+		MOV(32, GPR(inst->dest), R(EAX));
+		break;
+
+	case IROp::Shl:
+	case IROp::Shr:
+	case IROp::Sar:
+	case IROp::Ror:
+		// x86 masks the shift amount to 5 bits, just like MIPS.
+		MOV(32, R(ECX), GPR(inst->src2));
+		MOV(32, R(EAX), GPR(inst->src1));
+		switch (inst->op) {
+		case IROp::Shl: SHL(32, R(EAX), R(ECX)); break;
+		case IROp::Shr: SHR(32, R(EAX), R(ECX)); break;
+		case IROp::Sar: SAR(32, R(EAX), R(ECX)); break;
+		case IROp::Ror: ROR(32, R(EAX), R(ECX)); break;
+		default: break;
+		}
+		MOV(32, GPR(inst->dest), R(EAX));
+		break;
+
+	case IROp::ShlImm:
+	case IROp::ShrImm:
+	case IROp::SarImm:
+	case IROp::RorImm:
+		MOV(32, R(EAX), GPR(inst->src1));
+		if (inst->src2 != 0) {
 			switch (inst->op) {
-			case IROp::Add: code_->ADD(32, gpr.dest, gpr.src2); break;
-			case IROp::Sub: code_->SUB(32, gpr.dest, gpr.src2); break;
-			case IROp::And: code_->AND(32, gpr.dest, gpr.src2); break;
-			case IROp::Or: code_->OR(32, gpr.dest, gpr.src2); break;
-			case IROp::Xor: code_->XOR(32, gpr.dest, gpr.src2); break;
+			case IROp::ShlImm: SHL(32, R(EAX), Imm8(inst->src2)); break;
+			case IROp::ShrImm: SHR(32, R(EAX), Imm8(inst->src2)); break;
+			case IROp::SarImm: SAR(32, R(EAX), Imm8(inst->src2)); break;
+			case IROp::RorImm: ROR(32, R(EAX), Imm8(inst->src2)); break;
+			default: break;
 			}
-			break;
-
-			// Variable shifts.
-		case IROp::Shl:
-		case IROp::Shr:
-		case IROp::Sar:
-		case IROp::Ror:
-
-		case IROp::Slt:
-		case IROp::SltU:
-		case IROp::MovZ:
-		case IROp::MovNZ:
-		case IROp::Max:
-		case IROp::Min:
-			break;
-
-			// 2-op arithmetic with constant
-		case IROp::AddConst:
-		case IROp::SubConst:
-		case IROp::AndConst:
-		case IROp::OrConst:
-		case IROp::XorConst:
-		case IROp::SltConst:
-		case IROp::SltUConst:
-
-			// 2-op arithmetic with immediate
-		case IROp::ShlImm:
-		case IROp::ShrImm:
-		case IROp::SarImm:
-		case IROp::RorImm:
-
-			// 2-op arithmetic
-		case IROp::Mov:
-			code_->MOV(32, gpr.dest, gpr.src1);
-			break;
-
-		case IROp::Neg:
-		case IROp::Not:
-		case IROp::Ext8to32:
-		case IROp::Ext16to32:
-		case IROp::ReverseBits:
-		case IROp::BSwap16:
-		case IROp::BSwap32:
-		case IROp::Clz:
-			if (inst->dest != inst->src1) {
-				code_->NEG(32, gpr.dest); break;
-			}
-			break;
-				// Multiplier control
-		case IROp::MtLo:
-		case IROp::MtHi:
-		case IROp::MfLo:
-		case IROp::MfHi:
-		case IROp::Mult:
-		case IROp::MultU:
-		case IROp::Madd:
-		case IROp::MaddU:
-		case IROp::Msub:
-		case IROp::MsubU:
-		case IROp::Div:
-		case IROp::DivU:
-
-			// Memory access
-		case IROp::Load8:
-		case IROp::Load8Ext:
-		case IROp::Load16:
-		case IROp::Load16Ext:
-		case IROp::Load32:
-		case IROp::LoadFloat:
-		case IROp::Store8:
-		case IROp::Store16:
-		case IROp::Store32:
-		case IROp::StoreFloat:
-		case IROp::LoadVec4:
-		case IROp::StoreVec4:
-
-			// Output-only SIMD functions
-		case IROp::Vec4Init:
-		case IROp::Vec4Shuffle:
-
-			// 2-op SIMD functions
-		case IROp::Vec4Mov:
-			code_->MOVAPS(fpr.dest.GetSimpleReg(), fpr.src1);
-			break;
-		case IROp::Vec4Neg:
-		case IROp::Vec4Abs:
-			break;
-		case IROp::Vec4ClampToZero:
-			code_->PXOR(XMM0, R(XMM0));
-			code_->PMAXSW(XMM0, fpr.src1);
-			code_->MOVAPD(fpr.dest, XMM0);
-			break;
-		case IROp::Vec4DuplicateUpperBitsAndShift1:
-		case IROp::Vec2ClampToZero:
-
-			// 3-op SIMD functions
-		case IROp::Vec4Add:
-		case IROp::Vec4Sub:
-		case IROp::Vec4Mul:
-		case IROp::Vec4Div:
-
-		case IROp::Vec4Scale:
-		case IROp::Vec4Dot:
-
-			// Pack-unpack
-		case IROp::Vec2Unpack16To31:
-		case IROp::Vec2Unpack16To32:
-		case IROp::Vec4Unpack8To32:
-		case IROp::Vec2Pack32To16:
-		case IROp::Vec2Pack31To16:
-		case IROp::Vec4Pack32To8:
-		case IROp::Vec4Pack31To8:
-
-		case IROp::FCmpVfpuBit:
-		case IROp::FCmpVfpuAggregate:
-		case IROp::FCmovVfpuCC:
-
-			// Trancendental functions (non-simd)
-		case IROp::FSin:
-		case IROp::FCos:
-		case IROp::FRSqrt:
-		case IROp::FRecip:
-		case IROp::FAsin:
-
-			// 3-Op FP
-		case IROp::FAdd:
-		case IROp::FSub:
-		case IROp::FMul:
-		case IROp::FDiv:
-		case IROp::FMin:
-		case IROp::FMax:
-
-			// 2-Op FP
-		case IROp::FMov:
-		case IROp::FAbs:
-		case IROp::FSqrt:
-		case IROp::FNeg:
-		case IROp::FSat0_1:
-		case IROp::FSatMinus1_1:
-		case IROp::FSign:
-		case IROp::FCeil:
-		case IROp::FFloor:
-		case IROp::FCmp:
-		case IROp::FCvtSW:
-		case IROp::FCvtWS:
-		case IROp::FRound:
-		case IROp::FTrunc:
-
-			// Cross moves
-		case IROp::FMovFromGPR:
-		case IROp::FMovToGPR:
-		case IROp::FpCondToReg:
-		case IROp::VfpuCtrlToReg:
-
-			// VFPU flag/control
-		case IROp::SetCtrlVFPU:
-		case IROp::SetCtrlVFPUReg:
-		case IROp::SetCtrlVFPUFReg:
-		case IROp::ZeroFpCond:
-
-			// Block Exits
-		case IROp::ExitToConst:
-		case IROp::ExitToReg:
-		case IROp::ExitToConstIfEq:
-		case IROp::ExitToConstIfNeq:
-		case IROp::ExitToConstIfGtZ:
-		case IROp::ExitToConstIfGeZ:
-		case IROp::ExitToConstIfLtZ:
-		case IROp::ExitToConstIfLeZ:
-		case IROp::ExitToPC:
-
-			// Utilities
-		case IROp::Downcount:
-		case IROp::SetPC:
-		case IROp::SetPCConst:
-		case IROp::Syscall:
-		case IROp::Interpret:  // SLOW fallback. Can be made faster.
-		case IROp::CallReplacement:
-		case IROp::Break:
-		default:
-			break;
+		}
+		MOV(32, GPR(inst->dest), R(EAX));
+		break;
+
+	case IROp::Slt:
+	case IROp::SltU:
+	case IROp::SltConst:
+	case IROp::SltUConst:
+		MOV(32, R(EAX), GPR(inst->src1));
+		// Clear before the compare, XOR affects flags.
+		XOR(32, R(EDX), R(EDX));
+		if (inst->op == IROp::Slt || inst->op == IROp::SltU)
+			CMP(32, R(EAX), GPR(inst->src2));
+		else
+			CMP(32, R(EAX), Imm32(inst->constant));
+		SETcc(inst->op == IROp::Slt || inst->op == IROp::SltConst ? CC_L : CC_B, R(EDX));
+		MOV(32, GPR(inst->dest), R(EDX));
+		break;
+
+	case IROp::Clz:
+		// BSR leaves ZF set for zero, in which case 63 ^ 31 gives us 32.
+		BSR(32, EAX, GPR(inst->src1));
+		MOV(32, R(ECX), Imm32(63));
+		CMOVcc(32, EAX, R(ECX), CC_Z);
+		XOR(32, R(EAX), Imm8(31));
+		MOV(32, GPR(inst->dest), R(EAX));
+		break;
+
+	case IROp::MovZ:
+	case IROp::MovNZ:
+		MOV(32, R(EAX), GPR(inst->dest));
+		CMP(32, GPR(inst->src1), Imm8(0));
+		CMOVcc(32, EAX, GPR(inst->src2), inst->op == IROp::MovZ ? CC_E : CC_NE);
+		MOV(32, GPR(inst->dest), R(EAX));
+		break;
+
+	case IROp::Max:
+	case IROp::Min:
+		MOV(32, R(EAX), GPR(inst->src1));
+		MOV(32, R(EDX), GPR(inst->src2));
+		CMP(32, R(EAX), R(EDX));
+		CMOVcc(32, EAX, R(EDX), inst->op == IROp::Max ? CC_L : CC_G);
+		MOV(32, GPR(inst->dest), R(EAX));
+		break;
+
+	case IROp::BSwap16:
+		MOV(32, R(EAX), GPR(inst->src1));
+		BSWAP(32, EAX);
+		ROR(32, R(EAX), Imm8(16));
+		MOV(32, GPR(inst->dest), R(EAX));
+		break;
+	case IROp::BSwap32:
+		MOV(32, R(EAX), GPR(inst->src1));
+		BSWAP(32, EAX);
+		MOV(32, GPR(inst->dest), R(EAX));
+		break;
+
+	case IROp::Ext8to32:
+		MOVSX(32, 8, EAX, GPR(inst->src1));
+		MOV(32, GPR(inst->dest), R(EAX));
+		break;
+	case IROp::Ext16to32:
+		MOVSX(32, 16, EAX, GPR(inst->src1));
+		MOV(32, GPR(inst->dest), R(EAX));
+		break;
+
+	case IROp::MtLo:
+	case IROp::MtHi:
+		MOV(32, R(EAX), GPR(inst->src1));
+		MOV(32, GPR(inst->op == IROp::MtLo ? IRREG_LO : IRREG_HI), R(EAX));
+		break;
+	case IROp::MfLo:
+	case IROp::MfHi:
+		MOV(32, R(EAX), GPR(inst->op == IROp::MfLo ? IRREG_LO : IRREG_HI));
+		MOV(32, GPR(inst->dest), R(EAX));
+		break;
+
+	case IROp::Mult:
+	case IROp::MultU:
+	case IROp::Madd:
+	case IROp::MaddU:
+	case IROp::Msub:
+	case IROp::MsubU:
+	{
+		// lo and hi are adjacent, so we treat them as one 64-bit value.
+		bool isSigned = inst->op == IROp::Mult || inst->op == IROp::Madd || inst->op == IROp::Msub;
+		if (isSigned) {
+			MOVSX(64, 32, RAX, GPR(inst->src1));
+			MOVSX(64, 32, RDX, GPR(inst->src2));
+		} else {
+			// 32-bit moves zero extend, and the low 64 bits of the product are the same either way.
+			MOV(32, R(EAX), GPR(inst->src1));
+			MOV(32, R(EDX), GPR(inst->src2));
+		}
+		IMUL(64, RAX, R(RDX));
+		if (inst->op == IROp::Mult || inst->op == IROp::MultU)
+			MOV(64, GPR(IRREG_LO), R(RAX));
+		else if (inst->op == IROp::Madd || inst->op == IROp::MaddU)
+			ADD(64, GPR(IRREG_LO), R(RAX));
+		else
+			SUB(64, GPR(IRREG_LO), R(RAX));
+		break;
+	}
+
+	case IROp::Load8:
+		CompileAddress(inst);
+		MOVZX(32, 8, EAX, mem);
+		MOV(32, GPR(inst->dest), R(EAX));
+		break;
+	case IROp::Load8Ext:
+		CompileAddress(inst);
+		MOVSX(32, 8, EAX, mem);
+		MOV(32, GPR(inst->dest), R(EAX));
+		break;
+	case IROp::Load16:
+		CompileAddress(inst);
+		MOVZX(32, 16, EAX, mem);
+		MOV(32, GPR(inst->dest), R(EAX));
+		break;
+	case IROp::Load16Ext:
+		CompileAddress(inst);
+		MOVSX(32, 16, EAX, mem);
+		MOV(32, GPR(inst->dest), R(EAX));
+		break;
+	case IROp::Load32:
+		CompileAddress(inst);
+		MOV(32, R(EAX), mem);
+		MOV(32, GPR(inst->dest), R(EAX));
+		break;
+	case IROp::LoadFloat:
+		// Plain integer moves keep these easy to analyze for the memory fault handler.
+		CompileAddress(inst);
+		MOV(32, R(EAX), mem);
+		MOV(32, FPR(inst->dest), R(EAX));
+		break;
+	case IROp::LoadVec4:
+		CompileAddress(inst);
+		MOVUPS(XMM0, mem);
+		MOVAPS(FPR(inst->dest), XMM0);
+		break;
+
+	case IROp::Store8:
+		MOV(32, R(EDX), GPR(inst->src3));
+		CompileAddress(inst);
+		MOV(8, mem, R(EDX));
+		break;
+	case IROp::Store16:
+		MOV(32, R(EDX), GPR(inst->src3));
+		CompileAddress(inst);
+		MOV(16, mem, R(EDX));
+		break;
+	case IROp::Store32:
+		MOV(32, R(EDX), GPR(inst->src3));
+		CompileAddress(inst);
+		MOV(32, mem, R(EDX));
+		break;
+	case IROp::StoreFloat:
+		MOV(32, R(EDX), FPR(inst->src3));
+		CompileAddress(inst);
+		MOV(32, mem, R(EDX));
+		break;
+	case IROp::StoreVec4:
+		MOVAPS(XMM0, FPR(inst->src3));
+		CompileAddress(inst);
+		MOVUPS(mem, XMM0);
+		break;
+
+	case IROp::FAdd:
+	case IROp::FSub:
+	case IROp::FDiv:
+		MOVSS(XMM0, FPR(inst->src1));
+		switch (inst->op) {
+		case IROp::FAdd: ADDSS(XMM0, FPR(inst->src2)); break;
+		case IROp::FSub: SUBSS(XMM0, FPR(inst->src2)); break;
+		case IROp::FDiv: DIVSS(XMM0, FPR(inst->src2)); break;
+		default: break;
+		}
+		MOVSS(FPR(inst->dest), XMM0);
+		break;
+
+	case IROp::FMul:
+	{
+		// Inf * 0 must give a positive NAN, which x86 doesn't.  Any NAN result takes the slow path.
+		MOVSS(XMM0, FPR(inst->src1));
+		MULSS(XMM0, FPR(inst->src2));
+		UCOMISS(XMM0, R(XMM0));
+		FixupBranch isNAN = J_CC(CC_P, true);
+		MOVSS(FPR(inst->dest), XMM0);
+		FixupBranch done = J(true);
+		SetJumpTarget(isNAN);
+		CompileFallback(inst, false);
+		SetJumpTarget(done);
+		break;
+	}
+
+	case IROp::FMin:
+		// MINSS returns the second operand unless the first is less, matching std::min(a, b) with swapped args.
+		MOVSS(XMM0, FPR(inst->src2));
+		MINSS(XMM0, FPR(inst->src1));
+		MOVSS(FPR(inst->dest), XMM0);
+		break;
+	case IROp::FMax:
+		MOVSS(XMM0, FPR(inst->src2));
+		MAXSS(XMM0, FPR(inst->src1));
+		MOVSS(FPR(inst->dest), XMM0);
+		break;
+
+	case IROp::FMov:
+	case IROp::FAbs:
+	case IROp::FNeg:
+		MOV(32, R(EAX), FPR(inst->src1));
+		if (inst->op == IROp::FAbs)
+			AND(32, R(EAX), Imm32(0x7FFFFFFF));
+		else if (inst->op == IROp::FNeg)
+			XOR(32, R(EAX), Imm32(0x80000000));
+		MOV(32, FPR(inst->dest), R(EAX));
+		break;
+
+	case IROp::FSqrt:
+		SQRTSS(XMM0, FPR(inst->src1));
+		MOVSS(FPR(inst->dest), XMM0);
+		break;
+
+	case IROp::FCvtSW:
+		CVTSI2SS(XMM0, FPR(inst->src1));
+		MOVSS(FPR(inst->dest), XMM0);
+		break;
+
+	case IROp::FMovFromGPR:
+		MOV(32, R(EAX), GPR(inst->src1));
+		MOV(32, FPR(inst->dest), R(EAX));
+		break;
+	case IROp::FMovToGPR:
+		MOV(32, R(EAX), FPR(inst->src1));
+		MOV(32, GPR(inst->dest), R(EAX));
+		break;
+
+	case IROp::FpCondToReg:
+		MOV(32, R(EAX), GPR(IRREG_FPCOND));
+		MOV(32, GPR(inst->dest), R(EAX));
+		break;
+	case IROp::ZeroFpCond:
+		MOV(32, GPR(IRREG_FPCOND), Imm32(0));
+		break;
+	case IROp::VfpuCtrlToReg:
+		MOV(32, R(EAX), GPR(IRREG_VFPU_CTRL_BASE + inst->src1));
+		MOV(32, GPR(inst->dest), R(EAX));
+		break;
+	case IROp::SetCtrlVFPU:
+		MOV(32, GPR(IRREG_VFPU_CTRL_BASE + inst->dest), Imm32(inst->constant));
+		break;
+	case IROp::SetCtrlVFPUReg:
+		MOV(32, R(EAX), GPR(inst->src1));
+		MOV(32, GPR(IRREG_VFPU_CTRL_BASE + inst->dest), R(EAX));
+		break;
+	case IROp::SetCtrlVFPUFReg:
+		MOV(32, R(EAX), FPR(inst->src1));
+		MOV(32, GPR(IRREG_VFPU_CTRL_BASE + inst->dest), R(EAX));
+		break;
+
+	case IROp::Vec4Init:
+		MOV(PTRBITS, R(RAX), ImmPtr(vec4InitValues[inst->src1]));
+		MOVAPS(XMM0, MatR(RAX));
+		MOVAPS(FPR(inst->dest), XMM0);
+		break;
+	case IROp::Vec4Shuffle:
+		MOVAPS(XMM0, FPR(inst->src1));
+		SHUFPS(XMM0, R(XMM0), inst->src2);
+		MOVAPS(FPR(inst->dest), XMM0);
+		break;
+	case IROp::Vec4Mov:
+		MOVAPS(XMM0, FPR(inst->src1));
+		MOVAPS(FPR(inst->dest), XMM0);
+		break;
+
+	case IROp::Vec4Add:
+	case IROp::Vec4Sub:
+	case IROp::Vec4Mul:
+	case IROp::Vec4Div:
+		MOVAPS(XMM0, FPR(inst->src1));
+		switch (inst->op) {
+		case IROp::Vec4Add: ADDPS(XMM0, FPR(inst->src2)); break;
+		case IROp::Vec4Sub: SUBPS(XMM0, FPR(inst->src2)); break;
+		case IROp::Vec4Mul: MULPS(XMM0, FPR(inst->src2)); break;
+		case IROp::Vec4Div: DIVPS(XMM0, FPR(inst->src2)); break;
+		default: break;
+		}
+		MOVAPS(FPR(inst->dest), XMM0);
+		break;
+
+	case IROp::Vec4Scale:
+		MOVSS(XMM1, FPR(inst->src2));
+		SHUFPS(XMM1, R(XMM1), 0);
+		MOVAPS(XMM0, FPR(inst->src1));
+		MULPS(XMM0, R(XMM1));
+		MOVAPS(FPR(inst->dest), XMM0);
+		break;
+
+	case IROp::Vec4Neg:
+	case IROp::Vec4Abs:
+		MOV(PTRBITS, R(RAX), ImmPtr(inst->op == IROp::Vec4Neg ? signBits : noSignMask));
+		MOVAPS(XMM0, FPR(inst->src1));
+		if (inst->op == IROp::Vec4Neg)
+			XORPS(XMM0, MatR(RAX));
+		else
+			ANDPS(XMM0, MatR(RAX));
+		MOVAPS(FPR(inst->dest), XMM0);
+		break;
+
+	case IROp::Vec4Dot:
+		// Sum in the same order as the interpreter, for identical rounding.
+		MOVSS(XMM0, FPR(inst->src1));
+		MULSS(XMM0, FPR(inst->src2));
+		for (int i = 1; i < 4; i++) {
+			MOVSS(XMM1, FPR(inst->src1 + i));
+			MULSS(XMM1, FPR(inst->src2 + i));
+			ADDSS(XMM0, R(XMM1));
+		}
+		MOVSS(FPR(inst->dest), XMM0);
+		break;
+
+	case IROp::Vec4ClampToZero:
+		// Expand the sign bit, and use andnot to zero negative values.
+		MOVAPS(XMM0, FPR(inst->src1));
+		MOVAPS(XMM1, R(XMM0));
+		PSRAD(XMM1, 31);
+		PANDN(XMM1, R(XMM0));
+		MOVAPS(FPR(inst->dest), XMM1);
+		break;
+
+	case IROp::ExitToConst:
+		CompileExitToConst(inst->constant);
+		break;
+	case IROp::ExitToReg:
+		MOV(32, R(EAX), GPR(inst->src1));
+		MOV(32, MIPSSTATE_VAR(pc), R(EAX));
+		JMP(dispatcher_, true);
+		break;
+	case IROp::ExitToPC:
+		JMP(dispatcher_, true);
+		break;
+
+	case IROp::ExitToConstIfEq:
+	case IROp::ExitToConstIfNeq:
+	case IROp::ExitToConstIfGtZ:
+	case IROp::ExitToConstIfGeZ:
+	case IROp::ExitToConstIfLtZ:
+	case IROp::ExitToConstIfLeZ:
+	{
+		CCFlags skipCond;
+		if (inst->op == IROp::ExitToConstIfEq || inst->op == IROp::ExitToConstIfNeq) {
+			MOV(32, R(EAX), GPR(inst->src1));
+			CMP(32, R(EAX), GPR(inst->src2));
+			skipCond = inst->op == IROp::ExitToConstIfEq ? CC_NE : CC_E;
+		} else {
+			CMP(32, GPR(inst->src1), Imm8(0));
+			switch (inst->op) {
+			case IROp::ExitToConstIfGtZ: skipCond = CC_LE; break;
+			case IROp::ExitToConstIfGeZ: skipCond = CC_L; break;
+			case IROp::ExitToConstIfLtZ: skipCond = CC_GE; break;
+			default: skipCond = CC_G; break;
 			}
 		}
+		FixupBranch skip = J_CC(skipCond);
+		CompileExitToConst(inst->constant);
+		SetJumpTarget(skip);
+		break;
 	}
 
+	case IROp::Downcount:
+		SUB(32, MIPSSTATE_VAR(downcount), Imm32(inst->constant));
+		break;
+	case IROp::Idle:
+		ABI_CallFunctionC((const void *)&CoreTiming::Idle, 0);
+		break;
+	case IROp::SetPC:
+		MOV(32, R(EAX), GPR(inst->src1));
+		MOV(32, MIPSSTATE_VAR(pc), R(EAX));
+		break;
+	case IROp::SetPCConst:
+		MOV(32, MIPSSTATE_VAR(pc), Imm32(inst->constant));
+		break;
+
+	case IROp::ApplyRoundingMode:
+	case IROp::RestoreRoundingMode:
+	case IROp::UpdateRoundingMode:
+		// Not implemented in the interpreter either.
+		break;
+
+	default:
+		// Syscalls, replacements, breakpoints, rare VFPU ops and tricky rounding all end up here.
+		CompileFallback(inst, true);
+		break;
+	}
+}
 
-}  // namespace
+}  // namespace MIPSComp
 
-#endif // PPSSPP_ARCH(X86) || PPSSPP_ARCH(AMD64)
+#endif // PPSSPP_ARCH(AMD64)
@@ -1,23 +1,89 @@
-#include "Core/MIPS/IR/IRInst.h"
+// Copyright (c) 2016- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#pragma once
+
+#include "ppsspp_config.h"
+
+#include <string>
+#include <vector>
+
 #include "Common/x64Emitter.h"
+#include "Core/MIPS/IR/IRInst.h"
+#include "Core/MIPS/IR/IRJit.h"
 
 namespace MIPSComp {
 
-class IRToNativeInterface {
+#if PPSSPP_ARCH(AMD64)
+
+// Converts each finished IR block straight to x86-64 code, as a drop-in replacement for IRInterpret().
+// MIPS state is accessed directly in memory, there's no register allocation across IR instructions yet.
+// Anything not handled natively calls back into the interpreter for that single instruction.
+class IRToX86 : public IRToNativeInterface, public Gen::XCodeBlock {
 public:
-	virtual ~IRToNativeInterface() {}
+	IRToX86(MIPSState *mipsState);
 
-	virtual void ConvertIRToNative(const IRInst *instructions, int count, const u32 *constants) = 0;
-};
+	const u8 *EmitBlock(const IRInst *instructions, int count) override;
+	void SetBlockEntry(int blockNum, const u8 *entry) override;
+	void ClearAllBlocks() override;
+	void RunDispatcher() override;
+	void SetLookupPages(const IRBlockCache::LookupEntry *const *pages) override;
+	void SetProfiling(IRBlockCache *blocks) override;
 
-
-class IRToX86 : public IRToNativeInterface {
-public:
-	void SetCodeBlock(Gen::XCodeBlock *code) { code_ = code; }
-	virtual void ConvertIRToNative(const IRInst *instructions, int count, const u32 *constants) override;
+	bool CodeInRange(const u8 *ptr) const override {
+		return IsInSpace(ptr);
+	}
+	bool DescribeCodePtr(const u8 *ptr, std::string &name) const override;
+	const u8 *GetDispatcher() const override { return dispatcher_; }
+	const u8 *GetCrashHandler() const override { return crashHandler_; }
 
 private:
-	Gen::XCodeBlock *code_;
+	void GenerateFixedCode();
+	void CompileInstruction(const IRInst *inst);
+	void CompileFallback(const IRInst *inst, bool checkExit);
+	void CompileExitToConst(u32 pc);
+	void CompileAddress(const IRInst *inst);
+	void UpdateEntryTable();
+	void EndProfileSample();
+	static const u8 *ProfileEnterBlock(IRToX86 *self, u32 blockNum);
+
+	// Read directly by the dispatcher, so it must not move.
+	struct EntryTable {
+		const u8 *const *entries;
+		u32 count;
+		u32 profiling;
+		const IRBlockCache::LookupEntry *const *lookupPages;
+	};
+
+	MIPSState *mips_;
+	std::vector<const u8 *> entries_;
+	EntryTable table_{};
+
+	const u8 *enterDispatcher_ = nullptr;
+	const u8 *dispatcher_ = nullptr;
+	const u8 *crashHandler_ = nullptr;
+	const u8 *quitLoop_ = nullptr;
+	int blocksStartOffset_ = 0;
+
+	IRBlockCache *profileBlocks_ = nullptr;
+	int profileBlock_ = -1;
+	double profileStart_ = 0.0;
 };
 
+#endif
+
 }  // namespace
@@ -519,6 +519,7 @@ void PSP_Shutdown() {
 		MIPSAnalyst::StoreHashMap();
 	}
 #endif
+	MIPSAnalyst::StoreJitBlockCache();
 
 	if (pspIsIniting)
 		Core_NotifyLifecycle(CoreLifecycle::START_COMPLETE);
@@ -538,12 +539,15 @@ void PSP_Shutdown() {
 void PSP_BeginHostFrame() {
 	// Reapply the graphics state of the PSP
 	if (gpu) {
+		gpu->SyncThread();
 		gpu->BeginHostFrame();
 	}
 }
 
 void PSP_EndHostFrame() {
 	if (gpu) {
+		// Lists may still be running on the GE thread, they need to be in this frame.
+		gpu->SyncThread();
 		gpu->EndHostFrame();
 	}
 	SaveState::Cleanup();
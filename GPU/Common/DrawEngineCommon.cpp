@@ -19,7 +19,9 @@
 
 #include "Common/Data/Convert/ColorConv.h"
 #include "Common/Profiler/Profiler.h"
+#include "Common/TimeUtil.h"
 #include "Core/Config.h"
+#include "Core/System.h"
 #include "GPU/Common/DrawEngineCommon.h"
 #include "GPU/Common/SplineCommon.h"
 #include "GPU/Common/VertexDecoderCommon.h"
@@ -514,6 +516,10 @@ bool DrawEngineCommon::ApplyFramebufferRead(bool *fboTexNeedsBind) {
 
 void DrawEngineCommon::DecodeVertsStep(u8 *dest, int &i, int &decodedVerts) {
 	PROFILE_THIS_SCOPE("vertdec");
+	double start = 0.0;
+	if (coreCollectDebugStats) {
+		start = time_now_d();
+	}
 
 	const DeferredDrawCall &dc = drawCalls[i];
 
@@ -598,6 +604,10 @@ void DrawEngineCommon::DecodeVertsStep(u8 *dest, int &i, int &decodedVerts) {
 		indexGen.Advance(vertexCount);
 		i = lastMatch;
 	}
+
+	if (coreCollectDebugStats) {
+		gpuStats.msDecodingVertices += time_now_d() - start;
+	}
 }
 
 inline u32 ComputeMiniHashRange(const void *ptr, size_t sz) {
@@ -682,6 +692,62 @@ uint64_t DrawEngineCommon::ComputeHash() {
 	return fullhash;
 }
 
+bool DrawEngineCommon::CanUseVertexCache() const {
+	// Cannot cache vertex data with morph enabled.
+	if (!g_Config.bVertexCache || (lastVType_ & GE_VTYPE_MORPHCOUNT_MASK) != 0)
+		return false;
+	// Also avoid caching when software skinning.
+	if (g_Config.bSoftwareSkinning && (lastVType_ & GE_VTYPE_WEIGHT_MASK))
+		return false;
+	return true;
+}
+
+void DrawEngineCommon::StartHashingVertexArray(VertexArrayInfoCommon *vai) {
+	vai->hash = ComputeHash();
+	vai->minihash = ComputeMiniHash();
+	vai->status = VertexArrayInfoCommon::VAI_HASHING;
+	vai->drawsUntilNextFullHash = 0;
+}
+
+bool DrawEngineCommon::CheckVertexArrayHash(VertexArrayInfoCommon *vai) {
+	if (vai->drawsUntilNextFullHash != 0) {
+		vai->drawsUntilNextFullHash--;
+		return ComputeMiniHash() == vai->minihash;
+	}
+
+	// Let's try to skip a full hash if mini would fail.
+	if (ComputeMiniHash() != vai->minihash || ComputeHash() != vai->hash)
+		return false;
+
+	if (vai->numVerts > 64) {
+		// exponential backoff up to 16 draws, then every 24
+		vai->drawsUntilNextFullHash = std::min((int)VAI_MAX_DRAWS_BETWEEN_FULL_HASH, vai->numFrames);
+	} else {
+		// Lower numbers seem much more likely to change.
+		vai->drawsUntilNextFullHash = 0;
+	}
+	// TODO: tweak
+	//if (vai->numFrames > 1000) {
+	//	vai->status = VertexArrayInfoCommon::VAI_RELIABLE;
+	//}
+	return true;
+}
+
+void DrawEngineCommon::SaveVertexArrayDraw(VertexArrayInfoCommon *vai) {
+	vai->numVerts = indexGen.VertexCount();
+	vai->prim = indexGen.Prim();
+	vai->maxIndex = indexGen.MaxIndex();
+	vai->flags = gstate_c.vertexFullAlpha ? VAI_FLAG_VERTEXFULLALPHA : 0;
+}
+
+bool DrawEngineCommon::ShouldDecimateVertexArray(const VertexArrayInfoCommon *vai, int &unreliableLeft) {
+	if (vai->status == VertexArrayInfoCommon::VAI_UNRELIABLE) {
+		// We limit killing unreliable so we don't rehash too often.
+		return vai->lastFrame < gpuStats.numFlips - VAI_UNRELIABLE_KILL_AGE && --unreliableLeft >= 0;
+	}
+	return vai->lastFrame < gpuStats.numFlips - VAI_KILL_AGE;
+}
+
 // vertTypeID is the vertex type but with the UVGen mode smashed into the top bits.
 void DrawEngineCommon::SubmitPrim(void *verts, void *inds, GEPrimitiveType prim, int vertexCount, u32 vertTypeID, int cullMode, int *bytesRead) {
 	if (!indexGen.PrimCompatible(prevPrim_, prim) || numDrawCalls >= MAX_DEFERRED_DRAW_CALLS || vertexCountInDrawCalls_ + vertexCount > VERTEX_BUFFER_MAX) {
@@ -35,12 +35,59 @@ enum {
 	DECODED_INDEX_BUFFER_SIZE = VERTEX_BUFFER_MAX * 16,
 };
 
+enum {
+	VERTEXCACHE_DECIMATION_INTERVAL = 17,
+	VAI_KILL_AGE = 120,
+	VAI_UNRELIABLE_KILL_AGE = 240,
+	VAI_UNRELIABLE_KILL_MAX = 4,
+	// Large arrays back off full hashes up to this many draws apart.
+	VAI_MAX_DRAWS_BETWEEN_FULL_HASH = 24,
+};
+
 inline uint32_t GetVertTypeID(uint32_t vertType, int uvGenMode) {
 	// As the decoder depends on the UVGenMode when we use UV prescale, we simply mash it
 	// into the top of the verttype where there are unused bits.
 	return (vertType & 0xFFFFFF) | (uvGenMode << 24);
 }
 
+enum {
+	VAI_FLAG_VERTEXFULLALPHA = 1,
+};
+
+// Tracks the vertex data of a flushed batch of draws across frames, so that static geometry can be
+// decoded and uploaded once, and then drawn from a cached buffer. Backends derive from this to add
+// their own buffer handles, and look it up by ComputeVertexCacheID() in their vai_ map.
+// Try to keep this POD.
+class VertexArrayInfoCommon {
+public:
+	VertexArrayInfoCommon() {
+		lastFrame = gpuStats.numFlips;
+	}
+
+	enum VAIStatus : uint8_t {
+		VAI_NEW,
+		VAI_HASHING,
+		VAI_RELIABLE,  // cache, don't hash
+		VAI_UNRELIABLE,  // never cache
+	};
+
+	uint64_t hash = 0;
+	u32 minihash = 0;
+
+	// Precalculated parameters for the draw call.
+	u16 numVerts = 0;
+	u16 maxIndex = 0;
+	s8 prim = GE_PRIM_INVALID;
+	VAIStatus status = VAI_NEW;
+
+	// ID information
+	int numDraws = 0;
+	int numFrames = 0;
+	int lastFrame;  // So that we can forget.
+	u16 drawsUntilNextFullHash = 0;
+	u8 flags = 0;
+};
+
 struct SimpleVertex;
 namespace Spline { struct Weight2D; }
 
@@ -111,6 +158,28 @@ class DrawEngineCommon {
 	u32 ComputeMiniHash();
 	uint64_t ComputeHash();
 
+	// Whether the current batch may be drawn from the vertex cache at all.
+	bool CanUseVertexCache() const;
+	u32 ComputeVertexCacheID() const {
+		// This can have an effect on which UV decoder we need to use! And hence what the decoded data will look like. See #9263
+		return dcid_ ^ gstate.getUVGenMode();
+	}
+	// Hashes a new vertex array and moves it to VAI_HASHING.
+	void StartHashingVertexArray(VertexArrayInfoCommon *vai);
+	// Checks a VAI_HASHING vertex array against the current data. Returns false if it changed,
+	// in which case the backend should mark it unreliable and decode as usual.
+	bool CheckVertexArrayHash(VertexArrayInfoCommon *vai);
+	// Remembers what the decode just produced, to draw from the cached buffers later.
+	void SaveVertexArrayDraw(VertexArrayInfoCommon *vai);
+	static void CountVertexArrayDraw(VertexArrayInfoCommon *vai) {
+		vai->numDraws++;
+		if (vai->lastFrame != gpuStats.numFlips) {
+			vai->numFrames++;
+		}
+	}
+	// Used while decimating the backend's vai_, unreliableLeft limits how many unreliable arrays die per pass.
+	static bool ShouldDecimateVertexArray(const VertexArrayInfoCommon *vai, int &unreliableLeft);
+
 	// Vertex decoding
 	void DecodeVertsStep(u8 *dest, int &i, int &decodedVerts);
 
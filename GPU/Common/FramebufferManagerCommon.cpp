@@ -24,11 +24,13 @@
 #include "Common/Data/Convert/ColorConv.h"
 #include "Common/Data/Text/I18n.h"
 #include "Common/Common.h"
+#include "Common/TimeUtil.h"
 #include "Core/Config.h"
 #include "Core/ConfigValues.h"
 #include "Core/Core.h"
 #include "Core/CoreParameter.h"
 #include "Core/Debugger/MemBlockInfo.h"
+#include "Core/ELF/ParamSFO.h"
 #include "Core/Host.h"
 #include "Core/MIPS/MIPS.h"
 #include "Core/Reporting.h"
@@ -53,6 +55,9 @@ FramebufferManagerCommon::~FramebufferManagerCommon() {
 	DeviceLost();
 
 	DecimateFBOs();
+	if (readbacksTotal_ > 0) {
+		INFO_LOG(FRAMEBUF, "Framebuffer readbacks for %s: %d (%d merged), stalled %0.1f ms", g_paramSFO.GetDiscID().c_str(), readbacksTotal_, readbacksMergedTotal_, readbackStallTotal_ * 1000.0);
+	}
 	for (auto vfb : vfbs_) {
 		DestroyFramebuf(vfb);
 	}
@@ -453,6 +458,9 @@ VirtualFramebuffer *FramebufferManagerCommon::DoSetRenderFrameBuffer(const Frame
 }
 
 void FramebufferManagerCommon::DestroyFramebuf(VirtualFramebuffer *v) {
+	if (IsReadbackPending(v))
+		FlushPendingReadbacks();
+
 	// Notify the texture cache of both the color and depth buffers.
 	textureCache_->NotifyFramebuffer(v, NOTIFY_FB_DESTROYED);
 	if (v->fbo) {
@@ -698,6 +706,10 @@ void FramebufferManagerCommon::ReinterpretFramebuffer(VirtualFramebuffer *vfb, G
 }
 
 void FramebufferManagerCommon::NotifyRenderFramebufferSwitched(VirtualFramebuffer *prevVfb, VirtualFramebuffer *vfb, bool isClearingDepth) {
+	// Must download before drawing over it again.
+	if (IsReadbackPending(vfb))
+		FlushPendingReadbacks();
+
 	if (ShouldDownloadFramebuffer(vfb) && !vfb->memoryUpdated) {
 		ReadFramebufferToMemory(vfb, 0, 0, vfb->width, vfb->height);
 		vfb->usageFlags = (vfb->usageFlags | FB_USAGE_DOWNLOAD) & ~FB_USAGE_DOWNLOAD_CLEAR;
@@ -753,6 +765,8 @@ void FramebufferManagerCommon::NotifyRenderFramebufferSwitched(VirtualFramebuffe
 }
 
 void FramebufferManagerCommon::NotifyVideoUpload(u32 addr, int size, int width, GEBufferFormat fmt) {
+	FlushPendingReadbacks();
+
 	// Note: UpdateFromMemory() is still called later.
 	// This is a special case where we have extra information prior to the invalidation.
 
@@ -782,6 +796,8 @@ void FramebufferManagerCommon::NotifyVideoUpload(u32 addr, int size, int width,
 }
 
 void FramebufferManagerCommon::UpdateFromMemory(u32 addr, int size, bool safe) {
+	FlushPendingReadbacks();
+
 	// Take off the uncached flag from the address. Not to be confused with the start of VRAM.
 	addr &= 0x3FFFFFFF;
 	// TODO: Could go through all FBOs, but probably not important?
@@ -1035,7 +1051,7 @@ void FramebufferManagerCommon::DownloadFramebufferOnSwitch(VirtualFramebuffer *v
 		// To support this, we save the first frame to memory when we have a safe w/h.
 		// Saving each frame would be slow.
 		if (!g_Config.bDisableSlowFramebufEffects && !PSP_CoreParameter().compat.flags().DisableFirstFrameReadback) {
-			ReadFramebufferToMemory(vfb, 0, 0, vfb->safeWidth, vfb->safeHeight);
+			QueueReadback(vfb, 0, 0, vfb->safeWidth, vfb->safeHeight);
 			vfb->usageFlags = (vfb->usageFlags | FB_USAGE_DOWNLOAD) & ~FB_USAGE_DOWNLOAD_CLEAR;
 			vfb->firstFrameSaved = true;
 			vfb->safeWidth = 0;
@@ -1051,6 +1067,7 @@ void FramebufferManagerCommon::SetViewport2D(int x, int y, int w, int h) {
 
 void FramebufferManagerCommon::CopyDisplayToOutput(bool reallyDirty) {
 	DownloadFramebufferOnSwitch(currentRenderVfb_);
+	FlushPendingReadbacks();
 	shaderManager_->DirtyLastShader();
 
 	currentRenderVfb_ = nullptr;
@@ -1202,7 +1219,7 @@ void FramebufferManagerCommon::DecimateFBOs() {
 		int age = frameLastFramebufUsed_ - std::max(vfb->last_frame_render, vfb->last_frame_used);
 
 		if (ShouldDownloadFramebuffer(vfb) && age == 0 && !vfb->memoryUpdated) {
-			ReadFramebufferToMemory(vfb, 0, 0, vfb->width, vfb->height);
+			QueueReadback(vfb, 0, 0, vfb->width, vfb->height);
 			vfb->usageFlags = (vfb->usageFlags | FB_USAGE_DOWNLOAD) & ~FB_USAGE_DOWNLOAD_CLEAR;
 			vfb->firstFrameSaved = true;
 		}
@@ -1218,6 +1235,7 @@ void FramebufferManagerCommon::DecimateFBOs() {
 			}
 		}
 	}
+	FlushPendingReadbacks();
 
 	for (auto it = tempFBOs_.begin(); it != tempFBOs_.end(); ) {
 		int age = frameLastFramebufUsed_ - it->second.last_frame_used;
@@ -1245,6 +1263,8 @@ void FramebufferManagerCommon::DecimateFBOs() {
 void FramebufferManagerCommon::ResizeFramebufFBO(VirtualFramebuffer *vfb, int w, int h, bool force, bool skipCopy) {
 	_dbg_assert_(w > 0);
 	_dbg_assert_(h > 0);
+	if (IsReadbackPending(vfb))
+		FlushPendingReadbacks();
 	VirtualFramebuffer old = *vfb;
 
 	int oldWidth = vfb->bufferWidth;
@@ -1349,6 +1369,7 @@ bool FramebufferManagerCommon::NotifyFramebufferCopy(u32 src, u32 dst, int size,
 	if (size == 0) {
 		return false;
 	}
+	FlushPendingReadbacks();
 
 	dst &= 0x3FFFFFFF;
 	src &= 0x3FFFFFFF;
@@ -1679,6 +1700,7 @@ VirtualFramebuffer *FramebufferManagerCommon::FindDownloadTempBuffer(VirtualFram
 }
 
 void FramebufferManagerCommon::ApplyClearToMemory(int x1, int y1, int x2, int y2, u32 clearColor) {
+	FlushPendingReadbacks();
 	if (currentRenderVfb_) {
 		if ((currentRenderVfb_->usageFlags & FB_USAGE_DOWNLOAD_CLEAR) != 0) {
 			// Already zeroed in memory.
@@ -1764,6 +1786,7 @@ void FramebufferManagerCommon::ApplyClearToMemory(int x1, int y1, int x2, int y2
 }
 
 bool FramebufferManagerCommon::NotifyBlockTransferBefore(u32 dstBasePtr, int dstStride, int dstX, int dstY, u32 srcBasePtr, int srcStride, int srcX, int srcY, int width, int height, int bpp, u32 skipDrawReason) {
+	FlushPendingReadbacks();
 	if (!useBufferedRendering_) {
 		return false;
 	}
@@ -1841,6 +1864,7 @@ bool FramebufferManagerCommon::NotifyBlockTransferBefore(u32 dstBasePtr, int dst
 }
 
 void FramebufferManagerCommon::NotifyBlockTransferAfter(u32 dstBasePtr, int dstStride, int dstX, int dstY, u32 srcBasePtr, int srcStride, int srcX, int srcY, int width, int height, int bpp, u32 skipDrawReason) {
+	FlushPendingReadbacks();
 	// If it's a block transfer direct to the screen, and we're not using buffers, draw immediately.
 	// We may still do a partial block draw below if this doesn't pass.
 	if (!useBufferedRendering_ && dstStride >= 480 && width >= 480 && height == 272) {
@@ -2204,7 +2228,78 @@ void FramebufferManagerCommon::PackFramebufferSync_(VirtualFramebuffer *vfb, int
 	gpuStats.numReadbacks++;
 }
 
+void FramebufferManagerCommon::PackFramebufferTimed(VirtualFramebuffer *vfb, int x, int y, int w, int h) {
+	double start = time_now_d();
+	PackFramebufferSync_(vfb, x, y, w, h);
+	double stall = time_now_d() - start;
+
+	gpuStats.msReadbackStalls += stall;
+	readbackStallTotal_ += stall;
+	readbacksTotal_++;
+}
+
+void FramebufferManagerCommon::QueueReadback(VirtualFramebuffer *vfb, int x, int y, int w, int h) {
+	if (!vfb || !vfb->fbo)
+		return;
+
+	for (PendingReadback &pending : pendingReadbacks_) {
+		if (pending.vfb == vfb) {
+			// Just download the bounding rect, it's usually the whole thing anyway.
+			int x2 = std::max(pending.x + pending.w, x + w);
+			int y2 = std::max(pending.y + pending.h, y + h);
+			pending.x = std::min(pending.x, x);
+			pending.y = std::min(pending.y, y);
+			pending.w = x2 - pending.x;
+			pending.h = y2 - pending.y;
+			gpuStats.numReadbacksMerged++;
+			readbacksMergedTotal_++;
+			return;
+		}
+	}
+
+	pendingReadbacks_.push_back({ vfb, x, y, w, h });
+}
+
+bool FramebufferManagerCommon::IsReadbackPending(const VirtualFramebuffer *vfb) const {
+	for (const PendingReadback &pending : pendingReadbacks_) {
+		if (pending.vfb == vfb)
+			return true;
+	}
+	return false;
+}
+
+void FramebufferManagerCommon::FlushPendingReadbacks() {
+	if (pendingReadbacks_.empty())
+		return;
+
+	// Take them first, the blits below can end up back here.
+	std::vector<PendingReadback> pending;
+	pending.swap(pendingReadbacks_);
+	for (const PendingReadback &readback : pending) {
+		ReadFramebufferToMemoryNoRebind(readback.vfb, readback.x, readback.y, readback.w, readback.h);
+	}
+
+	textureCache_->ForgetLastTexture();
+	RebindFramebuffer("RebindFramebuffer - FlushPendingReadbacks");
+}
+
+void FramebufferManagerCommon::FlushPendingReadbacksInRange(u32 addr, u32 size) {
+	addr &= 0x3FFFFFFF;
+	for (const PendingReadback &pending : pendingReadbacks_) {
+		const u32 fb_address = pending.vfb->fb_address & 0x3FFFFFFF;
+		if (addr < fb_address + ColorBufferByteSize(pending.vfb) && fb_address < addr + size) {
+			FlushPendingReadbacks();
+			return;
+		}
+	}
+}
+
 void FramebufferManagerCommon::ReadFramebufferToMemory(VirtualFramebuffer *vfb, int x, int y, int w, int h) {
+	QueueReadback(vfb, x, y, w, h);
+	FlushPendingReadbacks();
+}
+
+void FramebufferManagerCommon::ReadFramebufferToMemoryNoRebind(VirtualFramebuffer *vfb, int x, int y, int w, int h) {
 	// Clamp to bufferWidth. Sometimes block transfers can cause this to hit.
 	if (x + w >= vfb->bufferWidth) {
 		w = vfb->bufferWidth - x;
@@ -2242,17 +2337,14 @@ void FramebufferManagerCommon::ReadFramebufferToMemory(VirtualFramebuffer *vfb,
 
 		if (vfb->renderWidth == vfb->width && vfb->renderHeight == vfb->height) {
 			// No need to blit
-			PackFramebufferSync_(vfb, x, y, w, h);
+			PackFramebufferTimed(vfb, x, y, w, h);
 		} else {
 			VirtualFramebuffer *nvfb = FindDownloadTempBuffer(vfb);
 			if (nvfb) {
 				BlitFramebuffer(nvfb, x, y, vfb, x, y, w, h, 0, "Blit_ReadFramebufferToMemory");
-				PackFramebufferSync_(nvfb, x, y, w, h);
+				PackFramebufferTimed(nvfb, x, y, w, h);
 			}
 		}
-
-		textureCache_->ForgetLastTexture();
-		RebindFramebuffer("RebindFramebuffer - ReadFramebufferToMemory");
 	}
 }
 
@@ -2280,6 +2372,7 @@ void FramebufferManagerCommon::DownloadFramebufferForClut(u32 fb_address, u32 lo
 
 		// We might still have a pending draw to the fb in question, flush if so.
 		FlushBeforeCopy();
+		FlushPendingReadbacks();
 
 		// No need to download if we already have it.
 		if (w > 0 && h > 0 && !vfb->memoryUpdated && vfb->clutUpdatedBytes < loadBytes) {
@@ -2295,7 +2388,7 @@ void FramebufferManagerCommon::DownloadFramebufferForClut(u32 fb_address, u32 lo
 			VirtualFramebuffer *nvfb = FindDownloadTempBuffer(vfb);
 			if (nvfb) {
 				BlitFramebuffer(nvfb, x, y, vfb, x, y, w, h, 0, "Blit_DownloadFramebufferForClut");
-				PackFramebufferSync_(nvfb, x, y, w, h);
+				PackFramebufferTimed(nvfb, x, y, w, h);
 			}
 
 			textureCache_->ForgetLastTexture();
@@ -244,8 +244,13 @@ class FramebufferManagerCommon {
 	void NotifyBlockTransferAfter(u32 dstBasePtr, int dstStride, int dstX, int dstY, u32 srcBasePtr, int srcStride, int srcX, int srcY, int w, int h, int bpp, u32 skipDrawReason);
 
 	bool BindFramebufferAsColorTexture(int stage, VirtualFramebuffer *framebuffer, int flags);
+	// Also does any queued downloads, so they share the stall.
 	void ReadFramebufferToMemory(VirtualFramebuffer *vfb, int x, int y, int w, int h);
 
+	// Downloads from QueueReadback() wait until something may look at the memory.
+	void FlushPendingReadbacks();
+	void FlushPendingReadbacksInRange(u32 addr, u32 size);
+
 	void DownloadFramebufferForClut(u32 fb_address, u32 loadBytes);
 	void DrawFramebufferToOutput(const u8 *srcPixels, GEBufferFormat srcPixelFormat, int srcStride);
 
@@ -362,6 +367,11 @@ class FramebufferManagerCommon {
 
 	bool ShouldDownloadFramebuffer(const VirtualFramebuffer *vfb) const;
 	void DownloadFramebufferOnSwitch(VirtualFramebuffer *vfb);
+	// Merges with any download already queued for the same framebuffer.
+	void QueueReadback(VirtualFramebuffer *vfb, int x, int y, int w, int h);
+	bool IsReadbackPending(const VirtualFramebuffer *vfb) const;
+	void ReadFramebufferToMemoryNoRebind(VirtualFramebuffer *vfb, int x, int y, int w, int h);
+	void PackFramebufferTimed(VirtualFramebuffer *vfb, int x, int y, int w, int h);
 	void FindTransferFramebuffers(VirtualFramebuffer *&dstBuffer, VirtualFramebuffer *&srcBuffer, u32 dstBasePtr, int dstStride, int &dstX, int &dstY, u32 srcBasePtr, int srcStride, int &srcX, int &srcY, int &srcWidth, int &srcHeight, int &dstWidth, int &dstHeight, int bpp);
 	VirtualFramebuffer *FindDownloadTempBuffer(VirtualFramebuffer *vfb);
 	virtual void UpdateDownloadTempBuffer(VirtualFramebuffer *nvfb) {}
@@ -413,6 +423,20 @@ class FramebufferManagerCommon {
 
 	bool gameUsesSequentialCopies_ = false;
 
+	struct PendingReadback {
+		VirtualFramebuffer *vfb;
+		int x;
+		int y;
+		int w;
+		int h;
+	};
+	std::vector<PendingReadback> pendingReadbacks_;
+
+	// For the whole game, logged on shutdown.
+	int readbacksTotal_ = 0;
+	int readbacksMergedTotal_ = 0;
+	double readbackStallTotal_ = 0.0;
+
 	// Sampled in BeginFrame/UpdateSize for safety.
 	float renderWidth_ = 0.0f;
 	float renderHeight_ = 0.0f;
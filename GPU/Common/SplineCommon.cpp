@@ -17,10 +17,15 @@
 
 #include <string.h>
 #include <algorithm>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
 
 #include "Common/Profiler/Profiler.h"
 
 #include "Common/CPUDetect.h"
+#include "Common/Thread/ParallelLoop.h"
+#include "ext/xxhash.h"
 
 #include "GPU/Common/GPUStateUtils.h"
 #include "GPU/Common/SplineCommon.h"
@@ -28,6 +33,14 @@
 #include "GPU/ge_constants.h"
 #include "GPU/GPUState.h"  // only needed for UVScale stuff
 
+// Below this many output vertices, the thread handoff costs more than it saves.
+#define TESS_MIN_PARALLEL_VERTICES 4096
+#define TESS_MIN_VERTICES_PER_THREAD 1024
+
+#define TESS_CACHE_DECIMATION_INTERVAL 30
+#define TESS_CACHE_KILL_AGE 60
+#define TESS_CACHE_MAX_BYTES (8 * 1024 * 1024)
+
 class SimpleBufferManager {
 private:
 	u8 *buf_;
@@ -341,9 +354,11 @@ class SubdivisionSurface {
 		const float inv_u = 1.0f / (float)surface.tess_u;
 		const float inv_v = 1.0f / (float)surface.tess_v;
 
-		for (int patch_u = 0; patch_u < surface.num_patches_u; ++patch_u) {
-			const int start_u = surface.GetTessStart(patch_u);
-			for (int patch_v = 0; patch_v < surface.num_patches_v; ++patch_v) {
+		auto tessPatches = [&](int lower, int upper) {
+			for (int patch = lower; patch < upper; ++patch) {
+				const int patch_u = patch % surface.num_patches_u;
+				const int patch_v = patch / surface.num_patches_u;
+				const int start_u = surface.GetTessStart(patch_u);
 				const int start_v = surface.GetTessStart(patch_v);
 
 				// Prepare 4x4 control points to tessellate
@@ -401,6 +416,15 @@ class SubdivisionSurface {
 					}
 				}
 			}
+		};
+
+		// Patches write separate vertices (splines skip the shared edges), so they can be split up freely.
+		const int numPatches = surface.num_patches_u * surface.num_patches_v;
+		const int vertsPerPatch = (surface.tess_u + 1) * (surface.tess_v + 1);
+		if (numPatches > 1 && numPatches * vertsPerPatch >= TESS_MIN_PARALLEL_VERTICES) {
+			ParallelRangeLoop(&g_threadManager, tessPatches, 0, numPatches, std::max(1, TESS_MIN_VERTICES_PER_THREAD / vertsPerPatch));
+		} else {
+			tessPatches(0, numPatches);
 		}
 
 		surface.BuildIndex(output.indices, output.count);
@@ -437,6 +461,80 @@ void SoftwareTessellation(OutputBuffers &output, const Surface &surface, u32 ori
 template void SoftwareTessellation<BezierSurface>(OutputBuffers &output, const BezierSurface &surface, u32 origVertType, const ControlPoints &points);
 template void SoftwareTessellation<SplineSurface>(OutputBuffers &output, const SplineSurface &surface, u32 origVertType, const ControlPoints &points);
 
+const TessellationCache::Entry *TessellationCache::Get(u64 key, bool *store) {
+	Decimate();
+
+	auto it = entries_.find(key);
+	if (it == entries_.end()) {
+		entries_[key].lastFrame = gpuStats.numFlips;
+		*store = false;
+		return nullptr;
+	}
+
+	Entry &entry = it->second;
+	entry.lastFrame = gpuStats.numFlips;
+	*store = entry.count == 0;
+	return entry.count != 0 ? &entry : nullptr;
+}
+
+void TessellationCache::Store(u64 key, const OutputBuffers &output, int numVertices) {
+	size_t bytes = numVertices * sizeof(SimpleVertex) + output.count * sizeof(u16);
+	if (totalBytes_ + bytes > TESS_CACHE_MAX_BYTES)
+		Clear();
+
+	Entry &entry = entries_[key];
+	entry.vertices.assign(output.vertices, output.vertices + numVertices);
+	entry.indices.assign(output.indices, output.indices + output.count);
+	entry.count = output.count;
+	entry.lastFrame = gpuStats.numFlips;
+	totalBytes_ += bytes;
+}
+
+void TessellationCache::Clear() {
+	entries_.clear();
+	totalBytes_ = 0;
+}
+
+void TessellationCache::Decimate() {
+	if (gpuStats.numFlips - lastDecimation_ < TESS_CACHE_DECIMATION_INTERVAL)
+		return;
+	lastDecimation_ = gpuStats.numFlips;
+
+	const int threshold = gpuStats.numFlips - TESS_CACHE_KILL_AGE;
+	for (auto it = entries_.begin(); it != entries_.end(); ) {
+		if (it->second.lastFrame < threshold) {
+			totalBytes_ -= it->second.vertices.size() * sizeof(SimpleVertex) + it->second.indices.size() * sizeof(u16);
+			it = entries_.erase(it);
+		} else {
+			++it;
+		}
+	}
+}
+
+static TessellationCache tessCache;
+
+template<class Surface>
+u64 ComputeTessCacheKey(const Surface &surface, u32 origVertType, const SimpleVertex *controlPoints, int numControlPoints, const void *indices, int indicesSize) {
+	// Everything the software tessellation output depends on, besides the control points.
+	const int state[] = {
+		// The same points and sizes give different output for beziers and splines.
+		std::is_same<Surface, SplineSurface>::value ? 1 : 0,
+		surface.tess_u, surface.tess_v,
+		surface.num_points_u, surface.num_points_v,
+		surface.type_u, surface.type_v,
+		(int)surface.primType, surface.patchFacing ? 1 : 0,
+		(int)origVertType, gstate.isLightingEnabled() ? 1 : 0,
+	};
+	u64 key = XXH3_64bits(state, sizeof(state));
+	key = XXH3_64bits_withSeed(controlPoints, sizeof(SimpleVertex) * numControlPoints, key);
+	if (indices)
+		key = XXH3_64bits_withSeed(indices, indicesSize, key);
+	return key;
+}
+
+template u64 ComputeTessCacheKey<BezierSurface>(const BezierSurface &surface, u32 origVertType, const SimpleVertex *controlPoints, int numControlPoints, const void *indices, int indicesSize);
+template u64 ComputeTessCacheKey<SplineSurface>(const SplineSurface &surface, u32 origVertType, const SimpleVertex *controlPoints, int numControlPoints, const void *indices, int indicesSize);
+
 template<class Surface>
 static void HardwareTessellation(OutputBuffers &output, const Surface &surface, u32 origVertType,
 	const SimpleVertex *const *points, TessellationDataTransfer *tessDataTransfer) {
@@ -483,6 +581,7 @@ using namespace Spline;
 void DrawEngineCommon::ClearSplineBezierWeights() {
 	Bezier3DWeight::weightsCache.Clear();
 	Spline3DWeight::weightsCache.Clear();
+	tessCache.Clear();
 }
 
 // Specialize to make instance (to avoid link error).
@@ -553,8 +652,21 @@ void DrawEngineCommon::SubmitCurve(const void *control_points, const void *indic
 	if (CanUseHardwareTessellation(surface.primType)) {
 		HardwareTessellation(output, surface, origVertType, points, tessDataTransfer);
 	} else {
-		ControlPoints cpoints(points, num_points, managedBuf);
-		SoftwareTessellation(output, surface, origVertType, cpoints);
+		int numControlPoints = index_upper_bound - index_lower_bound + 1;
+		u64 cacheKey = ComputeTessCacheKey(surface, origVertType, simplified_control_points + index_lower_bound, numControlPoints, indices, num_points * IndexSize(origVertType));
+		bool store;
+		const TessellationCache::Entry *cached = tessCache.Get(cacheKey, &store);
+		if (cached) {
+			// Safe to point at, nothing touches the cache until the flush below is done.
+			output.vertices = const_cast<SimpleVertex *>(cached->vertices.data());
+			output.indices = const_cast<u16 *>(cached->indices.data());
+			output.count = cached->count;
+		} else {
+			ControlPoints cpoints(points, num_points, managedBuf);
+			SoftwareTessellation(output, surface, origVertType, cpoints);
+			if (store)
+				tessCache.Store(cacheKey, output, surface.GetVertexCount());
+		}
 	}
 
 	u32 vertTypeWithIndex16 = (vertType & ~GE_VTYPE_IDX_MASK) | GE_VTYPE_IDX_16BIT;
@@ -17,6 +17,7 @@
 
 #pragma once
 #include <unordered_map>
+#include <vector>
 
 #include "Common/CommonTypes.h"
 #include "Common/Swap.h"
@@ -59,7 +60,8 @@ struct SurfaceInfo {
 	int tess_u, tess_v;
 	int num_points_u, num_points_v;
 	int num_patches_u, num_patches_v;
-	int type_u, type_v;
+	// Only used by splines.
+	int type_u = 0, type_v = 0;
 	GEPatchPrimType primType;
 	bool patchFacing;
 
@@ -109,6 +111,8 @@ struct BezierSurface : public SurfaceInfo {
 		return index_v * (tess_u + 1) + index_u + num_verts_per_patch * patch_index;
 	}
 
+	int GetVertexCount() const { return num_verts_per_patch * num_patches_u * num_patches_v; }
+
 	void BuildIndex(u16 *indices, int &count) const {
 		for (int patch_u = 0; patch_u < num_patches_u; ++patch_u) {
 			for (int patch_v = 0; patch_v < num_patches_v; ++patch_v) {
@@ -146,6 +150,8 @@ struct SplineSurface : public SurfaceInfo {
 		return index_v * num_vertices_u + index_u;
 	}
 
+	int GetVertexCount() const { return num_vertices_u * (num_patches_v * tess_v + 1); }
+
 	void BuildIndex(u16 *indices, int &count) const {
 		Spline::BuildIndex(indices, count, num_patches_u * tess_u, num_patches_v * tess_v, primType);
 	}
@@ -205,6 +211,36 @@ struct OutputBuffers {
 template<class Surface>
 void SoftwareTessellation(OutputBuffers &output, const Surface &surface, u32 origVertType, const ControlPoints &points);
 
+// Key for TessellationCache, covering everything the software tessellation output depends on.
+template<class Surface>
+u64 ComputeTessCacheKey(const Surface &surface, u32 origVertType, const SimpleVertex *controlPoints, int numControlPoints, const void *indices, int indicesSize);
+
+// Software tessellated output of patches, keyed by their control points and tessellation state.
+// Most games draw the same static patches every frame, which only need tessellating once.
+// Entries are only filled in the second time their key shows up, so animated patches just leave
+// a small blank entry behind instead of a copy of their output.
+class TessellationCache {
+public:
+	struct Entry {
+		std::vector<SimpleVertex> vertices;
+		std::vector<u16> indices;
+		int count = 0;
+		int lastFrame = 0;
+	};
+
+	// Returns the filled entry for key, if any. Otherwise, store says whether to Store() the output.
+	const Entry *Get(u64 key, bool *store);
+	void Store(u64 key, const OutputBuffers &output, int numVertices);
+	void Clear();
+
+private:
+	void Decimate();
+
+	std::unordered_map<u64, Entry> entries_;
+	size_t totalBytes_ = 0;
+	int lastDecimation_ = 0;
+};
+
 } // namespace Spline
 
 // Define function object for TemplateParameterDispatcher
@@ -16,10 +16,14 @@
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
 #include <algorithm>
+#include <atomic>
+#include <functional>
 
 #include "ppsspp_config.h"
 #include "Common/Data/Convert/ColorConv.h"
 #include "Common/Profiler/Profiler.h"
+#include "Common/Thread/ParallelLoop.h"
+#include "Common/Thread/ThreadManager.h"
 #include "Common/MemoryUtil.h"
 #include "Common/StringUtils.h"
 #include "Common/TimeUtil.h"
@@ -68,6 +72,10 @@
 #define TEXCACHE_MIN_PRESSURE 16 * 1024 * 1024  // Total in VRAM
 #define TEXCACHE_SECOND_MIN_PRESSURE 4 * 1024 * 1024
 
+// Smaller textures aren't worth handing off to other threads to decode.
+#define TEXCACHE_MIN_PARALLEL_DECODE_PIXELS (256 * 256)
+#define TEXCACHE_MIN_DECODE_LINES_PER_THREAD 32
+
 // Just for reference
 
 // PSP Color formats:
@@ -100,6 +108,35 @@ inline int dimHeight(u16 dim) {
 	return 1 << ((dim >> 8) & 0xFF);
 }
 
+std::unique_ptr<TexCacheEntry> &TexCache::operator [](u64 key) {
+	auto it = entries_.find(key);
+	if (it != entries_.end())
+		return it->second;
+
+	pages_[KeyToPage(key)].push_back(key);
+	return entries_[key];
+}
+
+TexCache::iterator TexCache::erase(iterator it) {
+	auto page = pages_.find(KeyToPage(it->first));
+	if (page != pages_.end()) {
+		std::vector<u64> &keys = page->second;
+		auto key = std::find(keys.begin(), keys.end(), it->first);
+		if (key != keys.end()) {
+			*key = keys.back();
+			keys.pop_back();
+		}
+		if (keys.empty())
+			pages_.erase(page);
+	}
+	return entries_.erase(it);
+}
+
+void TexCache::clear() {
+	entries_.clear();
+	pages_.clear();
+}
+
 // Vulkan color formats:
 // TODO
 TextureCacheCommon::TextureCacheCommon(Draw::DrawContext *draw)
@@ -311,14 +348,13 @@ void TextureCacheCommon::UpdateMaxSeenV(TexCacheEntry *entry, bool throughMode)
 		if (entry->cluthash != 0 && entry->maxSeenV == 0) {
 			const u64 cachekeyMin = (u64)(entry->addr & 0x3FFFFFFF) << 32;
 			const u64 cachekeyMax = cachekeyMin + (1ULL << 32);
-			for (auto it = cache_.lower_bound(cachekeyMin), end = cache_.upper_bound(cachekeyMax); it != end; ++it) {
+			cache_.ForEachInRange(cachekeyMin, cachekeyMax, [&](TexCacheEntry *other) {
 				// They should all be the same, just make sure we take any that has already increased.
 				// This is for a new texture.
-				if (it->second->maxSeenV != 0) {
-					entry->maxSeenV = it->second->maxSeenV;
-					break;
+				if (entry->maxSeenV == 0 && other->maxSeenV != 0) {
+					entry->maxSeenV = other->maxSeenV;
 				}
-			}
+			});
 		}
 
 		// Texture scale/offset and gen modes don't apply in through.
@@ -344,9 +380,9 @@ void TextureCacheCommon::UpdateMaxSeenV(TexCacheEntry *entry, bool throughMode)
 		if (entry->cluthash != 0) {
 			const u64 cachekeyMin = (u64)(entry->addr & 0x3FFFFFFF) << 32;
 			const u64 cachekeyMax = cachekeyMin + (1ULL << 32);
-			for (auto it = cache_.lower_bound(cachekeyMin), end = cache_.upper_bound(cachekeyMax); it != end; ++it) {
-				it->second->maxSeenV = entry->maxSeenV;
-			}
+			cache_.ForEachInRange(cachekeyMin, cachekeyMax, [&](TexCacheEntry *other) {
+				other->maxSeenV = entry->maxSeenV;
+			});
 		}
 	}
 }
@@ -388,10 +424,19 @@ TexCacheEntry *TextureCacheCommon::SetTexture() {
 	int bufw = GetTextureBufw(0, texaddr, format);
 	u8 maxLevel = gstate.getTextureMaxLevel();
 
+	// The hash below reads memory, so any queued download there has to land first.
+	// The mip levels can be anywhere, and are decoded from memory too, so check each of them.
+	for (int level = 0; level <= maxLevel; ++level) {
+		u32 levelAddr = gstate.getTextureAddress(level);
+		int levelBufw = level == 0 ? bufw : GetTextureBufw(level, levelAddr, format);
+		framebufferManager_->FlushPendingReadbacksInRange(levelAddr, textureBitsPerPixel[format] * levelBufw * gstate.getTextureHeight(level) / 8);
+	}
+
 	u32 minihash = MiniHash((const u32 *)Memory::GetPointerUnchecked(texaddr));
 
 	TexCache::iterator entryIter = cache_.find(cachekey);
 	TexCacheEntry *entry = nullptr;
+	gpuStats.numTextureCacheLookups++;
 
 	// Note: It's necessary to reset needshadertexclamp, for otherwise DIRTY_TEXCLAMP won't get set later.
 	// Should probably revisit how this works..
@@ -485,6 +530,7 @@ TexCacheEntry *TextureCacheCommon::SetTexture() {
 
 		if (match) {
 			// got one!
+			gpuStats.numTextureCacheHits++;
 			gstate_c.curTextureWidth = w;
 			gstate_c.curTextureHeight = h;
 			if (rehash) {
@@ -560,14 +606,14 @@ TexCacheEntry *TextureCacheCommon::SetTexture() {
 			const u64 cachekeyMax = cachekeyMin + (1ULL << 32);
 
 			int found = 0;
-			for (auto it = cache_.lower_bound(cachekeyMin), end = cache_.upper_bound(cachekeyMax); it != end; ++it) {
+			cache_.ForEachInRange(cachekeyMin, cachekeyMax, [&](TexCacheEntry *other) {
 				found++;
-			}
+			});
 
 			if (found >= TEXTURE_CLUT_VARIANTS_MIN) {
-				for (auto it = cache_.lower_bound(cachekeyMin), end = cache_.upper_bound(cachekeyMax); it != end; ++it) {
-					it->second->status |= TexCacheEntry::STATUS_CLUT_VARIANTS;
-				}
+				cache_.ForEachInRange(cachekeyMin, cachekeyMax, [&](TexCacheEntry *other) {
+					other->status |= TexCacheEntry::STATUS_CLUT_VARIANTS;
+				});
 
 				entry->status |= TexCacheEntry::STATUS_CLUT_VARIANTS;
 			}
@@ -715,7 +761,7 @@ void TextureCacheCommon::Decimate(bool forcePressure) {
 	if (g_Config.bTextureSecondaryCache && (forcePressure || secondCacheSizeEstimate_ >= TEXCACHE_SECOND_MIN_PRESSURE)) {
 		const u32 had = secondCacheSizeEstimate_;
 
-		for (TexCache::iterator iter = secondCache_.begin(); iter != secondCache_.end(); ) {
+		for (TexCacheMap::iterator iter = secondCache_.begin(); iter != secondCache_.end(); ) {
 			// In low memory mode, we kill them all since secondary cache is disabled.
 			if (lowMemoryMode_ || iter->second->lastFrame + TEXTURE_SECOND_KILL_AGE < gpuStats.numFlips) {
 				ReleaseTexture(iter->second.get(), true);
@@ -776,11 +822,11 @@ void TextureCacheCommon::HandleTextureChange(TexCacheEntry *const entry, const c
 	if (entry->cluthash != 0) {
 		const u64 cachekeyMin = (u64)(entry->addr & 0x3FFFFFFF) << 32;
 		const u64 cachekeyMax = cachekeyMin + (1ULL << 32);
-		for (auto it = cache_.lower_bound(cachekeyMin), end = cache_.upper_bound(cachekeyMax); it != end; ++it) {
-			if (it->second->cluthash != entry->cluthash) {
-				it->second->status |= TexCacheEntry::STATUS_CLUT_RECHECK;
+		cache_.ForEachInRange(cachekeyMin, cachekeyMax, [&](TexCacheEntry *other) {
+			if (other->cluthash != entry->cluthash) {
+				other->status |= TexCacheEntry::STATUS_CLUT_RECHECK;
 			}
-		}
+		});
 	}
 
 	if (entry->numFrames < TEXCACHE_FRAME_CHANGE_FREQUENT) {
@@ -824,24 +870,19 @@ void TextureCacheCommon::NotifyFramebuffer(VirtualFramebuffer *framebuffer, Fram
 		u64 cacheKeyEnd = (u64)fb_endAddr << 32;
 
 		// Color - no need to look in the mirrors.
-		for (auto it = cache_.lower_bound(cacheKey), end = cache_.upper_bound(cacheKeyEnd); it != end; ++it) {
-			it->second->status |= TexCacheEntry::STATUS_FRAMEBUFFER_OVERLAP;
+		auto markOverlap = [](TexCacheEntry *entry) {
+			entry->status |= TexCacheEntry::STATUS_FRAMEBUFFER_OVERLAP;
 			gpuStats.numTextureInvalidationsByFramebuffer++;
-		}
+		};
+		cache_.ForEachInRange(cacheKey, cacheKeyEnd, markOverlap);
 
 		if (z_stride != 0) {
 			// Depth. Just look at the range, but in each mirror (0x04200000 and 0x04600000).
 			// Games don't use 0x04400000 as far as I know - it has no swizzle effect so kinda useless.
 			cacheKey = (u64)z_addr << 32;
 			cacheKeyEnd = (u64)z_endAddr << 32;
-			for (auto it = cache_.lower_bound(cacheKey | 0x200000), end = cache_.upper_bound(cacheKeyEnd | 0x200000); it != end; ++it) {
-				it->second->status |= TexCacheEntry::STATUS_FRAMEBUFFER_OVERLAP;
-				gpuStats.numTextureInvalidationsByFramebuffer++;
-			}
-			for (auto it = cache_.lower_bound(cacheKey | 0x600000), end = cache_.upper_bound(cacheKeyEnd | 0x600000); it != end; ++it) {
-				it->second->status |= TexCacheEntry::STATUS_FRAMEBUFFER_OVERLAP;
-				gpuStats.numTextureInvalidationsByFramebuffer++;
-			}
+			cache_.ForEachInRange(cacheKey | 0x200000, cacheKeyEnd | 0x200000, markOverlap);
+			cache_.ForEachInRange(cacheKey | 0x600000, cacheKeyEnd | 0x600000, markOverlap);
 		}
 		break;
 	}
@@ -1155,6 +1196,7 @@ void TextureCacheCommon::LoadClut(u32 clutAddr, u32 loadBytes) {
 
 		// It's possible for a game to (successfully) access outside valid memory.
 		u32 bytes = Memory::ValidSize(clutAddr, loadBytes);
+		framebufferManager_->FlushPendingReadbacksInRange(clutAddr, bytes);
 		if (clutRenderAddress_ != 0xFFFFFFFF && !g_Config.bDisableSlowFramebufEffects) {
 			framebufferManager_->DownloadFramebufferForClut(clutRenderAddress_, clutRenderOffset_ + bytes);
 			Memory::MemcpyUnchecked(clutBufRaw_, clutAddr, bytes);
@@ -1211,7 +1253,18 @@ void TextureCacheCommon::LoadClut(u32 clutAddr, u32 loadBytes) {
 	clutMaxBytes_ = std::max(clutMaxBytes_, loadBytes);
 }
 
-void TextureCacheCommon::UnswizzleFromMem(u32 *dest, u32 destPitch, const u8 *texptr, u32 bufw, u32 height, u32 bytesPerPixel) {
+// Runs decodeRows over [0, rows), split into bands across the thread pool when the texture is big.
+// Each row covers linesPerRow lines of w pixels (like a row of DXT or swizzle blocks), so the size
+// checks are always in pixels. Every row must be independent of the others.
+static void DecodeRows(int w, int rows, const std::function<void(int, int)> &decodeRows, int linesPerRow = 1, bool parallel = true) {
+	if (parallel && w * rows * linesPerRow >= TEXCACHE_MIN_PARALLEL_DECODE_PIXELS) {
+		ParallelRangeLoop(&g_threadManager, decodeRows, 0, rows, std::max(TEXCACHE_MIN_DECODE_LINES_PER_THREAD / linesPerRow, 1));
+	} else {
+		decodeRows(0, rows);
+	}
+}
+
+static void UnswizzleRows(u32 *dest, u32 destPitch, const u8 *texptr, u32 bufw, u32 height, u32 bytesPerPixel, bool parallel) {
 	// Note: bufw is always aligned to 16 bytes, so rowWidth is always >= 16.
 	const u32 rowWidth = (bytesPerPixel > 0) ? (bufw * bytesPerPixel) : (bufw / 2);
 	// A visual mapping of unswizzling, where each letter is 16-byte and 8 letters is a block:
@@ -1228,7 +1281,14 @@ void TextureCacheCommon::UnswizzleFromMem(u32 *dest, u32 destPitch, const u8 *te
 	// The height is not always aligned to 8, but rounds up.
 	int byc = (height + 7) / 8;
 
-	DoUnswizzleTex16(texptr, dest, bxc, byc, destPitch);
+	// Each row of blocks is 8 lines of bufw pixels, so split by block rows.
+	DecodeRows(bufw, byc, [&](int by1, int by2) {
+		DoUnswizzleTex16(texptr + by1 * bxc * 128, dest + by1 * 8 * (destPitch / 4), bxc, by2 - by1, destPitch);
+	}, 8, parallel);
+}
+
+void TextureCacheCommon::UnswizzleFromMem(u32 *dest, u32 destPitch, const u8 *texptr, u32 bufw, u32 height, u32 bytesPerPixel) {
+	UnswizzleRows(dest, destPitch, texptr, bufw, height, bytesPerPixel, true);
 }
 
 bool TextureCacheCommon::GetCurrentClutBuffer(GPUDebugBuffer &buffer) {
@@ -1357,26 +1417,249 @@ static void DecodeDXTBlock(uint8_t *out, int outPitch, uint32_t texaddr, const u
 		h = (((int)limited / sizeof(DXTBlock)) / (bufw / 4)) * 4;
 	}
 
-	for (int y = 0; y < h; y += 4) {
-		u32 blockIndex = (y / 4) * (bufw / 4);
-		int blockHeight = std::min(h - y, 4);
-		for (int x = 0; x < minw; x += 4) {
-			if (n == 1)
-				DecodeDXT1Block(dst + outPitch32 * y + x, (const DXT1Block *)src + blockIndex, outPitch32, blockHeight, false);
-			if (n == 3)
-				DecodeDXT3Block(dst + outPitch32 * y + x, (const DXT3Block *)src + blockIndex, outPitch32, blockHeight);
-			if (n == 5)
-				DecodeDXT5Block(dst + outPitch32 * y + x, (const DXT5Block *)src + blockIndex, outPitch32, blockHeight);
-			blockIndex++;
+	// Split by rows of blocks, 4 lines each.
+	DecodeRows(minw, (h + 3) / 4, [&](int by1, int by2) {
+		for (int y = by1 * 4; y < by2 * 4; y += 4) {
+			u32 blockIndex = (y / 4) * (bufw / 4);
+			int blockHeight = std::min(h - y, 4);
+			for (int x = 0; x < minw; x += 4) {
+				if (n == 1)
+					DecodeDXT1Block(dst + outPitch32 * y + x, (const DXT1Block *)src + blockIndex, outPitch32, blockHeight, false);
+				if (n == 3)
+					DecodeDXT3Block(dst + outPitch32 * y + x, (const DXT3Block *)src + blockIndex, outPitch32, blockHeight);
+				if (n == 5)
+					DecodeDXT5Block(dst + outPitch32 * y + x, (const DXT5Block *)src + blockIndex, outPitch32, blockHeight);
+				blockIndex++;
+			}
 		}
-	}
+	}, 4);
 	w = (w + 3) & ~3;
 	if (reverseColors) {
 		ReverseColors(out, out, GE_TFMT_8888, outPitch32 * h, useBGRA);
 	}
 }
 
+// Decodes the formats that don't need a CLUT. This only uses what's passed in, so it can also run
+// on a copy of the texture from a worker thread (with parallel = false, since it's already on one.)
+static void DecodeDirectColorLevel(u8 *out, int outPitch, GETextureFormat format, const u8 *texptr, int w, int h, int bufw, bool swizzled, bool reverseColors, bool useBGRA, bool expandTo32bit, SimpleBuf<u32> &tmpTexBuf, bool parallel) {
+	switch (format) {
+	case GE_TFMT_4444:
+	case GE_TFMT_5551:
+	case GE_TFMT_5650:
+		if (!swizzled) {
+			// Just a simple copy, we swizzle the color format.
+			if (reverseColors) {
+				DecodeRows(w, h, [&](int y1, int y2) {
+					for (int y = y1; y < y2; ++y) {
+						ReverseColors(out + outPitch * y, texptr + bufw * sizeof(u16) * y, format, w, useBGRA);
+					}
+				}, 1, parallel);
+			} else if (expandTo32bit) {
+				DecodeRows(w, h, [&](int y1, int y2) {
+					for (int y = y1; y < y2; ++y) {
+						ConvertFormatToRGBA8888(format, (u32 *)(out + outPitch * y), (const u16 *)texptr + bufw * y, w);
+					}
+				}, 1, parallel);
+			} else {
+				DecodeRows(w, h, [&](int y1, int y2) {
+					for (int y = y1; y < y2; ++y) {
+						memcpy(out + outPitch * y, texptr + bufw * sizeof(u16) * y, w * sizeof(u16));
+					}
+				}, 1, parallel);
+			}
+		} else if (h >= 8 && bufw <= w && !expandTo32bit) {
+			// Note: this is always safe since h must be a power of 2, so a multiple of 8.
+			UnswizzleRows((u32 *)out, outPitch, texptr, bufw, h, 2, parallel);
+			if (reverseColors) {
+				DecodeRows(w, h, [&](int y1, int y2) {
+					ReverseColors(out + outPitch * y1, out + outPitch * y1, format, (y2 - y1) * outPitch / 2, useBGRA);
+				}, 1, parallel);
+			}
+		} else {
+			// We don't have enough space for all rows in out, so use a temp buffer.
+			tmpTexBuf.resize(bufw * ((h + 7) & ~7));
+			UnswizzleRows(tmpTexBuf.data(), bufw * 2, texptr, bufw, h, 2, parallel);
+			const u8 *unswizzled = (u8 *)tmpTexBuf.data();
+
+			if (reverseColors) {
+				DecodeRows(w, h, [&](int y1, int y2) {
+					for (int y = y1; y < y2; ++y) {
+						ReverseColors(out + outPitch * y, unswizzled + bufw * sizeof(u16) * y, format, w, useBGRA);
+					}
+				}, 1, parallel);
+			} else if (expandTo32bit) {
+				DecodeRows(w, h, [&](int y1, int y2) {
+					for (int y = y1; y < y2; ++y) {
+						ConvertFormatToRGBA8888(format, (u32 *)(out + outPitch * y), (const u16 *)unswizzled + bufw * y, w);
+					}
+				}, 1, parallel);
+			} else {
+				DecodeRows(w, h, [&](int y1, int y2) {
+					for (int y = y1; y < y2; ++y) {
+						memcpy(out + outPitch * y, unswizzled + bufw * sizeof(u16) * y, w * sizeof(u16));
+					}
+				}, 1, parallel);
+			}
+		}
+		break;
+
+	case GE_TFMT_8888:
+		if (!swizzled) {
+			if (reverseColors) {
+				DecodeRows(w, h, [&](int y1, int y2) {
+					for (int y = y1; y < y2; ++y) {
+						ReverseColors(out + outPitch * y, texptr + bufw * sizeof(u32) * y, format, w, useBGRA);
+					}
+				}, 1, parallel);
+			} else {
+				DecodeRows(w, h, [&](int y1, int y2) {
+					for (int y = y1; y < y2; ++y) {
+						memcpy(out + outPitch * y, texptr + bufw * sizeof(u32) * y, w * sizeof(u32));
+					}
+				}, 1, parallel);
+			}
+		} else if (h >= 8 && bufw <= w) {
+			UnswizzleRows((u32 *)out, outPitch, texptr, bufw, h, 4, parallel);
+			if (reverseColors) {
+				DecodeRows(w, h, [&](int y1, int y2) {
+					ReverseColors(out + outPitch * y1, out + outPitch * y1, format, (y2 - y1) * outPitch / 4, useBGRA);
+				}, 1, parallel);
+			}
+		} else {
+			// We don't have enough space for all rows in out, so use a temp buffer.
+			tmpTexBuf.resize(bufw * ((h + 7) & ~7));
+			UnswizzleRows(tmpTexBuf.data(), bufw * 4, texptr, bufw, h, 4, parallel);
+			const u8 *unswizzled = (u8 *)tmpTexBuf.data();
+
+			if (reverseColors) {
+				DecodeRows(w, h, [&](int y1, int y2) {
+					for (int y = y1; y < y2; ++y) {
+						ReverseColors(out + outPitch * y, unswizzled + bufw * sizeof(u32) * y, format, w, useBGRA);
+					}
+				}, 1, parallel);
+			} else {
+				DecodeRows(w, h, [&](int y1, int y2) {
+					for (int y = y1; y < y2; ++y) {
+						memcpy(out + outPitch * y, unswizzled + bufw * sizeof(u32) * y, w * sizeof(u32));
+					}
+				}, 1, parallel);
+			}
+		}
+		break;
+
+	default:
+		break;
+	}
+}
+
+// A copy of a changed texture and its decoded level 0, filled in by AsyncTexDecodeTask.
+struct AsyncTexDecode {
+	u32 texaddr;
+	GETextureFormat format;
+	int w;
+	int h;
+	int bufw;
+	bool swizzled;
+	bool reverseColors;
+	bool useBGRA;
+	bool expandTo32bit;
+	// The hash of src, if the entry's hash differs when we're done the result is stale.
+	u32 fullhash;
+	int pitch;
+
+	// SimpleBuf, since unswizzling wants both of these 16-byte aligned.
+	SimpleBuf<u32> src;
+	SimpleBuf<u32> decoded;
+	SimpleBuf<u32> tmpTexBuf;
+	std::atomic<bool> done{};
+
+	bool Matches(u32 addr, GETextureFormat fmt, int w2, int h2, int bufw2, bool swizzled2, bool reverse2, bool bgra2, bool expand2) const {
+		return texaddr == addr && format == fmt && w == w2 && h == h2 && bufw == bufw2 && swizzled == swizzled2 && reverseColors == reverse2 && useBGRA == bgra2 && expandTo32bit == expand2;
+	}
+};
+
+class AsyncTexDecodeTask : public Task {
+public:
+	AsyncTexDecodeTask(const std::shared_ptr<AsyncTexDecode> &decode) : decode_(decode) {
+	}
+
+	void Run() override {
+		AsyncTexDecode &d = *decode_;
+		// Already on a worker, so no ParallelRangeLoop (which could wait on this very thread.)
+		DecodeDirectColorLevel((u8 *)d.decoded.data(), d.pitch, d.format, (const u8 *)d.src.data(), d.w, d.h, d.bufw, d.swizzled, d.reverseColors, d.useBGRA, d.expandTo32bit, d.tmpTexBuf, false);
+		d.done = true;
+	}
+
+private:
+	std::shared_ptr<AsyncTexDecode> decode_;
+};
+
+// Called on a hash fail. Instead of decoding right away, copies the texture and decodes it on a worker,
+// so the entry can keep drawing with its old texture until ApplyTexture sees the result is done.
+bool TextureCacheCommon::StartAsyncDecode(TexCacheEntry *entry) {
+	if (!g_Config.bAsyncTextureDecode || !entry->texturePtr || replacer_.Enabled())
+		return false;
+
+	const u64 cachekey = entry->CacheKey();
+	auto pending = asyncDecodes_.find(cachekey);
+	if (pending != asyncDecodes_.end()) {
+		// Changed again before the last one was done, so just decode it now.
+		asyncDecodes_.erase(pending);
+		return false;
+	}
+
+	// Only large textures that don't need the CLUT or mips, and don't change every few frames.
+	const GETextureFormat format = (GETextureFormat)entry->format;
+	if (format > GE_TFMT_8888 || entry->maxLevel != 0 || !lastDecodeFlags_[format].valid)
+		return false;
+	if ((entry->status & TexCacheEntry::STATUS_CHANGE_FREQUENT) != 0 || IsVideo(entry->addr))
+		return false;
+	const u32 texaddr = entry->addr;
+	if ((texaddr & 0x00600000) != 0 && Memory::IsVRAMAddress(texaddr))
+		return false;
+
+	const int w = gstate.getTextureWidth(0);
+	const int h = gstate.getTextureHeight(0);
+	const int bufw = entry->bufw;
+	if (w * h < TEXCACHE_MIN_PARALLEL_DECODE_PIXELS)
+		return false;
+
+	// Unswizzling reads whole 8 line blocks, and plain copies read w pixels from the last line.
+	const int srcBpp = format == GE_TFMT_8888 ? 4 : 2;
+	const u32 srcBytes = srcBpp * std::max(bufw * ((h + 7) & ~7), bufw * (h - 1) + w);
+	if (!Memory::IsValidRange(texaddr, srcBytes))
+		return false;
+
+	const DecodeFlags &flags = lastDecodeFlags_[format];
+	std::shared_ptr<AsyncTexDecode> decode = std::make_shared<AsyncTexDecode>();
+	decode->texaddr = texaddr;
+	decode->format = format;
+	decode->w = w;
+	decode->h = h;
+	decode->bufw = bufw;
+	decode->swizzled = gstate.isTextureSwizzled();
+	decode->reverseColors = flags.reverseColors;
+	decode->useBGRA = flags.useBGRA;
+	decode->expandTo32bit = flags.expandTo32bit;
+	decode->fullhash = entry->fullhash;
+	decode->pitch = w * (format == GE_TFMT_8888 || flags.expandTo32bit ? 4 : 2);
+
+	decode->src.resize((srcBytes + 3) / 4);
+	Memory::MemcpyUnchecked(decode->src.data(), texaddr, srcBytes);
+	decode->decoded.resize((decode->pitch * ((h + 7) & ~7)) / 4);
+
+	asyncDecodes_[cachekey] = decode;
+	g_threadManager.EnqueueTask(new AsyncTexDecodeTask(decode), TaskType::CPU_COMPUTE);
+	return true;
+}
+
 void TextureCacheCommon::DecodeTextureLevel(u8 *out, int outPitch, GETextureFormat format, GEPaletteFormat clutformat, uint32_t texaddr, int level, int bufw, bool reverseColors, bool useBGRA, bool expandTo32bit) {
+	// Initialized to avoid a race condition with bShowDebugStats changing.
+	double start = 0.0;
+	if (coreCollectDebugStats) {
+		start = time_now_d();
+	}
+
 	bool swizzled = gstate.isTextureSwizzled();
 	if ((texaddr & 0x00600000) != 0 && Memory::IsVRAMAddress(texaddr)) {
 		// This means it's in a mirror, possibly a swizzled mirror.  Let's report.
@@ -1397,6 +1680,18 @@ void TextureCacheCommon::DecodeTextureLevel(u8 *out, int outPitch, GETextureForm
 	size_t len = snprintf(buf, sizeof(buf), "Tex_%08x_%dx%d_%s", texaddr, w, h, GeTextureFormatToString(format, clutformat));
 	NotifyMemInfo(MemBlockFlags::TEXTURE, texaddr, byteSize, buf, len);
 
+	if (finishedAsyncDecode_ && level == 0 && finishedAsyncDecode_->Matches(texaddr, format, w, h, bufw, swizzled, reverseColors, useBGRA, expandTo32bit)) {
+		// A worker already decoded this exact level, see StartAsyncDecode().
+		AsyncTexDecode *decoded = finishedAsyncDecode_;
+		for (int y = 0; y < h; ++y) {
+			memcpy(out + outPitch * y, (const u8 *)decoded->decoded.data() + decoded->pitch * y, decoded->pitch);
+		}
+		if (coreCollectDebugStats) {
+			gpuStats.msDecodingTextures += time_now_d() - start;
+		}
+		return;
+	}
+
 	switch (format) {
 	case GE_TFMT_CLUT4:
 	{
@@ -1417,26 +1712,34 @@ void TextureCacheCommon::DecodeTextureLevel(u8 *out, int outPitch, GETextureForm
 			if (clutAlphaLinear_ && mipmapShareClut && !expandTo32bit) {
 				// Here, reverseColors means the CLUT is already reversed.
 				if (reverseColors) {
-					for (int y = 0; y < h; ++y) {
-						DeIndexTexture4Optimal((u16 *)(out + outPitch * y), texptr + (bufw * y) / 2, w, clutAlphaLinearColor_);
-					}
+					DecodeRows(w, h, [&](int y1, int y2) {
+						for (int y = y1; y < y2; ++y) {
+							DeIndexTexture4Optimal((u16 *)(out + outPitch * y), texptr + (bufw * y) / 2, w, clutAlphaLinearColor_);
+						}
+					});
 				} else {
-					for (int y = 0; y < h; ++y) {
-						DeIndexTexture4OptimalRev((u16 *)(out + outPitch * y), texptr + (bufw * y) / 2, w, clutAlphaLinearColor_);
-					}
+					DecodeRows(w, h, [&](int y1, int y2) {
+						for (int y = y1; y < y2; ++y) {
+							DeIndexTexture4OptimalRev((u16 *)(out + outPitch * y), texptr + (bufw * y) / 2, w, clutAlphaLinearColor_);
+						}
+					});
 				}
 			} else {
 				const u16 *clut = GetCurrentClut<u16>() + clutSharingOffset;
 				if (expandTo32bit && !reverseColors) {
 					// We simply expand the CLUT to 32-bit, then we deindex as usual. Probably the fastest way.
 					ConvertFormatToRGBA8888(clutformat, expandClut_, clut, 16);
-					for (int y = 0; y < h; ++y) {
-						DeIndexTexture4((u32 *)(out + outPitch * y), texptr + (bufw * y) / 2, w, expandClut_);
-					}
+					DecodeRows(w, h, [&](int y1, int y2) {
+						for (int y = y1; y < y2; ++y) {
+							DeIndexTexture4((u32 *)(out + outPitch * y), texptr + (bufw * y) / 2, w, expandClut_);
+						}
+					});
 				} else {
-					for (int y = 0; y < h; ++y) {
-						DeIndexTexture4((u16 *)(out + outPitch * y), texptr + (bufw * y) / 2, w, clut);
-					}
+					DecodeRows(w, h, [&](int y1, int y2) {
+						for (int y = y1; y < y2; ++y) {
+							DeIndexTexture4((u16 *)(out + outPitch * y), texptr + (bufw * y) / 2, w, clut);
+						}
+					});
 				}
 			}
 		}
@@ -1445,15 +1748,17 @@ void TextureCacheCommon::DecodeTextureLevel(u8 *out, int outPitch, GETextureForm
 		case GE_CMODE_32BIT_ABGR8888:
 		{
 			const u32 *clut = GetCurrentClut<u32>() + clutSharingOffset;
-			for (int y = 0; y < h; ++y) {
-				DeIndexTexture4((u32 *)(out + outPitch * y), texptr + (bufw * y) / 2, w, clut);
-			}
+			DecodeRows(w, h, [&](int y1, int y2) {
+				for (int y = y1; y < y2; ++y) {
+					DeIndexTexture4((u32 *)(out + outPitch * y), texptr + (bufw * y) / 2, w, clut);
+				}
+			});
 		}
 		break;
 
 		default:
 			ERROR_LOG_REPORT(G3D, "Unknown CLUT4 texture mode %d", gstate.getClutPaletteFormat());
-			return;
+			break;
 		}
 	}
 	break;
@@ -1473,81 +1778,11 @@ void TextureCacheCommon::DecodeTextureLevel(u8 *out, int outPitch, GETextureForm
 	case GE_TFMT_4444:
 	case GE_TFMT_5551:
 	case GE_TFMT_5650:
-		if (!swizzled) {
-			// Just a simple copy, we swizzle the color format.
-			if (reverseColors) {
-				for (int y = 0; y < h; ++y) {
-					ReverseColors(out + outPitch * y, texptr + bufw * sizeof(u16) * y, format, w, useBGRA);
-				}
-			} else if (expandTo32bit) {
-				for (int y = 0; y < h; ++y) {
-					ConvertFormatToRGBA8888(format, (u32 *)(out + outPitch * y), (const u16 *)texptr + bufw * y, w);
-				}
-			} else {
-				for (int y = 0; y < h; ++y) {
-					memcpy(out + outPitch * y, texptr + bufw * sizeof(u16) * y, w * sizeof(u16));
-				}
-			}
-		} else if (h >= 8 && bufw <= w && !expandTo32bit) {
-			// Note: this is always safe since h must be a power of 2, so a multiple of 8.
-			UnswizzleFromMem((u32 *)out, outPitch, texptr, bufw, h, 2);
-			if (reverseColors) {
-				ReverseColors(out, out, format, h * outPitch / 2, useBGRA);
-			}
-		} else {
-			// We don't have enough space for all rows in out, so use a temp buffer.
-			tmpTexBuf32_.resize(bufw * ((h + 7) & ~7));
-			UnswizzleFromMem(tmpTexBuf32_.data(), bufw * 2, texptr, bufw, h, 2);
-			const u8 *unswizzled = (u8 *)tmpTexBuf32_.data();
-
-			if (reverseColors) {
-				for (int y = 0; y < h; ++y) {
-					ReverseColors(out + outPitch * y, unswizzled + bufw * sizeof(u16) * y, format, w, useBGRA);
-				}
-			} else if (expandTo32bit) {
-				for (int y = 0; y < h; ++y) {
-					ConvertFormatToRGBA8888(format, (u32 *)(out + outPitch * y), (const u16 *)unswizzled + bufw * y, w);
-				}
-			} else {
-				for (int y = 0; y < h; ++y) {
-					memcpy(out + outPitch * y, unswizzled + bufw * sizeof(u16) * y, w * sizeof(u16));
-				}
-			}
-		}
-		break;
-
 	case GE_TFMT_8888:
-		if (!swizzled) {
-			if (reverseColors) {
-				for (int y = 0; y < h; ++y) {
-					ReverseColors(out + outPitch * y, texptr + bufw * sizeof(u32) * y, format, w, useBGRA);
-				}
-			} else {
-				for (int y = 0; y < h; ++y) {
-					memcpy(out + outPitch * y, texptr + bufw * sizeof(u32) * y, w * sizeof(u32));
-				}
-			}
-		} else if (h >= 8 && bufw <= w) {
-			UnswizzleFromMem((u32 *)out, outPitch, texptr, bufw, h, 4);
-			if (reverseColors) {
-				ReverseColors(out, out, format, h * outPitch / 4, useBGRA);
-			}
-		} else {
-			// We don't have enough space for all rows in out, so use a temp buffer.
-			tmpTexBuf32_.resize(bufw * ((h + 7) & ~7));
-			UnswizzleFromMem(tmpTexBuf32_.data(), bufw * 4, texptr, bufw, h, 4);
-			const u8 *unswizzled = (u8 *)tmpTexBuf32_.data();
-
-			if (reverseColors) {
-				for (int y = 0; y < h; ++y) {
-					ReverseColors(out + outPitch * y, unswizzled + bufw * sizeof(u32) * y, format, w, useBGRA);
-				}
-			} else {
-				for (int y = 0; y < h; ++y) {
-					memcpy(out + outPitch * y, unswizzled + bufw * sizeof(u32) * y, w * sizeof(u32));
-				}
-			}
+		if (level == 0) {
+			lastDecodeFlags_[format] = { true, reverseColors, useBGRA, expandTo32bit };
 		}
+		DecodeDirectColorLevel(out, outPitch, format, texptr, w, h, bufw, swizzled, reverseColors, useBGRA, expandTo32bit, tmpTexBuf32_, true);
 		break;
 
 	case GE_TFMT_DXT1:
@@ -1566,6 +1801,10 @@ void TextureCacheCommon::DecodeTextureLevel(u8 *out, int outPitch, GETextureForm
 		ERROR_LOG_REPORT(G3D, "Unknown Texture Format %d!!!", format);
 		break;
 	}
+
+	if (coreCollectDebugStats) {
+		gpuStats.msDecodingTextures += time_now_d() - start;
+	}
 }
 
 void TextureCacheCommon::ReadIndexedTex(u8 *out, int outPitch, int level, const u8 *texptr, int bytesPerIndex, int bufw, bool expandTo32Bit) {
@@ -1596,21 +1835,27 @@ void TextureCacheCommon::ReadIndexedTex(u8 *out, int outPitch, int level, const
 	{
 		switch (bytesPerIndex) {
 		case 1:
-			for (int y = 0; y < h; ++y) {
-				DeIndexTexture((u16 *)(out + outPitch * y), (const u8 *)texptr + bufw * y, w, clut16);
-			}
+			DecodeRows(w, h, [&](int y1, int y2) {
+				for (int y = y1; y < y2; ++y) {
+					DeIndexTexture((u16 *)(out + outPitch * y), (const u8 *)texptr + bufw * y, w, clut16);
+				}
+			});
 			break;
 
 		case 2:
-			for (int y = 0; y < h; ++y) {
-				DeIndexTexture((u16 *)(out + outPitch * y), (const u16_le *)texptr + bufw * y, w, clut16);
-			}
+			DecodeRows(w, h, [&](int y1, int y2) {
+				for (int y = y1; y < y2; ++y) {
+					DeIndexTexture((u16 *)(out + outPitch * y), (const u16_le *)texptr + bufw * y, w, clut16);
+				}
+			});
 			break;
 
 		case 4:
-			for (int y = 0; y < h; ++y) {
-				DeIndexTexture((u16 *)(out + outPitch * y), (const u32_le *)texptr + bufw * y, w, clut16);
-			}
+			DecodeRows(w, h, [&](int y1, int y2) {
+				for (int y = y1; y < y2; ++y) {
+					DeIndexTexture((u16 *)(out + outPitch * y), (const u32_le *)texptr + bufw * y, w, clut16);
+				}
+			});
 			break;
 		}
 	}
@@ -1620,21 +1865,27 @@ void TextureCacheCommon::ReadIndexedTex(u8 *out, int outPitch, int level, const
 	{
 		switch (bytesPerIndex) {
 		case 1:
-			for (int y = 0; y < h; ++y) {
-				DeIndexTexture((u32 *)(out + outPitch * y), (const u8 *)texptr + bufw * y, w, clut32);
-			}
+			DecodeRows(w, h, [&](int y1, int y2) {
+				for (int y = y1; y < y2; ++y) {
+					DeIndexTexture((u32 *)(out + outPitch * y), (const u8 *)texptr + bufw * y, w, clut32);
+				}
+			});
 			break;
 
 		case 2:
-			for (int y = 0; y < h; ++y) {
-				DeIndexTexture((u32 *)(out + outPitch * y), (const u16_le *)texptr + bufw * y, w, clut32);
-			}
+			DecodeRows(w, h, [&](int y1, int y2) {
+				for (int y = y1; y < y2; ++y) {
+					DeIndexTexture((u32 *)(out + outPitch * y), (const u16_le *)texptr + bufw * y, w, clut32);
+				}
+			});
 			break;
 
 		case 4:
-			for (int y = 0; y < h; ++y) {
-				DeIndexTexture((u32 *)(out + outPitch * y), (const u32_le *)texptr + bufw * y, w, clut32);
-			}
+			DecodeRows(w, h, [&](int y1, int y2) {
+				for (int y = y1; y < y2; ++y) {
+					DeIndexTexture((u32 *)(out + outPitch * y), (const u32_le *)texptr + bufw * y, w, clut32);
+				}
+			});
 			break;
 		}
 	}
@@ -1690,8 +1941,11 @@ void TextureCacheCommon::ApplyTexture() {
 		// Okay, this matched and didn't change - but let's check the hash.  Maybe it will change.
 		bool doDelete = true;
 		if (!CheckFullHash(entry, doDelete)) {
-			HandleTextureChange(entry, "hash fail", true, doDelete);
-			nextNeedsRebuild_ = true;
+			// If it's decoding on a worker, keep using the old texture for now.
+			if (!doDelete || !StartAsyncDecode(entry)) {
+				HandleTextureChange(entry, "hash fail", true, doDelete);
+				nextNeedsRebuild_ = true;
+			}
 		} else if (nextTexture_ != nullptr) {
 			// The secondary cache may choose an entry from its storage by setting nextTexture_.
 			// This means we should set that, instead of our previous entry.
@@ -1701,10 +1955,29 @@ void TextureCacheCommon::ApplyTexture() {
 		}
 	}
 
+	std::shared_ptr<AsyncTexDecode> finishedDecode;
+	if (!asyncDecodes_.empty()) {
+		auto pending = asyncDecodes_.find(entry->CacheKey());
+		if (pending != asyncDecodes_.end() && (nextNeedsRebuild_ || pending->second->done)) {
+			finishedDecode = pending->second;
+			asyncDecodes_.erase(pending);
+			if (!nextNeedsRebuild_) {
+				// The worker is done, so now swap out the old texture.
+				HandleTextureChange(entry, "async decode", true, true);
+				nextNeedsRebuild_ = true;
+			}
+			// If the hash was forced to change meanwhile, it's stale, so decode normally.
+			if (finishedDecode->done && finishedDecode->fullhash == entry->fullhash) {
+				finishedAsyncDecode_ = finishedDecode.get();
+			}
+		}
+	}
+
 	// Okay, now actually rebuild the texture if needed.
 	if (nextNeedsRebuild_) {
 		_assert_(!entry->texturePtr);
 		BuildTexture(entry);
+		finishedAsyncDecode_ = nullptr;
 		InvalidateLastTexture();
 	}
 
@@ -1719,7 +1992,7 @@ void TextureCacheCommon::Clear(bool delete_them) {
 		ReleaseTexture(iter->second.get(), delete_them);
 	}
 	// In case the setting was changed, we ALWAYS clear the secondary cache (enabled or not.)
-	for (TexCache::iterator iter = secondCache_.begin(); iter != secondCache_.end(); ++iter) {
+	for (TexCacheMap::iterator iter = secondCache_.begin(); iter != secondCache_.end(); ++iter) {
 		ReleaseTexture(iter->second.get(), delete_them);
 	}
 	if (cache_.size() + secondCache_.size()) {
@@ -1730,9 +2003,13 @@ void TextureCacheCommon::Clear(bool delete_them) {
 		secondCacheSizeEstimate_ = 0;
 	}
 	videos_.clear();
+	// Any workers still running hold their own reference.
+	asyncDecodes_.clear();
 }
 
 void TextureCacheCommon::DeleteTexture(TexCache::iterator it) {
+	if (!asyncDecodes_.empty())
+		asyncDecodes_.erase(it->first);
 	ReleaseTexture(it->second.get(), true);
 	cacheSizeEstimate_ -= EstimateTexMemoryUsage(it->second.get());
 	cache_.erase(it);
@@ -1780,7 +2057,7 @@ bool TextureCacheCommon::CheckFullHash(TexCacheEntry *entry, bool &doDelete) {
 		if (entry->numInvalidated > 2 && entry->numInvalidated < 128 && !lowMemoryMode_) {
 			// We have a new hash: look for that hash in the secondary cache.
 			u64 secondKey = fullhash | (u64)entry->cluthash << 32;
-			TexCache::iterator secondIter = secondCache_.find(secondKey);
+			TexCacheMap::iterator secondIter = secondCache_.find(secondKey);
 			if (secondIter != secondCache_.end()) {
 				// Found it, but does it match our current params?  If not, abort.
 				TexCacheEntry *secondEntry = secondIter->second.get();
@@ -1855,8 +2132,7 @@ void TextureCacheCommon::Invalidate(u32 addr, int size, GPUInvalidationType type
 		endKey = (u64)-1;
 	}
 
-	for (TexCache::iterator iter = cache_.lower_bound(startKey), end = cache_.upper_bound(endKey); iter != end; ++iter) {
-		auto &entry = iter->second;
+	cache_.ForEachInRange(startKey, endKey, [&](TexCacheEntry *entry) {
 		u32 texAddr = entry->addr;
 		u32 texEnd = entry->addr + entry->sizeInRAM;
 
@@ -1886,7 +2162,7 @@ void TextureCacheCommon::Invalidate(u32 addr, int size, GPUInvalidationType type
 				entry->invalidHint++;
 			}
 		}
-	}
+	});
 }
 
 void TextureCacheCommon::InvalidateAll(GPUInvalidationType /*unused*/) {
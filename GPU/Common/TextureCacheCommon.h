@@ -17,7 +17,8 @@
 
 #pragma once
 
-#include <map>
+#include <algorithm>
+#include <unordered_map>
 #include <vector>
 #include <memory>
 
@@ -47,6 +48,7 @@ enum FramebufferNotificationChannel {
 #define TEXCACHE_MAX_TEXELS_SCALED (256*256)  // Per frame
 
 struct VirtualFramebuffer;
+struct AsyncTexDecode;
 class TextureReplacer;
 
 namespace Draw {
@@ -187,9 +189,75 @@ struct TexCacheEntry {
 	static u64 CacheKey(u32 addr, u8 format, u16 dim, u32 cluthash);
 };
 
-// Can't be unordered_map, we use lower_bound ... although for some reason that (used to?) compiles on MSVC.
-// Would really like to replace this with DenseHashMap but can't as long as we need lower_bound.
-typedef std::map<u64, std::unique_ptr<TexCacheEntry>> TexCache;
+typedef std::unordered_map<u64, std::unique_ptr<TexCacheEntry>> TexCacheMap;
+
+// Texture cache entries by CacheKey(). SetTexture only needs an exact lookup, so that's a hash map,
+// but invalidation and framebuffer checks look up address ranges, so the keys are also indexed by
+// address page.
+class TexCache {
+public:
+	typedef TexCacheMap::iterator iterator;
+
+	iterator begin() { return entries_.begin(); }
+	iterator end() { return entries_.end(); }
+	iterator find(u64 key) { return entries_.find(key); }
+	size_t size() const { return entries_.size(); }
+
+	// Adds an empty slot if the key isn't there yet.
+	std::unique_ptr<TexCacheEntry> &operator [](u64 key);
+	iterator erase(iterator it);
+	void clear();
+
+	// Calls func(TexCacheEntry *) for each entry with a key in [keyMin, keyMax], in key order.
+	// Must not add or remove entries from inside func.
+	template <typename F>
+	void ForEachInRange(u64 keyMin, u64 keyMax, F func);
+
+private:
+	// The address is the top 32 bits of the key, so this gives 64KB pages.
+	static u32 KeyToPage(u64 key) {
+		return (u32)(key >> 48);
+	}
+
+	TexCacheMap entries_;
+	std::unordered_map<u32, std::vector<u64>> pages_;
+	// Scratch space for ForEachInRange, to avoid allocating on each invalidate.
+	std::vector<u64> rangeKeys_;
+};
+
+template <typename F>
+void TexCache::ForEachInRange(u64 keyMin, u64 keyMax, F func) {
+	if (keyMin > keyMax || entries_.empty())
+		return;
+
+	rangeKeys_.clear();
+	auto gatherPage = [&](const std::vector<u64> &keys) {
+		for (u64 key : keys) {
+			if (key >= keyMin && key <= keyMax)
+				rangeKeys_.push_back(key);
+		}
+	};
+
+	const u32 pageMin = KeyToPage(keyMin);
+	const u32 pageMax = KeyToPage(keyMax);
+	if (pageMax - pageMin < pages_.size()) {
+		for (u64 page = pageMin; page <= pageMax; ++page) {
+			auto it = pages_.find((u32)page);
+			if (it != pages_.end())
+				gatherPage(it->second);
+		}
+	} else {
+		// Wide range (like after an overflow), cheaper to just check every page we have.
+		for (const auto &it : pages_) {
+			if (it.first >= pageMin && it.first <= pageMax)
+				gatherPage(it.second);
+		}
+	}
+
+	std::sort(rangeKeys_.begin(), rangeKeys_.end());
+	for (u64 key : rangeKeys_)
+		func(entries_.find(key)->second.get());
+}
 
 // Urgh.
 #ifdef IGNORE
@@ -274,6 +342,7 @@ class TextureCacheCommon {
 	virtual void BuildTexture(TexCacheEntry *const entry) = 0;
 	virtual void UpdateCurrentClut(GEPaletteFormat clutFormat, u32 clutBase, bool clutIndexIsSimple) = 0;
 	bool CheckFullHash(TexCacheEntry *entry, bool &doDelete);
+	bool StartAsyncDecode(TexCacheEntry *entry);
 
 	void DecodeTextureLevel(u8 *out, int outPitch, GETextureFormat format, GEPaletteFormat clutformat, uint32_t texaddr, int level, int bufw, bool reverseColors, bool useBGRA, bool expandTo32Bit);
 	void UnswizzleFromMem(u32 *dest, u32 destPitch, const u8 *texptr, u32 bufw, u32 height, u32 bytesPerPixel);
@@ -343,7 +412,7 @@ class TextureCacheCommon {
 	TexCache cache_;
 	u32 cacheSizeEstimate_ = 0;
 
-	TexCache secondCache_;
+	TexCacheMap secondCache_;
 	u32 secondCacheSizeEstimate_ = 0;
 
 	struct VideoInfo {
@@ -356,6 +425,20 @@ class TextureCacheCommon {
 	SimpleBuf<u32> tmpTexBuf32_;
 	SimpleBuf<u32> tmpTexBufRearrange_;
 
+	// Hash fails being decoded on a worker, by cache key. The entry keeps its old texture until they finish.
+	std::unordered_map<u64, std::shared_ptr<AsyncTexDecode>> asyncDecodes_;
+	// Only set during BuildTexture, DecodeTextureLevel copies from this instead of decoding.
+	AsyncTexDecode *finishedAsyncDecode_ = nullptr;
+
+	// How level 0 of each format was last decoded, so a worker can produce the same output.
+	struct DecodeFlags {
+		bool valid;
+		bool reverseColors;
+		bool useBGRA;
+		bool expandTo32bit;
+	};
+	DecodeFlags lastDecodeFlags_[16]{};
+
 	TexCacheEntry *nextTexture_ = nullptr;
 	VirtualFramebuffer *nextFramebufferTexture_ = nullptr;
 
@@ -32,6 +32,9 @@
 #if _M_SSE >= 0x401
 #include <smmintrin.h>
 #endif
+#ifdef AVX2_FUNC
+#include <immintrin.h>
+#endif
 
 u32 QuickTexHashSSE2(const void *checkp, u32 size) {
 	u32 check = 0;
@@ -307,7 +310,115 @@ void DoUnswizzleTex16Basic(const u8 *texptr, u32 *ydestp, int bxc, int byc, u32
 	}
 }
 
-#if !PPSSPP_ARCH(ARM64) && !defined(_M_SSE)
+#ifdef AVX2_FUNC
+// Two blocks side by side make 32 contiguous bytes on each line, so we can write a full AVX2 register.
+AVX2_FUNC static void DoUnswizzleTex16AVX2(const u8 *texptr, u32 *ydestp, int bxc, int byc, u32 pitch) {
+	if (((uintptr_t)ydestp & 0xF) != 0 || (pitch & 0xF) != 0) {
+		DoUnswizzleTex16Basic(texptr, ydestp, bxc, byc, pitch);
+		return;
+	}
+
+	const u32 pitchBy32 = pitch >> 2;
+	const __m128i *src = (const __m128i *)texptr;
+	for (int by = 0; by < byc; by++) {
+		u8 *xdest = (u8 *)ydestp;
+		int bx = 0;
+		for (; bx + 1 < bxc; bx += 2) {
+			u8 *dest = xdest;
+			for (int n = 0; n < 8; n++) {
+				const __m256i line = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_load_si128(src + n)), _mm_load_si128(src + 8 + n), 1);
+				_mm256_storeu_si256((__m256i *)dest, line);
+				dest += pitch;
+			}
+			src += 16;
+			xdest += 32;
+		}
+		if (bx < bxc) {
+			u8 *dest = xdest;
+			for (int n = 0; n < 8; n++) {
+				_mm_store_si128((__m128i *)dest, _mm_load_si128(src + n));
+				dest += pitch;
+			}
+			src += 8;
+		}
+		ydestp += pitchBy32 * 8;
+	}
+}
+
+AVX2_FUNC static void DeIndexTexture8To32AVX2(u32 *dest, const u8 *indexed, int length, const u32 *clut) {
+	int i = 0;
+	for (; i + 8 <= length; i += 8) {
+		const __m256i index = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(indexed + i)));
+		_mm256_storeu_si256((__m256i *)(dest + i), _mm256_i32gather_epi32((const int *)clut, index, 4));
+	}
+	for (; i < length; ++i) {
+		dest[i] = clut[indexed[i]];
+	}
+}
+
+// There's no 16-bit gather, so this gathers 32 bits at each entry and keeps the low half.
+AVX2_FUNC static void DeIndexTexture8To16AVX2(u16 *dest, const u8 *indexed, int length, const u16 *clut) {
+	const __m256i lowMask = _mm256_set1_epi32(0x0000FFFF);
+	int i = 0;
+	for (; i + 16 <= length; i += 16) {
+		const __m256i index1 = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(indexed + i)));
+		const __m256i index2 = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(indexed + i + 8)));
+		const __m256i colors1 = _mm256_and_si256(_mm256_i32gather_epi32((const int *)clut, index1, 2), lowMask);
+		const __m256i colors2 = _mm256_and_si256(_mm256_i32gather_epi32((const int *)clut, index2, 2), lowMask);
+		// Packing works within each 128-bit lane, so put the quarters back in order after.
+		const __m256i packed = _mm256_packus_epi32(colors1, colors2);
+		_mm256_storeu_si256((__m256i *)(dest + i), _mm256_permute4x64_epi64(packed, _MM_SHUFFLE(3, 1, 2, 0)));
+	}
+	for (; i < length; ++i) {
+		dest[i] = clut[indexed[i]];
+	}
+}
+
+// Same mixing as QuickTexHashSSE2, but 32 bytes at a time, so the result is different.
+AVX2_FUNC static u32 QuickTexHashAVX2(const void *checkp, u32 size) {
+	if (((intptr_t)checkp & 0x1f) != 0 || (size & 0x7f) != 0)
+		return QuickTexHashSSE2(checkp, size);
+
+	__m256i cursor = _mm256_setzero_si256();
+	__m256i cursor2 = _mm256_set_epi16(0x0001U, 0x0083U, 0x4309U, 0x4d9bU, 0xb651U, 0x4b73U, 0x9bd9U, 0xc00bU, 0x0001U, 0x0083U, 0x4309U, 0x4d9bU, 0xb651U, 0x4b73U, 0x9bd9U, 0xc00bU);
+	const __m256i update = _mm256_set1_epi16(0x2455U);
+	const __m256i *p = (const __m256i *)checkp;
+	for (u32 i = 0; i < size / 32; i += 4) {
+		__m256i chunk = _mm256_mullo_epi16(_mm256_load_si256(&p[i]), cursor2);
+		cursor = _mm256_add_epi16(cursor, chunk);
+		cursor = _mm256_xor_si256(cursor, _mm256_load_si256(&p[i + 1]));
+		cursor = _mm256_add_epi32(cursor, _mm256_load_si256(&p[i + 2]));
+		chunk = _mm256_mullo_epi16(_mm256_load_si256(&p[i + 3]), cursor2);
+		cursor = _mm256_xor_si256(cursor, chunk);
+		cursor2 = _mm256_add_epi16(cursor2, update);
+	}
+	cursor = _mm256_add_epi32(cursor, cursor2);
+	// Add the eight parts into the low i32.
+	__m128i sum = _mm_add_epi32(_mm256_castsi256_si128(cursor), _mm256_extracti128_si256(cursor, 1));
+	sum = _mm_add_epi32(sum, _mm_srli_si128(sum, 8));
+	sum = _mm_add_epi32(sum, _mm_srli_si128(sum, 4));
+	return _mm_cvtsi128_si32(sum);
+}
+#endif
+
+#if defined(_M_SSE)
+static void DeIndexTexture8To32Basic(u32 *dest, const u8 *indexed, int length, const u32 *clut) {
+	for (int i = 0; i < length; ++i) {
+		dest[i] = clut[indexed[i]];
+	}
+}
+
+static void DeIndexTexture8To16Basic(u16 *dest, const u8 *indexed, int length, const u16 *clut) {
+	for (int i = 0; i < length; ++i) {
+		dest[i] = clut[indexed[i]];
+	}
+}
+
+QuickTexHashFunc DoQuickTexHash = &QuickTexHashSSE2;
+UnswizzleTex16Func DoUnswizzleTex16 = &DoUnswizzleTex16Basic;
+DeIndexTexture8To32Func DoDeIndexTexture8To32 = &DeIndexTexture8To32Basic;
+DeIndexTexture8To16Func DoDeIndexTexture8To16 = &DeIndexTexture8To16Basic;
+#elif !PPSSPP_ARCH(ARM64)
 QuickTexHashFunc DoQuickTexHash = &QuickTexHashBasic;
 QuickTexHashFunc StableQuickTexHash = &QuickTexHashNonSSE;
 UnswizzleTex16Func DoUnswizzleTex16 = &DoUnswizzleTex16Basic;
@@ -322,6 +433,14 @@ void SetupTextureDecoder() {
 		DoUnswizzleTex16 = &DoUnswizzleTex16NEON;
 	}
 #endif
+#ifdef AVX2_FUNC
+	if (cpu_info.bAVX2) {
+		DoQuickTexHash = &QuickTexHashAVX2;
+		DoUnswizzleTex16 = &DoUnswizzleTex16AVX2;
+		DoDeIndexTexture8To32 = &DeIndexTexture8To32AVX2;
+		DoDeIndexTexture8To16 = &DeIndexTexture8To16AVX2;
+	}
+#endif
 }
 
 // S3TC / DXT Decoder
@@ -37,15 +37,27 @@ void SetupTextureDecoder();
 // Pitch must be aligned to 16 bits (as is the case on a PSP)
 void DoSwizzleTex16(const u32 *ysrcp, u8 *texptr, int bxc, int byc, u32 pitch);
 
-// For SSE, we statically link the SSE2 algorithms.
+typedef void (*UnswizzleTex16Func)(const u8 *texptr, u32 *ydestp, int bxc, int byc, u32 pitch);
+typedef u32 (*QuickTexHashFunc)(const void *checkp, u32 size);
+
+// For SSE, we statically link the SSE2 hash as the stable one.  It can't go wider without changing the result.
 #if defined(_M_SSE)
 u32 QuickTexHashSSE2(const void *checkp, u32 size);
-#define DoQuickTexHash QuickTexHashSSE2
 #define StableQuickTexHash QuickTexHashSSE2
+// Only compared against itself, so it switches to AVX2 in SetupTextureDecoder() when available.
+extern QuickTexHashFunc DoQuickTexHash;
 
 // Pitch must be aligned to 16 bytes (as is the case on a PSP)
 void DoUnswizzleTex16Basic(const u8 *texptr, u32 *ydestp, int bxc, int byc, u32 pitch);
-#define DoUnswizzleTex16 DoUnswizzleTex16Basic
+// Switches to AVX2 in SetupTextureDecoder() when available.
+extern UnswizzleTex16Func DoUnswizzleTex16;
+
+// CLUT lookup of 8-bit indices into a 32-bit palette, used by DeIndexTexture.
+typedef void (*DeIndexTexture8To32Func)(u32 *dest, const u8 *indexed, int length, const u32 *clut);
+extern DeIndexTexture8To32Func DoDeIndexTexture8To32;
+// Same for a 16-bit palette.  May read (but not use) the two bytes after the last entry used.
+typedef void (*DeIndexTexture8To16Func)(u16 *dest, const u8 *indexed, int length, const u16 *clut);
+extern DeIndexTexture8To16Func DoDeIndexTexture8To16;
 
 // For ARM64, NEON is mandatory, so we also statically link.
 #elif PPSSPP_ARCH(ARM64)
@@ -53,11 +65,9 @@ void DoUnswizzleTex16Basic(const u8 *texptr, u32 *ydestp, int bxc, int byc, u32
 #define StableQuickTexHash QuickTexHashNEON
 #define DoUnswizzleTex16 DoUnswizzleTex16NEON
 #else
-typedef u32 (*QuickTexHashFunc)(const void *checkp, u32 size);
 extern QuickTexHashFunc DoQuickTexHash;
 extern QuickTexHashFunc StableQuickTexHash;
 
-typedef void (*UnswizzleTex16Func)(const u8 *texptr, u32 *ydestp, int bxc, int byc, u32 pitch);
 extern UnswizzleTex16Func DoUnswizzleTex16;
 #endif
 
@@ -123,6 +133,16 @@ inline void DeIndexTexture(ClutT *dest, const IndexT *indexed, int length, const
 	const bool nakedIndex = gstate.isClutIndexSimple();
 
 	if (nakedIndex) {
+#if defined(_M_SSE)
+		if (sizeof(IndexT) == 1 && sizeof(ClutT) == 4) {
+			DoDeIndexTexture8To32((u32 *)dest, (const u8 *)indexed, length, (const u32 *)clut);
+			return;
+		}
+		if (sizeof(IndexT) == 1 && sizeof(ClutT) == 2) {
+			DoDeIndexTexture8To16((u16 *)dest, (const u8 *)indexed, length, (const u16 *)clut);
+			return;
+		}
+#endif
 		if (sizeof(IndexT) == 1) {
 			for (int i = 0; i < length; ++i) {
 				*dest++ = clut[*indexed++];
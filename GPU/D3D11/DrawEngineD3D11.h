@@ -50,52 +50,13 @@ class FramebufferManagerD3D11;
 // DRAWN_ONCE -> death
 // DRAWN_RELIABLE -> death
 
-enum {
-	VAI11_FLAG_VERTEXFULLALPHA = 1,
-};
-
 // Try to keep this POD.
-class VertexArrayInfoD3D11 {
+class VertexArrayInfoD3D11 : public VertexArrayInfoCommon {
 public:
-	VertexArrayInfoD3D11() {
-		status = VAI_NEW;
-		vbo = 0;
-		ebo = 0;
-		prim = GE_PRIM_INVALID;
-		numDraws = 0;
-		numFrames = 0;
-		lastFrame = gpuStats.numFlips;
-		numVerts = 0;
-		drawsUntilNextFullHash = 0;
-		flags = 0;
-	}
 	~VertexArrayInfoD3D11();
 
-	enum Status : uint8_t {
-		VAI_NEW,
-		VAI_HASHING,
-		VAI_RELIABLE,  // cache, don't hash
-		VAI_UNRELIABLE,  // never cache
-	};
-
-	uint64_t hash;
-	u32 minihash;
-
-	ID3D11Buffer *vbo;
-	ID3D11Buffer *ebo;
-
-	// Precalculated parameter for drawRangeElements
-	u16 numVerts;
-	u16 maxIndex;
-	s8 prim;
-	Status status;
-
-	// ID information
-	int numDraws;
-	int numFrames;
-	int lastFrame;  // So that we can forget.
-	u16 drawsUntilNextFullHash;
-	u8 flags;
+	ID3D11Buffer *vbo = nullptr;
+	ID3D11Buffer *ebo = nullptr;
 };
 
 class TessellationDataTransferD3D11 : public TessellationDataTransfer {
@@ -19,6 +19,7 @@
 
 #include "Common/CommonWindows.h"
 
+#include <map>
 #include <d3d11.h>
 
 #include "GPU/GPU.h"
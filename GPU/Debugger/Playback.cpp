@@ -16,6 +16,7 @@
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
 #include <algorithm>
+#include <atomic>
 #include <cstring>
 #include <functional>
 #include <mutex>
@@ -25,6 +26,8 @@
 #include "Common/Profiler/Profiler.h"
 #include "Common/Common.h"
 #include "Common/Log.h"
+#include "Common/Thread/ParallelLoop.h"
+#include "Common/TimeUtil.h"
 #include "Core/Core.h"
 #include "Core/CoreTiming.h"
 #include "Core/ELF/ParamSFO.h"
@@ -34,6 +37,8 @@
 #include "Core/MemMap.h"
 #include "Core/MIPS/MIPS.h"
 #include "Core/System.h"
+#include "Core/ThreadPools.h"
+#include "GPU/GPU.h"
 #include "GPU/GPUInterface.h"
 #include "GPU/GPUState.h"
 #include "GPU/ge_constants.h"
@@ -48,6 +53,15 @@ static std::vector<Command> lastExecCommands;
 static std::vector<u8> lastExecPushbuf;
 static std::mutex executeLock;
 
+struct ReplayBenchmark {
+	bool running;
+	int framesWanted;
+	double lastStart;
+	GPUStatistics lastStats;
+	std::vector<ReplayFrameStats> frames;
+};
+static ReplayBenchmark replayBenchmark;
+
 // This class maps pushbuffer (dump data) sections to PSP memory.
 // Dumps can be larger than available PSP memory, because they include generated data too.
 //
@@ -660,6 +674,160 @@ static bool ReadCompressed(u32 fp, void *dest, size_t sz, uint32_t version) {
 	return real_size == sz;
 }
 
+static bool ReadChunked(u32 fp) {
+	// Positions are 64-bit in the format, but we can only seek with an s32.
+	const u64 fileSize = pspFileSystem.SeekFile(fp, 0, FILEMOVE_END);
+	if (fileSize < sizeof(ChunkFooter) || fileSize > 0x7FFFFFFF) {
+		return false;
+	}
+
+	ChunkFooter footer;
+	pspFileSystem.SeekFile(fp, (s32)(fileSize - sizeof(footer)), FILEMOVE_BEGIN);
+	if (pspFileSystem.ReadFile(fp, (u8 *)&footer, sizeof(footer)) != sizeof(footer)) {
+		return false;
+	}
+	// Recording was cut off before the index was written.
+	if (memcmp(footer.magic, FOOTER_MAGIC, sizeof(footer.magic)) != 0) {
+		return false;
+	}
+
+	// The index sits right before the footer, so this also bounds chunkCount before we allocate.
+	const u64 indexSize = (u64)footer.chunkCount * sizeof(ChunkIndexEntry);
+	if (footer.indexPos > fileSize || footer.indexPos + indexSize + sizeof(ChunkFooter) != fileSize) {
+		return false;
+	}
+
+	std::vector<ChunkIndexEntry> index(footer.chunkCount);
+	pspFileSystem.SeekFile(fp, (s32)footer.indexPos, FILEMOVE_BEGIN);
+	if (pspFileSystem.ReadFile(fp, (u8 *)index.data(), indexSize) != indexSize) {
+		return false;
+	}
+
+	// Chunks are written in order between the header and the index, and cover the footer's sizes exactly.
+	const u64 commandsSize = (u64)footer.commandCount * sizeof(Command);
+	u64 commandsTotal = 0;
+	u64 pushbufTotal = 0;
+	u64 prevEnd = sizeof(Header);
+	for (const ChunkIndexEntry &entry : index) {
+		if (entry.type != ChunkType::COMMANDS && entry.type != ChunkType::PUSHBUF) {
+			return false;
+		}
+		if (entry.filePos < prevEnd || entry.filePos > footer.indexPos || entry.compressedSize > footer.indexPos - entry.filePos) {
+			return false;
+		}
+		prevEnd = entry.filePos + entry.compressedSize;
+
+		u64 &total = entry.type == ChunkType::COMMANDS ? commandsTotal : pushbufTotal;
+		const u64 limit = entry.type == ChunkType::COMMANDS ? commandsSize : footer.pushbufSize;
+		if ((u64)entry.offset + entry.size > limit) {
+			return false;
+		}
+		total += entry.size;
+	}
+	if (commandsTotal != commandsSize || pushbufTotal != footer.pushbufSize) {
+		return false;
+	}
+
+	// The chunks are decompressed in parallel, so their output ranges must not overlap either.
+	// Together with the totals above, that means they cover each buffer exactly once.
+	std::vector<const ChunkIndexEntry *> sorted(index.size());
+	for (size_t i = 0; i < index.size(); ++i) {
+		sorted[i] = &index[i];
+	}
+	std::sort(sorted.begin(), sorted.end(), [](const ChunkIndexEntry *a, const ChunkIndexEntry *b) {
+		if (a->type != b->type)
+			return a->type < b->type;
+		return a->offset < b->offset;
+	});
+	for (size_t i = 1; i < sorted.size(); ++i) {
+		const ChunkIndexEntry *prev = sorted[i - 1];
+		if (prev->type == sorted[i]->type && (u64)prev->offset + prev->size > sorted[i]->offset) {
+			return false;
+		}
+	}
+
+	lastExecCommands.resize(footer.commandCount);
+	lastExecPushbuf.resize(footer.pushbufSize);
+
+	// The file system isn't thread safe, so read everything first and only decompress in parallel.
+	std::vector<std::vector<u8>> compressed(index.size());
+	for (size_t i = 0; i < index.size(); ++i) {
+		const ChunkIndexEntry &entry = index[i];
+		compressed[i].resize(entry.compressedSize);
+		pspFileSystem.SeekFile(fp, (s32)entry.filePos, FILEMOVE_BEGIN);
+		if (pspFileSystem.ReadFile(fp, compressed[i].data(), entry.compressedSize) != entry.compressedSize) {
+			return false;
+		}
+	}
+
+	std::atomic<bool> failed(false);
+	ParallelRangeLoop(&g_threadManager, [&](int l, int h) {
+		for (int i = l; i < h; ++i) {
+			const ChunkIndexEntry &entry = index[i];
+			u8 *dest = entry.type == ChunkType::COMMANDS ? (u8 *)lastExecCommands.data() : lastExecPushbuf.data();
+			size_t real_size = ZSTD_decompress(dest + entry.offset, entry.size, compressed[i].data(), compressed[i].size());
+			if (real_size != entry.size)
+				failed = true;
+		}
+	}, 0, (int)index.size(), 1);
+
+	return !failed;
+}
+
+// Returns false once enough frames were measured.
+static bool ReplayBenchmarkFrame() {
+	ReplayBenchmark &bench = replayBenchmark;
+	double now = time_now_d();
+	if (bench.lastStart != 0.0) {
+		// Debug stats are only reset per host frame, so take the difference.
+		const GPUStatistics &prev = bench.lastStats;
+		ReplayFrameStats frame;
+		frame.seconds = now - bench.lastStart;
+		frame.displayListSeconds = gpuStats.msProcessingDisplayLists - prev.msProcessingDisplayLists;
+		frame.vertexDecodeSeconds = gpuStats.msDecodingVertices - prev.msDecodingVertices;
+		frame.textureDecodeSeconds = gpuStats.msDecodingTextures - prev.msDecodingTextures;
+		frame.rasterizeSeconds = gpuStats.msRasterizing - prev.msRasterizing;
+		frame.drawCalls = gpuStats.numDrawCalls - prev.numDrawCalls;
+		frame.flushes = gpuStats.numFlushes - prev.numFlushes;
+		frame.vertices = gpuStats.numVertsSubmitted - prev.numVertsSubmitted;
+		frame.texturesDecoded = gpuStats.numTexturesDecoded - prev.numTexturesDecoded;
+		frame.textureCacheLookups = gpuStats.numTextureCacheLookups - prev.numTextureCacheLookups;
+		frame.textureCacheHits = gpuStats.numTextureCacheHits - prev.numTextureCacheHits;
+		bench.frames.push_back(frame);
+	}
+
+	if ((int)bench.frames.size() >= bench.framesWanted) {
+		bench.running = false;
+		return false;
+	}
+
+	// Take this last, so the bookkeeping above isn't counted.
+	bench.lastStats = gpuStats;
+	bench.lastStart = time_now_d();
+	return true;
+}
+
+void BeginReplayBenchmark(int frames) {
+	std::lock_guard<std::mutex> guard(executeLock);
+	replayBenchmark.running = frames > 0;
+	replayBenchmark.framesWanted = frames;
+	replayBenchmark.lastStart = 0.0;
+	replayBenchmark.frames.clear();
+}
+
+bool IsReplayBenchmarkRunning() {
+	std::lock_guard<std::mutex> guard(executeLock);
+	return replayBenchmark.running;
+}
+
+std::vector<ReplayFrameStats> EndReplayBenchmark() {
+	std::lock_guard<std::mutex> guard(executeLock);
+	replayBenchmark.running = false;
+	std::vector<ReplayFrameStats> frames;
+	frames.swap(replayBenchmark.frames);
+	return frames;
+}
+
 static void ReplayStop() {
 	// This can happen from a separate thread.
 	std::lock_guard<std::mutex> guard(executeLock);
@@ -694,17 +862,21 @@ bool RunMountedReplay(const std::string &filename) {
 			g_paramSFO.SetValue("DISC_ID", std::string(header.gameID, gameIDLength), (int)sizeof(header.gameID));
 		}
 
-		u32 sz = 0;
-		pspFileSystem.ReadFile(fp, (u8 *)&sz, sizeof(sz));
-		u32 bufsz = 0;
-		pspFileSystem.ReadFile(fp, (u8 *)&bufsz, sizeof(bufsz));
-
-		lastExecCommands.resize(sz);
-		lastExecPushbuf.resize(bufsz);
-
 		bool truncated = false;
-		truncated = truncated || !ReadCompressed(fp, lastExecCommands.data(), sizeof(Command) * sz, header.version);
-		truncated = truncated || !ReadCompressed(fp, lastExecPushbuf.data(), bufsz, header.version);
+		if (header.version >= CHUNKED_VERSION) {
+			truncated = !ReadChunked(fp);
+		} else {
+			u32 sz = 0;
+			pspFileSystem.ReadFile(fp, (u8 *)&sz, sizeof(sz));
+			u32 bufsz = 0;
+			pspFileSystem.ReadFile(fp, (u8 *)&bufsz, sizeof(bufsz));
+
+			lastExecCommands.resize(sz);
+			lastExecPushbuf.resize(bufsz);
+
+			truncated = truncated || !ReadCompressed(fp, lastExecCommands.data(), sizeof(Command) * sz, header.version);
+			truncated = truncated || !ReadCompressed(fp, lastExecPushbuf.data(), bufsz, header.version);
+		}
 
 		pspFileSystem.CloseFile(fp);
 
@@ -716,6 +888,11 @@ bool RunMountedReplay(const std::string &filename) {
 		lastExecFilename = filename;
 	}
 
+	if (replayBenchmark.running && !ReplayBenchmarkFrame()) {
+		// Measured enough, don't start another frame.
+		return true;
+	}
+
 	DumpExecute executor(lastExecPushbuf, lastExecCommands);
 	return executor.Run();
 }
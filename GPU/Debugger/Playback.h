@@ -18,9 +18,32 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 namespace GPURecord {
 
 bool RunMountedReplay(const std::string &filename);
 
+// Measured from the start of one replay to the next, so the sync and flip are included.
+// The stage timings are only collected with coreCollectDebugStats.
+struct ReplayFrameStats {
+	double seconds;
+	double displayListSeconds;
+	double vertexDecodeSeconds;
+	double textureDecodeSeconds;
+	double rasterizeSeconds;
+	int drawCalls;
+	int flushes;
+	int vertices;
+	int texturesDecoded;
+	int textureCacheLookups;
+	int textureCacheHits;
+};
+
+// Replays the mounted dump until the given number of frames were measured, then stops.
+void BeginReplayBenchmark(int frames);
+bool IsReplayBenchmarkRunning();
+// Returns the frames measured since BeginReplayBenchmark().
+std::vector<ReplayFrameStats> EndReplayBenchmark();
+
 };
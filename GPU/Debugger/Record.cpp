@@ -51,19 +51,44 @@ static bool nextFrame = false;
 static int flipLastAction = -1;
 static std::function<void(const Path &)> writeCallback;
 
+// Only the chunk being built is kept in memory, older data is already in the file.
 static std::vector<u8> pushbuf;
 static std::vector<Command> commands;
 static std::vector<u32> lastRegisters;
+// Pushbuf positions, only within the current chunk.
 static std::vector<u32> lastTextures;
 static std::set<u32> lastRenderTargets;
 
+static FILE *recordFile = nullptr;
+static Path recordFilename;
+static u64 recordFilePos = 0;
+static std::vector<ChunkIndexEntry> chunkIndex;
+// Where pushbuf and commands start within the whole recording.
+static u32 pushbufBase = 0;
+static u32 commandsBase = 0;
+
+enum {
+	PUSHBUF_CHUNK_SIZE = 8 * 1024 * 1024,
+	COMMANDS_CHUNK_COUNT = 64 * 1024,
+};
+
+static u32 PushbufPos() {
+	return pushbufBase + (u32)pushbuf.size();
+}
+
+// Returns the position of the data within the whole recording.
+static u32 AppendPushbuf(const void *p, u32 sz) {
+	u32 ptr = PushbufPos();
+	pushbuf.resize(pushbuf.size() + sz);
+	memcpy(pushbuf.data() + ptr - pushbufBase, p, sz);
+	return ptr;
+}
+
 static void FlushRegisters() {
 	if (!lastRegisters.empty()) {
 		Command last{CommandType::REGISTERS};
-		last.ptr = (u32)pushbuf.size();
 		last.sz = (u32)(lastRegisters.size() * sizeof(u32));
-		pushbuf.resize(pushbuf.size() + last.sz);
-		memcpy(pushbuf.data() + last.ptr, lastRegisters.data(), last.sz);
+		last.ptr = AppendPushbuf(lastRegisters.data(), last.sz);
 		lastRegisters.clear();
 
 		commands.push_back(last);
@@ -90,58 +115,108 @@ static Path GenRecordingFilename() {
 	return dumpDir / StringFromFormat("%s_%04d.ppdmp", prefix.c_str(), 9999);
 }
 
-static void BeginRecording() {
+static bool BeginRecording() {
+	recordFilename = GenRecordingFilename();
+	NOTICE_LOG(G3D, "Recording filename: %s", recordFilename.c_str());
+
+	recordFile = File::OpenCFile(recordFilename, "wb");
+	if (!recordFile) {
+		ERROR_LOG(G3D, "Unable to open %s for recording", recordFilename.c_str());
+		return false;
+	}
+
+	Header header{};
+	strncpy(header.magic, HEADER_MAGIC, sizeof(header.magic));
+	header.version = VERSION;
+	strncpy(header.gameID, g_paramSFO.GetDiscID().c_str(), sizeof(header.gameID));
+	fwrite(&header, sizeof(header), 1, recordFile);
+	recordFilePos = sizeof(header);
+
 	active = true;
 	nextFrame = false;
 	lastTextures.clear();
 	lastRenderTargets.clear();
+	chunkIndex.clear();
+	pushbufBase = 0;
+	commandsBase = 0;
 	flipLastAction = gpuStats.numFlips;
 
-	u32 ptr = (u32)pushbuf.size();
+	u32 ptr = PushbufPos();
 	u32 sz = 512 * 4;
 	pushbuf.resize(pushbuf.size() + sz);
-	gstate.Save((u32_le *)(pushbuf.data() + ptr));
+	gstate.Save((u32_le *)(pushbuf.data() + ptr - pushbufBase));
 
 	commands.push_back({CommandType::INIT, sz, ptr});
+	return true;
 }
 
-static void WriteCompressed(FILE *fp, const void *p, size_t sz) {
+static void WriteChunk(ChunkType type, u32 offset, const void *p, u32 sz) {
+	if (sz == 0)
+		return;
+
 	size_t compressed_size = ZSTD_compressBound(sz);
 	u8 *compressed = new u8[compressed_size];
 	compressed_size = ZSTD_compress(compressed, compressed_size, p, sz, 6);
 
-	u32 write_size = (u32)compressed_size;
-	fwrite(&write_size, sizeof(write_size), 1, fp);
-	fwrite(compressed, compressed_size, 1, fp);
+	ChunkIndexEntry entry{ type };
+	entry.offset = offset;
+	entry.size = sz;
+	entry.compressedSize = (u32)compressed_size;
+	entry.filePos = recordFilePos;
+	fwrite(compressed, compressed_size, 1, recordFile);
+	recordFilePos += compressed_size;
+	chunkIndex.push_back(entry);
 
 	delete [] compressed;
 }
 
-static Path WriteRecording() {
-	FlushRegisters();
-
-	const Path filename = GenRecordingFilename();
-
-	NOTICE_LOG(G3D, "Recording filename: %s", filename.c_str());
-
-	FILE *fp = File::OpenCFile(filename, "wb");
-	Header header{};
-	strncpy(header.magic, HEADER_MAGIC, sizeof(header.magic));
-	header.version = VERSION;
-	strncpy(header.gameID, g_paramSFO.GetDiscID().c_str(), sizeof(header.gameID));
-	fwrite(&header, sizeof(header), 1, fp);
+static void WritePushbufChunk() {
+	// Keep the next chunk aligned, since de-duplicating only searches aligned positions within the chunk.
+	pushbuf.resize((pushbuf.size() + 15) & ~15, 0);
+	WriteChunk(ChunkType::PUSHBUF, pushbufBase, pushbuf.data(), (u32)pushbuf.size());
+	pushbufBase += (u32)pushbuf.size();
+	pushbuf.clear();
+	// These were only for de-duplicating within the chunk.
+	lastTextures.clear();
+}
 
-	u32 sz = (u32)commands.size();
-	fwrite(&sz, sizeof(sz), 1, fp);
-	u32 bufsz = (u32)pushbuf.size();
-	fwrite(&bufsz, sizeof(bufsz), 1, fp);
+static void WriteCommandsChunk() {
+	WriteChunk(ChunkType::COMMANDS, commandsBase * sizeof(Command), commands.data(), (u32)(commands.size() * sizeof(Command)));
+	commandsBase += (u32)commands.size();
+	commands.clear();
+}
 
-	WriteCompressed(fp, commands.data(), commands.size() * sizeof(Command));
-	WriteCompressed(fp, pushbuf.data(), bufsz);
+// Called between commands, so memory stays bounded however long the recording is.
+static void WriteFullChunks() {
+	if (pushbuf.size() >= PUSHBUF_CHUNK_SIZE)
+		WritePushbufChunk();
+	if (commands.size() >= COMMANDS_CHUNK_COUNT)
+		WriteCommandsChunk();
+}
 
-	fclose(fp);
+static bool HasCommands() {
+	return commandsBase != 0 || !commands.empty();
+}
 
-	return filename;
+static Path WriteRecording() {
+	FlushRegisters();
+	WritePushbufChunk();
+	WriteCommandsChunk();
+
+	ChunkFooter footer{};
+	footer.commandCount = commandsBase;
+	footer.pushbufSize = pushbufBase;
+	footer.chunkCount = (u32)chunkIndex.size();
+	footer.indexPos = recordFilePos;
+	memcpy(footer.magic, FOOTER_MAGIC, sizeof(footer.magic));
+	fwrite(chunkIndex.data(), sizeof(ChunkIndexEntry), chunkIndex.size(), recordFile);
+	fwrite(&footer, sizeof(footer), 1, recordFile);
+
+	fclose(recordFile);
+	recordFile = nullptr;
+	chunkIndex.clear();
+
+	return recordFilename;
 }
 
 static void GetVertDataSizes(int vcount, const void *indices, u32 &vbytes, u32 &ibytes) {
@@ -235,9 +310,9 @@ static Command EmitCommandWithRAM(CommandType t, const void *p, u32 sz, u32 alig
 		}
 
 		if (prev) {
-			cmd.ptr = (u32)(prev - pushbuf.data());
+			cmd.ptr = pushbufBase + (u32)(prev - pushbuf.data());
 		} else {
-			cmd.ptr = (u32)pushbuf.size();
+			cmd.ptr = PushbufPos();
 			int pad = 0;
 			if (cmd.ptr & (align - 1)) {
 				pad = align - (cmd.ptr & (align - 1));
@@ -245,9 +320,9 @@ static Command EmitCommandWithRAM(CommandType t, const void *p, u32 sz, u32 alig
 			}
 			pushbuf.resize(pushbuf.size() + sz + pad);
 			if (pad) {
-				memset(pushbuf.data() + cmd.ptr - pad, 0, pad);
+				memset(pushbuf.data() + cmd.ptr - pushbufBase - pad, 0, pad);
 			}
-			memcpy(pushbuf.data() + cmd.ptr, p, sz);
+			memcpy(pushbuf.data() + cmd.ptr - pushbufBase, p, sz);
 		}
 	}
 
@@ -296,11 +371,11 @@ static void EmitTextureData(int level, u32 texaddr) {
 
 		// Dumps are huge - let's try to find this already emitted.
 		for (u32 prevptr : lastTextures) {
-			if (pushbuf.size() < prevptr + bytes) {
+			if (PushbufPos() < prevptr + bytes) {
 				continue;
 			}
 
-			if (memcmp(pushbuf.data() + prevptr, p, bytes) == 0) {
+			if (memcmp(pushbuf.data() + prevptr - pushbufBase, p, bytes) == 0) {
 				commands.push_back({type, bytes, prevptr});
 				// Okay, that was easy.  Bail out.
 				return;
@@ -425,8 +500,6 @@ void SetCallback(const std::function<void(const Path &)> callback) {
 static void FinishRecording() {
 	// We're done - this was just to write the result out.
 	Path filename = WriteRecording();
-	commands.clear();
-	pushbuf.clear();
 
 	NOTICE_LOG(SYSTEM, "Recording finished");
 	active = false;
@@ -437,6 +510,35 @@ static void FinishRecording() {
 	writeCallback = nullptr;
 }
 
+static void AbortRecording() {
+	nextFrame = false;
+	active = false;
+	flipLastAction = gpuStats.numFlips;
+
+	// Let the caller know, with no file.
+	if (writeCallback)
+		writeCallback(Path());
+	writeCallback = nullptr;
+}
+
+void Reset() {
+	if (recordFile) {
+		// Never finished, so there's no index and it can't be played back anyway.
+		fclose(recordFile);
+		recordFile = nullptr;
+		File::Delete(recordFilename);
+	}
+	if (active || nextFrame)
+		AbortRecording();
+
+	pushbuf.clear();
+	commands.clear();
+	lastRegisters.clear();
+	lastTextures.clear();
+	lastRenderTargets.clear();
+	chunkIndex.clear();
+}
+
 void NotifyCommand(u32 pc) {
 	if (!active) {
 		return;
@@ -488,6 +590,8 @@ void NotifyCommand(u32 pc) {
 		lastRegisters.push_back(op);
 		break;
 	}
+
+	WriteFullChunks();
 }
 
 void NotifyMemcpy(u32 dest, u32 src, u32 sz) {
@@ -496,14 +600,14 @@ void NotifyMemcpy(u32 dest, u32 src, u32 sz) {
 	}
 	if (Memory::IsVRAMAddress(dest)) {
 		FlushRegisters();
-		Command cmd{CommandType::MEMCPYDEST, sizeof(dest), (u32)pushbuf.size()};
-		pushbuf.resize(pushbuf.size() + sizeof(dest));
-		memcpy(pushbuf.data() + cmd.ptr, &dest, sizeof(dest));
+		Command cmd{CommandType::MEMCPYDEST, sizeof(dest), AppendPushbuf(&dest, sizeof(dest))};
+		commands.push_back(cmd);
 
 		sz = Memory::ValidSize(dest, sz);
 		if (sz != 0) {
 			EmitCommandWithRAM(CommandType::MEMCPYDATA, Memory::GetPointer(dest), sz, 1);
 		}
+		WriteFullChunks();
 	}
 }
 
@@ -522,9 +626,9 @@ void NotifyMemset(u32 dest, int v, u32 sz) {
 		MemsetCommand data{dest, v, sz};
 
 		FlushRegisters();
-		Command cmd{CommandType::MEMSET, sizeof(data), (u32)pushbuf.size()};
-		pushbuf.resize(pushbuf.size() + sizeof(data));
-		memcpy(pushbuf.data() + cmd.ptr, &data, sizeof(data));
+		Command cmd{CommandType::MEMSET, sizeof(data), AppendPushbuf(&data, sizeof(data))};
+		commands.push_back(cmd);
+		WriteFullChunks();
 	}
 }
 
@@ -537,12 +641,13 @@ void NotifyUpload(u32 dest, u32 sz) {
 
 void NotifyDisplay(u32 framebuf, int stride, int fmt) {
 	bool writePending = false;
-	if (active && !commands.empty()) {
+	if (active && HasCommands()) {
 		writePending = true;
 	}
 	if (nextFrame && (gstate_c.skipDrawReason & SKIPDRAW_SKIPFRAME) == 0) {
 		NOTICE_LOG(SYSTEM, "Recording starting on display...");
-		BeginRecording();
+		if (!BeginRecording())
+			AbortRecording();
 	}
 	if (!active) {
 		return;
@@ -556,12 +661,8 @@ void NotifyDisplay(u32 framebuf, int stride, int fmt) {
 	DisplayBufData disp{ { framebuf }, stride, fmt };
 
 	FlushRegisters();
-	u32 ptr = (u32)pushbuf.size();
 	u32 sz = (u32)sizeof(disp);
-	pushbuf.resize(pushbuf.size() + sz);
-	memcpy(pushbuf.data() + ptr, &disp, sz);
-
-	commands.push_back({ CommandType::DISPLAY, sz, ptr });
+	commands.push_back({ CommandType::DISPLAY, sz, AppendPushbuf(&disp, sz) });
 
 	if (writePending) {
 		NOTICE_LOG(SYSTEM, "Recording complete on display");
@@ -572,7 +673,7 @@ void NotifyDisplay(u32 framebuf, int stride, int fmt) {
 void NotifyFrame() {
 	const bool noDisplayAction = flipLastAction + 4 < gpuStats.numFlips;
 	// We do this only to catch things that don't call NotifyDisplay.
-	if (active && !commands.empty() && noDisplayAction) {
+	if (active && HasCommands() && noDisplayAction) {
 		NOTICE_LOG(SYSTEM, "Recording complete on frame");
 
 		struct DisplayBufData {
@@ -584,18 +685,15 @@ void NotifyFrame() {
 		__DisplayGetFramebuf(&disp.topaddr, &disp.linesize, &disp.pixelFormat, 0);
 
 		FlushRegisters();
-		u32 ptr = (u32)pushbuf.size();
 		u32 sz = (u32)sizeof(disp);
-		pushbuf.resize(pushbuf.size() + sz);
-		memcpy(pushbuf.data() + ptr, &disp, sz);
-
-		commands.push_back({ CommandType::DISPLAY, sz, ptr });
+		commands.push_back({ CommandType::DISPLAY, sz, AppendPushbuf(&disp, sz) });
 
 		FinishRecording();
 	}
 	if (nextFrame && (gstate_c.skipDrawReason & SKIPDRAW_SKIPFRAME) == 0 && noDisplayAction) {
 		NOTICE_LOG(SYSTEM, "Recording starting on frame...");
-		BeginRecording();
+		if (!BeginRecording())
+			AbortRecording();
 	}
 }
 
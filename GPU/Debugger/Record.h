@@ -28,8 +28,10 @@ namespace GPURecord {
 bool IsActive();
 bool IsActivePending();
 bool Activate();
-// Call only if Activate() returns true.
+// Call only if Activate() returns true.  The path is empty if the recording failed.
 void SetCallback(const std::function<void(const Path &)> callback);
+// Drops any recording in progress, like on shutdown.
+void Reset();
 
 void NotifyCommand(u32 pc);
 void NotifyMemcpy(u32 dest, u32 src, u32 sz);
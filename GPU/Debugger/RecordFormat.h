@@ -34,8 +34,17 @@ static const char *HEADER_MAGIC = "PPSSPPGE";
 // Version 3: Adds FRAMEBUF0-FRAMEBUF9
 // Version 4: Expanded header with game ID
 // Version 5: Uses zstd
-static const int VERSION = 5;
+// Version 6: Chunked zstd frames, with an index at the end
+static const int VERSION = 6;
 static const int MIN_VERSION = 2;
+static const int CHUNKED_VERSION = 6;
+
+static const char *FOOTER_MAGIC = "PPGEINDX";
+
+enum class ChunkType : u8 {
+	COMMANDS = 0,
+	PUSHBUF = 1,
+};
 
 enum class CommandType : u8 {
 	INIT = 0,
@@ -76,6 +85,28 @@ struct Command {
 	u32 ptr;
 };
 
+// Each chunk is an independent zstd frame, so they can be read in any order.
+struct ChunkIndexEntry {
+	ChunkType type;
+	u8 pad[3];
+	// Byte offset and size within the commands or the pushbuf, once decompressed.
+	u32 offset;
+	u32 size;
+	u32 compressedSize;
+	u64 filePos;
+};
+
+// Last thing in the file.  Earlier versions have the sizes right after the header instead.
+struct ChunkFooter {
+	u32 commandCount;
+	u32 pushbufSize;
+	u32 chunkCount;
+	u32 pad;
+	// Where the array of ChunkIndexEntry starts.
+	u64 indexPos;
+	char magic[8];
+};
+
 #pragma pack(pop)
 
 };
@@ -59,15 +59,12 @@ enum {
 	TRANSFORMED_VERTEX_BUFFER_SIZE = VERTEX_BUFFER_MAX * sizeof(TransformedVertex)
 };
 
-#define VERTEXCACHE_DECIMATION_INTERVAL 17
 #define VERTEXCACHE_NAME_DECIMATION_INTERVAL 41
 #define VERTEXCACHE_NAME_DECIMATION_MAX 100
 #define VERTEXCACHE_NAME_CACHE_SIZE 64
 #define VERTEXCACHE_NAME_CACHE_FULL_BYTES (1024 * 1024)
 #define VERTEXCACHE_NAME_CACHE_MAX_AGE 120
 
-enum { VAI_KILL_AGE = 120, VAI_UNRELIABLE_KILL_AGE = 240, VAI_UNRELIABLE_KILL_MAX = 4 };
-
 DrawEngineGLES::DrawEngineGLES(Draw::DrawContext *draw) : vai_(256), inputLayoutMap_(16), draw_(draw) {
 	render_ = (GLRenderManager *)draw_->GetNativeObject(Draw::NativeObject::RENDER_MANAGER);
 
@@ -271,18 +268,9 @@ void DrawEngineGLES::DecimateTrackedVertexArrays() {
 		return;
 	}
 
-	const int threshold = gpuStats.numFlips - VAI_KILL_AGE;
-	const int unreliableThreshold = gpuStats.numFlips - VAI_UNRELIABLE_KILL_AGE;
 	int unreliableLeft = VAI_UNRELIABLE_KILL_MAX;
 	vai_.Iterate([&](uint32_t hash, VertexArrayInfo *vai) {
-		bool kill;
-		if (vai->status == VertexArrayInfo::VAI_UNRELIABLE) {
-			// We limit killing unreliable so we don't rehash too often.
-			kill = vai->lastFrame < unreliableThreshold && --unreliableLeft >= 0;
-		} else {
-			kill = vai->lastFrame < threshold;
-		}
-		if (kill) {
+		if (ShouldDecimateVertexArray(vai, unreliableLeft)) {
 			FreeVertexArray(vai);
 			delete vai;
 			vai_.Remove(hash);
@@ -346,14 +334,9 @@ void DrawEngineGLES::DoFlush() {
 		bool populateCache = false;
 		VertexArrayInfo *vai = nullptr;
 
-		// Cannot cache vertex data with morph enabled.
-		bool useCache = g_Config.bVertexCache && !(lastVType_ & GE_VTYPE_MORPHCOUNT_MASK);
-		// Also avoid caching when software skinning.
-		if (g_Config.bSoftwareSkinning && (lastVType_ & GE_VTYPE_WEIGHT_MASK))
-			useCache = false;
-
+		bool useCache = CanUseVertexCache();
 		if (useCache) {
-			u32 id = dcid_ ^ gstate.getUVGenMode();  // This can have an effect on which UV decoder we need to use! And hence what the decoded data will look like. See #9263
+			u32 id = ComputeVertexCacheID();
 			vai = vai_.Get(id);
 			if (!vai) {
 				vai = new VertexArrayInfo();
@@ -364,11 +347,7 @@ void DrawEngineGLES::DoFlush() {
 			case VertexArrayInfo::VAI_NEW:
 				{
 					// Haven't seen this one before.
-					uint64_t dataHash = ComputeHash();
-					vai->hash = dataHash;
-					vai->minihash = ComputeMiniHash();
-					vai->status = VertexArrayInfo::VAI_HASHING;
-					vai->drawsUntilNextFullHash = 0;
+					StartHashingVertexArray(vai);
 					useCache = false;
 					break;
 				}
@@ -377,40 +356,11 @@ void DrawEngineGLES::DoFlush() {
 				// But if we get this far it's likely to be worth creating a vertex buffer.
 			case VertexArrayInfo::VAI_HASHING:
 				{
-					vai->numDraws++;
-					if (vai->lastFrame != gpuStats.numFlips) {
-						vai->numFrames++;
-					}
-					if (vai->drawsUntilNextFullHash == 0) {
-						// Let's try to skip a full hash if mini would fail.
-						const u32 newMiniHash = ComputeMiniHash();
-						uint64_t newHash = vai->hash;
-						if (newMiniHash == vai->minihash) {
-							newHash = ComputeHash();
-						}
-						if (newMiniHash != vai->minihash || newHash != vai->hash) {
-							MarkUnreliable(vai);
-							useCache = false;
-							break;
-						}
-						if (vai->numVerts > 64) {
-							// exponential backoff up to 16 draws, then every 32
-							vai->drawsUntilNextFullHash = std::min(32, vai->numFrames);
-						} else {
-							// Lower numbers seem much more likely to change.
-							vai->drawsUntilNextFullHash = 0;
-						}
-						// TODO: tweak
-						//if (vai->numFrames > 1000) {
-						//	vai->status = VertexArrayInfo::VAI_RELIABLE;
-						//}
-					} else {
-						vai->drawsUntilNextFullHash--;
-						u32 newMiniHash = ComputeMiniHash();
-						if (newMiniHash != vai->minihash) {
-							MarkUnreliable(vai);
-							break;
-						}
+					CountVertexArrayDraw(vai);
+					if (!CheckVertexArrayHash(vai)) {
+						MarkUnreliable(vai);
+						useCache = false;
+						break;
 					}
 
 					if (vai->vbo == nullptr) {
@@ -436,10 +386,7 @@ void DrawEngineGLES::DoFlush() {
 				// Reliable - we don't even bother hashing anymore. Right now we don't go here until after a very long time.
 			case VertexArrayInfo::VAI_RELIABLE:
 				{
-					vai->numDraws++;
-					if (vai->lastFrame != gpuStats.numFlips) {
-						vai->numFrames++;
-					}
+					CountVertexArrayDraw(vai);
 					gpuStats.numCachedDrawCalls++;
 					gpuStats.numCachedVertsDrawn += vai->numVerts;
 					vertexBuffer = vai->vbo;
@@ -453,10 +400,7 @@ void DrawEngineGLES::DoFlush() {
 
 			case VertexArrayInfo::VAI_UNRELIABLE:
 				{
-					vai->numDraws++;
-					if (vai->lastFrame != gpuStats.numFlips) {
-						vai->numFrames++;
-					}
+					CountVertexArrayDraw(vai);
 					useCache = false;
 					break;
 				}
@@ -484,10 +428,7 @@ void DrawEngineGLES::DoFlush() {
 			}
 
 			if (populateCache || (vai && vai->status == VertexArrayInfo::VAI_NEW)) {
-				vai->numVerts = indexGen.VertexCount();
-				vai->prim = indexGen.Prim();
-				vai->maxIndex = indexGen.MaxIndex();
-				vai->flags = gstate_c.vertexFullAlpha ? VAI_FLAG_VERTEXFULLALPHA : 0;
+				SaveVertexArrayDraw(vai);
 			}
 
 			gpuStats.numUncachedVertsDrawn += indexGen.VertexCount();
@@ -23,6 +23,7 @@
 
 #include "GPU/GPU.h"
 #include "GPU/GPUInterface.h"
+#include "GPU/Debugger/Record.h"
 
 #if PPSSPP_API(ANY_GL)
 #include "GPU/GLES/GPU_GLES.h"
@@ -114,6 +115,7 @@ bool GPU_Init(GraphicsContext *ctx, Draw::DrawContext *draw) {
 void GPU_Shutdown() {
 	// Wait for IsReady, since it might be running on a thread.
 	if (gpu) {
+		gpu->SyncThread();
 		gpu->CancelReady();
 		while (!gpu->IsReady()) {
 			sleep_ms(10);
@@ -122,4 +124,5 @@ void GPU_Shutdown() {
 	delete gpu;
 	gpu = nullptr;
 	gpuDebug = nullptr;
+	GPURecord::Reset();
 }
@@ -73,9 +73,16 @@ struct GPUStatistics {
 		numTexturesDecoded = 0;
 		numFramebufferEvaluations = 0;
 		numReadbacks = 0;
+		numReadbacksMerged = 0;
+		msReadbackStalls = 0;
 		numUploads = 0;
 		numClears = 0;
+		numTextureCacheLookups = 0;
+		numTextureCacheHits = 0;
 		msProcessingDisplayLists = 0;
+		msDecodingVertices = 0;
+		msDecodingTextures = 0;
+		msRasterizing = 0;
 		vertexGPUCycles = 0;
 		otherGPUCycles = 0;
 		memset(gpuCommandsAtCallLevel, 0, sizeof(gpuCommandsAtCallLevel));
@@ -98,9 +105,18 @@ struct GPUStatistics {
 	int numTexturesDecoded;
 	int numFramebufferEvaluations;
 	int numReadbacks;
+	int numReadbacksMerged;
 	int numUploads;
 	int numClears;
+	int numTextureCacheLookups;
+	int numTextureCacheHits;
 	double msProcessingDisplayLists;
+	// Stage timings, only collected with coreCollectDebugStats.
+	double msDecodingVertices;
+	double msDecodingTextures;
+	double msRasterizing;
+	// Always collected, readbacks are slow enough anyway.
+	double msReadbackStalls;
 	int vertexGPUCycles;
 	int otherGPUCycles;
 	int gpuCommandsAtCallLevel[4];
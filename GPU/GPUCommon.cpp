@@ -10,6 +10,7 @@
 #include "Common/Serialize/Serializer.h"
 #include "Common/Serialize/SerializeFuncs.h"
 #include "Common/Serialize/SerializeList.h"
+#include "Common/Thread/ThreadUtil.h"
 #include "Common/TimeUtil.h"
 #include "Core/Reporting.h"
 #include "GPU/GeDisasm.h"
@@ -29,6 +30,7 @@
 #include "Core/HLE/sceGe.h"
 #include "Core/MemMapHelpers.h"
 #include "Core/Util/PPGeDraw.h"
+#include "ext/xxhash.h"
 #include "GPU/Common/DrawEngineCommon.h"
 #include "GPU/Common/FramebufferManagerCommon.h"
 #include "GPU/Common/SplineCommon.h"
@@ -363,6 +365,9 @@ size_t commonCommandTableSize = ARRAY_SIZE(commonCommandTable);
 // TODO: Make class member?
 GPUCommon::CommandInfo GPUCommon::cmdInfo_[256];
 
+// Commands with any of these can't be part of a recorded state run.
+static const uint64_t STATE_RUN_EXCLUDE_FLAGS = FLAG_FLUSHBEFORE | FLAG_EXECUTE | FLAG_EXECUTEONCHANGE | FLAG_READS_PC | FLAG_WRITES_PC;
+
 void GPUCommon::Flush() {
 	drawEngineCommon_->DispatchFlush();
 }
@@ -377,6 +382,7 @@ GPUCommon::GPUCommon(GraphicsContext *gfxCtx, Draw::DrawContext *draw) :
 	// you'd expect due to the int64 field, but the Linux ABI apparently does not require that.
 	static_assert(sizeof(DisplayList) == 456, "Bad DisplayList size");
 
+	stateRuns_.resize(STATE_RUN_SLOTS);
 	Reinitialize();
 	SetupColorConv();
 	gstate.Reset();
@@ -412,13 +418,104 @@ GPUCommon::GPUCommon(GraphicsContext *gfxCtx, Draw::DrawContext *draw) :
 	UpdateVsyncInterval(true);
 
 	PPGeSetDrawContext(draw);
+
+	if (g_Config.bThreadedGE) {
+		geThreadState_ = GEThreadState::READY;
+		geThread_ = new std::thread(&GPUCommon::GEThreadFunc, this);
+	}
 }
 
 GPUCommon::~GPUCommon() {
+	if (geThread_) {
+		std::unique_lock<std::mutex> guard(geLock_);
+		while (geThreadState_ == GEThreadState::QUEUED)
+			geDone_.wait(guard);
+		geThreadState_ = GEThreadState::DISABLED;
+		geWake_.notify_one();
+		guard.unlock();
+
+		geThread_->join();
+		delete geThread_;
+		geThread_ = nullptr;
+	}
+
 	// Probably not necessary.
 	PPGeSetDrawContext(nullptr);
 }
 
+void GPUCommon::GEThreadFunc() {
+	SetCurrentThreadName("GE");
+
+	std::unique_lock<std::mutex> guard(geLock_);
+	while (true) {
+		geWake_.wait(guard, [this] { return geThreadState_ != GEThreadState::READY; });
+		if (geThreadState_ == GEThreadState::DISABLED)
+			break;
+
+		guard.unlock();
+		ProcessDLQueue();
+		guard.lock();
+
+		geThreadState_ = GEThreadState::READY;
+		geDone_.notify_one();
+	}
+}
+
+bool GPUCommon::IsGEThread() const {
+	return geThread_ && std::this_thread::get_id() == geThread_->get_id();
+}
+
+void GPUCommon::SyncThread() {
+	if (!geThread_ || IsGEThread())
+		return;
+
+	{
+		std::unique_lock<std::mutex> guard(geLock_);
+		while (geThreadState_ == GEThreadState::QUEUED)
+			geDone_.wait(guard);
+	}
+
+	// Now that the lists are done, schedule what they raised, in order.
+	for (const DeferredGEEvent &ev : geEvents_) {
+		if (ev.interrupt)
+			__GeTriggerInterrupt(ev.listid, ev.pc, ev.atTicks);
+		else
+			__GeTriggerSync(ev.type, ev.listid, ev.atTicks);
+	}
+	geEvents_.clear();
+}
+
+void GPUCommon::KickDLQueue() {
+	// The ticks must come from the CPU thread, CoreTiming isn't threadsafe.
+	startingTicks = CoreTiming::GetTicks();
+
+	// The debugger and recorder expect to stop the CPU along with the GE, so those stay inline.
+	if (!geThread_ || dumpThisFrame_ || GPUDebug::IsActive() || GPURecord::IsActive()) {
+		ProcessDLQueue();
+		return;
+	}
+
+	geLock_.lock();
+	geThreadState_ = GEThreadState::QUEUED;
+	geWake_.notify_one();
+	geLock_.unlock();
+}
+
+bool GPUCommon::TriggerSync(GPUSyncType type, int listid, u64 atTicks) {
+	if (!IsGEThread())
+		return __GeTriggerSync(type, listid, atTicks);
+	geEvents_.push_back({ false, type, listid, 0, atTicks });
+	return true;
+}
+
+bool GPUCommon::TriggerInterrupt(int listid, u32 pc, u64 atTicks) {
+	if (!IsGEThread())
+		return __GeTriggerInterrupt(listid, pc, atTicks);
+	// __GeTriggerInterrupt() always accepts, so the list can be paused the same way here.
+	geEvents_.push_back({ true, GPU_SYNC_LIST, listid, pc, atTicks });
+	return true;
+}
+
 void GPUCommon::UpdateCmdInfo() {
 	if (g_Config.bSoftwareSkinning) {
 		cmdInfo_[GE_CMD_VERTEXTYPE].flags &= ~FLAG_FLUSHBEFOREONCHANGE;
@@ -435,6 +532,9 @@ void GPUCommon::UpdateCmdInfo() {
 		cmdInfo_[GE_CMD_JUMP].func = &GPUCommon::Execute_Jump;
 		cmdInfo_[GE_CMD_CALL].func = &GPUCommon::Execute_Call;
 	}
+
+	// The recorded runs depend on the flags.
+	ClearStateRuns();
 }
 
 void GPUCommon::BeginHostFrame() {
@@ -450,6 +550,7 @@ void GPUCommon::EndHostFrame() {
 }
 
 void GPUCommon::Reinitialize() {
+	SyncThread();
 	memset(dls, 0, sizeof(dls));
 	for (int i = 0; i < DisplayListMaxCount; ++i) {
 		dls[i].state = PSP_GE_DL_STATE_NONE;
@@ -458,6 +559,7 @@ void GPUCommon::Reinitialize() {
 
 	nextListID = 0;
 	currentList = nullptr;
+	ClearStateRuns();
 	isbreak = false;
 	drawCompleteTicks = 0;
 	busyTicks = 0;
@@ -552,6 +654,7 @@ void GPUCommon::PopDLQueue() {
 }
 
 bool GPUCommon::BusyDrawing() {
+	SyncThread();
 	u32 state = DrawSync(1);
 	if (state == PSP_GE_LIST_DRAWING || state == PSP_GE_LIST_STALLING) {
 		if (currentList && currentList->state != PSP_GE_DL_STATE_PAUSED) {
@@ -570,6 +673,7 @@ void GPUCommon::DumpNextFrame() {
 }
 
 u32 GPUCommon::DrawSync(int mode) {
+	SyncThread();
 	if (mode < 0 || mode > 1)
 		return SCE_KERNEL_ERROR_INVALID_MODE;
 
@@ -618,6 +722,7 @@ void GPUCommon::CheckDrawSync() {
 }
 
 int GPUCommon::ListSync(int listid, int mode) {
+	SyncThread();
 	if (listid < 0 || listid >= DisplayListMaxCount)
 		return SCE_KERNEL_ERROR_INVALID_ID;
 
@@ -662,6 +767,7 @@ int GPUCommon::ListSync(int listid, int mode) {
 }
 
 int GPUCommon::GetStack(int index, u32 stackPtr) {
+	SyncThread();
 	if (!currentList) {
 		// Seems like it doesn't return an error code?
 		return 0;
@@ -687,6 +793,7 @@ int GPUCommon::GetStack(int index, u32 stackPtr) {
 }
 
 u32 GPUCommon::EnqueueList(u32 listpc, u32 stall, int subIntrBase, PSPPointer<PspGeListArgs> args, bool head) {
+	SyncThread();
 	// TODO Check the stack values in missing arg and ajust the stack depth
 
 	// Check alignment
@@ -794,13 +901,14 @@ u32 GPUCommon::EnqueueList(u32 listpc, u32 stall, int subIntrBase, PSPPointer<Ps
 		drawCompleteTicks = (u64)-1;
 
 		// TODO save context when starting the list if param is set
-		ProcessDLQueue();
+		KickDLQueue();
 	}
 
 	return id;
 }
 
 u32 GPUCommon::DequeueList(int listid) {
+	SyncThread();
 	if (listid < 0 || listid >= DisplayListMaxCount || dls[listid].state == PSP_GE_DL_STATE_NONE)
 		return SCE_KERNEL_ERROR_INVALID_ID;
 
@@ -824,6 +932,7 @@ u32 GPUCommon::DequeueList(int listid) {
 }
 
 u32 GPUCommon::UpdateStall(int listid, u32 newstall) {
+	SyncThread();
 	if (listid < 0 || listid >= DisplayListMaxCount || dls[listid].state == PSP_GE_DL_STATE_NONE)
 		return SCE_KERNEL_ERROR_INVALID_ID;
 	auto &dl = dls[listid];
@@ -832,12 +941,13 @@ u32 GPUCommon::UpdateStall(int listid, u32 newstall) {
 
 	dl.stall = newstall & 0x0FFFFFFF;
 	
-	ProcessDLQueue();
+	KickDLQueue();
 
 	return 0;
 }
 
 u32 GPUCommon::Continue() {
+	SyncThread();
 	if (!currentList)
 		return 0;
 
@@ -873,11 +983,12 @@ u32 GPUCommon::Continue() {
 		return -1;
 	}
 
-	ProcessDLQueue();
+	KickDLQueue();
 	return 0;
 }
 
 u32 GPUCommon::Break(int mode) {
+	SyncThread();
 	if (mode < 0 || mode > 1)
 		return SCE_KERNEL_ERROR_INVALID_MODE;
 
@@ -1028,7 +1139,9 @@ bool GPUCommon::InterpretList(DisplayList &list) {
 	if (coreCollectDebugStats) {
 		double total = time_now_d() - start - timeSpentStepping_;
 		_dbg_assert_msg_(total >= 0.0, "Time spent DL processing became negative");
-		hleSetSteppingTime(timeSpentStepping_);
+		// Stepping only happens inline on the CPU thread, see KickDLQueue().
+		if (!IsGEThread())
+			hleSetSteppingTime(timeSpentStepping_);
 		timeSpentStepping_ = 0.0;
 		gpuStats.msProcessingDisplayLists += total;
 	}
@@ -1040,11 +1153,25 @@ void GPUCommon::FastRunLoop(DisplayList &list) {
 	PROFILE_THIS_SCOPE("gpuloop");
 	const CommandInfo *cmdInfo = cmdInfo_;
 	int dc = downcount;
+	bool runStart = true;
 	for (; dc > 0; --dc) {
 		// We know that display list PCs have the upper nibble == 0 - no need to mask the pointer
 		const u32 op = *(const u32_le *)(Memory::base + list.pc);
 		const u32 cmd = op >> 24;
 		const CommandInfo &info = cmdInfo[cmd];
+		const bool plainState = (info.flags & STATE_RUN_EXCLUDE_FLAGS) == 0;
+		if (runStart && plainState && dc >= STATE_RUN_MIN_OPS) {
+			runStart = false;
+			int applied = ApplyStateRun(list.pc, dc);
+			if (applied != 0) {
+				list.pc += applied * 4;
+				// The loop takes off the last one.
+				dc -= applied - 1;
+				continue;
+			}
+		}
+		runStart = !plainState;
+
 		const u32 diff = op ^ gstate.cmdmem[cmd];
 		if (diff == 0) {
 			if (info.flags & FLAG_EXECUTE) {
@@ -1075,6 +1202,147 @@ void GPUCommon::FastRunLoop(DisplayList &list) {
 	downcount = 0;
 }
 
+int GPUCommon::ApplyStateRun(u32 pc, int maxOps) {
+	StateRun &run = stateRuns_[(pc >> 2) & (STATE_RUN_SLOTS - 1)];
+	if (run.pc != pc || run.status == StateRun::EMPTY) {
+		// Lists that only run once aren't worth recording, wait until it comes back.
+		run.pc = pc;
+		run.status = StateRun::SEEN;
+		run.misses = 0;
+		run.numOps = 0;
+		run.lastFrame = gpuStats.numFlips;
+		run.ops.clear();
+		return 0;
+	}
+
+	switch (run.status) {
+	case StateRun::SEEN:
+		return RecordStateRun(run, pc, maxOps);
+
+	case StateRun::CACHED:
+		if (run.numOps > maxOps)
+			return 0;
+		if (XXH3_64bits(Memory::base + pc, run.numOps * sizeof(u32)) != run.hash) {
+			if (++run.misses >= STATE_RUN_MAX_MISSES) {
+				run.status = StateRun::SKIP;
+				run.ops.clear();
+				return 0;
+			}
+			return RecordStateRun(run, pc, maxOps);
+		}
+		run.lastFrame = gpuStats.numFlips;
+		ReplayStateRun(run);
+		return run.numOps;
+
+	default:
+		return 0;
+	}
+}
+
+int GPUCommon::RecordStateRun(StateRun &run, u32 pc, int maxOps) {
+	maxOps = std::min(maxOps, (int)STATE_RUN_MAX_OPS);
+	maxOps = std::min(maxOps, (int)(Memory::ValidSize(pc, maxOps * sizeof(u32)) / sizeof(u32)));
+	const u32_le *src = (const u32_le *)Memory::GetPointerUnchecked(pc);
+
+	int numOps = 0;
+	while (numOps < maxOps && (cmdInfo_[src[numOps] >> 24].flags & STATE_RUN_EXCLUDE_FLAGS) == 0)
+		numOps++;
+
+	// lastFrame stays put, so these get another look once decimated.
+	if (numOps < STATE_RUN_MIN_OPS) {
+		run.status = StateRun::SKIP;
+		run.ops.clear();
+		return 0;
+	}
+
+	// Only the last value of each command matters, since nothing in the run reads them.
+	s16 lastIndex[256];
+	memset(lastIndex, 0xFF, sizeof(lastIndex));
+	for (int i = 0; i < numOps; ++i)
+		lastIndex[src[i] >> 24] = (s16)i;
+
+	run.ops.clear();
+	// Those that flush go first, so a needed flush happens before any other state changes.
+	for (int pass = 0; pass < 2; ++pass) {
+		const bool wantFlush = pass == 0;
+		for (int i = 0; i < numOps; ++i) {
+			const u32 cmd = src[i] >> 24;
+			const bool flushes = (cmdInfo_[cmd].flags & FLAG_FLUSHBEFOREONCHANGE) != 0;
+			if (lastIndex[cmd] == i && flushes == wantFlush)
+				run.ops.push_back(src[i]);
+		}
+	}
+
+	run.status = StateRun::CACHED;
+	run.numOps = numOps;
+	run.hash = XXH3_64bits(src, numOps * sizeof(u32));
+	run.lastFrame = gpuStats.numFlips;
+	stateRunsStart_ = std::min(stateRunsStart_, pc);
+	stateRunsEnd_ = std::max(stateRunsEnd_, pc + numOps * (u32)sizeof(u32));
+
+	ReplayStateRun(run);
+	return numOps;
+}
+
+void GPUCommon::ReplayStateRun(const StateRun &run) {
+	uint64_t dirty = 0;
+	for (u32 op : run.ops) {
+		const u32 cmd = op >> 24;
+		if (op == gstate.cmdmem[cmd])
+			continue;
+
+		const uint64_t flags = cmdInfo_[cmd].flags;
+		if (flags & FLAG_FLUSHBEFOREONCHANGE) {
+			if (drawEngineCommon_->GetNumDrawCalls()) {
+				drawEngineCommon_->DispatchFlush();
+			}
+		}
+		gstate.cmdmem[cmd] = op;
+		dirty |= flags >> 8;
+	}
+	if (dirty)
+		gstate_c.Dirty(dirty);
+}
+
+void GPUCommon::InvalidateStateRuns(u32 addr, int size) {
+	const u32 end = addr + size;
+	if (end <= stateRunsStart_ || addr >= stateRunsEnd_)
+		return;
+
+	for (StateRun &run : stateRuns_) {
+		if (run.status == StateRun::EMPTY)
+			continue;
+		const u32 runEnd = run.pc + std::max(run.numOps, 1) * (u32)sizeof(u32);
+		if (run.pc < end && runEnd > addr)
+			run.status = StateRun::EMPTY;
+	}
+}
+
+void GPUCommon::DecimateStateRuns() {
+	stateRunsStart_ = 0xFFFFFFFF;
+	stateRunsEnd_ = 0;
+	for (StateRun &run : stateRuns_) {
+		if (run.status == StateRun::EMPTY)
+			continue;
+		if (gpuStats.numFlips - run.lastFrame > STATE_RUN_KILL_AGE) {
+			run.status = StateRun::EMPTY;
+			run.ops.clear();
+		} else if (run.status == StateRun::CACHED) {
+			stateRunsStart_ = std::min(stateRunsStart_, run.pc);
+			stateRunsEnd_ = std::max(stateRunsEnd_, run.pc + run.numOps * (u32)sizeof(u32));
+		}
+	}
+}
+
+void GPUCommon::ClearStateRuns() {
+	for (StateRun &run : stateRuns_) {
+		run.status = StateRun::EMPTY;
+		run.ops.clear();
+	}
+	stateRunsStart_ = 0xFFFFFFFF;
+	stateRunsEnd_ = 0;
+}
+
 void GPUCommon::BeginFrame() {
 	immCount_ = 0;
 	if (dumpNextFrame_) {
@@ -1085,6 +1353,11 @@ void GPUCommon::BeginFrame() {
 		dumpThisFrame_ = false;
 	}
 	GPURecord::NotifyFrame();
+
+	if (gpuStats.numFlips - lastStateRunDecimation_ >= STATE_RUN_DECIMATION_INTERVAL) {
+		DecimateStateRuns();
+		lastStateRunDecimation_ = gpuStats.numFlips;
+	}
 }
 
 void GPUCommon::SlowRunLoop(DisplayList &list)
@@ -1190,8 +1463,8 @@ int GPUCommon::GetNextListIndex() {
 	}
 }
 
+// startingTicks must be set first, see KickDLQueue().
 void GPUCommon::ProcessDLQueue() {
-	startingTicks = CoreTiming::GetTicks();
 	cyclesExecuted = 0;
 
 	// Seems to be correct behaviour to process the list anyway?
@@ -1204,6 +1477,7 @@ void GPUCommon::ProcessDLQueue() {
 		DisplayList &l = dls[listIndex];
 		DEBUG_LOG(G3D, "Starting DL execution at %08x - stall = %08x", l.pc, l.stall);
 		if (!InterpretList(l)) {
+			FlushPendingReadbacks();
 			return;
 		} else {
 			// Some other list could've taken the spot while we dilly-dallied around.
@@ -1215,13 +1489,22 @@ void GPUCommon::ProcessDLQueue() {
 	}
 
 	currentList = nullptr;
+	FlushPendingReadbacks();
 
 	drawCompleteTicks = startingTicks + cyclesExecuted;
 	busyTicks = std::max(busyTicks, drawCompleteTicks);
-	__GeTriggerSync(GPU_SYNC_DRAW, 1, drawCompleteTicks);
+	TriggerSync(GPU_SYNC_DRAW, 1, drawCompleteTicks);
 	// Since the event is in CoreTiming, we're in sync.  Just set 0 now.
 }
 
+void GPUCommon::FlushPendingReadbacks() {
+	// The CPU may look at the downloaded memory as soon as we return.
+	// Note that we don't know if it actually will, so this still blocks at the end of every list,
+	// not only when the CPU touches the memory. Merging only helps within a list.
+	if (framebufferManager_)
+		framebufferManager_->FlushPendingReadbacks();
+}
+
 void GPUCommon::PreExecuteOp(u32 op, u32 diff) {
 	// Nothing to do
 }
@@ -1453,7 +1736,7 @@ void GPUCommon::Execute_End(u32 op, u32 diff) {
 			}
 			// TODO: Technically, jump/call/ret should generate an interrupt, but before the pc change maybe?
 			if (currentList->interruptsEnabled && trigger) {
-				if (__GeTriggerInterrupt(currentList->id, currentList->pc, startingTicks + cyclesExecuted)) {
+				if (TriggerInterrupt(currentList->id, currentList->pc, startingTicks + cyclesExecuted)) {
 					currentList->pendingInterrupt = true;
 					UpdateState(GPUSTATE_INTERRUPT);
 				}
@@ -1465,7 +1748,7 @@ void GPUCommon::Execute_End(u32 op, u32 diff) {
 		case PSP_GE_SIGNAL_HANDLER_PAUSE:
 			currentList->state = PSP_GE_DL_STATE_PAUSED;
 			if (currentList->interruptsEnabled) {
-				if (__GeTriggerInterrupt(currentList->id, currentList->pc, startingTicks + cyclesExecuted)) {
+				if (TriggerInterrupt(currentList->id, currentList->pc, startingTicks + cyclesExecuted)) {
 					currentList->pendingInterrupt = true;
 					UpdateState(GPUSTATE_INTERRUPT);
 				}
@@ -1488,13 +1771,13 @@ void GPUCommon::Execute_End(u32 op, u32 diff) {
 				currentList->started = false;
 			}
 
-			if (currentList->interruptsEnabled && __GeTriggerInterrupt(currentList->id, currentList->pc, startingTicks + cyclesExecuted)) {
+			if (currentList->interruptsEnabled && TriggerInterrupt(currentList->id, currentList->pc, startingTicks + cyclesExecuted)) {
 				currentList->pendingInterrupt = true;
 			} else {
 				currentList->state = PSP_GE_DL_STATE_COMPLETED;
 				currentList->waitTicks = startingTicks + cyclesExecuted;
 				busyTicks = std::max(busyTicks, currentList->waitTicks);
-				__GeTriggerSync(GPU_SYNC_LIST, currentList->id, currentList->waitTicks);
+				TriggerSync(GPU_SYNC_LIST, currentList->id, currentList->waitTicks);
 			}
 			break;
 		}
@@ -2425,6 +2708,7 @@ struct DisplayList_v2 {
 };
 
 void GPUCommon::DoState(PointerWrap &p) {
+	SyncThread();
 	auto s = p.Section("GPUCommon", 1, 4);
 	if (!s)
 		return;
@@ -2500,9 +2784,11 @@ void GPUCommon::DoState(PointerWrap &p) {
 }
 
 void GPUCommon::InterruptStart(int listid) {
+	SyncThread();
 	interruptRunning = true;
 }
 void GPUCommon::InterruptEnd(int listid) {
+	SyncThread();
 	interruptRunning = false;
 	isbreak = false;
 
@@ -2526,11 +2812,12 @@ void GPUCommon::InterruptEnd(int listid) {
 		}
 	}
 
-	ProcessDLQueue();
+	KickDLQueue();
 }
 
 // TODO: Maybe cleaner to keep this in GE and trigger the clear directly?
 void GPUCommon::SyncEnd(GPUSyncType waitType, int listid, bool wokeThreads) {
+	SyncThread();
 	if (waitType == GPU_SYNC_DRAW && wokeThreads)
 	{
 		for (int i = 0; i < DisplayListMaxCount; ++i) {
@@ -2738,6 +3025,7 @@ void GPUCommon::DoBlockTransfer(u32 skipDrawReason) {
 }
 
 bool GPUCommon::PerformMemoryCopy(u32 dest, u32 src, int size) {
+	SyncThread();
 	// Track stray copies of a framebuffer in RAM. MotoGP does this.
 	if (framebufferManager_->MayIntersectFramebuffer(src) || framebufferManager_->MayIntersectFramebuffer(dest)) {
 		if (!framebufferManager_->NotifyFramebufferCopy(src, dest, size, false, gstate_c.skipDrawReason)) {
@@ -2761,6 +3049,7 @@ bool GPUCommon::PerformMemoryCopy(u32 dest, u32 src, int size) {
 }
 
 bool GPUCommon::PerformMemorySet(u32 dest, u8 v, int size) {
+	SyncThread();
 	// This may indicate a memset, usually to 0, of a framebuffer.
 	if (framebufferManager_->MayIntersectFramebuffer(dest)) {
 		Memory::Memset(dest, v, size, "GPUMemset");
@@ -2778,6 +3067,7 @@ bool GPUCommon::PerformMemorySet(u32 dest, u8 v, int size) {
 }
 
 bool GPUCommon::PerformMemoryDownload(u32 dest, int size) {
+	SyncThread();
 	// Cheat a bit to force a download of the framebuffer.
 	// VRAM + 0x00400000 is simply a VRAM mirror.
 	if (Memory::IsVRAMAddress(dest)) {
@@ -2787,6 +3077,7 @@ bool GPUCommon::PerformMemoryDownload(u32 dest, int size) {
 }
 
 bool GPUCommon::PerformMemoryUpload(u32 dest, int size) {
+	SyncThread();
 	// Cheat a bit to force an upload of the framebuffer.
 	// VRAM + 0x00400000 is simply a VRAM mirror.
 	if (Memory::IsVRAMAddress(dest)) {
@@ -2797,6 +3088,10 @@ bool GPUCommon::PerformMemoryUpload(u32 dest, int size) {
 }
 
 void GPUCommon::InvalidateCache(u32 addr, int size, GPUInvalidationType type) {
+	SyncThread();
+	// Writebacks (HINT) happen every time a list is built, the hash check covers those.
+	if (size > 0 && type != GPU_INVALIDATE_HINT)
+		InvalidateStateRuns(addr, size);
 	if (size > 0)
 		textureCache_->Invalidate(addr, size, type);
 	else
@@ -2811,6 +3106,7 @@ void GPUCommon::InvalidateCache(u32 addr, int size, GPUInvalidationType type) {
 }
 
 void GPUCommon::NotifyVideoUpload(u32 addr, int size, int width, int format) {
+	SyncThread();
 	if (Memory::IsVRAMAddress(addr)) {
 		framebufferManager_->NotifyVideoUpload(addr, size, width, (GEBufferFormat)format);
 	}
@@ -2819,7 +3115,9 @@ void GPUCommon::NotifyVideoUpload(u32 addr, int size, int width, int format) {
 }
 
 bool GPUCommon::PerformStencilUpload(u32 dest, int size) {
+	SyncThread();
 	if (framebufferManager_->MayIntersectFramebuffer(dest)) {
+		framebufferManager_->FlushPendingReadbacks();
 		framebufferManager_->NotifyStencilUpload(dest, size);
 		return true;
 	}
@@ -2913,7 +3211,7 @@ size_t GPUCommon::FormatGPUStatsCommon(char *buffer, size_t size) {
 		"Vertices: %d cached: %d uncached: %d\n"
 		"FBOs active: %d (evaluations: %d)\n"
 		"Textures: %d, dec: %d, invalidated: %d, hashed: %d kB\n"
-		"Readbacks: %d, uploads: %d\n"
+		"Readbacks: %d (merged: %d, stalled %0.2f ms), uploads: %d\n"
 		"GPU cycles executed: %d (%f per vertex)\n",
 		gpuStats.msProcessingDisplayLists * 1000.0f,
 		gpuStats.numDrawCalls,
@@ -2932,6 +3230,8 @@ size_t GPUCommon::FormatGPUStatsCommon(char *buffer, size_t size) {
 		gpuStats.numTextureInvalidations,
 		gpuStats.numTextureDataBytesHashed / 1024,
 		gpuStats.numReadbacks,
+		gpuStats.numReadbacksMerged,
+		gpuStats.msReadbackStalls * 1000.0f,
 		gpuStats.numUploads,
 		gpuStats.vertexGPUCycles + gpuStats.otherGPUCycles,
 		vertexAverageCycles
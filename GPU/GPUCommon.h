@@ -1,6 +1,12 @@
 #pragma once
 
 #include "ppsspp_config.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
 #include "Common/Common.h"
 #include "Common/MemoryUtil.h"
 #include "GPU/GPUInterface.h"
@@ -84,6 +90,7 @@ class GPUCommon : public GPUInterface, public GPUDebugInterface {
 
 	void BeginHostFrame() override;
 	void EndHostFrame() override;
+	void SyncThread() override;
 
 	void InterruptStart(int listid) override;
 	void InterruptEnd(int listid) override;
@@ -100,6 +107,7 @@ class GPUCommon : public GPUInterface, public GPUDebugInterface {
 
 	bool InterpretList(DisplayList &list) override;
 	void ProcessDLQueue();
+	void FlushPendingReadbacks();
 	u32  UpdateStall(int listid, u32 newstall) override;
 	u32  EnqueueList(u32 listpc, u32 stall, int subIntrBase, PSPPointer<PspGeListArgs> args, bool head) override;
 	u32  DequeueList(int listid) override;
@@ -233,6 +241,7 @@ class GPUCommon : public GPUInterface, public GPUDebugInterface {
 	}
 
 	DisplayList* getList(int listid) override {
+		SyncThread();
 		return &dls[listid];
 	}
 
@@ -288,6 +297,7 @@ class GPUCommon : public GPUInterface, public GPUDebugInterface {
 	void UpdatePC(u32 currentPC, u32 newPC);
 	void UpdateState(GPURunState state);
 	void PopDLQueue();
+	void KickDLQueue();
 	void CheckDrawSync();
 	int  GetNextListIndex();
 	virtual void FastLoadBoneMatrix(u32 target);
@@ -370,6 +380,76 @@ class GPUCommon : public GPUInterface, public GPUDebugInterface {
 	double timeSteppingStarted_;
 	double timeSpentStepping_;
 	int lastVsync_ = -1;
+
+	// Threaded GE.  While lists run on the GE thread, the sync and interrupt events they
+	// raise are held here, and scheduled on the CPU thread in SyncThread().
+	enum class GEThreadState {
+		DISABLED,
+		READY,
+		QUEUED,
+	};
+	struct DeferredGEEvent {
+		bool interrupt;
+		GPUSyncType type;
+		int listid;
+		u32 pc;
+		u64 atTicks;
+	};
+
+	void GEThreadFunc();
+	bool IsGEThread() const;
+	bool TriggerSync(GPUSyncType type, int listid, u64 atTicks);
+	bool TriggerInterrupt(int listid, u32 pc, u64 atTicks);
+
+	std::thread *geThread_ = nullptr;
+	std::mutex geLock_;
+	std::condition_variable geWake_;
+	std::condition_variable geDone_;
+	GEThreadState geThreadState_ = GEThreadState::DISABLED;
+	std::vector<DeferredGEEvent> geEvents_;
+
+	// Runs of plain state commands (nothing executed, no pc changes) are recorded the second
+	// time they're seen at an address.  After that, while the memory hashes the same, the
+	// final value of each command is applied directly instead of dispatching every op.
+	enum {
+		STATE_RUN_SLOTS = 4096,
+		STATE_RUN_MIN_OPS = 8,
+		STATE_RUN_MAX_OPS = 256,
+		STATE_RUN_MAX_MISSES = 4,
+		STATE_RUN_DECIMATION_INTERVAL = 30,
+		STATE_RUN_KILL_AGE = 60,
+	};
+	struct StateRun {
+		enum RunStatus : u8 {
+			EMPTY,
+			SEEN,
+			CACHED,
+			// Changes too often, or too short to bother.
+			SKIP,
+		};
+
+		u32 pc = 0;
+		RunStatus status = EMPTY;
+		u8 misses = 0;
+		int numOps = 0;
+		int lastFrame = 0;
+		u64 hash = 0;
+		// Last value of each command in the run, the ones that flush before change first.
+		std::vector<u32> ops;
+	};
+
+	int ApplyStateRun(u32 pc, int maxOps);
+	int RecordStateRun(StateRun &run, u32 pc, int maxOps);
+	void ReplayStateRun(const StateRun &run);
+	void InvalidateStateRuns(u32 addr, int size);
+	void DecimateStateRuns();
+	void ClearStateRuns();
+
+	std::vector<StateRun> stateRuns_;
+	// Bounds of the recorded runs, to skip most invalidations quickly.
+	u32 stateRunsStart_ = 0xFFFFFFFF;
+	u32 stateRunsEnd_ = 0;
+	int lastStateRunDecimation_ = 0;
 };
 
 struct CommonCommandTableEntry {
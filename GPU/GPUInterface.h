@@ -178,6 +178,8 @@ class GPUInterface {
 	// Frame managment
 	virtual void BeginHostFrame() = 0;
 	virtual void EndHostFrame() = 0;
+	// Waits for display lists running on the GE thread, if any.  Call before touching GE state or memory it writes.
+	virtual void SyncThread() = 0;
 
 	// Draw queue management
 	virtual DisplayList* getList(int listid) = 0;
@@ -0,0 +1,171 @@
+// Copyright (c) 2021- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include <algorithm>
+
+#include "Common/Profiler/Profiler.h"
+#include "Common/Thread/ParallelLoop.h"
+#include "GPU/Software/BinManager.h"
+
+class DrawBinTilesTask : public Task {
+public:
+	DrawBinTilesTask(BinManager *binner, int queueIndex, WaitableCounter *counter)
+		: binner_(binner), queueIndex_(queueIndex), counter_(counter) {}
+
+	void Run() override {
+		binner_->DrawTiles(queueIndex_);
+		counter_->Count();
+	}
+
+private:
+	BinManager *binner_;
+	int queueIndex_;
+	WaitableCounter *counter_;
+};
+
+BinManager::BinManager() {
+	for (BinQueue &queue : queues_) {
+		queue.tris.reserve(MAX_QUEUED_TRIANGLES);
+		queue.nextTile = 0;
+	}
+}
+
+BinManager::~BinManager() {
+	WaitInFlight();
+}
+
+inline int BinManager::ScreenToTile(int v) {
+	return std::max(0, std::min(v >> TILE_SHIFT, TILES_PER_ROW - 1));
+}
+
+void BinManager::AddTriangle(const VertexData &v0, const VertexData &v1, const VertexData &v2) {
+	BinCoords range;
+	if (!Rasterizer::GetTriangleRange(v0, v1, v2, range))
+		return;
+
+	BinQueue *queue = &queues_[cur_];
+	if (queue->tris.size() >= MAX_QUEUED_TRIANGLES) {
+		// Let the workers get started on this batch while we queue up the next one.
+		WaitInFlight();
+		inFlight_ = Kick(cur_, false);
+		cur_ ^= 1;
+		queue = &queues_[cur_];
+	}
+
+	if (queue->tris.empty()) {
+		// Draw state can't change without a drain, so this is valid for the whole queue.
+		// If the other queue is still drawing, reuse its state: compiling now could clear jit code it's running.
+		if (inFlight_)
+			queue->state = queues_[cur_ ^ 1].state;
+		else
+			Rasterizer::ComputeRasterizerState(&queue->state);
+	}
+
+	u16 index = (u16)queue->tris.size();
+	queue->tris.push_back({ v0, v1, v2, range });
+
+	int tx1 = ScreenToTile(range.x1);
+	int ty1 = ScreenToTile(range.y1);
+	int tx2 = ScreenToTile(range.x2);
+	int ty2 = ScreenToTile(range.y2);
+	for (int ty = ty1; ty <= ty2; ++ty) {
+		for (int tx = tx1; tx <= tx2; ++tx) {
+			int tile = ty * TILES_PER_ROW + tx;
+			std::vector<u16> &list = queue->tiles[tile];
+			if (list.empty())
+				queue->touchedTiles.push_back((u16)tile);
+			list.push_back(index);
+		}
+	}
+}
+
+void BinManager::Drain() {
+	WaitInFlight();
+
+	BinQueue &queue = queues_[cur_];
+	if (queue.tris.empty())
+		return;
+
+	PROFILE_THIS_SCOPE("bin_drain");
+	if (queue.tris.size() < MIN_PARALLEL_TRIANGLES || queue.touchedTiles.size() == 1) {
+		DrawTiles(cur_);
+	} else {
+		Kick(cur_, true)->WaitAndRelease();
+	}
+	ClearQueue(queue);
+}
+
+WaitableCounter *BinManager::Kick(int queueIndex, bool helpOut) {
+	BinQueue &queue = queues_[queueIndex];
+	queue.nextTile = 0;
+
+	int numTasks = std::min((int)queue.touchedTiles.size(), g_threadManager.GetNumLooperThreads());
+	if (helpOut)
+		numTasks = std::max(numTasks - 1, 0);
+
+	WaitableCounter *counter = new WaitableCounter(numTasks);
+	for (int i = 0; i < numTasks; ++i) {
+		// Keep each worker on its own thread, so the tile work stays spread out.
+		g_threadManager.EnqueueTaskOnThread(i, new DrawBinTilesTask(this, queueIndex, counter), TaskType::CPU_COMPUTE);
+	}
+
+	if (helpOut)
+		DrawTiles(queueIndex);
+	return counter;
+}
+
+void BinManager::DrawTiles(int queueIndex) {
+	BinQueue &queue = queues_[queueIndex];
+	const int numTiles = (int)queue.touchedTiles.size();
+
+	int i;
+	while ((i = queue.nextTile++) < numTiles) {
+		int tile = queue.touchedTiles[i];
+		int tx = tile % TILES_PER_ROW;
+		int ty = tile / TILES_PER_ROW;
+
+		// Edge tiles also take anything clamped into them.
+		BinCoords clip;
+		clip.x1 = tx == 0 ? -UNBOUNDED : tx << TILE_SHIFT;
+		clip.y1 = ty == 0 ? -UNBOUNDED : ty << TILE_SHIFT;
+		clip.x2 = tx == TILES_PER_ROW - 1 ? UNBOUNDED : ((tx + 1) << TILE_SHIFT) - 1;
+		clip.y2 = ty == TILES_PER_ROW - 1 ? UNBOUNDED : ((ty + 1) << TILE_SHIFT) - 1;
+
+		// Triangles are kept in submission order within each tile, so blending works out.
+		for (u16 index : queue.tiles[tile]) {
+			const BinTriangle &tri = queue.tris[index];
+			Rasterizer::DrawTriangle(tri.v0, tri.v1, tri.v2, tri.range, clip, queue.state);
+		}
+	}
+}
+
+void BinManager::WaitInFlight() {
+	if (!inFlight_)
+		return;
+
+	inFlight_->WaitAndRelease();
+	inFlight_ = nullptr;
+	ClearQueue(queues_[cur_ ^ 1]);
+}
+
+void BinManager::ClearQueue(BinQueue &queue) {
+	for (u16 tile : queue.touchedTiles)
+		queue.tiles[tile].clear();
+	queue.touchedTiles.clear();
+	queue.tris.clear();
+	queue.nextTile = 0;
+}
@@ -0,0 +1,77 @@
+// Copyright (c) 2021- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#pragma once
+
+#include <atomic>
+#include <vector>
+
+#include "GPU/Software/Rasterizer.h"
+
+struct WaitableCounter;
+
+struct BinTriangle {
+	VertexData v0;
+	VertexData v1;
+	VertexData v2;
+	BinCoords range;
+};
+
+// Queues up triangles by screen tile, and rasterizes the tiles in parallel on the thread pool.
+// The rasterizer reads live gstate, so the queue must be drained before any state it uses changes.
+class BinManager {
+public:
+	BinManager();
+	~BinManager();
+
+	void AddTriangle(const VertexData &v0, const VertexData &v1, const VertexData &v2);
+	// Draws everything queued, and waits for it to finish.
+	void Drain();
+
+	// Used by the worker tasks.
+	void DrawTiles(int queueIndex);
+
+private:
+	enum {
+		// Tiles are 64x64 pixels, which is 1024 in screen coordinates.
+		TILE_SHIFT = 10,
+		TILES_PER_ROW = 4096 >> 6,
+		TILE_COUNT = TILES_PER_ROW * TILES_PER_ROW,
+		MAX_QUEUED_TRIANGLES = 1024,
+		// Below this, the thread handoff costs more than it saves.
+		MIN_PARALLEL_TRIANGLES = 8,
+		// Clip bound for the edge tiles, far outside any screen coordinate.
+		UNBOUNDED = 1 << 28,
+	};
+
+	struct BinQueue {
+		std::vector<BinTriangle> tris;
+		std::vector<u16> tiles[TILE_COUNT];
+		std::vector<u16> touchedTiles;
+		Rasterizer::RasterizerState state;
+		std::atomic<int> nextTile;
+	};
+
+	static int ScreenToTile(int v);
+	WaitableCounter *Kick(int queueIndex, bool helpOut);
+	void WaitInFlight();
+	void ClearQueue(BinQueue &queue);
+
+	BinQueue queues_[2];
+	int cur_ = 0;
+	WaitableCounter *inFlight_ = nullptr;
+};
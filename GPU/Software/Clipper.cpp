@@ -19,6 +19,7 @@
 
 #include "GPU/GPUState.h"
 
+#include "GPU/Software/BinManager.h"
 #include "GPU/Software/Clipper.h"
 #include "GPU/Software/Rasterizer.h"
 #include "GPU/Software/RasterizerRectangle.h"
@@ -125,7 +126,7 @@ static void RotateUVThrough(const VertexData &tl, const VertexData &br, VertexDa
 	}
 }
 
-void ProcessTriangleInternal(VertexData &v0, VertexData &v1, VertexData &v2, const VertexData &provoking, bool fromRectangle);
+void ProcessTriangleInternal(VertexData &v0, VertexData &v1, VertexData &v2, const VertexData &provoking, bool fromRectangle, BinManager &binner);
 
 static inline bool CheckOutsideZ(ClipCoords p, int &pos, int &neg) {
 	constexpr float outsideValue = 1.000030517578125f;
@@ -141,7 +142,7 @@ static inline bool CheckOutsideZ(ClipCoords p, int &pos, int &neg) {
 	return false;
 }
 
-void ProcessRect(const VertexData& v0, const VertexData& v1)
+void ProcessRect(const VertexData& v0, const VertexData& v1, BinManager &binner)
 {
 	if (!gstate.isModeThrough()) {
 		// We may discard the entire rect based on depth values.
@@ -190,14 +191,14 @@ void ProcessRect(const VertexData& v0, const VertexData& v1)
 		}
 
 		// Four triangles to do backfaces as well. Two of them will get backface culled.
-		ProcessTriangleInternal(*topleft, *topright, *bottomright, buf[3], true);
-		ProcessTriangleInternal(*bottomright, *topright, *topleft, buf[3], true);
-		ProcessTriangleInternal(*bottomright, *bottomleft, *topleft, buf[3], true);
-		ProcessTriangleInternal(*topleft, *bottomleft, *bottomright, buf[3], true);
+		ProcessTriangleInternal(*topleft, *topright, *bottomright, buf[3], true, binner);
+		ProcessTriangleInternal(*bottomright, *topright, *topleft, buf[3], true, binner);
+		ProcessTriangleInternal(*bottomright, *bottomleft, *topleft, buf[3], true, binner);
+		ProcessTriangleInternal(*topleft, *bottomleft, *bottomright, buf[3], true, binner);
 	} else {
 		// through mode handling
 
-		if (Rasterizer::RectangleFastPath(v0, v1)) {
+		if (Rasterizer::RectangleFastPath(v0, v1, binner)) {
 			return;
 		}
 
@@ -239,25 +240,30 @@ void ProcessRect(const VertexData& v0, const VertexData& v1)
 		RotateUVThrough(v0, v1, *topright, *bottomleft);
 
 		if (gstate.isModeClear()) {
+			// Clears aren't binned, so draw anything queued first.
+			binner.Drain();
 			Rasterizer::ClearRectangle(v0, v1);
 		} else {
 			// Four triangles to do backfaces as well. Two of them will get backface culled.
-			Rasterizer::DrawTriangle(*topleft, *topright, *bottomright);
-			Rasterizer::DrawTriangle(*bottomright, *topright, *topleft);
-			Rasterizer::DrawTriangle(*bottomright, *bottomleft, *topleft);
-			Rasterizer::DrawTriangle(*topleft, *bottomleft, *bottomright);
+			binner.AddTriangle(*topleft, *topright, *bottomright);
+			binner.AddTriangle(*bottomright, *topright, *topleft);
+			binner.AddTriangle(*bottomright, *bottomleft, *topleft);
+			binner.AddTriangle(*topleft, *bottomleft, *bottomright);
 		}
 	}
 }
 
-void ProcessPoint(VertexData& v0)
+void ProcessPoint(VertexData& v0, BinManager &binner)
 {
 	// Points need no clipping. Will be bounds checked in the rasterizer (which seems backwards?)
+	binner.Drain();
 	Rasterizer::DrawPoint(v0);
 }
 
-void ProcessLine(VertexData& v0, VertexData& v1)
+void ProcessLine(VertexData& v0, VertexData& v1, BinManager &binner)
 {
+	// Lines aren't binned, so draw anything queued first.
+	binner.Drain();
 	if (gstate.isModeThrough()) {
 		// Actually, should clip this one too so we don't need to do bounds checks in the rasterizer.
 		Rasterizer::DrawLine(v0, v1);
@@ -290,16 +296,16 @@ void ProcessLine(VertexData& v0, VertexData& v1)
 	Rasterizer::DrawLine(data[0], data[1]);
 }
 
-void ProcessTriangleInternal(VertexData &v0, VertexData &v1, VertexData &v2, const VertexData &provoking, bool fromRectangle) {
+void ProcessTriangleInternal(VertexData &v0, VertexData &v1, VertexData &v2, const VertexData &provoking, bool fromRectangle, BinManager &binner) {
 	if (gstate.isModeThrough()) {
 		// In case of cull reordering, make sure the right color is on the final vertex.
 		if (gstate.getShadeMode() == GE_SHADE_FLAT) {
 			VertexData corrected2 = v2;
 			corrected2.color0 = provoking.color0;
 			corrected2.color1 = provoking.color1;
-			Rasterizer::DrawTriangle(v0, v1, corrected2);
+			binner.AddTriangle(v0, v1, corrected2);
 		} else {
-			Rasterizer::DrawTriangle(v0, v1, v2);
+			binner.AddTriangle(v0, v1, v2);
 		}
 		return;
 	}
@@ -383,13 +389,13 @@ void ProcessTriangleInternal(VertexData &v0, VertexData &v1, VertexData &v2, con
 				data[2].color1 = provoking.color1;
 			}
 
-			Rasterizer::DrawTriangle(data[0], data[1], data[2]);
+			binner.AddTriangle(data[0], data[1], data[2]);
 		}
 	}
 }
 
-void ProcessTriangle(VertexData &v0, VertexData &v1, VertexData &v2, const VertexData &provoking) {
-	ProcessTriangleInternal(v0, v1, v2, provoking, false);
+void ProcessTriangle(VertexData &v0, VertexData &v1, VertexData &v2, const VertexData &provoking, BinManager &binner) {
+	ProcessTriangleInternal(v0, v1, v2, provoking, false, binner);
 }
 
 } // namespace
@@ -0,0 +1,180 @@
+// Copyright (c) 2021- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include "ppsspp_config.h"
+#include <algorithm>
+#include <mutex>
+#include "Common/StringUtils.h"
+#include "GPU/GPUState.h"
+#include "GPU/Software/DrawPixel.h"
+#include "GPU/Software/Rasterizer.h"
+
+namespace Rasterizer {
+
+static std::mutex jitCacheLock;
+static PixelJitCache *jitCache = nullptr;
+
+void Init() {
+	jitCache = new PixelJitCache();
+}
+
+void Shutdown() {
+	delete jitCache;
+	jitCache = nullptr;
+}
+
+bool DescribeCodePtr(const u8 *ptr, std::string &name) {
+	if (!jitCache->IsInSpace(ptr)) {
+		return false;
+	}
+
+	name = jitCache->DescribeCodePtr(ptr);
+	return true;
+}
+
+static void DrawSinglePixelFallback(int x, int y, int z, int fog, const Vec4<int> &color_in) {
+	DrawSinglePixelNonClear(DrawingCoords(x, y, 0), (u16)z, (u8)fog, color_in);
+}
+
+SingleFunc GetSingleFunc() {
+	PixelFuncID id;
+	jitCache->ComputePixelFuncID(&id);
+	SingleFunc jitted = jitCache->GetSingle(id);
+	if (jitted) {
+		return jitted;
+	}
+
+	return &DrawSinglePixelFallback;
+}
+
+PixelJitCache::PixelJitCache() {
+	// 256k should be plenty, there are only so many states in a frame.
+	AllocCodeSpace(1024 * 64 * 4);
+
+	// Add some random code to "help" MSVC's buggy disassembler :(
+#if defined(_WIN32) && (PPSSPP_ARCH(X86) || PPSSPP_ARCH(AMD64)) && !PPSSPP_PLATFORM(UWP)
+	using namespace Gen;
+	for (int i = 0; i < 100; i++) {
+		MOV(32, R(EAX), R(EBX));
+		RET();
+	}
+#elif PPSSPP_ARCH(ARM)
+	BKPT(0);
+	BKPT(0);
+#endif
+}
+
+void PixelJitCache::Clear() {
+	ClearCodeSpace(0);
+	cache_.clear();
+	addresses_.clear();
+}
+
+void PixelJitCache::ComputePixelFuncID(PixelFuncID *id_out) {
+	PixelFuncID id;
+
+	id.applyDepthRange = !gstate.isModeThrough();
+	id.alphaTestFunc = gstate.isAlphaTestEnabled() ? gstate.getAlphaTestFunction() : GE_COMP_ALWAYS;
+	id.colorTest = gstate.isColorTestEnabled();
+	id.applyFog = gstate.isFogEnabled() && !gstate.isModeThrough();
+	id.depthTestFunc = gstate.isDepthTestEnabled() ? gstate.getDepthTestFunction() : GE_COMP_ALWAYS;
+	id.depthWrite = gstate.isDepthTestEnabled() && gstate.isDepthWriteEnabled();
+	id.stencilTest = gstate.isStencilTestEnabled();
+	id.fbFormat = gstate.FrameBufFormat();
+	id.dithering = gstate.isDitherEnabled();
+	id.applyLogicOp = gstate.isLogicOpEnabled();
+	id.applyColorWriteMask = gstate.getColorMask() != 0;
+
+	id.alphaBlend = gstate.isAlphaBlendEnabled();
+	if (id.alphaBlend) {
+		id.alphaBlendEq = gstate.getBlendEq();
+		// Anything past the last real factor behaves like FIX.
+		id.alphaBlendSrc = std::min((int)gstate.getBlendFuncA(), (int)GE_SRCBLEND_FIXA);
+		id.alphaBlendDst = std::min((int)gstate.getBlendFuncB(), (int)GE_DSTBLEND_FIXB);
+	}
+
+	*id_out = id;
+}
+
+std::string PixelJitCache::DescribePixelFuncID(const PixelFuncID &id) {
+	static const char *const comparisonNames[] = { "NEVER", "ALWAYS", "EQ", "NE", "LT", "LE", "GT", "GE" };
+	static const char *const formatNames[] = { "565", "5551", "4444", "8888" };
+	static const char *const blendEqNames[] = { "ADD", "SUB", "RSUB", "MIN", "MAX", "ABSDIFF", "EQ6", "EQ7" };
+
+	std::string name = formatNames[id.fbFormat];
+	if (id.applyDepthRange)
+		name += ":DEPTHRANGE";
+	if (id.alphaTestFunc != GE_COMP_ALWAYS)
+		name += StringFromFormat(":AT%s", comparisonNames[id.alphaTestFunc]);
+	if (id.colorTest)
+		name += ":CT";
+	if (id.applyFog)
+		name += ":FOG";
+	if (id.depthTestFunc != GE_COMP_ALWAYS)
+		name += StringFromFormat(":ZT%s", comparisonNames[id.depthTestFunc]);
+	if (id.depthWrite)
+		name += ":ZWRITE";
+	if (id.stencilTest)
+		name += ":STENCIL";
+	if (id.alphaBlend)
+		name += StringFromFormat(":BLEND%s_%d_%d", blendEqNames[id.alphaBlendEq], id.alphaBlendSrc, id.alphaBlendDst);
+	if (id.dithering)
+		name += ":DITHER";
+	if (id.applyLogicOp)
+		name += ":LOGIC";
+	if (id.applyColorWriteMask)
+		name += ":MSK";
+	return name;
+}
+
+std::string PixelJitCache::DescribeCodePtr(const u8 *ptr) {
+	ptrdiff_t dist = 0x7FFFFFFF;
+	PixelFuncID found{};
+	for (const auto &it : addresses_) {
+		ptrdiff_t it_dist = ptr - it.second;
+		if (it_dist >= 0 && it_dist < dist) {
+			found = it.first;
+			dist = it_dist;
+		}
+	}
+
+	return DescribePixelFuncID(found);
+}
+
+SingleFunc PixelJitCache::GetSingle(const PixelFuncID &id) {
+	std::lock_guard<std::mutex> guard(jitCacheLock);
+
+	auto it = cache_.find(id);
+	if (it != cache_.end()) {
+		return it->second;
+	}
+
+	if (GetSpaceLeft() < 16384) {
+		Clear();
+	}
+
+#if PPSSPP_ARCH(AMD64) && !PPSSPP_PLATFORM(UWP)
+	addresses_[id] = GetCodePointer();
+	SingleFunc func = CompileSingle(id);
+	cache_[id] = func;
+	return func;
+#else
+	return nullptr;
+#endif
+}
+
+};
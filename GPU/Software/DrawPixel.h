@@ -0,0 +1,151 @@
+// Copyright (c) 2021- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#pragma once
+
+#include "ppsspp_config.h"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+#if PPSSPP_ARCH(ARM)
+#include "Common/ArmEmitter.h"
+#elif PPSSPP_ARCH(ARM64)
+#include "Common/Arm64Emitter.h"
+#elif PPSSPP_ARCH(X86) || PPSSPP_ARCH(AMD64)
+#include "Common/x64Emitter.h"
+#elif PPSSPP_ARCH(MIPS)
+#include "Common/MipsEmitter.h"
+#else
+#include "Common/FakeEmitter.h"
+#endif
+#include "GPU/Math3D.h"
+#include "GPU/ge_constants.h"
+
+// Everything about the render state that changes the shape of the per-pixel code.
+// Values like refs, masks and fixed colors are read from gstate when drawing.
+struct PixelFuncID {
+	PixelFuncID() : fullKey(0) {
+	}
+
+	union {
+		u32 fullKey;
+		struct {
+			// Depth range test, skipped in through mode.
+			uint32_t applyDepthRange : 1;
+			// GEComparison, ALWAYS when disabled.
+			uint32_t alphaTestFunc : 3;
+			uint32_t colorTest : 1;
+			uint32_t applyFog : 1;
+			// GEComparison, ALWAYS when disabled.
+			uint32_t depthTestFunc : 3;
+			uint32_t depthWrite : 1;
+			uint32_t stencilTest : 1;
+			// GEBufferFormat.
+			uint32_t fbFormat : 2;
+			uint32_t dithering : 1;
+			uint32_t applyLogicOp : 1;
+			uint32_t applyColorWriteMask : 1;
+			uint32_t alphaBlend : 1;
+			// GEBlendMode.
+			uint32_t alphaBlendEq : 3;
+			// GEBlendSrcFactor / GEBlendDstFactor, with all FIX variants as 10.
+			uint32_t alphaBlendSrc : 4;
+			uint32_t alphaBlendDst : 4;
+			uint32_t : 4;
+		};
+	};
+
+	bool operator == (const PixelFuncID &other) const {
+		return fullKey == other.fullKey;
+	}
+};
+
+namespace std {
+
+template <>
+struct hash<PixelFuncID> {
+	std::size_t operator()(const PixelFuncID &k) const {
+		return hash<u32>()(k.fullKey);
+	}
+};
+
+};
+
+namespace Rasterizer {
+
+// Draws a single non-clear mode pixel, applying all tests and writing color and depth.
+typedef void (*SingleFunc)(int x, int y, int z, int fog, const Math3D::Vec4<int> &color_in);
+SingleFunc GetSingleFunc();
+
+void Init();
+void Shutdown();
+
+bool DescribeCodePtr(const u8 *ptr, std::string &name);
+
+#if PPSSPP_ARCH(ARM)
+class PixelJitCache : public ArmGen::ARMXCodeBlock {
+#elif PPSSPP_ARCH(ARM64)
+class PixelJitCache : public Arm64Gen::ARM64CodeBlock {
+#elif PPSSPP_ARCH(X86) || PPSSPP_ARCH(AMD64)
+class PixelJitCache : public Gen::XCodeBlock {
+#elif PPSSPP_ARCH(MIPS)
+class PixelJitCache : public MIPSGen::MIPSCodeBlock {
+#else
+class PixelJitCache : public FakeGen::FakeXCodeBlock {
+#endif
+public:
+	PixelJitCache();
+
+	void ComputePixelFuncID(PixelFuncID *id_out);
+
+	// Returns a pointer to the code to run, or nullptr if this state isn't supported.
+	SingleFunc GetSingle(const PixelFuncID &id);
+	void Clear();
+
+	std::string DescribeCodePtr(const u8 *ptr);
+	std::string DescribePixelFuncID(const PixelFuncID &id);
+
+private:
+	SingleFunc CompileSingle(const PixelFuncID &id);
+
+#if PPSSPP_ARCH(X86) || PPSSPP_ARCH(AMD64)
+	Gen::OpArg ConstArg(const void *ptr, Gen::X64Reg tempReg);
+	bool Jit_DepthRange(const PixelFuncID &id);
+	bool Jit_AlphaTest(const PixelFuncID &id);
+	bool Jit_ApplyFog(const PixelFuncID &id);
+	bool Jit_DepthTest(const PixelFuncID &id);
+	bool Jit_ComputeColorAddress(const PixelFuncID &id);
+	bool Jit_ComputeDither(const PixelFuncID &id);
+	bool Jit_ReadColor(const PixelFuncID &id);
+	bool Jit_AlphaBlend(const PixelFuncID &id);
+	bool Jit_BlendFactor(Gen::X64Reg dest, int factor, Gen::X64Reg otherColor, const u32 *fixColor);
+	bool Jit_ApplyDither(const PixelFuncID &id);
+	bool Jit_WriteColor(const PixelFuncID &id);
+	bool Jit_CompareOrDiscard(GEComparison func, Gen::X64Reg lhs, Gen::X64Reg rhs);
+
+	// Whether the new color is still packed as 8-bit RGBA, rather than 32-bit lanes.
+	bool colorIsPacked_ = true;
+
+	std::vector<Gen::FixupBranch> discards_;
+#endif
+
+	std::unordered_map<PixelFuncID, SingleFunc> cache_;
+	std::unordered_map<PixelFuncID, const u8 *> addresses_;
+};
+
+};
@@ -0,0 +1,593 @@
+// Copyright (c) 2021- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include "ppsspp_config.h"
+#if PPSSPP_ARCH(X86) || PPSSPP_ARCH(AMD64)
+
+#include <emmintrin.h>
+#include "Common/x64Emitter.h"
+#include "Common/CPUDetect.h"
+#include "GPU/GPUState.h"
+#include "GPU/Software/DrawPixel.h"
+#include "GPU/Software/SoftGpu.h"
+#include "GPU/ge_constants.h"
+
+using namespace Gen;
+
+namespace Rasterizer {
+
+#ifdef _WIN32
+static const X64Reg argXReg = RCX;
+static const X64Reg argYReg = RDX;
+static const X64Reg argZReg = R8;
+static const X64Reg argFogReg = R9;
+// The color pointer is on the stack.
+#else
+static const X64Reg argXReg = RDI;
+static const X64Reg argYReg = RSI;
+static const X64Reg argZReg = RDX;
+static const X64Reg argFogReg = RCX;
+static const X64Reg argColorPtrReg = R8;
+#endif
+
+static const X64Reg tempReg1 = RAX;
+static const X64Reg tempReg2 = R10;
+static const X64Reg tempReg3 = R11;
+
+// Once the address is known, these stay put until the color is written.
+static const X64Reg colorPtrReg = tempReg2;
+static const X64Reg oldColorReg = tempReg3;
+// X and Y are no longer needed by the time the dither value is ready.
+static const X64Reg ditherReg = argYReg;
+
+// Starts out as the clamped color, packed to 8-bit RGBA in the low lane.
+static const X64Reg argColorReg = XMM0;
+static const X64Reg fpScratchReg1 = XMM1;
+static const X64Reg fpScratchReg2 = XMM2;
+static const X64Reg fpScratchReg3 = XMM3;
+static const X64Reg fpScratchReg4 = XMM4;
+static const X64Reg fpScratchReg5 = XMM5;
+
+alignas(16) static const u16 by255i[8] = { 0x8081, 0x8081, 0x8081, 0x8081, 0x8081, 0x8081, 0x8081, 0x8081, };
+alignas(16) static const float by255f[4] = { 1.0f / 255.0f, 1.0f / 255.0f, 1.0f / 255.0f, 1.0f / 255.0f, };
+alignas(16) static const u32 all255[4] = { 255, 255, 255, 255, };
+alignas(16) static const u32 color4444mask[4] = { 0xf00ff00f, 0xf00ff00f, 0xf00ff00f, 0xf00ff00f, };
+
+// Shift and mask pairs that match RGBA8888ToRGB565() and friends.
+struct ColorPiece {
+	u8 shift;
+	u32 mask;
+};
+static const ColorPiece pieces565[] = { { 3, 0x001F }, { 5, 0x07E0 }, { 8, 0xF800 } };
+static const ColorPiece pieces5551[] = { { 3, 0x001F }, { 6, 0x03E0 }, { 9, 0x7C00 }, { 16, 0x8000 } };
+static const ColorPiece pieces4444[] = { { 4, 0x000F }, { 8, 0x00F0 }, { 12, 0x0F00 }, { 16, 0xF000 } };
+
+SingleFunc PixelJitCache::CompileSingle(const PixelFuncID &id) {
+	// These are rare enough to leave to the C++ path.
+	if (id.colorTest || id.stencilTest || id.applyLogicOp)
+		return nullptr;
+	if (id.alphaBlend && id.alphaBlendEq > GE_BLENDMODE_ABSDIFF)
+		return nullptr;
+
+	BeginWrite();
+	const u8 *start = AlignCode16();
+	discards_.clear();
+	colorIsPacked_ = true;
+
+#ifdef _WIN32
+	// 32 bytes of shadow space and the return address come first.
+	MOV(PTRBITS, R(tempReg1), MDisp(RSP, 40));
+	MOVDQA(argColorReg, MatR(tempReg1));
+#else
+	MOVDQA(argColorReg, MatR(argColorPtrReg));
+#endif
+	// This clamps to 0-255, just like Clamp() in the C++ path.
+	PACKSSDW(argColorReg, R(argColorReg));
+	PACKUSWB(argColorReg, R(argColorReg));
+
+	bool success = true;
+	success = success && Jit_DepthRange(id);
+	success = success && Jit_AlphaTest(id);
+	success = success && Jit_ApplyFog(id);
+	success = success && Jit_DepthTest(id);
+	success = success && Jit_ComputeColorAddress(id);
+	success = success && Jit_ComputeDither(id);
+	success = success && Jit_ReadColor(id);
+	success = success && Jit_AlphaBlend(id);
+	success = success && Jit_ApplyDither(id);
+	success = success && Jit_WriteColor(id);
+
+	for (FixupBranch &fixup : discards_)
+		SetJumpTarget(fixup);
+	discards_.clear();
+
+	if (!success) {
+		EndWrite();
+		ResetCodePtr(GetOffset(start));
+		return nullptr;
+	}
+
+	RET();
+
+	EndWrite();
+	return (SingleFunc)start;
+}
+
+OpArg PixelJitCache::ConstArg(const void *ptr, X64Reg tempReg) {
+	if (RipAccessible(ptr))
+		return M(ptr);
+	MOV(PTRBITS, R(tempReg), ImmPtr(ptr));
+	return MatR(tempReg);
+}
+
+bool PixelJitCache::Jit_CompareOrDiscard(GEComparison func, X64Reg lhs, X64Reg rhs) {
+	// Jump out when the test fails, so the condition is inverted.
+	CCFlags cc;
+	switch (func) {
+	case GE_COMP_NEVER:
+		discards_.push_back(J(true));
+		return true;
+	case GE_COMP_ALWAYS:
+		return true;
+	case GE_COMP_EQUAL: cc = CC_NE; break;
+	case GE_COMP_NOTEQUAL: cc = CC_E; break;
+	case GE_COMP_LESS: cc = CC_AE; break;
+	case GE_COMP_LEQUAL: cc = CC_A; break;
+	case GE_COMP_GREATER: cc = CC_BE; break;
+	case GE_COMP_GEQUAL: cc = CC_B; break;
+	default:
+		return false;
+	}
+
+	CMP(32, R(lhs), R(rhs));
+	discards_.push_back(J_CC(cc, true));
+	return true;
+}
+
+bool PixelJitCache::Jit_DepthRange(const PixelFuncID &id) {
+	if (!id.applyDepthRange)
+		return true;
+
+	MOVZX(32, 16, tempReg1, ConstArg(&gstate.minz, tempReg1));
+	CMP(32, R(argZReg), R(tempReg1));
+	discards_.push_back(J_CC(CC_B, true));
+
+	MOVZX(32, 16, tempReg1, ConstArg(&gstate.maxz, tempReg1));
+	CMP(32, R(argZReg), R(tempReg1));
+	discards_.push_back(J_CC(CC_A, true));
+	return true;
+}
+
+bool PixelJitCache::Jit_AlphaTest(const PixelFuncID &id) {
+	GEComparison func = (GEComparison)id.alphaTestFunc;
+	if (func == GE_COMP_ALWAYS || func == GE_COMP_NEVER)
+		return Jit_CompareOrDiscard(func, tempReg1, tempReg1);
+
+	// The ref is in byte 1 of alphatest, and the mask in byte 2.
+	const u8 *alphatest = (const u8 *)&gstate.alphatest;
+	MOVD_xmm(R(tempReg1), argColorReg);
+	SHR(32, R(tempReg1), Imm8(24));
+	AND(8, R(tempReg1), ConstArg(alphatest + 2, tempReg3));
+	MOVZX(32, 8, tempReg2, ConstArg(alphatest + 1, tempReg2));
+	AND(8, R(tempReg2), ConstArg(alphatest + 2, tempReg3));
+
+	return Jit_CompareOrDiscard(func, tempReg1, tempReg2);
+}
+
+bool PixelJitCache::Jit_ApplyFog(const PixelFuncID &id) {
+	if (!id.applyFog)
+		return true;
+
+	// Widen to 16-bit, which is plenty for color * fog.
+	PXOR(fpScratchReg1, R(fpScratchReg1));
+	MOVDQA(fpScratchReg2, R(argColorReg));
+	PUNPCKLBW(fpScratchReg2, R(fpScratchReg1));
+	MOVD_xmm(fpScratchReg3, ConstArg(&gstate.fogcolor, tempReg1));
+	PUNPCKLBW(fpScratchReg3, R(fpScratchReg1));
+
+	MOVD_xmm(fpScratchReg4, R(argFogReg));
+	PSHUFLW(fpScratchReg4, R(fpScratchReg4), _MM_SHUFFLE(0, 0, 0, 0));
+	MOV(32, R(tempReg1), Imm32(255));
+	SUB(32, R(tempReg1), R(argFogReg));
+	MOVD_xmm(fpScratchReg5, R(tempReg1));
+	PSHUFLW(fpScratchReg5, R(fpScratchReg5), _MM_SHUFFLE(0, 0, 0, 0));
+
+	// (color * fog + fogColor * (255 - fog)) / 255, which can't exceed 65025.
+	PMULLW(fpScratchReg2, R(fpScratchReg4));
+	PMULLW(fpScratchReg3, R(fpScratchReg5));
+	PADDW(fpScratchReg2, R(fpScratchReg3));
+	// For 16-bit x, x / 255 == (x * 0x8081) >> 23, so this matches the integer divide exactly.
+	PMULHUW(fpScratchReg2, ConstArg(by255i, tempReg1));
+	PSRLW(fpScratchReg2, 7);
+	PACKUSWB(fpScratchReg2, R(fpScratchReg2));
+
+	// Fog doesn't touch alpha.
+	MOVD_xmm(R(tempReg1), fpScratchReg2);
+	AND(32, R(tempReg1), Imm32(0x00FFFFFF));
+	MOVD_xmm(R(tempReg2), argColorReg);
+	AND(32, R(tempReg2), Imm32(0xFF000000));
+	OR(32, R(tempReg1), R(tempReg2));
+	MOVD_xmm(argColorReg, R(tempReg1));
+	return true;
+}
+
+bool PixelJitCache::Jit_DepthTest(const PixelFuncID &id) {
+	GEComparison func = (GEComparison)id.depthTestFunc;
+	if (func == GE_COMP_NEVER)
+		return Jit_CompareOrDiscard(func, argZReg, argZReg);
+	if (func == GE_COMP_ALWAYS && !id.depthWrite)
+		return true;
+
+	// Offset = x + y * stride, which may be negative in theory.
+	MOV(32, R(tempReg1), ConstArg(&gstate.zbwidth, tempReg1));
+	AND(32, R(tempReg1), Imm32(0x7FC));
+	IMUL(32, tempReg1, R(argYReg));
+	ADD(32, R(tempReg1), R(argXReg));
+	MOVSX(64, 32, tempReg1, R(tempReg1));
+
+	MOV(PTRBITS, R(tempReg2), ImmPtr(&depthbuf.data));
+	MOV(PTRBITS, R(tempReg2), MatR(tempReg2));
+	LEA(PTRBITS, tempReg2, MComplex(tempReg2, tempReg1, SCALE_2, 0));
+
+	if (func != GE_COMP_ALWAYS) {
+		MOVZX(32, 16, tempReg1, MatR(tempReg2));
+		if (!Jit_CompareOrDiscard(func, argZReg, tempReg1))
+			return false;
+	}
+
+	if (id.depthWrite)
+		MOV(16, MatR(tempReg2), R(argZReg));
+	return true;
+}
+
+bool PixelJitCache::Jit_ComputeColorAddress(const PixelFuncID &id) {
+	MOV(32, R(tempReg1), ConstArg(&gstate.fbwidth, tempReg1));
+	AND(32, R(tempReg1), Imm32(0x7FC));
+	IMUL(32, tempReg1, R(argYReg));
+	ADD(32, R(tempReg1), R(argXReg));
+	MOVSX(64, 32, tempReg1, R(tempReg1));
+
+	MOV(PTRBITS, R(colorPtrReg), ImmPtr(&fb.data));
+	MOV(PTRBITS, R(colorPtrReg), MatR(colorPtrReg));
+	LEA(PTRBITS, colorPtrReg, MComplex(colorPtrReg, tempReg1, id.fbFormat == GE_FORMAT_8888 ? SCALE_4 : SCALE_2, 0));
+	return true;
+}
+
+bool PixelJitCache::Jit_ComputeDither(const PixelFuncID &id) {
+	if (!id.dithering)
+		return true;
+
+	// Shift amount is (x & 3) * 4, which has to be in CL.  Both X and fog are done with now.
+	if (argXReg != RCX)
+		MOV(32, R(RCX), R(argXReg));
+	AND(32, R(RCX), Imm8(3));
+	SHL(32, R(RCX), Imm8(2));
+
+	AND(32, R(argYReg), Imm8(3));
+	MOV(PTRBITS, R(tempReg1), ImmPtr(&gstate.dithmtx[0]));
+	MOV(32, R(tempReg1), MComplex(tempReg1, argYReg, SCALE_4, 0));
+	SHR(32, R(tempReg1), R(RCX));
+
+	// Now sign extend the low 4 bits, so 8-F are negative.
+	SHL(32, R(tempReg1), Imm8(28));
+	SAR(32, R(tempReg1), Imm8(28));
+	MOV(32, R(ditherReg), R(tempReg1));
+	return true;
+}
+
+bool PixelJitCache::Jit_ReadColor(const PixelFuncID &id) {
+	// 565 has no stencil to keep, so we may be able to skip the read.
+	if (id.fbFormat == GE_FORMAT_565 && !id.alphaBlend && !id.applyColorWriteMask)
+		return true;
+
+	switch ((GEBufferFormat)id.fbFormat) {
+	case GE_FORMAT_8888:
+		MOV(32, R(oldColorReg), MatR(colorPtrReg));
+		return true;
+
+	case GE_FORMAT_565:
+		// This matches RGB565ToRGBA8888(), R and B first.
+		MOVZX(32, 16, oldColorReg, MatR(colorPtrReg));
+		MOV(32, R(RCX), R(oldColorReg));
+		AND(32, R(RCX), Imm32(0x0000001F));
+		MOV(32, R(tempReg1), R(oldColorReg));
+		AND(32, R(tempReg1), Imm32(0x0000F800));
+		SHL(32, R(tempReg1), Imm8(5));
+		OR(32, R(RCX), R(tempReg1));
+
+		// Expand 5 -> 8.  At this point we have 00BB00RR.
+		MOV(32, R(tempReg1), R(RCX));
+		SHL(32, R(RCX), Imm8(3));
+		SHR(32, R(tempReg1), Imm8(2));
+		OR(32, R(RCX), R(tempReg1));
+		AND(32, R(RCX), Imm32(0x00FF00FF));
+		OR(32, R(RCX), Imm32(0xFF000000));
+
+		// Now G, aligned and then expanded from 6 bits.
+		SHL(32, R(oldColorReg), Imm8(3 + 2));
+		AND(32, R(oldColorReg), Imm32(0x0000FC00));
+		MOV(32, R(tempReg1), R(oldColorReg));
+		SHR(32, R(tempReg1), Imm8(2 + 4));
+		OR(32, R(oldColorReg), R(tempReg1));
+		AND(32, R(oldColorReg), Imm32(0x0000FF00));
+		OR(32, R(oldColorReg), R(RCX));
+		return true;
+
+	case GE_FORMAT_5551:
+		MOVZX(32, 16, oldColorReg, MatR(colorPtrReg));
+		MOV(32, R(RCX), R(oldColorReg));
+		MOV(32, R(tempReg1), R(oldColorReg));
+		AND(32, R(RCX), Imm32(0x0000001F));
+		AND(32, R(tempReg1), Imm32(0x000003E0));
+		SHL(32, R(tempReg1), Imm8(3));
+		OR(32, R(RCX), R(tempReg1));
+
+		MOV(32, R(tempReg1), R(oldColorReg));
+		AND(32, R(tempReg1), Imm32(0x00007C00));
+		SHL(32, R(tempReg1), Imm8(6));
+		OR(32, R(RCX), R(tempReg1));
+
+		// Expand 5 -> 8, leaving the bits that were shifted out behind.
+		MOV(32, R(tempReg1), R(RCX));
+		SHL(32, R(RCX), Imm8(3));
+		SHR(32, R(tempReg1), Imm8(2));
+		AND(32, R(tempReg1), Imm32(0x00070707));
+		OR(32, R(RCX), R(tempReg1));
+
+		// A is a single bit, so 0 becomes 0 and 1 becomes 0xFF.
+		SHR(32, R(oldColorReg), Imm8(15));
+		NEG(32, R(oldColorReg));
+		AND(32, R(oldColorReg), Imm32(0xFF000000));
+		OR(32, R(oldColorReg), R(RCX));
+		return true;
+
+	case GE_FORMAT_4444:
+		MOVZX(32, 16, oldColorReg, MatR(colorPtrReg));
+		MOVD_xmm(fpScratchReg1, R(oldColorReg));
+		PUNPCKLBW(fpScratchReg1, R(fpScratchReg1));
+		PAND(fpScratchReg1, ConstArg(color4444mask, tempReg1));
+		MOVSS(fpScratchReg2, R(fpScratchReg1));
+		MOVSS(fpScratchReg3, R(fpScratchReg1));
+		PSRLW(fpScratchReg2, 4);
+		PSLLW(fpScratchReg3, 4);
+		POR(fpScratchReg1, R(fpScratchReg2));
+		POR(fpScratchReg1, R(fpScratchReg3));
+		MOVD_xmm(R(oldColorReg), fpScratchReg1);
+		return true;
+
+	default:
+		return false;
+	}
+}
+
+bool PixelJitCache::Jit_BlendFactor(X64Reg dest, int factor, X64Reg otherColor, const u32 *fixColor) {
+	// The source and dest factor enums line up, only the color for 0 and 1 differs.
+	// Since everything here is 0-255, 255 - x is the same as x ^ 255.
+	switch (factor) {
+	case GE_SRCBLEND_DSTCOLOR:
+		MOVDQA(dest, R(otherColor));
+		break;
+
+	case GE_SRCBLEND_INVDSTCOLOR:
+		MOVDQA(dest, R(otherColor));
+		PXOR(dest, ConstArg(all255, tempReg1));
+		break;
+
+	case GE_SRCBLEND_SRCALPHA:
+	case GE_SRCBLEND_INVSRCALPHA:
+	case GE_SRCBLEND_DOUBLESRCALPHA:
+	case GE_SRCBLEND_DOUBLEINVSRCALPHA:
+		PSHUFD(dest, R(fpScratchReg2), _MM_SHUFFLE(3, 3, 3, 3));
+		break;
+
+	case GE_SRCBLEND_DSTALPHA:
+	case GE_SRCBLEND_INVDSTALPHA:
+	case GE_SRCBLEND_DOUBLEDSTALPHA:
+	case GE_SRCBLEND_DOUBLEINVDSTALPHA:
+		PSHUFD(dest, R(fpScratchReg3), _MM_SHUFFLE(3, 3, 3, 3));
+		break;
+
+	case GE_SRCBLEND_FIXA:
+		MOVD_xmm(dest, ConstArg(fixColor, tempReg1));
+		PUNPCKLBW(dest, R(fpScratchReg1));
+		PUNPCKLWD(dest, R(fpScratchReg1));
+		break;
+
+	default:
+		return false;
+	}
+
+	switch (factor) {
+	case GE_SRCBLEND_INVSRCALPHA:
+	case GE_SRCBLEND_INVDSTALPHA:
+		PXOR(dest, ConstArg(all255, tempReg1));
+		break;
+
+	case GE_SRCBLEND_DOUBLESRCALPHA:
+	case GE_SRCBLEND_DOUBLEDSTALPHA:
+		PSLLD(dest, 1);
+		break;
+
+	case GE_SRCBLEND_DOUBLEINVSRCALPHA:
+	case GE_SRCBLEND_DOUBLEINVDSTALPHA:
+		// 255 - min(2 * a, 255).  The high words are zero, so a 16-bit min works.
+		PSLLD(dest, 1);
+		PMINSW(dest, ConstArg(all255, tempReg1));
+		PXOR(dest, ConstArg(all255, tempReg1));
+		break;
+
+	default:
+		break;
+	}
+	return true;
+}
+
+bool PixelJitCache::Jit_AlphaBlend(const PixelFuncID &id) {
+	if (!id.alphaBlend)
+		return true;
+
+	switch ((GEBlendMode)id.alphaBlendEq) {
+	case GE_BLENDMODE_MIN:
+	case GE_BLENDMODE_MAX:
+	case GE_BLENDMODE_ABSDIFF:
+		// These work fine on 8-bit values, no need to widen.
+		MOVDQA(fpScratchReg2, R(argColorReg));
+		MOVD_xmm(fpScratchReg3, R(oldColorReg));
+		if (id.alphaBlendEq == GE_BLENDMODE_MIN) {
+			PMINUB(fpScratchReg2, R(fpScratchReg3));
+		} else if (id.alphaBlendEq == GE_BLENDMODE_MAX) {
+			PMAXUB(fpScratchReg2, R(fpScratchReg3));
+		} else {
+			MOVDQA(fpScratchReg4, R(fpScratchReg2));
+			PSUBUSB(fpScratchReg2, R(fpScratchReg3));
+			PSUBUSB(fpScratchReg3, R(fpScratchReg4));
+			POR(fpScratchReg2, R(fpScratchReg3));
+		}
+		MOVDQA(argColorReg, R(fpScratchReg2));
+		return true;
+
+	default:
+		break;
+	}
+
+	// Widen both to 32-bit lanes.
+	PXOR(fpScratchReg1, R(fpScratchReg1));
+	MOVDQA(fpScratchReg2, R(argColorReg));
+	PUNPCKLBW(fpScratchReg2, R(fpScratchReg1));
+	PUNPCKLWD(fpScratchReg2, R(fpScratchReg1));
+	MOVD_xmm(fpScratchReg3, R(oldColorReg));
+	PUNPCKLBW(fpScratchReg3, R(fpScratchReg1));
+	PUNPCKLWD(fpScratchReg3, R(fpScratchReg1));
+
+	if (!Jit_BlendFactor(fpScratchReg4, id.alphaBlendSrc, fpScratchReg3, &gstate.blendfixa))
+		return false;
+	if (!Jit_BlendFactor(fpScratchReg5, id.alphaBlendDst, fpScratchReg2, &gstate.blendfixb))
+		return false;
+
+	// This is the same float math as AlphaBlendingResult(), so the rounding matches.
+	CVTDQ2PS(fpScratchReg2, R(fpScratchReg2));
+	CVTDQ2PS(fpScratchReg4, R(fpScratchReg4));
+	MULPS(fpScratchReg2, R(fpScratchReg4));
+	CVTDQ2PS(fpScratchReg3, R(fpScratchReg3));
+	CVTDQ2PS(fpScratchReg5, R(fpScratchReg5));
+	MULPS(fpScratchReg3, R(fpScratchReg5));
+
+	switch ((GEBlendMode)id.alphaBlendEq) {
+	case GE_BLENDMODE_MUL_AND_ADD:
+		ADDPS(fpScratchReg2, R(fpScratchReg3));
+		break;
+
+	case GE_BLENDMODE_MUL_AND_SUBTRACT:
+		SUBPS(fpScratchReg2, R(fpScratchReg3));
+		break;
+
+	case GE_BLENDMODE_MUL_AND_SUBTRACT_REVERSE:
+		SUBPS(fpScratchReg3, R(fpScratchReg2));
+		MOVAPS(fpScratchReg2, R(fpScratchReg3));
+		break;
+
+	default:
+		return false;
+	}
+
+	MULPS(fpScratchReg2, ConstArg(by255f, tempReg1));
+	CVTPS2DQ(argColorReg, R(fpScratchReg2));
+	colorIsPacked_ = false;
+	return true;
+}
+
+bool PixelJitCache::Jit_ApplyDither(const PixelFuncID &id) {
+	if (id.dithering) {
+		if (colorIsPacked_) {
+			PXOR(fpScratchReg1, R(fpScratchReg1));
+			PUNPCKLBW(argColorReg, R(fpScratchReg1));
+			PUNPCKLWD(argColorReg, R(fpScratchReg1));
+			colorIsPacked_ = false;
+		}
+
+		MOVD_xmm(fpScratchReg1, R(ditherReg));
+		PSHUFD(fpScratchReg1, R(fpScratchReg1), _MM_SHUFFLE(0, 0, 0, 0));
+		PADDD(argColorReg, R(fpScratchReg1));
+	}
+
+	if (!colorIsPacked_) {
+		// Clamps, just like ToRGB().
+		PACKSSDW(argColorReg, R(argColorReg));
+		PACKUSWB(argColorReg, R(argColorReg));
+		colorIsPacked_ = true;
+	}
+	return true;
+}
+
+bool PixelJitCache::Jit_WriteColor(const PixelFuncID &id) {
+	MOVD_xmm(R(tempReg1), argColorReg);
+	AND(32, R(tempReg1), Imm32(0x00FFFFFF));
+
+	// Without a stencil test, the stencil bits are kept as is.
+	if (id.fbFormat != GE_FORMAT_565) {
+		MOV(32, R(RCX), R(oldColorReg));
+		AND(32, R(RCX), Imm32(0xFF000000));
+		OR(32, R(tempReg1), R(RCX));
+	}
+
+	if (id.applyColorWriteMask) {
+		MOV(32, R(RCX), ConstArg(&gstate.pmskc, RCX));
+		AND(32, R(RCX), Imm32(0x00FFFFFF));
+		MOVZX(32, 8, argZReg, ConstArg(&gstate.pmska, argZReg));
+		SHL(32, R(argZReg), Imm8(24));
+		OR(32, R(RCX), R(argZReg));
+
+		// new = (new & ~mask) | (old & mask), with one less temp.
+		MOV(32, R(argZReg), R(oldColorReg));
+		XOR(32, R(argZReg), R(tempReg1));
+		AND(32, R(argZReg), R(RCX));
+		XOR(32, R(tempReg1), R(argZReg));
+	}
+
+	auto encode = [&](const ColorPiece *pieces, size_t count) {
+		for (size_t i = 0; i < count; ++i) {
+			X64Reg dest = i == 0 ? RCX : argZReg;
+			MOV(32, R(dest), R(tempReg1));
+			SHR(32, R(dest), Imm8(pieces[i].shift));
+			AND(32, R(dest), Imm32(pieces[i].mask));
+			if (i != 0)
+				OR(32, R(RCX), R(dest));
+		}
+		MOV(16, MatR(colorPtrReg), R(RCX));
+	};
+
+	switch ((GEBufferFormat)id.fbFormat) {
+	case GE_FORMAT_8888:
+		MOV(32, MatR(colorPtrReg), R(tempReg1));
+		return true;
+	case GE_FORMAT_565:
+		encode(pieces565, ARRAY_SIZE(pieces565));
+		return true;
+	case GE_FORMAT_5551:
+		encode(pieces5551, ARRAY_SIZE(pieces5551));
+		return true;
+	case GE_FORMAT_4444:
+		encode(pieces4444, ARRAY_SIZE(pieces4444));
+		return true;
+	default:
+		return false;
+	}
+}
+
+};
+
+#endif
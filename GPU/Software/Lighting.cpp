@@ -36,107 +36,134 @@ static inline float pspLightPow(float v, float e) {
 	return v;
 }
 
-void Process(VertexData& vertex, bool hasColor) {
-	const int materialupdate = gstate.materialupdate & (hasColor ? 7 : 0);
+void ComputeState(State *state, bool hasColor) {
+	for (int light = 0; light < 4; ++light) {
+		State::LightState &lstate = state->lights[light];
+		lstate.pos = GetLightVec(gstate.lpos, light);
+		// In other words, L.Length2() == 0.0f means Dot({0, 0, 1}, worldnormal).
+		lstate.normalizedPos = lstate.pos.NormalizedOr001(cpu_info.bSSE4_1);
+		lstate.att = GetLightVec(gstate.latt, light);
+		lstate.spotDir = GetLightVec(gstate.ldir, light).NormalizedOr001(cpu_info.bSSE4_1);
+		lstate.spotCutoff = getFloat24(gstate.lcutoff[light]);
+		lstate.spotExp = getFloat24(gstate.lconv[light]);
+		lstate.ambientColor = Vec3<float>::FromRGB(gstate.getLightAmbientColor(light));
+		lstate.diffuseColor = Vec3<float>::FromRGB(gstate.getDiffuseColor(light));
+		lstate.specularColor = Vec3<float>::FromRGB(gstate.getSpecularColor(light));
+
+		lstate.enabled = gstate.isLightChanEnabled(light);
+		lstate.directional = gstate.isDirectionalLight(light);
+		lstate.spot = gstate.isSpotLight(light);
+		lstate.poweredDiffuse = gstate.isUsingPoweredDiffuseLight(light);
+		lstate.specular = gstate.isUsingSpecularLight(light);
+	}
+
+	state->ambientColor = Vec3<float>::FromRGB(gstate.getAmbientRGBA());
+	state->materialEmissive = Vec3<float>::FromRGB(gstate.getMaterialEmissive());
+	state->materialAmbient = Vec3<float>::FromRGB(gstate.getMaterialAmbientRGBA());
+	state->materialDiffuse = Vec3<float>::FromRGB(gstate.getMaterialDiffuse());
+	state->materialSpecular = Vec3<float>::FromRGB(gstate.getMaterialSpecular());
+	state->specularExp = gstate.getMaterialSpecularCoef();
+	state->ambientAlpha = gstate.getAmbientA();
+	state->materialAmbientAlpha = gstate.getMaterialAmbientA();
+	state->materialUpdate = gstate.materialupdate & (hasColor ? 7 : 0);
+
+	state->lightingEnabled = gstate.isLightingEnabled();
+	state->useSecondaryColor = gstate.isUsingSecondaryColor();
+
+	// Always calculate texture coords from lighting results if environment mapping is active.
+	// This should be done even if lighting is disabled altogether.
+	bool envMap = gstate.getUVGenMode() == GE_TEXMAP_ENVIRONMENT_MAP;
+	state->envMapS = envMap ? gstate.getUVLS0() : -1;
+	state->envMapT = envMap ? gstate.getUVLS1() : -1;
+}
+
+void Process(VertexData &vertex, const State &state) {
+	const int materialupdate = state.materialUpdate;
 
 	Vec3<float> vcol0 = vertex.color0.rgb().Cast<float>() * Vec3<float>::AssignToAll(1.0f / 255.0f);
-	Vec3<float> mec = Vec3<float>::FromRGB(gstate.getMaterialEmissive());
+	Vec3<float> mec = state.materialEmissive;
 
-	Vec3<float> mac = (materialupdate & 1) ? vcol0 : Vec3<float>::FromRGB(gstate.getMaterialAmbientRGBA());
-	Vec3<float> final_color = mec + mac * Vec3<float>::FromRGB(gstate.getAmbientRGBA());
+	Vec3<float> mac = (materialupdate & 1) ? vcol0 : state.materialAmbient;
+	Vec3<float> final_color = mec + mac * state.ambientColor;
 	Vec3<float> specular_color(0.0f, 0.0f, 0.0f);
 
-	for (unsigned int light = 0; light < 4; ++light) {
-		// Always calculate texture coords from lighting results if environment mapping is active
-		// TODO: Should specular lighting should affect this, too?  Doesn't in GLES.
-		// This should be done even if lighting is disabled altogether.
-		if (gstate.getUVGenMode() == GE_TEXMAP_ENVIRONMENT_MAP) {
-			Vec3<float> L = GetLightVec(gstate.lpos, light);
-			// In other words, L.Length2() == 0.0f means Dot({0, 0, 1}, worldnormal).
-			float diffuse_factor = Dot(L.NormalizedOr001(cpu_info.bSSE4_1), vertex.worldnormal);
-
-			if (gstate.getUVLS0() == (int)light)
-				vertex.texturecoords.s() = (diffuse_factor + 1.f) / 2.f;
-
-			if (gstate.getUVLS1() == (int)light)
-				vertex.texturecoords.t() = (diffuse_factor + 1.f) / 2.f;
-		}
+	// TODO: Should specular lighting should affect this, too?  Doesn't in GLES.
+	if (state.envMapS >= 0) {
+		float diffuse_factor = Dot(state.lights[state.envMapS].normalizedPos, vertex.worldnormal);
+		vertex.texturecoords.s() = (diffuse_factor + 1.f) / 2.f;
+	}
+	if (state.envMapT >= 0) {
+		float diffuse_factor = Dot(state.lights[state.envMapT].normalizedPos, vertex.worldnormal);
+		vertex.texturecoords.t() = (diffuse_factor + 1.f) / 2.f;
 	}
 
-	if (!gstate.isLightingEnabled())
+	if (!state.lightingEnabled)
 		return;
 
 	for (unsigned int light = 0; light < 4; ++light) {
-		if (!gstate.isLightChanEnabled(light))
+		const State::LightState &lstate = state.lights[light];
+		if (!lstate.enabled)
 			continue;
 
 		// L =  vector from vertex to light source
 		// TODO: Should transfer the light positions to world/view space for these calculations?
-		Vec3<float> L = GetLightVec(gstate.lpos, light);
-		if (!gstate.isDirectionalLight(light)) {
+		Vec3<float> L = lstate.pos;
+		if (!lstate.directional) {
 			L -= vertex.worldpos;
 		}
 		// TODO: Should this normalize (0, 0, 0) to (0, 0, 1)?
 		float d = L.NormalizeOr001();
 
 		float att = 1.f;
-		if (!gstate.isDirectionalLight(light)) {
-			att = 1.f / Dot(GetLightVec(gstate.latt, light), Vec3f(1.0f, d, d * d));
+		if (!lstate.directional) {
+			att = 1.f / Dot(lstate.att, Vec3f(1.0f, d, d * d));
 			if (att > 1.f) att = 1.f;
 			if (att < 0.f) att = 0.f;
 		}
 
 		float spot = 1.f;
-		if (gstate.isSpotLight(light)) {
-			Vec3<float> dir = GetLightVec(gstate.ldir, light);
-			float rawSpot = Dot(dir.NormalizedOr001(cpu_info.bSSE4_1), L);
-			float cutoff = getFloat24(gstate.lcutoff[light]);
-			if (rawSpot >= cutoff) {
-				float conv = getFloat24(gstate.lconv[light]);
-				spot = pspLightPow(rawSpot, conv);
+		if (lstate.spot) {
+			float rawSpot = Dot(lstate.spotDir, L);
+			if (rawSpot >= lstate.spotCutoff) {
+				spot = pspLightPow(rawSpot, lstate.spotExp);
 			} else {
 				spot = 0.f;
 			}
 		}
 
 		// ambient lighting
-		Vec3<float> lac = Vec3<float>::FromRGB(gstate.getLightAmbientColor(light));
-		final_color += lac * mac * att * spot;
+		final_color += lstate.ambientColor * mac * att * spot;
 
 		// diffuse lighting
-		Vec3<float> ldc = Vec3<float>::FromRGB(gstate.getDiffuseColor(light));
-		Vec3<float> mdc = (materialupdate & 2) ? vcol0 : Vec3<float>::FromRGB(gstate.getMaterialDiffuse());
+		Vec3<float> mdc = (materialupdate & 2) ? vcol0 : state.materialDiffuse;
 
 		float diffuse_factor = Dot(L, vertex.worldnormal);
-		if (gstate.isUsingPoweredDiffuseLight(light)) {
-			float k = gstate.getMaterialSpecularCoef();
-			diffuse_factor = pspLightPow(diffuse_factor, k);
+		if (lstate.poweredDiffuse) {
+			diffuse_factor = pspLightPow(diffuse_factor, state.specularExp);
 		}
 
 		if (diffuse_factor > 0.f) {
-			final_color += ldc * mdc * diffuse_factor * att * spot;
+			final_color += lstate.diffuseColor * mdc * diffuse_factor * att * spot;
 		}
 
-		if (gstate.isUsingSpecularLight(light) && diffuse_factor >= 0.0f) {
+		if (lstate.specular && diffuse_factor >= 0.0f) {
 			Vec3<float> H = L + Vec3<float>(0.f, 0.f, 1.f);
 
-			Vec3<float> lsc = Vec3<float>::FromRGB(gstate.getSpecularColor(light));
-			Vec3<float> msc = (materialupdate & 4) ? vcol0 : Vec3<float>::FromRGB(gstate.getMaterialSpecular());
+			Vec3<float> msc = (materialupdate & 4) ? vcol0 : state.materialSpecular;
 
 			float specular_factor = Dot(H.NormalizedOr001(cpu_info.bSSE4_1), vertex.worldnormal);
-			float k = gstate.getMaterialSpecularCoef();
-			specular_factor = pspLightPow(specular_factor, k);
+			specular_factor = pspLightPow(specular_factor, state.specularExp);
 
 			if (specular_factor > 0.f) {
-				specular_color += lsc * msc * specular_factor * att * spot;
+				specular_color += lstate.specularColor * msc * specular_factor * att * spot;
 			}
 		}
 	}
 
-	int maa = (materialupdate & 1) ? vertex.color0.a() : gstate.getMaterialAmbientA();
-	int final_alpha = (gstate.getAmbientA() * maa) / 255;
+	int maa = (materialupdate & 1) ? vertex.color0.a() : state.materialAmbientAlpha;
+	int final_alpha = (state.ambientAlpha * maa) / 255;
 
-	if (gstate.isUsingSecondaryColor()) {
+	if (state.useSecondaryColor) {
 		Vec3<int> final_color_int = (final_color.Clamp(0.0f, 1.0f) * 255.0f).Cast<int>();
 		vertex.color0 = Vec4<int>(final_color_int, final_alpha);
 		vertex.color1 = (specular_color.Clamp(0.0f, 1.0f) * 255.0f).Cast<int>();
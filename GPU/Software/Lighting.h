@@ -21,6 +21,49 @@
 
 namespace Lighting {
 
-void Process(VertexData& vertex, bool hasColor);
+// Light and material parameters, converted once per draw rather than per vertex.
+struct State {
+	struct LightState {
+		Vec3f pos;
+		// Normalized, for environment mapping.
+		Vec3f normalizedPos;
+		Vec3f att;
+		// Normalized.
+		Vec3f spotDir;
+		float spotCutoff;
+		float spotExp;
+		Vec3f ambientColor;
+		Vec3f diffuseColor;
+		Vec3f specularColor;
+
+		bool enabled;
+		bool directional;
+		bool spot;
+		bool poweredDiffuse;
+		bool specular;
+	};
+
+	LightState lights[4];
+
+	Vec3f ambientColor;
+	Vec3f materialEmissive;
+	Vec3f materialAmbient;
+	Vec3f materialDiffuse;
+	Vec3f materialSpecular;
+	float specularExp;
+	int ambientAlpha;
+	int materialAmbientAlpha;
+	// Already masked off when the vertices have no color.
+	int materialUpdate;
+
+	bool lightingEnabled;
+	bool useSecondaryColor;
+	// Light indices used for environment mapping, or -1.
+	int envMapS;
+	int envMapT;
+};
+
+void ComputeState(State *state, bool hasColor);
+void Process(VertexData &vertex, const State &state);
 
 }
\ No newline at end of file
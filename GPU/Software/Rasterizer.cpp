@@ -21,7 +21,6 @@
 
 #include "Common/Data/Convert/ColorConv.h"
 #include "Common/Profiler/Profiler.h"
-#include "Common/Thread/ParallelLoop.h"
 #include "Core/ThreadPools.h"
 #include "Core/Config.h"
 #include "Core/MemMap.h"
@@ -1134,11 +1133,88 @@ static inline Vec4<float> EdgeRecip(const Vec4<int> &w0, const Vec4<int> &w1, co
 #endif
 }
 
+// Runs the depth range and depth tests for a whole quad, setting the sign bit in mask for lanes that fail.
+// The pixel stage still runs both tests, this just lets us skip shading pixels that can't pass them.
+static inline Vec4<int> ApplyEarlyDepthTests(const RasterizerState &state, const DrawingCoords &p, const Vec4<int> &z, const Vec4<int> &mask) {
+	// Only read depth for lanes we're drawing, others may be outside the buffer.
+	int ref[4]{};
+	if (state.earlyDepthTest != GE_COMP_ALWAYS) {
+		const int stride = gstate.DepthBufStride();
+		for (int i = 0; i < 4; ++i) {
+			if (mask[i] >= 0)
+				ref[i] = depthbuf.Get16(p.x + (i & 1), p.y + (i / 2), stride);
+		}
+	}
+
+#if defined(_M_SSE)
+	// The pixel stage sees z truncated to 16 bits, so this must too.  Then signed compares are safe.
+	const __m128i zv = _mm_and_si128(z.ivec, _mm_set1_epi32(0xFFFF));
+	const __m128i allOnes = _mm_set1_epi32(-1);
+	__m128i fail = _mm_setzero_si128();
+	if (state.earlyDepthRange) {
+		__m128i belowMin = _mm_cmplt_epi32(zv, _mm_set1_epi32(gstate.getDepthRangeMin()));
+		__m128i aboveMax = _mm_cmpgt_epi32(zv, _mm_set1_epi32(gstate.getDepthRangeMax()));
+		fail = _mm_or_si128(belowMin, aboveMax);
+	}
+
+	const __m128i refv = _mm_loadu_si128((const __m128i *)ref);
+	switch (state.earlyDepthTest) {
+	case GE_COMP_NEVER:
+		fail = allOnes;
+		break;
+	case GE_COMP_ALWAYS:
+		break;
+	case GE_COMP_EQUAL:
+		fail = _mm_or_si128(fail, _mm_xor_si128(_mm_cmpeq_epi32(zv, refv), allOnes));
+		break;
+	case GE_COMP_NOTEQUAL:
+		fail = _mm_or_si128(fail, _mm_cmpeq_epi32(zv, refv));
+		break;
+	case GE_COMP_LESS:
+		fail = _mm_or_si128(fail, _mm_xor_si128(_mm_cmplt_epi32(zv, refv), allOnes));
+		break;
+	case GE_COMP_LEQUAL:
+		fail = _mm_or_si128(fail, _mm_cmpgt_epi32(zv, refv));
+		break;
+	case GE_COMP_GREATER:
+		fail = _mm_or_si128(fail, _mm_xor_si128(_mm_cmpgt_epi32(zv, refv), allOnes));
+		break;
+	case GE_COMP_GEQUAL:
+		fail = _mm_or_si128(fail, _mm_cmplt_epi32(zv, refv));
+		break;
+	}
+
+	return _mm_or_si128(mask.ivec, fail);
+#else
+	Vec4<int> result = mask;
+	for (int i = 0; i < 4; ++i) {
+		u16 z16 = (u16)z[i];
+		bool pass = true;
+		if (state.earlyDepthRange && (z16 < gstate.getDepthRangeMin() || z16 > gstate.getDepthRangeMax()))
+			pass = false;
+
+		switch (state.earlyDepthTest) {
+		case GE_COMP_NEVER: pass = false; break;
+		case GE_COMP_ALWAYS: break;
+		case GE_COMP_EQUAL: pass = pass && z16 == ref[i]; break;
+		case GE_COMP_NOTEQUAL: pass = pass && z16 != ref[i]; break;
+		case GE_COMP_LESS: pass = pass && z16 < ref[i]; break;
+		case GE_COMP_LEQUAL: pass = pass && z16 <= ref[i]; break;
+		case GE_COMP_GREATER: pass = pass && z16 > ref[i]; break;
+		case GE_COMP_GEQUAL: pass = pass && z16 >= ref[i]; break;
+		}
+
+		if (!pass)
+			result[i] = -1;
+	}
+	return result;
+#endif
+}
+
 template <bool clearMode>
 void DrawTriangleSlice(
 	const VertexData& v0, const VertexData& v1, const VertexData& v2,
-	int x1, int y1, int x2, int y2,
-	bool byY, int h1, int h2)
+	const BinCoords &range, const BinCoords &clip, const RasterizerState &state)
 {
 	Vec4<int> bias0 = Vec4<int>::AssignToAll(IsRightSideOrFlatBottomLine(v0.screenpos.xy(), v1.screenpos.xy(), v2.screenpos.xy()) ? -1 : 0);
 	Vec4<int> bias1 = Vec4<int>::AssignToAll(IsRightSideOrFlatBottomLine(v1.screenpos.xy(), v2.screenpos.xy(), v0.screenpos.xy()) ? -1 : 0);
@@ -1170,14 +1246,15 @@ void DrawTriangleSlice(
 	TriangleEdge e1;
 	TriangleEdge e2;
 
-	int64_t minX = x1, maxX = x2, minY = y1, maxY = y2;
-	if (byY) {
-		maxY = std::min(maxY, minY + h2 * 16 * 2) - 1;
-		minY += h1 * 16 * 2;
-	} else {
-		maxX = std::min(maxX, minX + h2 * 16 * 2) - 1;
-		minX += h1 * 16 * 2;
-	}
+	// Start at the quad containing the clip corner, keeping quads aligned to the triangle's range.
+	// That way every tile steps through the same pixel pairs.
+	int64_t minX = range.x1 + ((clip.x1 - range.x1) & ~31);
+	int64_t minY = range.y1 + ((clip.y1 - range.y1) & ~31);
+	int64_t maxX = clip.x2, maxY = clip.y2;
+
+	const Vec4<int> quadX(0, 16, 0, 16);
+	const Vec4<int> quadY(0, 0, 16, 16);
+	const Vec4<int> clipStep = Vec4<int>::AssignToAll(32);
 
 	ScreenCoords pprime(minX, minY, 0);
 	Vec4<int> w0_base = e0.Start(v1.screenpos, v2.screenpos, pprime);
@@ -1188,8 +1265,6 @@ void DrawTriangleSlice(
 	// This is common, and when we interpolate, we lose accuracy.
 	const bool flatZ = v0.screenpos.z == v1.screenpos.z && v0.screenpos.z == v2.screenpos.z;
 
-	Sampler::Funcs sampler = Sampler::GetFuncs();
-
 	for (int64_t curY = minY; curY <= maxY; curY += 32,
 										w0_base = e0.StepY(w0_base),
 										w1_base = e1.StepY(w1_base),
@@ -1199,9 +1274,12 @@ void DrawTriangleSlice(
 		Vec4<int> w2 = w2_base;
 
 		// TODO: Maybe we can clip the edges instead?
-		int scissorYPlus1 = curY + 16 > maxY ? -1 : 0;
-		Vec4<int> scissor_mask = Vec4<int>(0, maxX - minX, scissorYPlus1, (maxX - minX) | scissorYPlus1);
-		Vec4<int> scissor_step = Vec4<int>(0, -32, 0, -32);
+		// Lanes outside the clip rect end up with the sign bit set.
+		Vec4<int> posY = Vec4<int>::AssignToAll((int)curY) + quadY;
+		Vec4<int> clipY = (posY - Vec4<int>::AssignToAll(clip.y1)) | (Vec4<int>::AssignToAll(clip.y2) - posY);
+		Vec4<int> posX = Vec4<int>::AssignToAll((int)minX) + quadX;
+		Vec4<int> clipLeft = posX - Vec4<int>::AssignToAll(clip.x1);
+		Vec4<int> clipRight = Vec4<int>::AssignToAll(clip.x2) - posX;
 
 		DrawingCoords p = TransformUnit::ScreenToDrawing(ScreenCoords(minX, curY, 0));
 
@@ -1209,14 +1287,32 @@ void DrawTriangleSlice(
 			w0 = e0.StepX(w0),
 			w1 = e1.StepX(w1),
 			w2 = e2.StepX(w2),
-			scissor_mask = scissor_mask + scissor_step,
+			clipLeft = clipLeft + clipStep,
+			clipRight = clipRight - clipStep,
 			p.x = (p.x + 2) & 0x3FF) {
 
 			// If p is on or inside all edges, render pixel
+			Vec4<int> scissor_mask = clipLeft | clipRight | clipY;
 			Vec4<int> mask = MakeMask(w0, w1, w2, bias0, bias1, bias2, scissor_mask);
 			if (AnyMask(mask)) {
 				Vec4<float> wsum_recip = EdgeRecip(w0, w1, w2);
 
+				Vec4<int> z;
+				if (flatZ) {
+					z = Vec4<int>::AssignToAll(v2.screenpos.z);
+				} else {
+					// TODO: Is that the correct way to interpolate?
+					Vec4<float> zfloats = w0.Cast<float>() * v0.screenpos.z + w1.Cast<float>() * v1.screenpos.z + w2.Cast<float>() * v2.screenpos.z;
+					z = (zfloats * wsum_recip).Cast<int>();
+				}
+
+				// Drop hidden pixels now, so they don't get shaded or textured.
+				if (state.earlyDepthRange || state.earlyDepthTest != GE_COMP_ALWAYS) {
+					mask = ApplyEarlyDepthTests(state, p, z, mask);
+					if (!AnyMask(mask))
+						continue;
+				}
+
 				Vec4<int> prim_color[4];
 				Vec3<int> sec_color[4];
 				if (gstate.getShadeMode() == GE_SHADE_GOURAUD && !clearMode) {
@@ -1246,7 +1342,7 @@ void DrawTriangleSlice(
 						GetTextureCoordinates(v0, v1, v2, w0, w1, w2, wsum_recip, s, t);
 					}
 
-					ApplyTexturing(sampler, prim_color, s, t, maxTexLevel, texptr, texbufw);
+					ApplyTexturing(state.samplers, prim_color, s, t, maxTexLevel, texptr, texbufw);
 				}
 
 				if (!clearMode) {
@@ -1270,15 +1366,6 @@ void DrawTriangleSlice(
 					}
 				}
 
-				Vec4<int> z;
-				if (flatZ) {
-					z = Vec4<int>::AssignToAll(v2.screenpos.z);
-				} else {
-					// TODO: Is that the correct way to interpolate?
-					Vec4<float> zfloats = w0.Cast<float>() * v0.screenpos.z + w1.Cast<float>() * v1.screenpos.z + w2.Cast<float>() * v2.screenpos.z;
-					z = (zfloats * wsum_recip).Cast<int>();
-				}
-
 				DrawingCoords subp = p;
 				for (int i = 0; i < 4; ++i) {
 					if (mask[i] < 0) {
@@ -1287,25 +1374,23 @@ void DrawTriangleSlice(
 					subp.x = p.x + (i & 1);
 					subp.y = p.y + (i / 2);
 
-					DrawSinglePixel<clearMode>(subp, (u16)z[i], fog[i], prim_color[i]);
+					if (clearMode)
+						DrawSinglePixel<true>(subp, (u16)z[i], fog[i], prim_color[i]);
+					else
+						state.drawPixel(subp.x, subp.y, (u16)z[i], fog[i], prim_color[i]);
 				}
 			}
 		}
 	}
 }
 
-// Draws triangle, vertices specified in counter-clockwise direction
-void DrawTriangle(const VertexData& v0, const VertexData& v1, const VertexData& v2)
-{
-	PROFILE_THIS_SCOPE("draw_tri");
-
+bool GetTriangleRange(const VertexData &v0, const VertexData &v1, const VertexData &v2, BinCoords &range) {
 	Vec2<int> d01((int)v0.screenpos.x - (int)v1.screenpos.x, (int)v0.screenpos.y - (int)v1.screenpos.y);
 	Vec2<int> d02((int)v0.screenpos.x - (int)v2.screenpos.x, (int)v0.screenpos.y - (int)v2.screenpos.y);
-	Vec2<int> d12((int)v1.screenpos.x - (int)v2.screenpos.x, (int)v1.screenpos.y - (int)v2.screenpos.y);
 
 	// Drop primitives which are not in CCW order by checking the cross product
 	if (d01.x * d02.y - d01.y * d02.x < 0)
-		return;
+		return false;
 
 	int minX = std::min(std::min(v0.screenpos.x, v1.screenpos.x), v2.screenpos.x) & ~0xF;
 	int minY = std::min(std::min(v0.screenpos.y, v1.screenpos.y), v2.screenpos.y) & ~0xF;
@@ -1314,47 +1399,42 @@ void DrawTriangle(const VertexData& v0, const VertexData& v1, const VertexData&
 
 	DrawingCoords scissorTL(gstate.getScissorX1(), gstate.getScissorY1(), 0);
 	DrawingCoords scissorBR(gstate.getScissorX2(), gstate.getScissorY2(), 0);
-	minX = std::max(minX, (int)TransformUnit::DrawingToScreen(scissorTL).x);
-	maxX = std::min(maxX, (int)TransformUnit::DrawingToScreen(scissorBR).x);
-	minY = std::max(minY, (int)TransformUnit::DrawingToScreen(scissorTL).y);
-	maxY = std::min(maxY, (int)TransformUnit::DrawingToScreen(scissorBR).y);
+	range.x1 = std::max(minX, (int)TransformUnit::DrawingToScreen(scissorTL).x);
+	range.x2 = std::min(maxX, (int)TransformUnit::DrawingToScreen(scissorBR).x);
+	range.y1 = std::max(minY, (int)TransformUnit::DrawingToScreen(scissorTL).y);
+	range.y2 = std::min(maxY, (int)TransformUnit::DrawingToScreen(scissorBR).y);
 
-	// 32 because we do two pixels at once, and we don't want overlap.
-	int rangeY = (maxY - minY) / 32 + 1;
-	int rangeX = (maxX - minX) / 32 + 1;
+	return range.x1 <= range.x2 && range.y1 <= range.y2;
+}
 
-	const int MIN_LINES_PER_THREAD = 4;
+void ComputeRasterizerState(RasterizerState *state) {
+	state->samplers = Sampler::GetFuncs();
+	state->drawPixel = GetSingleFunc();
 
-	if (rangeY >= 12 && rangeX >= rangeY * 4) {
-		if (gstate.isModeClear()) {
-			auto bound = [&](int a, int b) -> void {
-				DrawTriangleSlice<true>(v0, v1, v2, minX, minY, maxX, maxY, false, a, b);
-			};
-			ParallelRangeLoop(&g_threadManager, bound, 0, rangeX, MIN_LINES_PER_THREAD);
-		} else {
-			auto bound = [&](int a, int b) -> void {
-				DrawTriangleSlice<false>(v0, v1, v2, minX, minY, maxX, maxY, false, a, b);
-			};
-			ParallelRangeLoop(&g_threadManager, bound, 0, rangeX, MIN_LINES_PER_THREAD);
-		}
-	} else if (rangeY >= 12 && rangeX >= 12) {
-		if (gstate.isModeClear()) {
-			auto bound = [&](int a, int b) -> void {
-				DrawTriangleSlice<true>(v0, v1, v2, minX, minY, maxX, maxY, true, a, b);
-			};
-			ParallelRangeLoop(&g_threadManager, bound, 0, rangeY, MIN_LINES_PER_THREAD);
-		} else {
-			auto bound = [&](int a, int b) -> void {
-				DrawTriangleSlice<false>(v0, v1, v2, minX, minY, maxX, maxY, true, a, b);
-			};
-			ParallelRangeLoop(&g_threadManager, bound, 0, rangeY, MIN_LINES_PER_THREAD);
-		}
+	// Failing these has no side effects, so they can be applied to a quad before shading.
+	// With stencil on, a depth fail still updates stencil, so those pixels must reach the pixel stage.
+	state->earlyDepthRange = !gstate.isModeThrough();
+	state->earlyDepthTest = GE_COMP_ALWAYS;
+	if (gstate.isDepthTestEnabled() && !gstate.isStencilTestEnabled() && !gstate.isModeClear())
+		state->earlyDepthTest = gstate.getDepthTestFunction();
+}
+
+// Draws triangle, vertices specified in counter-clockwise direction
+void DrawTriangle(const VertexData &v0, const VertexData &v1, const VertexData &v2, const BinCoords &range, const BinCoords &clip, const RasterizerState &state) {
+	PROFILE_THIS_SCOPE("draw_tri");
+
+	BinCoords sub;
+	sub.x1 = std::max(range.x1, clip.x1);
+	sub.y1 = std::max(range.y1, clip.y1);
+	sub.x2 = std::min(range.x2, clip.x2);
+	sub.y2 = std::min(range.y2, clip.y2);
+	if (sub.x1 > sub.x2 || sub.y1 > sub.y2)
+		return;
+
+	if (gstate.isModeClear()) {
+		DrawTriangleSlice<true>(v0, v1, v2, range, sub, state);
 	} else {
-		if (gstate.isModeClear()) {
-			DrawTriangleSlice<true>(v0, v1, v2, minX, minY, maxX, maxY, true, 0, rangeY);
-		} else {
-			DrawTriangleSlice<false>(v0, v1, v2, minX, minY, maxX, maxY, true, 0, rangeY);
-		}
+		DrawTriangleSlice<false>(v0, v1, v2, range, sub, state);
 	}
 }
 
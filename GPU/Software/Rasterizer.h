@@ -18,13 +18,38 @@
 #pragma once
 
 #include "TransformUnit.h" // for DrawingCoords
+#include "GPU/Software/DrawPixel.h"
+#include "GPU/Software/Sampler.h"
 
 struct GPUDebugBuffer;
 
+// Inclusive rectangle in screen coordinates (1/16 pixel units.)
+struct BinCoords {
+	int x1;
+	int y1;
+	int x2;
+	int y2;
+};
+
 namespace Rasterizer {
 
-// Draws a triangle if its vertices are specified in counter-clockwise order
-void DrawTriangle(const VertexData& v0, const VertexData& v1, const VertexData& v2);
+// Functions specialized for the current draw state.  Only valid until that state changes.
+struct RasterizerState {
+	Sampler::Funcs samplers;
+	SingleFunc drawPixel;
+	// Applied to whole quads before shading, see ComputeRasterizerState.
+	bool earlyDepthRange;
+	GEComparison earlyDepthTest;
+};
+
+void ComputeRasterizerState(RasterizerState *state);
+
+// Computes the scissored screen bounds of a triangle.  Returns false if nothing would be drawn,
+// including when the vertices are not in counter-clockwise order.
+bool GetTriangleRange(const VertexData &v0, const VertexData &v1, const VertexData &v2, BinCoords &range);
+// Draws the part of a triangle (bounded by range, see above) which lies inside clip.
+// Safe to call from multiple threads as long as the clip rects don't overlap.
+void DrawTriangle(const VertexData &v0, const VertexData &v1, const VertexData &v2, const BinCoords &range, const BinCoords &clip, const RasterizerState &state);
 void DrawPoint(const VertexData &v0);
 void DrawLine(const VertexData &v0, const VertexData &v1);
 void ClearRectangle(const VertexData &v0, const VertexData &v1);
@@ -13,6 +13,7 @@
 #include "GPU/GPUState.h"
 
 #include "GPU/Common/TextureCacheCommon.h"
+#include "GPU/Software/BinManager.h"
 #include "GPU/Software/SoftGpu.h"
 #include "GPU/Software/Rasterizer.h"
 #include "GPU/Software/Sampler.h"
@@ -73,6 +74,217 @@ static inline Vec4<int> ModulateRGBA(const Vec4<int>& prim_color, const Vec4<int
 
 }
 
+// Sprites where each pixel just takes its color (optionally alpha tested or blended over the old one.)
+// These are drawn a row at a time, skipping the per-pixel pipeline.
+struct SpriteBlitState {
+	// Pixels with less alpha than this fail the alpha test.
+	int minAlpha;
+	// SRCALPHA / INVSRCALPHA / ADD.
+	bool alphaBlend;
+};
+
+enum {
+	// Rows are fetched and written in chunks of this many pixels.
+	SPRITE_CHUNK_SIZE = 256,
+};
+
+static bool GetSpriteBlitState(SpriteBlitState *state, int z) {
+	if (gstate.isStencilTestEnabled() || gstate.isDepthTestEnabled() || gstate.isLogicOpEnabled() || gstate.isColorTestEnabled())
+		return false;
+	if (gstate.isDitherEnabled() || gstate.getColorMask() != 0)
+		return false;
+	if (!gstate.isModeThrough()) {
+		// Fog would vary per pixel, and z is the same everywhere so the range test only needs checking once.
+		if (gstate.isFogEnabled())
+			return false;
+		if (z < gstate.getDepthRangeMin() || z > gstate.getDepthRangeMax())
+			return false;
+	}
+
+	state->minAlpha = 0;
+	if (gstate.isAlphaTestEnabled()) {
+		if (gstate.getAlphaTestMask() != 0xFF)
+			return false;
+		int ref = gstate.getAlphaTestRef();
+		switch (gstate.getAlphaTestFunction()) {
+		case GE_COMP_ALWAYS: break;
+		case GE_COMP_GREATER: state->minAlpha = ref + 1; break;
+		case GE_COMP_GEQUAL: state->minAlpha = ref; break;
+		case GE_COMP_NOTEQUAL:
+			if (ref != 0)
+				return false;
+			state->minAlpha = 1;
+			break;
+		default:
+			return false;
+		}
+	}
+
+	state->alphaBlend = gstate.isAlphaBlendEnabled();
+	if (state->alphaBlend) {
+		if (gstate.getBlendEq() != GE_BLENDMODE_MUL_AND_ADD || gstate.getBlendFuncA() != GE_SRCBLEND_SRCALPHA || gstate.getBlendFuncB() != GE_DSTBLEND_INVSRCALPHA)
+			return false;
+	}
+	return true;
+}
+
+// Whether the texture function leaves the texel alone, apart from maybe alpha.
+static bool IsTextureFunctionPassthrough(const Vec4<int> &prim_color) {
+	switch (gstate.getTextureFunction()) {
+	case GE_TEXFUNC_REPLACE:
+		return true;
+	case GE_TEXFUNC_MODULATE:
+		return !gstate.isColorDoublingEnabled() && prim_color == Vec4<int>(255, 255, 255, 255);
+	default:
+		return false;
+	}
+}
+
+static inline u32 LookupClutColor(u32 index) {
+	switch (gstate.getClutPaletteFormat()) {
+	case GE_CMODE_16BIT_BGR5650:
+		return RGB565ToRGBA8888(reinterpret_cast<const u16 *>(clut)[index]);
+	case GE_CMODE_16BIT_ABGR5551:
+		return RGBA5551ToRGBA8888(reinterpret_cast<const u16 *>(clut)[index]);
+	case GE_CMODE_16BIT_ABGR4444:
+		return RGBA4444ToRGBA8888(reinterpret_cast<const u16 *>(clut)[index]);
+	case GE_CMODE_32BIT_ABGR8888:
+	default:
+		return clut[index];
+	}
+}
+
+// Reads count texels along a row, converted to RGBA8888.
+static void FetchSpriteTexels(u32 *dst, int s, int t, int ds, int count, const u8 *texptr, int texbufw, Sampler::NearestFunc nearestFunc, const u32 *palette) {
+	if (ds == 1 && texptr && !gstate.isTextureSwizzled()) {
+		switch (gstate.getTextureFormat()) {
+		case GE_TFMT_8888:
+			memcpy(dst, texptr + (t * texbufw + s) * 4, count * sizeof(u32));
+			return;
+		case GE_TFMT_5551:
+			ConvertRGBA5551ToRGBA8888(dst, (const u16 *)texptr + t * texbufw + s, count);
+			return;
+		case GE_TFMT_4444:
+			ConvertRGBA4444ToRGBA8888(dst, (const u16 *)texptr + t * texbufw + s, count);
+			return;
+		case GE_TFMT_5650:
+			ConvertRGB565ToRGBA8888(dst, (const u16 *)texptr + t * texbufw + s, count);
+			return;
+		case GE_TFMT_CLUT8:
+		{
+			const u8 *src = texptr + t * texbufw + s;
+			for (int i = 0; i < count; ++i)
+				dst[i] = palette[src[i]];
+			return;
+		}
+		case GE_TFMT_CLUT4:
+		{
+			const u8 *src = texptr + t * (texbufw / 2);
+			for (int i = 0; i < count; ++i) {
+				int u = s + i;
+				dst[i] = palette[(u & 1) ? (src[u >> 1] >> 4) : (src[u >> 1] & 0xF)];
+			}
+			return;
+		}
+		default:
+			break;
+		}
+	}
+
+	for (int i = 0; i < count; ++i) {
+		dst[i] = nearestFunc(s, t, texptr, texbufw, 0);
+		s += ds;
+	}
+}
+
+static inline u32 ReadSpritePixel(int x, int y, int stride) {
+	switch (gstate.FrameBufFormat()) {
+	case GE_FORMAT_565: return RGB565ToRGBA8888(fb.Get16(x, y, stride));
+	case GE_FORMAT_5551: return RGBA5551ToRGBA8888(fb.Get16(x, y, stride));
+	case GE_FORMAT_4444: return RGBA4444ToRGBA8888(fb.Get16(x, y, stride));
+	default: return fb.Get32(x, y, stride);
+	}
+}
+
+static inline void WriteSpritePixel(int x, int y, int stride, u32 value) {
+	switch (gstate.FrameBufFormat()) {
+	case GE_FORMAT_565: fb.Set16(x, y, stride, RGBA8888ToRGB565(value)); break;
+	case GE_FORMAT_5551: fb.Set16(x, y, stride, RGBA8888ToRGBA5551(value)); break;
+	case GE_FORMAT_4444: fb.Set16(x, y, stride, RGBA8888ToRGBA4444(value)); break;
+	default: fb.Set32(x, y, stride, value); break;
+	}
+}
+
+// Writes a row of final RGBA colors, keeping the stencil bits already in the framebuffer.
+static void WriteSpriteRow(int x, int y, int count, const u32 *colors, const SpriteBlitState &state) {
+	const int stride = gstate.FrameBufStride();
+
+	if (state.alphaBlend) {
+		for (int i = 0; i < count; ++i) {
+			const int a = colors[i] >> 24;
+			if (a < state.minAlpha)
+				continue;
+			const u32 old_color = ReadSpritePixel(x + i, y, stride);
+			const Vec3<int> blended = AlphaBlendingResult(Vec4<int>::FromRGBA(colors[i]), Vec4<int>::FromRGBA(old_color));
+			// The stencil bits don't matter for 565, which always reads back full alpha.
+			WriteSpritePixel(x + i, y, stride, blended.ToRGB() | (old_color & 0xFF000000));
+		}
+		return;
+	}
+
+	if (gstate.FrameBufFormat() == GE_FORMAT_8888) {
+		u32 *dst = fb.Get32Ptr(x, y, stride);
+		int i = 0;
+#if defined(_M_SSE)
+		const __m128i rgbMask = _mm_set1_epi32(0x00FFFFFF);
+		const __m128i minAlpha = _mm_set1_epi32(state.minAlpha - 1);
+		for (; i + 4 <= count; i += 4) {
+			__m128i src = _mm_loadu_si128((const __m128i *)&colors[i]);
+			__m128i old = _mm_loadu_si128((const __m128i *)&dst[i]);
+			// Lanes that pass the alpha test take the new color, but keep the old stencil.
+			__m128i pass = _mm_cmpgt_epi32(_mm_srli_epi32(src, 24), minAlpha);
+			__m128i keep = _mm_andnot_si128(_mm_and_si128(pass, rgbMask), old);
+			__m128i result = _mm_or_si128(keep, _mm_and_si128(_mm_and_si128(pass, rgbMask), src));
+			_mm_storeu_si128((__m128i *)&dst[i], result);
+		}
+#endif
+		for (; i < count; ++i) {
+			if ((int)(colors[i] >> 24) >= state.minAlpha)
+				dst[i] = (dst[i] & 0xFF000000) | (colors[i] & 0x00FFFFFF);
+		}
+		return;
+	}
+
+	u16 converted[SPRITE_CHUNK_SIZE];
+	u16 stencilMask;
+	switch (gstate.FrameBufFormat()) {
+	case GE_FORMAT_565:
+		ConvertRGBA8888ToRGB565(converted, colors, count);
+		stencilMask = 0;
+		break;
+	case GE_FORMAT_5551:
+		ConvertRGBA8888ToRGBA5551(converted, colors, count);
+		stencilMask = 0x8000;
+		break;
+	case GE_FORMAT_4444:
+	default:
+		ConvertRGBA8888ToRGBA4444(converted, colors, count);
+		stencilMask = 0xF000;
+		break;
+	}
+
+	u16 *dst = fb.Get16Ptr(x, y, stride);
+	if (state.minAlpha == 0) {
+		for (int i = 0; i < count; ++i)
+			dst[i] = (dst[i] & stencilMask) | (converted[i] & ~stencilMask);
+	} else {
+		for (int i = 0; i < count; ++i) {
+			if ((int)(colors[i] >> 24) >= state.minAlpha)
+				dst[i] = (dst[i] & stencilMask) | (converted[i] & ~stencilMask);
+		}
+	}
+}
+
 void DrawSprite(const VertexData& v0, const VertexData& v1) {
 	const u8 *texptr = nullptr;
 
@@ -84,6 +296,7 @@ void DrawSprite(const VertexData& v0, const VertexData& v1) {
 
 	ScreenCoords pprime(v0.screenpos.x, v0.screenpos.y, 0);
 	Sampler::NearestFunc nearestFunc = Sampler::GetNearestFunc();  // Looks at gstate.
+	SingleFunc drawPixel = GetSingleFunc();
 
 	DrawingCoords pos0 = TransformUnit::ScreenToDrawing(v0.screenpos);
 	// Include the ending pixel based on its center, not start.
@@ -96,6 +309,7 @@ void DrawSprite(const VertexData& v0, const VertexData& v1) {
 	float fog = 1.0f;
 
 	bool isWhite = v1.color0 == Vec4<int>(255, 255, 255, 255);
+	SpriteBlitState blitState;
 
 	if (gstate.isTextureMapEnabled()) {
 		// 1:1 (but with mirror support) texture mapping!
@@ -164,6 +378,34 @@ void DrawSprite(const VertexData& v0, const VertexData& v1) {
 				}
 				t += dt;
 			}
+		} else if (IsTextureFunctionPassthrough(v1.color0) && GetSpriteBlitState(&blitState, (u16)z)) {
+			u32 palette[256];
+			if (texfmt == GE_TFMT_CLUT8 || texfmt == GE_TFMT_CLUT4) {
+				const int paletteSize = texfmt == GE_TFMT_CLUT8 ? 256 : 16;
+				for (int i = 0; i < paletteSize; ++i)
+					palette[i] = LookupClutColor(gstate.transformClutIndex(i));
+			}
+
+			// Without texture alpha, the primitive's alpha passes straight through.
+			const bool useTextureAlpha = gstate.isTextureAlphaUsed();
+			const u32 primAlpha = (u32)std::max(0, std::min(v1.color0.a(), 255)) << 24;
+
+			u32 row[SPRITE_CHUNK_SIZE];
+			int t = t_start;
+			for (int y = pos0.y; y < pos1.y; y++) {
+				int s = s_start;
+				for (int x = pos0.x; x < pos1.x; x += SPRITE_CHUNK_SIZE) {
+					const int count = std::min(pos1.x - x, (int)SPRITE_CHUNK_SIZE);
+					FetchSpriteTexels(row, s, t, ds, count, texptr, texbufw, nearestFunc, palette);
+					if (!useTextureAlpha) {
+						for (int i = 0; i < count; ++i)
+							row[i] = (row[i] & 0x00FFFFFF) | primAlpha;
+					}
+					WriteSpriteRow(x, y, count, row, blitState);
+					s += ds * count;
+				}
+				t += dt;
+			}
 		} else {
 			int t = t_start;
 			for (int y = pos0.y; y < pos1.y; y++) {
@@ -173,8 +415,7 @@ void DrawSprite(const VertexData& v0, const VertexData& v1) {
 					Vec4<int> prim_color = v1.color0;
 					Vec4<int> tex_color = Vec4<int>::FromRGBA(nearestFunc(s, t, texptr, texbufw, 0));
 					prim_color = GetTextureFunctionOutput(prim_color, tex_color);
-					DrawingCoords pos(x, y, z);
-					DrawSinglePixelNonClear(pos, (u16)z, 1.0f, prim_color);
+					drawPixel(x, y, (u16)z, 1, prim_color);
 					s += ds;
 				}
 				t += dt;
@@ -209,12 +450,19 @@ void DrawSprite(const VertexData& v0, const VertexData& v1) {
 					pixel++;
 				}
 			}
+		} else if (GetSpriteBlitState(&blitState, (u16)z)) {
+			u32 row[SPRITE_CHUNK_SIZE];
+			std::fill(row, row + SPRITE_CHUNK_SIZE, v1.color0.Clamp(0, 255).ToRGBA());
+			for (int y = pos0.y; y < pos1.y; y++) {
+				for (int x = pos0.x; x < pos1.x; x += SPRITE_CHUNK_SIZE) {
+					WriteSpriteRow(x, y, std::min(pos1.x - x, (int)SPRITE_CHUNK_SIZE), row, blitState);
+				}
+			}
 		} else {
 			for (int y = pos0.y; y < pos1.y; y++) {
 				for (int x = pos0.x; x < pos1.x; x++) {
 					Vec4<int> prim_color = v1.color0;
-					DrawingCoords pos(x, y, z);
-					DrawSinglePixelNonClear(pos, (u16)z, fog, prim_color);
+					drawPixel(x, y, (u16)z, (u8)fog, prim_color);
 				}
 			}
 		}
@@ -230,7 +478,7 @@ static inline bool NoClampOrWrap(const Vec2f &tc) {
 }
 
 // Returns true if the normal path should be skipped.
-bool RectangleFastPath(const VertexData &v0, const VertexData &v1) {
+bool RectangleFastPath(const VertexData &v0, const VertexData &v1, BinManager &binner) {
 	g_DarkStalkerStretch = DSStretch::Off;
 	// Check for 1:1 texture mapping. In that case we can call DrawSprite.
 	int xdiff = v1.screenpos.x - v0.screenpos.x;
@@ -245,6 +493,7 @@ bool RectangleFastPath(const VertexData &v0, const VertexData &v1) {
 	// We already have a fast path for clear in ClearRectangle.
 	bool state_check = !gstate.isModeClear() && NoClampOrWrap(v0.texturecoords) && NoClampOrWrap(v1.texturecoords);
 	if ((coord_check || !gstate.isTextureMapEnabled()) && orient_check && state_check) {
+		binner.Drain();
 		Rasterizer::DrawSprite(v0, v1);
 		return true;
 	}
@@ -263,6 +512,7 @@ bool RectangleFastPath(const VertexData &v0, const VertexData &v1) {
 			}
 			if (g_needsClearAfterDialog) {
 				g_needsClearAfterDialog = false;
+				binner.Drain();
 				// Afterwards, we also need to clear the actual destination. Can do a fast rectfill.
 				gstate.textureMapEnable &= ~1;
 				VertexData newV1 = v1;
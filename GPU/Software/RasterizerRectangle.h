@@ -12,9 +12,12 @@
 // sense to specifically detect rectangles that do 1:1 texture mapping (like a sprite), because
 // the JIT will then be able to eliminate UV interpolation.
 
+class BinManager;
+
 namespace Rasterizer {
 	// Returns true if the normal path should be skipped.
-	bool RectangleFastPath(const VertexData &v0, const VertexData &v1);
+	// Drains the binner before drawing anything itself.
+	bool RectangleFastPath(const VertexData &v0, const VertexData &v1, BinManager &binner);
 
 	bool DetectRectangleFromThroughModeStrip(const VertexData data[4]);
 }
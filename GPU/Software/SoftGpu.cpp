@@ -36,6 +36,7 @@
 #include "Common/Profiler/Profiler.h"
 #include "Common/GPU/thin3d.h"
 
+#include "GPU/Software/DrawPixel.h"
 #include "GPU/Software/Rasterizer.h"
 #include "GPU/Software/Sampler.h"
 #include "GPU/Software/SoftGpu.h"
@@ -67,6 +68,7 @@ SoftGPU::SoftGPU(GraphicsContext *gfxCtx, Draw::DrawContext *draw)
 	displayFormat_ = GE_FORMAT_8888;
 
 	Sampler::Init();
+	Rasterizer::Init();
 	drawEngine_ = new SoftwareDrawEngine();
 	drawEngine_->Init();
 	drawEngineCommon_ = drawEngine_;
@@ -97,6 +99,9 @@ void SoftGPU::DeviceRestore() {
 }
 
 SoftGPU::~SoftGPU() {
+	// Workers may still be using the sampler jit.
+	FlushDraws();
+
 	if (fbTex) {
 		fbTex->Release();
 		fbTex = nullptr;
@@ -107,6 +112,7 @@ SoftGPU::~SoftGPU() {
 	}
 
 	Sampler::Shutdown();
+	Rasterizer::Shutdown();
 }
 
 void SoftGPU::SetDisplayFramebuffer(u32 framebuf, u32 stride, GEBufferFormat format) {
@@ -269,6 +275,7 @@ void SoftGPU::CopyToCurrentFboFromDisplayRam(int srcwidth, int srcheight) {
 }
 
 void SoftGPU::CopyDisplayToOutput(bool reallyDirty) {
+	FlushDraws();
 	// The display always shows 480x272.
 	CopyToCurrentFboFromDisplayRam(FB_WIDTH, FB_HEIGHT);
 	framebufferDirty_ = false;
@@ -297,6 +304,7 @@ void SoftGPU::FastRunLoop(DisplayList &list) {
 		u32 cmd = op >> 24;
 
 		u32 diff = op ^ gstate.cmdmem[cmd];
+		CheckFlushOp(cmd, diff);
 		gstate.cmdmem[cmd] = op;
 		ExecuteOp(op, diff);
 
@@ -304,6 +312,77 @@ void SoftGPU::FastRunLoop(DisplayList &list) {
 	}
 }
 
+// Queued triangles are rasterized later, against the live gstate.  So anything the rasterizer
+// reads must not change until they're drawn.  Vertex processing state is already baked in.
+static bool IsVertexOnlyCmd(int cmd) {
+	switch (cmd) {
+	case GE_CMD_BEZIER:
+	case GE_CMD_SPLINE:
+	case GE_CMD_PATCHDIVISION:
+	case GE_CMD_PATCHPRIMITIVE:
+	case GE_CMD_PATCHFACING:
+	case GE_CMD_PATCHCULLENABLE:
+	case GE_CMD_CULL:
+	case GE_CMD_CULLFACEENABLE:
+	case GE_CMD_REVERSENORMAL:
+	case GE_CMD_VIEWPORTXSCALE:
+	case GE_CMD_VIEWPORTYSCALE:
+	case GE_CMD_VIEWPORTZSCALE:
+	case GE_CMD_VIEWPORTXCENTER:
+	case GE_CMD_VIEWPORTYCENTER:
+	case GE_CMD_VIEWPORTZCENTER:
+	case GE_CMD_LIGHTINGENABLE:
+	case GE_CMD_LIGHTMODE:
+	case GE_CMD_MATERIALUPDATE:
+	case GE_CMD_AMBIENTCOLOR:
+	case GE_CMD_AMBIENTALPHA:
+	case GE_CMD_MATERIALDIFFUSE:
+	case GE_CMD_MATERIALEMISSIVE:
+	case GE_CMD_MATERIALAMBIENT:
+	case GE_CMD_MATERIALALPHA:
+	case GE_CMD_MATERIALSPECULAR:
+	case GE_CMD_MATERIALSPECULARCOEF:
+		return true;
+
+	default:
+		// Morph weights and all the per light parameters.
+		return (cmd >= GE_CMD_MORPHWEIGHT0 && cmd <= GE_CMD_MORPHWEIGHT7) ||
+			(cmd >= GE_CMD_LIGHTENABLE0 && cmd <= GE_CMD_LIGHTENABLE3) ||
+			(cmd >= GE_CMD_LIGHTTYPE0 && cmd <= GE_CMD_LIGHTTYPE3) ||
+			(cmd >= GE_CMD_LX0 && cmd <= GE_CMD_LSC3);
+	}
+}
+
+inline void SoftGPU::CheckFlushOp(int cmd, u32 diff) {
+	const u8 cmdFlags = cmdInfo_[cmd].flags;
+	if (cmd == GE_CMD_VERTEXTYPE) {
+		// Of the vertex format, only through mode matters to the rasterizer.
+		if (diff & GE_VTYPE_THROUGH_MASK)
+			FlushDraws();
+	} else if ((cmdFlags & FLAG_FLUSHBEFORE) || (diff && (cmdFlags & FLAG_FLUSHBEFOREONCHANGE))) {
+		if (!IsVertexOnlyCmd(cmd))
+			FlushDraws();
+	} else if (cmd == GE_CMD_LOADCLUT) {
+		// The clut is reloaded even when the address is the same.
+		FlushDraws();
+	} else if (diff && (cmd == GE_CMD_TEXLEVEL || (cmd >= GE_CMD_DITH0 && cmd <= GE_CMD_DITH3))) {
+		FlushDraws();
+	}
+}
+
+void SoftGPU::PreExecuteOp(u32 op, u32 diff) {
+	CheckFlushOp(op >> 24, diff);
+}
+
+void SoftGPU::FinishDeferred() {
+	// Lists end, stall, or wait on a signal here, so the CPU may look at the framebuffer next.
+	FlushDraws();
+}
+
+void SoftGPU::FlushDraws() {
+	drawEngine_->transformUnit.Flush();
+}
+
 void SoftGPU::ExecuteOp(u32 op, u32 diff) {
 	u32 cmd = op >> 24;
 	u32 data = op & 0xFFFFFF;
@@ -868,7 +947,9 @@ void SoftGPU::GetStats(char *buffer, size_t bufsize) {
 
 void SoftGPU::InvalidateCache(u32 addr, int size, GPUInvalidationType type)
 {
-	// Nothing to invalidate.
+	// Nothing to invalidate, but memory is about to be accessed, so finish any queued drawing.
+	SyncThread();
+	FlushDraws();
 }
 
 void SoftGPU::NotifyVideoUpload(u32 addr, int size, int width, int format)
@@ -926,6 +1007,7 @@ bool SoftGPU::FramebufferDirty() {
 }
 
 bool SoftGPU::GetCurrentFramebuffer(GPUDebugBuffer &buffer, GPUDebugFramebufferType type, int maxRes) {
+	FlushDraws();
 	int x1 = gstate.getRegionX1();
 	int y1 = gstate.getRegionY1();
 	int x2 = gstate.getRegionX2() + 1;
@@ -962,6 +1044,7 @@ bool SoftGPU::GetOutputFramebuffer(GPUDebugBuffer &buffer) {
 
 bool SoftGPU::GetCurrentDepthbuffer(GPUDebugBuffer &buffer)
 {
+	FlushDraws();
 	const int w = gstate.getRegionX2() - gstate.getRegionX1() + 1;
 	const int h = gstate.getRegionY2() - gstate.getRegionY1() + 1;
 	buffer.Allocate(w, h, GPU_DBG_FORMAT_16BIT);
@@ -979,6 +1062,7 @@ bool SoftGPU::GetCurrentDepthbuffer(GPUDebugBuffer &buffer)
 
 bool SoftGPU::GetCurrentStencilbuffer(GPUDebugBuffer &buffer)
 {
+	FlushDraws();
 	return Rasterizer::GetCurrentStencilbuffer(buffer);
 }
 
@@ -1008,5 +1092,9 @@ bool SoftGPU::DescribeCodePtr(const u8 *ptr, std::string &name) {
 		name = "SamplerJit:" + subname;
 		return true;
 	}
+	if (Rasterizer::DescribeCodePtr(ptr, subname)) {
+		name = "PixelJit:" + subname;
+		return true;
+	}
 	return false;
 }
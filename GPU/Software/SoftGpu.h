@@ -48,6 +48,10 @@ struct FormatBuffer {
 	inline u16 *Get16Ptr(int x, int y, int stride) {
 		return &as16[x + y * stride];
 	}
+
+	inline u32 *Get32Ptr(int x, int y, int stride) {
+		return &as32[x + y * stride];
+	}
 };
 
 class PresentationCommon;
@@ -60,6 +64,7 @@ class SoftGPU : public GPUCommon {
 
 	void CheckGPUFeatures() override {}
 	void InitClear() override {}
+	void PreExecuteOp(u32 op, u32 diff) override;
 	void ExecuteOp(u32 op, u32 diff) override;
 
 	void SetDisplayFramebuffer(u32 framebuf, u32 stride, GEBufferFormat format) override;
@@ -101,6 +106,9 @@ class SoftGPU : public GPUCommon {
 
 protected:
 	void FastRunLoop(DisplayList &list) override;
+	void FinishDeferred() override;
+	void CheckFlushOp(int cmd, u32 diff);
+	void FlushDraws();
 	void CopyToCurrentFboFromDisplayRam(int srcwidth, int srcheight);
 	void ConvertTextureDescFrom16(Draw::TextureDesc &desc, int srcwidth, int srcheight, u8 *overrideData = nullptr);
 
@@ -21,13 +21,17 @@
 #include "Common/CPUDetect.h"
 #include "Common/Math/math_util.h"
 #include "Common/MemoryUtil.h"
+#include "Common/TimeUtil.h"
 #include "Core/Config.h"
+#include "Core/System.h"
+#include "GPU/GPU.h"
 #include "GPU/GPUState.h"
 #include "GPU/Common/DrawEngineCommon.h"
 #include "GPU/Common/VertexDecoderCommon.h"
 #include "GPU/Common/SplineCommon.h"
 #include "GPU/Debugger/Debugger.h"
 #include "GPU/Software/TransformUnit.h"
+#include "GPU/Software/BinManager.h"
 #include "GPU/Software/Clipper.h"
 #include "GPU/Software/Lighting.h"
 #include "GPU/Software/RasterizerRectangle.h"
@@ -36,10 +40,13 @@
 
 TransformUnit::TransformUnit() {
 	buf = (u8 *)AllocateMemoryPages(TRANSFORM_BUF_SIZE, MEM_PROT_READ | MEM_PROT_WRITE);
+	binner_ = new BinManager();
 }
 
 TransformUnit::~TransformUnit() {
 	FreeMemoryPages(buf, DECODED_VERTEX_BUFFER_SIZE);
+	FreeAlignedMemory(vertexCache_);
+	delete binner_;
 }
 
 SoftwareDrawEngine::SoftwareDrawEngine() {
@@ -156,15 +163,99 @@ ScreenCoords TransformUnit::DrawingToScreen(const DrawingCoords& coords)
 	return ret;
 }
 
-VertexData TransformUnit::ReadVertex(VertexReader& vreader)
-{
+// Everything about the vertex transform that stays the same for a whole draw.
+struct TransformState {
+	Lighting::State lightingState;
+
+	// Matrix columns, translation last.
+	Vec3f worldMatrix[4];
+	Vec3f viewMatrix[4];
+	Vec4f projMatrix[4];
+	Vec3f tgenMatrix[4];
+	Vec3f boneMatrix[8][4];
+
+	float fogEnd;
+	float fogSlope;
+
+	bool readUV;
+	bool negateNormals;
+	bool enableSkinning;
+	int numBoneWeights;
+	bool enableFog;
+	bool enableTextureMatrix;
+	GETexProjMapMode uvProjMode;
+};
+
+static void LoadMatrix4x3(Vec3f columns[4], const float *m) {
+	for (int i = 0; i < 4; ++i)
+		columns[i] = Vec3f(m[i * 3 + 0], m[i * 3 + 1], m[i * 3 + 2]);
+}
+
+static void LoadMatrix4x4(Vec4f columns[4], const float *m) {
+	for (int i = 0; i < 4; ++i)
+		columns[i] = Vec4f(m[i * 4 + 0], m[i * 4 + 1], m[i * 4 + 2], m[i * 4 + 3]);
+}
+
+// Same math and rounding as Mat3x3 * vec + translation, but a column at a time so it vectorizes.
+static inline Vec3f TransformPoint(const Vec3f m[4], const Vec3f &v) {
+	return m[0] * v.x + m[1] * v.y + m[2] * v.z + m[3];
+}
+
+static inline Vec3f TransformNormal(const Vec3f m[4], const Vec3f &v) {
+	return m[0] * v.x + m[1] * v.y + m[2] * v.z;
+}
+
+static inline Vec4f TransformProjection(const Vec4f m[4], const Vec3f &v) {
+	// The w of 1.0 just adds the last column.
+	return m[0] * v.x + m[1] * v.y + m[2] * v.z + m[3];
+}
+
+static void ComputeTransformState(TransformState *state, const VertexReader &vreader) {
+	state->readUV = !gstate.isModeClear() && gstate.isTextureMapEnabled() && vreader.hasUV();
+	state->negateNormals = gstate.areNormalsReversed();
+	state->enableSkinning = vertTypeIsSkinningEnabled(gstate.vertType) && !gstate.isModeThrough();
+	state->numBoneWeights = vertTypeGetNumBoneWeights(gstate.vertType);
+	state->enableFog = gstate.isFogEnabled();
+	state->enableTextureMatrix = gstate.getUVGenMode() == GE_TEXMAP_TEXTURE_MATRIX;
+	state->uvProjMode = gstate.getUVProjMode();
+
+	// Through mode vertices skip everything below.
+	if (gstate.isModeThrough())
+		return;
+
+	LoadMatrix4x3(state->worldMatrix, gstate.worldMatrix);
+	LoadMatrix4x3(state->viewMatrix, gstate.viewMatrix);
+	LoadMatrix4x4(state->projMatrix, gstate.projMatrix);
+	LoadMatrix4x3(state->tgenMatrix, gstate.tgenMatrix);
+	if (state->enableSkinning) {
+		for (int i = 0; i < state->numBoneWeights; ++i)
+			LoadMatrix4x3(state->boneMatrix[i], &gstate.boneMatrix[12 * i]);
+	}
+
+	float fog_end = getFloat24(gstate.fog1);
+	float fog_slope = getFloat24(gstate.fog2);
+	// Same fixup as in ShaderManagerGLES.cpp
+	if (my_isnanorinf(fog_end)) {
+		// Not really sure what a sensible value might be, but let's try 64k.
+		fog_end = std::signbit(fog_end) ? -65535.0f : 65535.0f;
+	}
+	if (my_isnanorinf(fog_slope)) {
+		fog_slope = std::signbit(fog_slope) ? -65535.0f : 65535.0f;
+	}
+	state->fogEnd = fog_end;
+	state->fogSlope = fog_slope;
+
+	Lighting::ComputeState(&state->lightingState, vreader.hasColor0());
+}
+
+VertexData TransformUnit::ReadVertex(VertexReader &vreader, const TransformState &state) {
 	VertexData vertex;
 
 	float pos[3];
 	// VertexDecoder normally scales z, but we want it unscaled.
 	vreader.ReadPosThroughZ16(pos);
 
-	if (!gstate.isModeClear() && gstate.isTextureMapEnabled() && vreader.hasUV()) {
+	if (state.readUV) {
 		float uv[2];
 		vreader.ReadUV(uv);
 		vertex.texturecoords = Vec2<float>(uv[0], uv[1]);
@@ -175,22 +266,21 @@ VertexData TransformUnit::ReadVertex(VertexReader& vreader)
 		vreader.ReadNrm(normal);
 		vertex.normal = Vec3<float>(normal[0], normal[1], normal[2]);
 
-		if (gstate.areNormalsReversed())
+		if (state.negateNormals)
 			vertex.normal = -vertex.normal;
 	}
 
-	if (vertTypeIsSkinningEnabled(gstate.vertType) && !gstate.isModeThrough()) {
+	if (state.enableSkinning) {
 		float W[8] = { 1.f, 0.f, 0.f, 0.f, 0.f, 0.f, 0.f, 0.f };
 		vreader.ReadWeights(W);
 
 		Vec3<float> tmppos(0.f, 0.f, 0.f);
 		Vec3<float> tmpnrm(0.f, 0.f, 0.f);
 
-		for (int i = 0; i < vertTypeGetNumBoneWeights(gstate.vertType); ++i) {
-			Mat3x3<float> bone(&gstate.boneMatrix[12*i]);
-			tmppos += (bone * ModelCoords(pos[0], pos[1], pos[2]) + Vec3<float>(gstate.boneMatrix[12*i+9], gstate.boneMatrix[12*i+10], gstate.boneMatrix[12*i+11])) * W[i];
+		for (int i = 0; i < state.numBoneWeights; ++i) {
+			tmppos += TransformPoint(state.boneMatrix[i], ModelCoords(pos[0], pos[1], pos[2])) * W[i];
 			if (vreader.hasNormal())
-				tmpnrm += (bone * vertex.normal) * W[i];
+				tmpnrm += TransformNormal(state.boneMatrix[i], vertex.normal) * W[i];
 		}
 
 		pos[0] = tmppos.x;
@@ -218,37 +308,27 @@ VertexData TransformUnit::ReadVertex(VertexReader& vreader)
 
 	if (!gstate.isModeThrough()) {
 		vertex.modelpos = ModelCoords(pos[0], pos[1], pos[2]);
-		vertex.worldpos = WorldCoords(TransformUnit::ModelToWorld(vertex.modelpos));
-		ModelCoords viewpos = TransformUnit::WorldToView(vertex.worldpos);
-		vertex.clippos = ClipCoords(TransformUnit::ViewToClip(viewpos));
-		if (gstate.isFogEnabled()) {
-			float fog_end = getFloat24(gstate.fog1);
-			float fog_slope = getFloat24(gstate.fog2);
-			// Same fixup as in ShaderManagerGLES.cpp
-			if (my_isnanorinf(fog_end)) {
-				// Not really sure what a sensible value might be, but let's try 64k.
-				fog_end = std::signbit(fog_end) ? -65535.0f : 65535.0f;
-			}
-			if (my_isnanorinf(fog_slope)) {
-				fog_slope = std::signbit(fog_slope) ? -65535.0f : 65535.0f;
-			}
-			vertex.fogdepth = (viewpos.z + fog_end) * fog_slope;
+		vertex.worldpos = WorldCoords(TransformPoint(state.worldMatrix, vertex.modelpos));
+		ModelCoords viewpos = TransformPoint(state.viewMatrix, vertex.worldpos);
+		vertex.clippos = ClipCoords(TransformProjection(state.projMatrix, viewpos));
+		if (state.enableFog) {
+			vertex.fogdepth = (viewpos.z + state.fogEnd) * state.fogSlope;
 		} else {
 			vertex.fogdepth = 1.0f;
 		}
 		vertex.screenpos = ClipToScreenInternal(vertex.clippos, &outside_range_flag);
 
 		if (vreader.hasNormal()) {
-			vertex.worldnormal = TransformUnit::ModelToWorldNormal(vertex.normal);
+			vertex.worldnormal = TransformNormal(state.worldMatrix, vertex.normal);
 			vertex.worldnormal /= vertex.worldnormal.Length();
 		} else {
 			vertex.worldnormal = Vec3<float>(0.0f, 0.0f, 1.0f);
 		}
 
 		// Time to generate some texture coords.  Lighting will handle shade mapping.
-		if (gstate.getUVGenMode() == GE_TEXMAP_TEXTURE_MATRIX) {
+		if (state.enableTextureMatrix) {
 			Vec3f source;
-			switch (gstate.getUVProjMode()) {
+			switch (state.uvProjMode) {
 			case GE_PROJMAP_POSITION:
 				source = vertex.modelpos;
 				break;
@@ -267,18 +347,17 @@ VertexData TransformUnit::ReadVertex(VertexReader& vreader)
 
 			default:
 				source = Vec3f::AssignToAll(0.0f);
-				ERROR_LOG_REPORT(G3D, "Software: Unsupported UV projection mode %x", gstate.getUVProjMode());
+				ERROR_LOG_REPORT(G3D, "Software: Unsupported UV projection mode %x", state.uvProjMode);
 				break;
 			}
 
 			// TODO: What about uv scale and offset?
-			Mat3x3<float> tgen(gstate.tgenMatrix);
-			Vec3<float> stq = tgen * source + Vec3<float>(gstate.tgenMatrix[9], gstate.tgenMatrix[10], gstate.tgenMatrix[11]);
+			Vec3<float> stq = TransformPoint(state.tgenMatrix, source);
 			float z_recip = 1.0f / stq.z;
 			vertex.texturecoords = Vec2f(stq.x * z_recip, stq.y * z_recip);
 		}
 
-		Lighting::Process(vertex, vreader.hasColor0());
+		Lighting::Process(vertex, state.lightingState);
 	} else {
 		vertex.screenpos.x = (int)(pos[0] * 16) + gstate.getOffsetX16();
 		vertex.screenpos.y = (int)(pos[1] * 16) + gstate.getOffsetY16();
@@ -320,10 +399,55 @@ void TransformUnit::SubmitPrimitive(void* vertices, void* indices, GEPrimitiveTy
 
 	if (indices)
 		GetIndexBounds(indices, vertex_count, vertex_type, &index_lower_bound, &index_upper_bound);
+	// Initialized to avoid a race condition with bShowDebugStats changing.
+	double start = 0.0;
+	if (coreCollectDebugStats) {
+		start = time_now_d();
+	}
 	vdecoder.DecodeVerts(buf, vertices, index_lower_bound, index_upper_bound);
+	if (coreCollectDebugStats) {
+		// Everything after the decode (transform, clipping, binning, drawing) counts as rasterizing.
+		double decoded = time_now_d();
+		gpuStats.msDecodingVertices += decoded - start;
+		start = decoded;
+	}
 
 	VertexReader vreader(buf, vtxfmt, vertex_type);
 
+	TransformState transformState;
+	ComputeTransformState(&transformState, vreader);
+
+	// Indexed draws often reuse vertices, so only transform each one once.
+	const int cacheSize = indices ? index_upper_bound - index_lower_bound + 1 : 0;
+	if (cacheSize > vertexCacheCapacity_) {
+		FreeAlignedMemory(vertexCache_);
+		vertexCacheCapacity_ = std::max(cacheSize, 1024);
+		vertexCache_ = (VertexData *)AllocateAlignedMemory(vertexCacheCapacity_ * sizeof(VertexData), 16);
+	}
+	vertexCacheStatus_.assign(cacheSize, VERTEX_NOT_CACHED);
+
+	auto readVertex = [&](int vtx) -> VertexData {
+		if (!indices) {
+			vreader.Goto(vtx);
+			return ReadVertex(vreader, transformState);
+		}
+
+		const int index = ConvertIndex(vtx) - index_lower_bound;
+		u8 &status = vertexCacheStatus_[index];
+		if (status == VERTEX_NOT_CACHED) {
+			// The flag is only cleared when a prim is culled, so track this vertex separately.
+			const bool wasOutside = outside_range_flag;
+			outside_range_flag = false;
+			vreader.Goto(index);
+			vertexCache_[index] = ReadVertex(vreader, transformState);
+			status = outside_range_flag ? VERTEX_CACHED_OUTSIDE : VERTEX_CACHED;
+			outside_range_flag = outside_range_flag || wasOutside;
+		} else if (status == VERTEX_CACHED_OUTSIDE) {
+			outside_range_flag = true;
+		}
+		return vertexCache_[index];
+	};
+
 	static VertexData data[4];  // Normally max verts per prim is 3, but we temporarily need 4 to detect rectangles from strips.
 	// This is the index of the next vert in data (or higher, may need modulus.)
 	static int data_index = 0;
@@ -345,9 +469,6 @@ void TransformUnit::SubmitPrimitive(void* vertices, void* indices, GEPrimitiveTy
 	default: vtcs_per_prim = 0; break;
 	}
 
-	// TODO: Do this in two passes - first process the vertices (before indexing/stripping),
-	// then resolve the indices. This lets us avoid transforming shared vertices twice.
-
 	switch (prim_type) {
 	case GE_PRIM_POINTS:
 	case GE_PRIM_LINES:
@@ -355,13 +476,7 @@ void TransformUnit::SubmitPrimitive(void* vertices, void* indices, GEPrimitiveTy
 	case GE_PRIM_RECTANGLES:
 		{
 			for (int vtx = 0; vtx < vertex_count; ++vtx) {
-				if (indices) {
-					vreader.Goto(ConvertIndex(vtx) - index_lower_bound);
-				} else {
-					vreader.Goto(vtx);
-				}
-
-				data[data_index++] = ReadVertex(vreader);
+				data[data_index++] = readVertex(vtx);
 				if (data_index < vtcs_per_prim) {
 					// Keep reading.  Note: an incomplete prim will stay read for GE_PRIM_KEEP_PREVIOUS.
 					continue;
@@ -379,26 +494,26 @@ void TransformUnit::SubmitPrimitive(void* vertices, void* indices, GEPrimitiveTy
 				case GE_PRIM_TRIANGLES:
 				{
 					if (!gstate.isCullEnabled() || gstate.isModeClear()) {
-						Clipper::ProcessTriangle(data[0], data[1], data[2], data[2]);
-						Clipper::ProcessTriangle(data[2], data[1], data[0], data[2]);
+						Clipper::ProcessTriangle(data[0], data[1], data[2], data[2], *binner_);
+						Clipper::ProcessTriangle(data[2], data[1], data[0], data[2], *binner_);
 					} else if (!gstate.getCullMode()) {
-						Clipper::ProcessTriangle(data[2], data[1], data[0], data[2]);
+						Clipper::ProcessTriangle(data[2], data[1], data[0], data[2], *binner_);
 					} else {
-						Clipper::ProcessTriangle(data[0], data[1], data[2], data[2]);
+						Clipper::ProcessTriangle(data[0], data[1], data[2], data[2], *binner_);
 					}
 					break;
 				}
 
 				case GE_PRIM_RECTANGLES:
-					Clipper::ProcessRect(data[0], data[1]);
+					Clipper::ProcessRect(data[0], data[1], *binner_);
 					break;
 
 				case GE_PRIM_LINES:
-					Clipper::ProcessLine(data[0], data[1]);
+					Clipper::ProcessLine(data[0], data[1], *binner_);
 					break;
 
 				case GE_PRIM_POINTS:
-					Clipper::ProcessPoint(data[0]);
+					Clipper::ProcessPoint(data[0], *binner_);
 					break;
 
 				default:
@@ -414,13 +529,7 @@ void TransformUnit::SubmitPrimitive(void* vertices, void* indices, GEPrimitiveTy
 			// If data_index is 1 or 2, etc., it means we're continuing a line strip.
 			int skip_count = data_index == 0 ? 1 : 0;
 			for (int vtx = 0; vtx < vertex_count; ++vtx) {
-				if (indices) {
-					vreader.Goto(ConvertIndex(vtx) - index_lower_bound);
-				} else {
-					vreader.Goto(vtx);
-				}
-
-				data[(data_index++) & 1] = ReadVertex(vreader);
+				data[(data_index++) & 1] = readVertex(vtx);
 				if (outside_range_flag) {
 					// Drop all primitives containing the current vertex
 					skip_count = 2;
@@ -432,7 +541,7 @@ void TransformUnit::SubmitPrimitive(void* vertices, void* indices, GEPrimitiveTy
 					--skip_count;
 				} else {
 					// We already incremented data_index, so data_index & 1 is previous one.
-					Clipper::ProcessLine(data[data_index & 1], data[(data_index & 1) ^ 1]);
+					Clipper::ProcessLine(data[data_index & 1], data[(data_index & 1) ^ 1], *binner_);
 				}
 			}
 			break;
@@ -447,31 +556,19 @@ void TransformUnit::SubmitPrimitive(void* vertices, void* indices, GEPrimitiveTy
 			// This is for Darkstalkers (and should speed up many 2D games).
 			if (vertex_count == 4 && gstate.isModeThrough()) {
 				for (int vtx = 0; vtx < 4; ++vtx) {
-					if (indices) {
-						vreader.Goto(ConvertIndex(vtx) - index_lower_bound);
-					}
-					else {
-						vreader.Goto(vtx);
-					}
-					data[vtx] = ReadVertex(vreader);
+					data[vtx] = readVertex(vtx);
 				}
 
 				// If a strip is effectively a rectangle, draw it as such!
 				if (Rasterizer::DetectRectangleFromThroughModeStrip(data)) {
-					Clipper::ProcessRect(data[0], data[3]);
+					Clipper::ProcessRect(data[0], data[3], *binner_);
 					break;
 				}
 			}
 
 			for (int vtx = 0; vtx < vertex_count; ++vtx) {
-				if (indices) {
-					vreader.Goto(ConvertIndex(vtx) - index_lower_bound);
-				} else {
-					vreader.Goto(vtx);
-				}
-
 				int provoking_index = (data_index++) % 3;
-				data[provoking_index] = ReadVertex(vreader);
+				data[provoking_index] = readVertex(vtx);
 				if (outside_range_flag) {
 					// Drop all primitives containing the current vertex
 					skip_count = 2;
@@ -485,14 +582,14 @@ void TransformUnit::SubmitPrimitive(void* vertices, void* indices, GEPrimitiveTy
 				}
 
 				if (!gstate.isCullEnabled() || gstate.isModeClear()) {
-					Clipper::ProcessTriangle(data[0], data[1], data[2], data[provoking_index]);
-					Clipper::ProcessTriangle(data[2], data[1], data[0], data[provoking_index]);
+					Clipper::ProcessTriangle(data[0], data[1], data[2], data[provoking_index], *binner_);
+					Clipper::ProcessTriangle(data[2], data[1], data[0], data[provoking_index], *binner_);
 				} else if ((!gstate.getCullMode()) ^ ((data_index - 1) % 2)) {
 					// We need to reverse the vertex order for each second primitive,
 					// but we additionally need to do that for every primitive if CCW cullmode is used.
-					Clipper::ProcessTriangle(data[2], data[1], data[0], data[provoking_index]);
+					Clipper::ProcessTriangle(data[2], data[1], data[0], data[provoking_index], *binner_);
 				} else {
-					Clipper::ProcessTriangle(data[0], data[1], data[2], data[provoking_index]);
+					Clipper::ProcessTriangle(data[0], data[1], data[2], data[provoking_index], *binner_);
 				}
 			}
 			break;
@@ -507,25 +604,14 @@ void TransformUnit::SubmitPrimitive(void* vertices, void* indices, GEPrimitiveTy
 
 			// Only read the central vertex if we're not continuing.
 			if (data_index == 0) {
-				if (indices) {
-					vreader.Goto(ConvertIndex(0) - index_lower_bound);
-				} else {
-					vreader.Goto(0);
-				}
-				data[0] = ReadVertex(vreader);
+				data[0] = readVertex(0);
 				data_index++;
 				start_vtx = 1;
 			}
 
 			for (int vtx = start_vtx; vtx < vertex_count; ++vtx) {
-				if (indices) {
-					vreader.Goto(ConvertIndex(vtx) - index_lower_bound);
-				} else {
-					vreader.Goto(vtx);
-				}
-
 				int provoking_index = 2 - ((data_index++) % 2);
-				data[provoking_index] = ReadVertex(vreader);
+				data[provoking_index] = readVertex(vtx);
 				if (outside_range_flag) {
 					// Drop all primitives containing the current vertex
 					skip_count = 2;
@@ -539,14 +625,14 @@ void TransformUnit::SubmitPrimitive(void* vertices, void* indices, GEPrimitiveTy
 				}
 
 				if (!gstate.isCullEnabled() || gstate.isModeClear()) {
-					Clipper::ProcessTriangle(data[0], data[1], data[2], data[provoking_index]);
-					Clipper::ProcessTriangle(data[2], data[1], data[0], data[provoking_index]);
+					Clipper::ProcessTriangle(data[0], data[1], data[2], data[provoking_index], *binner_);
+					Clipper::ProcessTriangle(data[2], data[1], data[0], data[provoking_index], *binner_);
 				} else if ((!gstate.getCullMode()) ^ ((data_index - 1) % 2)) {
 					// We need to reverse the vertex order for each second primitive,
 					// but we additionally need to do that for every primitive if CCW cullmode is used.
-					Clipper::ProcessTriangle(data[2], data[1], data[0], data[provoking_index]);
+					Clipper::ProcessTriangle(data[2], data[1], data[0], data[provoking_index], *binner_);
 				} else {
-					Clipper::ProcessTriangle(data[0], data[1], data[2], data[provoking_index]);
+					Clipper::ProcessTriangle(data[0], data[1], data[2], data[provoking_index], *binner_);
 				}
 			}
 			break;
@@ -557,9 +643,23 @@ void TransformUnit::SubmitPrimitive(void* vertices, void* indices, GEPrimitiveTy
 		break;
 	}
 
+	if (coreCollectDebugStats) {
+		gpuStats.msRasterizing += time_now_d() - start;
+	}
+
 	GPUDebug::NotifyDraw();
 }
 
+void TransformUnit::Flush() {
+	if (coreCollectDebugStats) {
+		double start = time_now_d();
+		binner_->Drain();
+		gpuStats.msRasterizing += time_now_d() - start;
+	} else {
+		binner_->Drain();
+	}
+}
+
 // TODO: This probably is not the best interface.
 // Also, we should try to merge this into the similar function in DrawEngineCommon.
 bool TransformUnit::GetCurrentSimpleVertices(int count, std::vector<GPUDebugVertex> &vertices, std::vector<u16> &indices) {
@@ -113,7 +113,9 @@ struct VertexData
 };
 
 class VertexReader;
+struct TransformState;
 
+class BinManager;
 class SoftwareDrawEngine;
 
 class TransformUnit {
@@ -132,10 +134,27 @@ class TransformUnit {
 	void SubmitPrimitive(void* vertices, void* indices, GEPrimitiveType prim_type, int vertex_count, u32 vertex_type, int *bytesRead, SoftwareDrawEngine *drawEngine);
 
 	bool GetCurrentSimpleVertices(int count, std::vector<GPUDebugVertex> &vertices, std::vector<u16> &indices);
-	VertexData ReadVertex(VertexReader& vreader);
+	VertexData ReadVertex(VertexReader &vreader, const TransformState &state);
+
+	// Finishes drawing everything submitted so far.
+	void Flush();
 
 	bool outside_range_flag = false;
 	u8 *buf;
+
+private:
+	enum {
+		VERTEX_NOT_CACHED,
+		VERTEX_CACHED,
+		VERTEX_CACHED_OUTSIDE,
+	};
+
+	BinManager *binner_;
+
+	// Transformed vertices of the current indexed draw, by index from the lower bound.
+	VertexData *vertexCache_ = nullptr;
+	int vertexCacheCapacity_ = 0;
+	std::vector<u8> vertexCacheStatus_;
 };
 
 class SoftwareDrawEngine : public DrawEngineCommon {
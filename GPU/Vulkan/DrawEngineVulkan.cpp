@@ -56,11 +56,8 @@ enum {
 	VERTEX_CACHE_SIZE = 8192 * 1024
 };
 
-#define VERTEXCACHE_DECIMATION_INTERVAL 17
 #define DESCRIPTORSET_DECIMATION_INTERVAL 1  // Temporarily cut to 1. Handle reuse breaks this when textures get deleted.
 
-enum { VAI_KILL_AGE = 120, VAI_UNRELIABLE_KILL_AGE = 240, VAI_UNRELIABLE_KILL_MAX = 4 };
-
 enum {
 	DRAW_BINDING_TEXTURE = 0,
 	DRAW_BINDING_2ND_TEXTURE = 1,
@@ -309,18 +306,9 @@ void DrawEngineVulkan::BeginFrame() {
 	if (--decimationCounter_ <= 0) {
 		decimationCounter_ = VERTEXCACHE_DECIMATION_INTERVAL;
 
-		const int threshold = gpuStats.numFlips - VAI_KILL_AGE;
-		const int unreliableThreshold = gpuStats.numFlips - VAI_UNRELIABLE_KILL_AGE;
 		int unreliableLeft = VAI_UNRELIABLE_KILL_MAX;
 		vai_.Iterate([&](uint32_t hash, VertexArrayInfoVulkan *vai) {
-			bool kill;
-			if (vai->status == VertexArrayInfoVulkan::VAI_UNRELIABLE) {
-				// We limit killing unreliable so we don't rehash too often.
-				kill = vai->lastFrame < unreliableThreshold && --unreliableLeft >= 0;
-			} else {
-				kill = vai->lastFrame < threshold;
-			}
-			if (kill) {
+			if (ShouldDecimateVertexArray(vai, unreliableLeft)) {
 				// This is actually quite safe.
 				vai_.Remove(hash);
 				delete vai;
@@ -628,18 +616,13 @@ void DrawEngineVulkan::DoFlush() {
 		int maxIndex;
 		bool useElements = true;
 
-		// Cannot cache vertex data with morph enabled.
-		bool useCache = g_Config.bVertexCache && !(lastVType_ & GE_VTYPE_MORPHCOUNT_MASK);
-		// Also avoid caching when software skinning.
+		bool useCache = CanUseVertexCache();
 		VkBuffer vbuf = VK_NULL_HANDLE;
 		VkBuffer ibuf = VK_NULL_HANDLE;
-		if (g_Config.bSoftwareSkinning && (lastVType_ & GE_VTYPE_WEIGHT_MASK)) {
-			useCache = false;
-		}
 
 		if (useCache) {
 			PROFILE_THIS_SCOPE("vcache");
-			u32 id = dcid_ ^ gstate.getUVGenMode();  // This can have an effect on which UV decoder we need to use! And hence what the decoded data will look like. See #9263
+			u32 id = ComputeVertexCacheID();
 			VertexArrayInfoVulkan *vai = vai_.Get(id);
 			if (!vai) {
 				vai = new VertexArrayInfoVulkan();
@@ -650,16 +633,9 @@ void DrawEngineVulkan::DoFlush() {
 			case VertexArrayInfoVulkan::VAI_NEW:
 			{
 				// Haven't seen this one before. We don't actually upload the vertex data yet.
-				uint64_t dataHash = ComputeHash();
-				vai->hash = dataHash;
-				vai->minihash = ComputeMiniHash();
-				vai->status = VertexArrayInfoVulkan::VAI_HASHING;
-				vai->drawsUntilNextFullHash = 0;
+				StartHashingVertexArray(vai);
 				DecodeVertsToPushBuffer(frame->pushVertex, &vbOffset, &vbuf);  // writes to indexGen
-				vai->numVerts = indexGen.VertexCount();
-				vai->prim = indexGen.Prim();
-				vai->maxIndex = indexGen.MaxIndex();
-				vai->flags = gstate_c.vertexFullAlpha ? VAIVULKAN_FLAG_VERTEXFULLALPHA : 0;
+				SaveVertexArrayDraw(vai);
 				goto rotateVBO;
 			}
 
@@ -668,51 +644,18 @@ void DrawEngineVulkan::DoFlush() {
 			case VertexArrayInfoVulkan::VAI_HASHING:
 			{
 				PROFILE_THIS_SCOPE("vcachehash");
-				vai->numDraws++;
-				if (vai->lastFrame != gpuStats.numFlips) {
-					vai->numFrames++;
-				}
-				if (vai->drawsUntilNextFullHash == 0) {
-					// Let's try to skip a full hash if mini would fail.
-					const u32 newMiniHash = ComputeMiniHash();
-					uint64_t newHash = vai->hash;
-					if (newMiniHash == vai->minihash) {
-						newHash = ComputeHash();
-					}
-					if (newMiniHash != vai->minihash || newHash != vai->hash) {
-						MarkUnreliable(vai);
-						DecodeVertsToPushBuffer(frame->pushVertex, &vbOffset, &vbuf);
-						goto rotateVBO;
-					}
-					if (vai->numVerts > 64) {
-						// exponential backoff up to 16 draws, then every 24
-						vai->drawsUntilNextFullHash = std::min(24, vai->numFrames);
-					} else {
-						// Lower numbers seem much more likely to change.
-						vai->drawsUntilNextFullHash = 0;
-					}
-					// TODO: tweak
-					//if (vai->numFrames > 1000) {
-					//	vai->status = VertexArrayInfo::VAI_RELIABLE;
-					//}
-				} else {
-					vai->drawsUntilNextFullHash--;
-					u32 newMiniHash = ComputeMiniHash();
-					if (newMiniHash != vai->minihash) {
-						MarkUnreliable(vai);
-						DecodeVertsToPushBuffer(frame->pushVertex, &vbOffset, &vbuf);
-						goto rotateVBO;
-					}
+				CountVertexArrayDraw(vai);
+				if (!CheckVertexArrayHash(vai)) {
+					MarkUnreliable(vai);
+					DecodeVertsToPushBuffer(frame->pushVertex, &vbOffset, &vbuf);
+					goto rotateVBO;
 				}
 
 				if (!vai->vb) {
 					// Directly push to the vertex cache.
 					DecodeVertsToPushBuffer(vertexCache_, &vai->vbOffset, &vai->vb);
 					_dbg_assert_msg_(gstate_c.vertBounds.minV >= gstate_c.vertBounds.maxV, "Should not have checked UVs when caching.");
-					vai->numVerts = indexGen.VertexCount();
-					vai->prim = indexGen.Prim();
-					vai->maxIndex = indexGen.MaxIndex();
-					vai->flags = gstate_c.vertexFullAlpha ? VAIVULKAN_FLAG_VERTEXFULLALPHA : 0;
+					SaveVertexArrayDraw(vai);
 					useElements = !indexGen.SeenOnlyPurePrims();
 					if (!useElements && indexGen.PureCount()) {
 						vai->numVerts = indexGen.PureCount();
@@ -729,7 +672,7 @@ void DrawEngineVulkan::DoFlush() {
 					gpuStats.numCachedDrawCalls++;
 					useElements = vai->ib ? true : false;
 					gpuStats.numCachedVertsDrawn += vai->numVerts;
-					gstate_c.vertexFullAlpha = vai->flags & VAIVULKAN_FLAG_VERTEXFULLALPHA;
+					gstate_c.vertexFullAlpha = vai->flags & VAI_FLAG_VERTEXFULLALPHA;
 				}
 				vbuf = vai->vb;
 				ibuf = vai->ib;
@@ -744,10 +687,7 @@ void DrawEngineVulkan::DoFlush() {
 			// Reliable - we don't even bother hashing anymore. Right now we don't go here until after a very long time.
 			case VertexArrayInfoVulkan::VAI_RELIABLE:
 			{
-				vai->numDraws++;
-				if (vai->lastFrame != gpuStats.numFlips) {
-					vai->numFrames++;
-				}
+				CountVertexArrayDraw(vai);
 				gpuStats.numCachedDrawCalls++;
 				gpuStats.numCachedVertsDrawn += vai->numVerts;
 				vbuf = vai->vb;
@@ -758,16 +698,13 @@ void DrawEngineVulkan::DoFlush() {
 				maxIndex = vai->maxIndex;
 				prim = static_cast<GEPrimitiveType>(vai->prim);
 
-				gstate_c.vertexFullAlpha = vai->flags & VAIVULKAN_FLAG_VERTEXFULLALPHA;
+				gstate_c.vertexFullAlpha = vai->flags & VAI_FLAG_VERTEXFULLALPHA;
 				break;
 			}
 
 			case VertexArrayInfoVulkan::VAI_UNRELIABLE:
 			{
-				vai->numDraws++;
-				if (vai->lastFrame != gpuStats.numFlips) {
-					vai->numFrames++;
-				}
+				CountVertexArrayDraw(vai);
 				DecodeVertsToPushBuffer(frame->pushVertex, &vbOffset, &vbuf);
 				goto rotateVBO;
 			}
@@ -373,6 +373,7 @@ static const JitDisableFlag jitDisableFlags[] = {
 	{ MIPSComp::JitDisable::CACHE_POINTERS, "Cached pointers" },
 	{ MIPSComp::JitDisable::REGALLOC_GPR, "GPR Regalloc across instructions" },
 	{ MIPSComp::JitDisable::REGALLOC_FPR, "FPR Regalloc across instructions" },
+	{ MIPSComp::JitDisable::IDLE_LOOP, "Idle loop skipping" },
 };
 
 void JitDebugScreen::CreateViews() {
@@ -939,6 +940,7 @@ UI::EventReturn JitCompareScreen::OnShowStats(UI::EventParams &e) {
 	NOTICE_LOG(JIT, "Average Bloat: %0.2f%%", 100 * bcStats.avgBloat);
 	NOTICE_LOG(JIT, "Min Bloat: %0.2f%%  (%08x)", 100 * bcStats.minBloat, bcStats.minBloatBlock);
 	NOTICE_LOG(JIT, "Max Bloat: %0.2f%%  (%08x)", 100 * bcStats.maxBloat, bcStats.maxBloatBlock);
+	NOTICE_LOG(JIT, "Background compile queue: %d, latency avg %0.2f ms, max %0.2f ms", bcStats.compileQueueDepth, bcStats.avgCompileLatency * 1000.0, bcStats.maxCompileLatency * 1000.0);
 
 	int ctr = 0, sz = (int)bcStats.bloatMap.size();
 	for (auto iter : bcStats.bloatMap) {
@@ -949,6 +951,11 @@ UI::EventReturn JitCompareScreen::OnShowStats(UI::EventParams &e) {
 		}
 		ctr++;
 	}
+
+	// Only has anything if profiling was enabled, e.g. through the websocket debugger.
+	for (const JitBlockProfileResult &result : JitBlockProfileTop(blockCache, 10)) {
+		NOTICE_LOG(JIT, "Hot block %08x (%s): %llu runs, %0.3f ms", result.stats.originalAddress, result.symbol.c_str(), (unsigned long long)result.stats.executions, result.stats.hostTime * 1000.0);
+	}
 	return UI::EVENT_DONE;
 }
 
@@ -3,6 +3,7 @@
 // To build on non-windows systems, just run CMake in the SDL directory, it will build both a normal ppsspp and the headless version.
 
 #include "ppsspp_config.h"
+#include <algorithm>
 #include <cstdio>
 #include <cstdlib>
 #include <limits>
@@ -11,6 +12,7 @@
 #endif
 
 #include "Common/Profiler/Profiler.h"
+#include "Common/Data/Format/JSONWriter.h"
 #include "Common/System/NativeApp.h"
 #include "Common/System/System.h"
 
@@ -28,9 +30,12 @@
 #include "Core/System.h"
 #include "Core/WebServer.h"
 #include "Core/HLE/sceUtility.h"
+#include "Core/MIPS/IR/IRJit.h"
+#include "Core/MIPS/JitCommon/JitCommon.h"
 #include "Core/Host.h"
 #include "Core/SaveState.h"
 #include "GPU/Common/FramebufferManagerCommon.h"
+#include "GPU/Debugger/Playback.h"
 #include "Log.h"
 #include "LogManager.h"
 
@@ -130,6 +135,10 @@ int printUsage(const char *progname, const char *reason)
 	fprintf(stderr, "  -v, --verbose         show the full passed/failed result\n");
 	fprintf(stderr, "  -i                    use the interpreter\n");
 	fprintf(stderr, "  --ir                  use ir interpreter\n");
+	fprintf(stderr, "  --ir-jit              use ir with native backend\n");
+	fprintf(stderr, "  --bench-ir            run each test with both ir dispatch modes, report speed\n");
+	fprintf(stderr, "  --bench-dump=FRAMES   replay each GE dump FRAMES times, report timings as json\n");
+	fprintf(stderr, "  --bench-json=FILE     write the --bench-dump results to FILE instead of stdout\n");
 	fprintf(stderr, "  -j                    use jit (default)\n");
 	fprintf(stderr, "  -c, --compare         compare with output in file.expected\n");
 	fprintf(stderr, "\nSee headless.txt for details.\n");
@@ -151,7 +160,67 @@ static HeadlessHost *getHost(GPUCore gpuCore) {
 	}
 }
 
-bool RunAutoTest(HeadlessHost *headlessHost, CoreParameter &coreParameter, bool autoCompare, bool verbose, double timeout)
+struct IRBenchmark {
+	bool threaded = false;
+	double seconds = 0.0;
+	u64 instructions = 0;
+};
+
+static void WriteDumpBenchmark(json::JsonWriter &writer, const std::string &filename, const char *backend, const std::vector<GPURecord::ReplayFrameStats> &frames) {
+	writer.pushDict();
+	writer.writeString("file", filename);
+	writer.writeString("backend", backend);
+
+	GPURecord::ReplayFrameStats total{};
+	double minSeconds = frames.empty() ? 0.0 : frames[0].seconds;
+	double maxSeconds = 0.0;
+	writer.pushArray("frames");
+	for (const GPURecord::ReplayFrameStats &frame : frames) {
+		writer.pushDict();
+		writer.writeFloat("ms", frame.seconds * 1000.0);
+		writer.writeFloat("displayListMs", frame.displayListSeconds * 1000.0);
+		writer.writeFloat("vertexDecodeMs", frame.vertexDecodeSeconds * 1000.0);
+		writer.writeFloat("textureDecodeMs", frame.textureDecodeSeconds * 1000.0);
+		writer.writeFloat("rasterizeMs", frame.rasterizeSeconds * 1000.0);
+		writer.writeInt("drawCalls", frame.drawCalls);
+		writer.writeInt("flushes", frame.flushes);
+		writer.writeInt("vertices", frame.vertices);
+		writer.writeInt("texturesDecoded", frame.texturesDecoded);
+		writer.writeInt("textureCacheLookups", frame.textureCacheLookups);
+		writer.writeInt("textureCacheHits", frame.textureCacheHits);
+		writer.pop();
+
+		total.seconds += frame.seconds;
+		total.displayListSeconds += frame.displayListSeconds;
+		total.vertexDecodeSeconds += frame.vertexDecodeSeconds;
+		total.textureDecodeSeconds += frame.textureDecodeSeconds;
+		total.rasterizeSeconds += frame.rasterizeSeconds;
+		total.drawCalls += frame.drawCalls;
+		total.textureCacheLookups += frame.textureCacheLookups;
+		total.textureCacheHits += frame.textureCacheHits;
+		minSeconds = std::min(minSeconds, frame.seconds);
+		maxSeconds = std::max(maxSeconds, frame.seconds);
+	}
+	writer.pop();
+
+	double count = frames.empty() ? 1.0 : (double)frames.size();
+	writer.pushDict("summary");
+	writer.writeInt("frames", (int)frames.size());
+	writer.writeFloat("avgMs", total.seconds * 1000.0 / count);
+	writer.writeFloat("minMs", minSeconds * 1000.0);
+	writer.writeFloat("maxMs", maxSeconds * 1000.0);
+	writer.writeFloat("avgDisplayListMs", total.displayListSeconds * 1000.0 / count);
+	writer.writeFloat("avgVertexDecodeMs", total.vertexDecodeSeconds * 1000.0 / count);
+	writer.writeFloat("avgTextureDecodeMs", total.textureDecodeSeconds * 1000.0 / count);
+	writer.writeFloat("avgRasterizeMs", total.rasterizeSeconds * 1000.0 / count);
+	writer.writeFloat("avgDrawCalls", total.drawCalls / count);
+	writer.writeFloat("textureCacheHitRate", total.textureCacheLookups > 0 ? (double)total.textureCacheHits / total.textureCacheLookups : 0.0);
+	writer.pop();
+
+	writer.pop();
+}
+
+bool RunAutoTest(HeadlessHost *headlessHost, CoreParameter &coreParameter, bool autoCompare, bool verbose, double timeout, IRBenchmark *bench = nullptr)
 {
 	// Kinda ugly, trying to guesstimate the test name from filename...
 	currentTestName = GetTestName(coreParameter.fileToStart);
@@ -188,6 +257,12 @@ bool RunAutoTest(HeadlessHost *headlessHost, CoreParameter &coreParameter, bool
 	if (coreParameter.graphicsContext && coreParameter.graphicsContext->GetDrawContext())
 		coreParameter.graphicsContext->GetDrawContext()->BeginFrame();
 
+	// Only set up for the IR core, see --bench-ir.
+	MIPSComp::IRJit *irjit = bench ? static_cast<MIPSComp::IRJit *>(MIPSComp::jit) : nullptr;
+	if (irjit)
+		irjit->SetThreadedDispatch(bench->threaded);
+	double startTime = time_now_d();
+
 	coreState = coreParameter.startBreak ? CORE_STEPPING : CORE_RUNNING;
 	while (coreState == CORE_RUNNING || coreState == CORE_STEPPING)
 	{
@@ -215,6 +290,11 @@ bool RunAutoTest(HeadlessHost *headlessHost, CoreParameter &coreParameter, bool
 	}
 	PSP_EndHostFrame();
 
+	if (irjit) {
+		bench->seconds = time_now_d() - startTime;
+		bench->instructions = irjit->GetGuestInstructionCount();
+	}
+
 	if (coreParameter.graphicsContext && coreParameter.graphicsContext->GetDrawContext())
 		coreParameter.graphicsContext->GetDrawContext()->EndFrame();
 
@@ -241,6 +321,10 @@ int main(int argc, const char* argv[])
 	bool fullLog = false;
 	bool autoCompare = false;
 	bool verbose = false;
+	bool benchIR = false;
+	int benchDumpFrames = 0;
+	const char *benchJsonFilename = nullptr;
+	const char *gpuCoreName = "software";
 	const char *stateToLoad = 0;
 	GPUCore gpuCore = GPUCORE_SOFTWARE;
 	CPUCore cpuCore = CPUCore::JIT;
@@ -274,6 +358,14 @@ int main(int argc, const char* argv[])
 			cpuCore = CPUCore::JIT;
 		else if (!strcmp(argv[i], "--ir"))
 			cpuCore = CPUCore::IR_JIT;
+		else if (!strcmp(argv[i], "--ir-jit"))
+			cpuCore = CPUCore::JIT_IR;
+		else if (!strcmp(argv[i], "--bench-ir"))
+			benchIR = true;
+		else if (!strncmp(argv[i], "--bench-dump=", strlen("--bench-dump=")) && strlen(argv[i]) > strlen("--bench-dump="))
+			benchDumpFrames = atoi(argv[i] + strlen("--bench-dump="));
+		else if (!strncmp(argv[i], "--bench-json=", strlen("--bench-json=")) && strlen(argv[i]) > strlen("--bench-json="))
+			benchJsonFilename = argv[i] + strlen("--bench-json=");
 		else if (!strcmp(argv[i], "-c") || !strcmp(argv[i], "--compare"))
 			autoCompare = true;
 		else if (!strcmp(argv[i], "-v") || !strcmp(argv[i], "--verbose"))
@@ -294,13 +386,16 @@ int main(int argc, const char* argv[])
 				gpuCore = GPUCORE_VULKAN;
 			else
 				return printUsage(argv[0], "Unknown gpu backend specified after --graphics=. Allowed: software, directx9, directx11, vulkan, gles, null.");
+			gpuCoreName = gpuName;
 		}
 		// Default to GLES if no value selected.
 		else if (!strcmp(argv[i], "--graphics")) {
 #if PPSSPP_API(ANY_GL)
 			gpuCore = GPUCORE_GLES;
+			gpuCoreName = "gles";
 #else
 			gpuCore = GPUCORE_DIRECTX11;
+			gpuCoreName = "directx11";
 #endif
 		} else if (!strncmp(argv[i], "--screenshot=", strlen("--screenshot=")) && strlen(argv[i]) > strlen("--screenshot="))
 			screenshotFilename = argv[i] + strlen("--screenshot=");
@@ -356,7 +451,7 @@ int main(int argc, const char* argv[])
 	bool glWorking = host->InitGraphics(&error_string, &graphicsContext);
 
 	CoreParameter coreParameter;
-	coreParameter.cpuCore = cpuCore;
+	coreParameter.cpuCore = benchIR ? CPUCore::IR_JIT : cpuCore;
 	coreParameter.gpuCore = glWorking ? gpuCore : GPUCORE_SOFTWARE;
 	coreParameter.graphicsContext = graphicsContext;
 	coreParameter.enableSound = false;
@@ -452,11 +547,39 @@ int main(int argc, const char* argv[])
 	if (stateToLoad != NULL)
 		SaveState::Load(Path(stateToLoad), -1);
 
+	json::JsonWriter benchWriter(json::JsonWriter::PRETTY);
+	if (benchDumpFrames > 0) {
+		// The stage timings are only collected with debug stats on.
+		Core_ForceDebugStats(true);
+		benchWriter.begin();
+		benchWriter.pushArray("dumps");
+	}
+
 	std::vector<std::string> failedTests;
 	std::vector<std::string> passedTests;
 	for (size_t i = 0; i < testFilenames.size(); ++i)
 	{
 		coreParameter.fileToStart = Path(testFilenames[i]);
+		if (benchDumpFrames > 0) {
+			GPURecord::BeginReplayBenchmark(benchDumpFrames);
+			RunAutoTest(headlessHost, coreParameter, false, verbose, timeout);
+			const char *backend = coreParameter.gpuCore == gpuCore ? gpuCoreName : "software";
+			WriteDumpBenchmark(benchWriter, testFilenames[i], backend, GPURecord::EndReplayBenchmark());
+			continue;
+		}
+		if (benchIR) {
+			IRBenchmark results[2];
+			results[1].threaded = true;
+			for (IRBenchmark &result : results)
+				RunAutoTest(headlessHost, coreParameter, false, verbose, timeout, &result);
+
+			printf("%s:\n", coreParameter.fileToStart.c_str());
+			for (const IRBenchmark &result : results) {
+				double mips = result.seconds > 0.0 ? (double)result.instructions / result.seconds / 1000000.0 : 0.0;
+				printf("  %-8s dispatch: %8.2f MIPS (%llu instructions in %.3f seconds)\n", result.threaded ? "threaded" : "switch", mips, (unsigned long long)result.instructions, result.seconds);
+			}
+			continue;
+		}
 		if (autoCompare)
 			printf("%s:\n", coreParameter.fileToStart.c_str());
 		bool passed = RunAutoTest(headlessHost, coreParameter, autoCompare, verbose, timeout);
@@ -473,6 +596,18 @@ int main(int argc, const char* argv[])
 		}
 	}
 
+	if (benchDumpFrames > 0) {
+		benchWriter.pop();
+		benchWriter.end();
+		Core_ForceDebugStats(false);
+		if (benchJsonFilename) {
+			if (!File::WriteStringToFile(true, benchWriter.str(), Path(std::string(benchJsonFilename))))
+				fprintf(stderr, "Failed to write benchmark results to %s\n", benchJsonFilename);
+		} else {
+			printf("%s", benchWriter.str().c_str());
+		}
+	}
+
 	if (autoCompare)
 	{
 		printf("%d tests passed, %d tests failed.\n", (int)passedTests.size(), (int)failedTests.size());
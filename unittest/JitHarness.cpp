@@ -28,6 +28,7 @@
 #include "Core/MIPS/JitCommon/JitBlockCache.h"
 #include "Core/MIPS/MIPSCodeUtils.h"
 #include "Core/MIPS/MIPSDebugInterface.h"
+#include "Core/MIPS/MIPSAnalyst.h"
 #include "Core/MIPS/MIPSAsm.h"
 #include "Core/MIPS/MIPSTables.h"
 #include "Core/MIPS/MIPSVFPUUtils.h"
@@ -35,6 +36,7 @@
 #include "Core/Core.h"
 #include "Core/CoreTiming.h"
 #include "Core/HLE/HLE.h"
+#include "unittest/UnitTest.h"
 
 // Temporary hacks around annoying linking errors.  Copied from Headless.
 void NativeUpdate() { }
@@ -203,3 +205,66 @@ bool TestJit() {
 
 	return jit_speed >= interp_speed;
 }
+
+static u32 EncodeIType(u32 op, MIPSGPReg rs, MIPSGPReg rt, s16 imm) {
+	return (op << 26) | (rs << 21) | (rt << 16) | (u16)imm;
+}
+
+// Writes the words at the start of user memory, and returns the address of the branch.
+static u32 WriteLoop(const u32 *words, size_t count, size_t branchIndex) {
+	u32 base = PSP_GetUserMemoryBase();
+	for (size_t i = 0; i < count; ++i)
+		Memory::Write_U32(words[i], base + (u32)i * 4);
+	return base + (u32)branchIndex * 4;
+}
+
+bool TestSpinWaitLoop() {
+	SetupJitHarness();
+
+	const u32 base = PSP_GetUserMemoryBase();
+	const u32 nop = 0;
+	// lw is 0x23, sw 0x2B, beq 0x04, addiu 0x09, andi 0x0C.
+	const u32 pollFlag[] = {
+		EncodeIType(0x23, MIPS_REG_A0, MIPS_REG_V0, 0),
+		EncodeIType(0x0C, MIPS_REG_V0, MIPS_REG_V0, 1),
+		EncodeIType(0x04, MIPS_REG_V0, MIPS_REG_ZERO, -3),
+		nop,
+	};
+	bool pollFlagOkay = MIPSAnalyst::IsSpinWaitLoop(base, WriteLoop(pollFlag, ARRAY_SIZE(pollFlag), 2));
+
+	// A counter makes each pass different.
+	const u32 counter[] = {
+		EncodeIType(0x09, MIPS_REG_A1, MIPS_REG_A1, 1),
+		EncodeIType(0x23, MIPS_REG_A0, MIPS_REG_V0, 0),
+		EncodeIType(0x04, MIPS_REG_V0, MIPS_REG_ZERO, -3),
+		nop,
+	};
+	bool counterOkay = !MIPSAnalyst::IsSpinWaitLoop(base, WriteLoop(counter, ARRAY_SIZE(counter), 2));
+
+	// Same for a store, even in the delay slot.
+	const u32 store[] = {
+		EncodeIType(0x23, MIPS_REG_A0, MIPS_REG_V0, 0),
+		EncodeIType(0x04, MIPS_REG_V0, MIPS_REG_ZERO, -2),
+		EncodeIType(0x2B, MIPS_REG_A0, MIPS_REG_V0, 4),
+	};
+	bool storeOkay = !MIPSAnalyst::IsSpinWaitLoop(base, WriteLoop(store, ARRAY_SIZE(store), 1));
+
+	// Nothing could ever break out of this one, so leave it alone.
+	const u32 noLoad[] = {
+		EncodeIType(0x04, MIPS_REG_A0, MIPS_REG_ZERO, -1),
+		nop,
+	};
+	bool noLoadOkay = !MIPSAnalyst::IsSpinWaitLoop(base, WriteLoop(noLoad, ARRAY_SIZE(noLoad), 0));
+
+	// And the branch has to go back to the start.
+	bool wrongTargetOkay = !MIPSAnalyst::IsSpinWaitLoop(base + 4, WriteLoop(pollFlag, ARRAY_SIZE(pollFlag), 2));
+
+	DestroyJitHarness();
+
+	EXPECT_TRUE(pollFlagOkay);
+	EXPECT_TRUE(counterOkay);
+	EXPECT_TRUE(storeOkay);
+	EXPECT_TRUE(noLoadOkay);
+	EXPECT_TRUE(wrongTargetOkay);
+	return true;
+}
@@ -0,0 +1,226 @@
+// Copyright (c) 2021- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include <cstdio>
+
+#include "Common/Common.h"
+#include "Core/MIPS/IR/IRInst.h"
+#include "Core/MIPS/IR/IRPassSimplify.h"
+#include "unittest/UnitTest.h"
+
+// VFPU registers start after the FPU ones.
+static const int VREG = 32;
+
+static bool ExpectOps(const IRWriter &w, const IROp *ops, size_t count) {
+	const std::vector<IRInst> &insts = w.GetInstructions();
+	bool match = insts.size() == count;
+	for (size_t i = 0; match && i < count; ++i)
+		match = insts[i].op == ops[i];
+	if (!match) {
+		char buf[256];
+		printf("Unexpected IR:\n");
+		for (const IRInst &inst : insts) {
+			DisassembleIR(buf, sizeof(buf), inst);
+			printf("  %s\n", buf);
+		}
+	}
+	return match;
+}
+
+static bool TestDeadStores() {
+	IROptions opts{};
+	IRWriter in, out;
+
+	// The first a1 write is overwritten before use, and the temp is never read.
+	in.Write(IROp::AddConst, IRTEMP_0, MIPS_REG_A0, in.AddConstant(4));
+	in.WriteSetConstant(MIPS_REG_A1, 5);
+	in.WriteSetConstant(MIPS_REG_A1, 6);
+	in.Write(IROp::Store32, MIPS_REG_A1, MIPS_REG_SP, in.AddConstant(0));
+	// An exit keeps everything but temps alive, so v0 must stay.
+	in.WriteSetConstant(MIPS_REG_V0, 1);
+	in.Write(IROp::ExitToConstIfEq, in.AddConstant(0x08804000), MIPS_REG_A2, MIPS_REG_A3);
+	in.WriteSetConstant(MIPS_REG_V0, 2);
+	// Same for the prefix, only the last write counts.
+	in.Write(IROp::SetCtrlVFPU, VFPU_CTRL_SPREFIX, in.AddConstant(0xE4));
+	in.Write(IROp::SetCtrlVFPU, VFPU_CTRL_SPREFIX, in.AddConstant(0x1B));
+	in.Write(IROp::ExitToConst, in.AddConstant(0x08804010));
+
+	RemoveDeadStores(in, out, opts);
+	static const IROp expected[] = {
+		IROp::SetConst,
+		IROp::Store32,
+		IROp::SetConst,
+		IROp::ExitToConstIfEq,
+		IROp::SetConst,
+		IROp::SetCtrlVFPU,
+		IROp::ExitToConst,
+	};
+	RET(ExpectOps(out, expected, ARRAY_SIZE(expected)));
+	EXPECT_EQ_HEX(out.GetInstructions()[0].constant, 6);
+	EXPECT_EQ_HEX(out.GetInstructions()[5].constant, 0x1B);
+
+	// Interpret might read anything, so nothing before it is dead.
+	in.Clear();
+	out.Clear();
+	in.WriteSetConstant(MIPS_REG_A1, 5);
+	in.Write(IROp::Interpret, 0, in.AddConstant(0));
+	in.WriteSetConstant(MIPS_REG_A1, 6);
+	in.Write(IROp::ExitToConst, in.AddConstant(0x08804010));
+	RemoveDeadStores(in, out, opts);
+	EXPECT_EQ_INT((int)out.GetInstructions().size(), 4);
+	return true;
+}
+
+static bool TestCommonSubexpressions() {
+	IROptions opts{};
+	IRWriter in, out;
+
+	// Indexing the same array twice: (a1 << 2) + a0.
+	in.Write(IROp::ShlImm, MIPS_REG_V0, MIPS_REG_A1, 2);
+	in.Write(IROp::Add, MIPS_REG_V0, MIPS_REG_A0, MIPS_REG_V0);
+	in.Write(IROp::Load32, MIPS_REG_T0, MIPS_REG_V0, in.AddConstant(0));
+	in.Write(IROp::ShlImm, MIPS_REG_V1, MIPS_REG_A1, 2);
+	in.Write(IROp::Add, MIPS_REG_V1, MIPS_REG_V1, MIPS_REG_A0);
+	in.Write(IROp::Store32, MIPS_REG_T0, MIPS_REG_V1, in.AddConstant(4));
+	in.Write(IROp::ExitToConst, in.AddConstant(0x08804010));
+
+	// The second shift is kept, but is then dead since v1 gets a copy of v0.
+	IRWriter cse;
+	EliminateCommonSubexpressions(in, cse, opts);
+	RemoveDeadStores(cse, out, opts);
+	static const IROp expected[] = {
+		IROp::ShlImm,
+		IROp::Add,
+		IROp::Load32,
+		IROp::Mov,
+		IROp::Store32,
+		IROp::ExitToConst,
+	};
+	RET(ExpectOps(out, expected, ARRAY_SIZE(expected)));
+	EXPECT_EQ_INT((int)out.GetInstructions()[3].src1, (int)MIPS_REG_V0);
+
+	// Once a source changes, the expression must be recomputed.
+	in.Clear();
+	out.Clear();
+	in.Write(IROp::AddConst, IRTEMP_0, MIPS_REG_SP, in.AddConstant(16));
+	in.Write(IROp::Load32, MIPS_REG_A0, IRTEMP_0, in.AddConstant(0));
+	in.Write(IROp::AddConst, MIPS_REG_SP, MIPS_REG_SP, in.AddConstant(32));
+	in.Write(IROp::AddConst, IRTEMP_1, MIPS_REG_SP, in.AddConstant(16));
+	in.Write(IROp::AddConst, IRTEMP_2, MIPS_REG_SP, in.AddConstant(8));
+	in.Write(IROp::ExitToConst, in.AddConstant(0x08804010));
+	EliminateCommonSubexpressions(in, out, opts);
+	static const IROp expected2[] = {
+		IROp::AddConst,
+		IROp::Load32,
+		IROp::AddConst,
+		IROp::AddConst,
+		IROp::AddConst,
+		IROp::ExitToConst,
+	};
+	RET(ExpectOps(out, expected2, ARRAY_SIZE(expected2)));
+	return true;
+}
+
+static bool TestVFPUPrefixes() {
+	IROptions opts{};
+	IRWriter in, out;
+
+	// vadd.q with a negated T prefix is really a vsub.q.
+	in.Write(IROp::Vec4Neg, IRVTEMP_PFX_T, VREG + 4);
+	in.Write(IROp::Vec4Add, VREG + 8, VREG + 0, IRVTEMP_PFX_T);
+	// A swizzled S prefix read by a scalar op can use the original lane.
+	in.Write(IROp::Vec4Shuffle, IRVTEMP_PFX_S, VREG + 12, 0x1B);
+	in.Write(IROp::FMul, VREG + 16, IRVTEMP_PFX_S + 1, VREG + 17);
+	in.Write(IROp::ExitToConst, in.AddConstant(0x08804010));
+
+	IRWriter folded;
+	FoldVFPUPrefixes(in, folded, opts);
+	RemoveDeadStores(folded, out, opts);
+	static const IROp expected[] = {
+		IROp::Vec4Sub,
+		IROp::FMul,
+		IROp::ExitToConst,
+	};
+	RET(ExpectOps(out, expected, ARRAY_SIZE(expected)));
+	EXPECT_EQ_INT((int)out.GetInstructions()[0].src1, VREG + 0);
+	EXPECT_EQ_INT((int)out.GetInstructions()[0].src2, VREG + 4);
+	EXPECT_EQ_INT((int)out.GetInstructions()[1].src1, VREG + 14);
+
+	// If the original is overwritten in between, the temp must be kept.
+	in.Clear();
+	folded.Clear();
+	out.Clear();
+	in.Write(IROp::FNeg, IRVTEMP_PFX_T, VREG + 4);
+	in.Write(IROp::SetConstF, VREG + 4, in.AddConstantFloat(1.0f));
+	in.Write(IROp::FAdd, VREG + 8, VREG + 0, IRVTEMP_PFX_T);
+	in.Write(IROp::ExitToConst, in.AddConstant(0x08804010));
+	FoldVFPUPrefixes(in, folded, opts);
+	RemoveDeadStores(folded, out, opts);
+	static const IROp expected2[] = {
+		IROp::FNeg,
+		IROp::SetConstF,
+		IROp::FAdd,
+		IROp::ExitToConst,
+	};
+	RET(ExpectOps(out, expected2, ARRAY_SIZE(expected2)));
+
+	// A swizzled copy to another vector becomes a single shuffle.
+	in.Clear();
+	folded.Clear();
+	out.Clear();
+	in.Write(IROp::Vec4Shuffle, IRVTEMP_PFX_S, VREG + 0, 0xB1);
+	in.Write(IROp::Vec4Mov, VREG + 4, IRVTEMP_PFX_S);
+	in.Write(IROp::ExitToConst, in.AddConstant(0x08804010));
+	FoldVFPUPrefixes(in, folded, opts);
+	RemoveDeadStores(folded, out, opts);
+	static const IROp expected3[] = {
+		IROp::Vec4Shuffle,
+		IROp::ExitToConst,
+	};
+	RET(ExpectOps(out, expected3, ARRAY_SIZE(expected3)));
+	EXPECT_EQ_INT((int)out.GetInstructions()[0].dest, VREG + 4);
+	EXPECT_EQ_INT((int)out.GetInstructions()[0].src1, VREG + 0);
+	EXPECT_EQ_INT((int)out.GetInstructions()[0].src2, 0xB1);
+
+	// But vmov.q C000, C000[y,x,w,z] can't shuffle in place, it would read lanes it already wrote.
+	in.Clear();
+	folded.Clear();
+	out.Clear();
+	in.Write(IROp::Vec4Shuffle, IRVTEMP_PFX_S, VREG + 0, 0xB1);
+	in.Write(IROp::Vec4Mov, VREG + 0, IRVTEMP_PFX_S);
+	in.Write(IROp::ExitToConst, in.AddConstant(0x08804010));
+	FoldVFPUPrefixes(in, folded, opts);
+	RemoveDeadStores(folded, out, opts);
+	static const IROp expected4[] = {
+		IROp::Vec4Shuffle,
+		IROp::Vec4Mov,
+		IROp::ExitToConst,
+	};
+	RET(ExpectOps(out, expected4, ARRAY_SIZE(expected4)));
+	EXPECT_EQ_INT((int)out.GetInstructions()[0].dest, IRVTEMP_PFX_S);
+	EXPECT_EQ_INT((int)out.GetInstructions()[1].src1, IRVTEMP_PFX_S);
+	return true;
+}
+
+bool TestIRPassSimplify() {
+	InitIR();
+
+	RET(TestDeadStores());
+	RET(TestCommonSubexpressions());
+	RET(TestVFPUPrefixes());
+	return true;
+}
@@ -0,0 +1,166 @@
+// Copyright (c) 2021- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include "ppsspp_config.h"
+#include <cstdio>
+#include <cstring>
+
+#include "Common/Common.h"
+#include "GPU/ge_constants.h"
+#include "GPU/GPUState.h"
+#include "GPU/Math3D.h"
+#include "GPU/Software/DrawPixel.h"
+#include "GPU/Software/Rasterizer.h"
+#include "GPU/Software/SoftGpu.h"
+#include "unittest/UnitTest.h"
+
+// Runs the pixel jit and DrawSinglePixelNonClear on the same random states and buffers,
+// and checks they leave exactly the same color, stencil (the color's top bits) and depth.
+
+static const int PIXEL_STATES = 20000;
+static const int PIXELS_PER_STATE = 32;
+static const int PIXEL_BUF_STRIDE = 64;
+static const int PIXEL_BUF_HEIGHT = 16;
+
+static u32 pixelSeed = 0x12345678;
+
+static u32 PixelRand() {
+	pixelSeed = pixelSeed * 1103515245 + 12345;
+	return pixelSeed >> 8;
+}
+
+static u32 PixelRandBits(int bits) {
+	return PixelRand() & ((1 << bits) - 1);
+}
+
+static void RandomizePixelState() {
+	gstate.fbwidth = PIXEL_BUF_STRIDE;
+	gstate.zbwidth = PIXEL_BUF_STRIDE;
+	gstate.framebufpixformat = PixelRandBits(2);
+	gstate.vertType = PixelRandBits(1) ? GE_VTYPE_THROUGH : 0;
+
+	gstate.minz = PixelRandBits(16);
+	gstate.maxz = PixelRandBits(2) == 0 ? 0xFFFF : PixelRandBits(16);
+	gstate.alphaTestEnable = PixelRandBits(1);
+	gstate.alphatest = PixelRandBits(24);
+	gstate.fogEnable = PixelRandBits(1);
+	gstate.fogcolor = PixelRandBits(24);
+	gstate.zTestEnable = PixelRandBits(1);
+	gstate.ztestfunc = PixelRandBits(3);
+	gstate.zmsk = PixelRandBits(1);
+
+	gstate.alphaBlendEnable = PixelRandBits(1);
+	// Only the real blend equations, the others just report an error in the C++ path.
+	gstate.blend = PixelRandBits(8) | ((PixelRand() % (GE_BLENDMODE_ABSDIFF + 1)) << 8);
+	gstate.blendfixa = PixelRandBits(24);
+	gstate.blendfixb = PixelRandBits(24);
+	gstate.ditherEnable = PixelRandBits(1);
+	for (int i = 0; i < 4; ++i)
+		gstate.dithmtx[i] = PixelRandBits(16);
+	gstate.pmskc = PixelRandBits(2) == 0 ? PixelRandBits(24) : 0;
+	gstate.pmska = PixelRandBits(2) == 0 ? PixelRandBits(8) : 0;
+
+	// These always use the C++ path, but it's still worth going through the fallback now and then.
+	gstate.colorTestEnable = PixelRandBits(5) == 0;
+	gstate.stencilTestEnable = PixelRandBits(5) == 0;
+	gstate.logicOpEnable = PixelRandBits(5) == 0;
+	gstate.clearmode = 0;
+}
+
+bool TestPixelJit() {
+	Rasterizer::Init();
+
+	const size_t colorSize = PIXEL_BUF_STRIDE * PIXEL_BUF_HEIGHT * sizeof(u32);
+	const size_t depthSize = PIXEL_BUF_STRIDE * PIXEL_BUF_HEIGHT * sizeof(u16);
+	u8 *colorInit = new u8[colorSize];
+	u8 *colorJit = new u8[colorSize];
+	u8 *colorBasic = new u8[colorSize];
+	u8 *depthInit = new u8[depthSize];
+	u8 *depthJit = new u8[depthSize];
+	u8 *depthBasic = new u8[depthSize];
+
+	struct PixelArgs {
+		int x;
+		int y;
+		int z;
+		int fog;
+		Vec4<int> color;
+	};
+	// On the stack, so the colors are aligned like the rasterizer's.
+	PixelArgs pixels[PIXELS_PER_STATE];
+
+	int jitted = 0;
+	bool success = true;
+	for (int state = 0; state < PIXEL_STATES && success; ++state) {
+		RandomizePixelState();
+
+		for (size_t i = 0; i < colorSize; ++i)
+			colorInit[i] = (u8)PixelRand();
+		for (size_t i = 0; i < depthSize; ++i)
+			depthInit[i] = (u8)PixelRand();
+		for (int i = 0; i < PIXELS_PER_STATE; ++i) {
+			PixelArgs &p = pixels[i];
+			p.x = PixelRand() % PIXEL_BUF_STRIDE;
+			p.y = PixelRand() % PIXEL_BUF_HEIGHT;
+			p.z = PixelRandBits(16);
+			p.fog = PixelRandBits(8);
+			// Go a bit outside 0-255, to check the clamping.
+			p.color.r() = (int)(PixelRand() % 320) - 32;
+			p.color.g() = (int)(PixelRand() % 320) - 32;
+			p.color.b() = (int)(PixelRand() % 320) - 32;
+			p.color.a() = (int)(PixelRand() % 320) - 32;
+		}
+
+		Rasterizer::SingleFunc func = Rasterizer::GetSingleFunc();
+		if (!gstate.isColorTestEnabled() && !gstate.isStencilTestEnabled() && !gstate.isLogicOpEnabled())
+			++jitted;
+
+		memcpy(colorJit, colorInit, colorSize);
+		memcpy(depthJit, depthInit, depthSize);
+		fb.data = colorJit;
+		depthbuf.data = depthJit;
+		for (int i = 0; i < PIXELS_PER_STATE; ++i)
+			func(pixels[i].x, pixels[i].y, pixels[i].z, pixels[i].fog, pixels[i].color);
+
+		memcpy(colorBasic, colorInit, colorSize);
+		memcpy(depthBasic, depthInit, depthSize);
+		fb.data = colorBasic;
+		depthbuf.data = depthBasic;
+		for (int i = 0; i < PIXELS_PER_STATE; ++i) {
+			const PixelArgs &p = pixels[i];
+			Rasterizer::DrawSinglePixelNonClear(DrawingCoords(p.x, p.y, 0), (u16)p.z, (u8)p.fog, p.color);
+		}
+
+		if (memcmp(colorJit, colorBasic, colorSize) != 0 || memcmp(depthJit, depthBasic, depthSize) != 0) {
+			printf("Pixel jit mismatch at state %d: fbformat=%d blend=%06x alphatest=%06x ztest=%d/%d fog=%d dither=%d\n", state, gstate.FrameBufFormat(), gstate.blend & 0xFFFFFF, gstate.alphatest & 0xFFFFFF, gstate.zTestEnable & 1, gstate.ztestfunc & 7, gstate.fogEnable & 1, gstate.ditherEnable & 1);
+			success = false;
+		}
+	}
+	fb.data = nullptr;
+	depthbuf.data = nullptr;
+
+	printf("Pixel jit: compared %d states, %d of them without a C++ only feature\n", PIXEL_STATES, jitted);
+
+	delete[] colorInit;
+	delete[] colorJit;
+	delete[] colorBasic;
+	delete[] depthInit;
+	delete[] depthJit;
+	delete[] depthBasic;
+	Rasterizer::Shutdown();
+	return success;
+}
@@ -0,0 +1,200 @@
+// Copyright (c) 2021- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <string>
+
+#include "Common/Data/Convert/ColorConv.h"
+#include "Common/CPUDetect.h"
+#include "Common/MemoryUtil.h"
+#include "Common/TimeUtil.h"
+#include "GPU/Common/TextureDecoder.h"
+#include "unittest/UnitTest.h"
+
+// Checks the texture kernels picked at runtime (like AVX2) against the basic versions.
+// With --bench, also prints the throughput of each.  The timings are only logged, never checked.
+
+static const int KERNEL_PIXELS = 512 * 512;
+static const int KERNEL_BENCH_REPEAT = 50;
+
+static void BenchKernel(const std::string &name, size_t bytes, const std::function<void()> &func) {
+	if (!g_benchmarkTests)
+		return;
+
+	// Warm up the caches first.
+	func();
+
+	double start = time_now_d();
+	for (int i = 0; i < KERNEL_BENCH_REPEAT; ++i) {
+		func();
+	}
+	double elapsed = time_now_d() - start;
+	printf("  %-32s %9.1f MB/s\n", name.c_str(), (double)bytes * KERNEL_BENCH_REPEAT / (elapsed * 1024.0 * 1024.0));
+}
+
+static void FillPattern(u8 *data, size_t size) {
+	u32 seed = 0x12345678;
+	for (size_t i = 0; i < size; ++i) {
+		seed = seed * 1103515245 + 12345;
+		data[i] = (u8)(seed >> 16);
+	}
+}
+
+// Odd sizes and offsets, to hit the tails and unaligned pointers.
+static const u32 kernelCheckSizes[] = { 1, 7, 15, 16, 17, 33, 255, 1000 };
+
+static bool CheckConvert16To32(const char *name, Convert16bppTo32bppFunc basic, Convert16bppTo32bppFunc picked, const u16 *src, u32 *dstBasic, u32 *dstPicked) {
+	for (u32 size : kernelCheckSizes) {
+		basic(dstBasic + 1, src + 3, size);
+		picked(dstPicked + 1, src + 3, size);
+		if (memcmp(dstBasic + 1, dstPicked + 1, size * sizeof(u32)) != 0) {
+			printf("%s: mismatch with %d pixels\n", name, size);
+			return false;
+		}
+	}
+
+	basic(dstBasic, src, KERNEL_PIXELS);
+	picked(dstPicked, src, KERNEL_PIXELS);
+	EXPECT_TRUE(memcmp(dstBasic, dstPicked, KERNEL_PIXELS * sizeof(u32)) == 0);
+
+	BenchKernel(std::string(name) + " (basic)", KERNEL_PIXELS * sizeof(u16), [&] { basic(dstBasic, src, KERNEL_PIXELS); });
+	BenchKernel(name, KERNEL_PIXELS * sizeof(u16), [&] { picked(dstPicked, src, KERNEL_PIXELS); });
+	return true;
+}
+
+static bool CheckConvert16To16(const char *name, Convert16bppTo16bppFunc basic, Convert16bppTo16bppFunc picked, const u16 *src, u16 *dstBasic, u16 *dstPicked) {
+	for (u32 size : kernelCheckSizes) {
+		basic(dstBasic + 1, src + 3, size);
+		picked(dstPicked + 1, src + 3, size);
+		if (memcmp(dstBasic + 1, dstPicked + 1, size * sizeof(u16)) != 0) {
+			printf("%s: mismatch with %d pixels\n", name, size);
+			return false;
+		}
+	}
+
+	basic(dstBasic, src, KERNEL_PIXELS);
+	picked(dstPicked, src, KERNEL_PIXELS);
+	EXPECT_TRUE(memcmp(dstBasic, dstPicked, KERNEL_PIXELS * sizeof(u16)) == 0);
+
+	BenchKernel(std::string(name) + " (basic)", KERNEL_PIXELS * sizeof(u16), [&] { basic(dstBasic, src, KERNEL_PIXELS); });
+	BenchKernel(name, KERNEL_PIXELS * sizeof(u16), [&] { picked(dstPicked, src, KERNEL_PIXELS); });
+	return true;
+}
+
+static bool CheckTextureKernels(u8 *src, u8 *dstBasic, u8 *dstPicked) {
+	bool success = true;
+	success = success && CheckConvert16To32("RGB565ToRGBA8888", &ConvertRGB565ToRGBA8888Basic, ConvertRGB565ToRGBA8888, (const u16 *)src, (u32 *)dstBasic, (u32 *)dstPicked);
+	success = success && CheckConvert16To32("RGBA5551ToRGBA8888", &ConvertRGBA5551ToRGBA8888Basic, ConvertRGBA5551ToRGBA8888, (const u16 *)src, (u32 *)dstBasic, (u32 *)dstPicked);
+	success = success && CheckConvert16To32("RGBA4444ToRGBA8888", &ConvertRGBA4444ToRGBA8888Basic, ConvertRGBA4444ToRGBA8888, (const u16 *)src, (u32 *)dstBasic, (u32 *)dstPicked);
+	success = success && CheckConvert16To16("RGBA4444ToABGR4444", &ConvertRGBA4444ToABGR4444Basic, ConvertRGBA4444ToABGR4444, (const u16 *)src, (u16 *)dstBasic, (u16 *)dstPicked);
+	success = success && CheckConvert16To16("RGBA5551ToABGR1555", &ConvertRGBA5551ToABGR1555Basic, ConvertRGBA5551ToABGR1555, (const u16 *)src, (u16 *)dstBasic, (u16 *)dstPicked);
+	success = success && CheckConvert16To16("RGB565ToBGR565", &ConvertRGB565ToBGR565Basic, ConvertRGB565ToBGR565, (const u16 *)src, (u16 *)dstBasic, (u16 *)dstPicked);
+
+#if defined(_M_SSE)
+	if (success) {
+		// 512x512 at 32 bits, so 2048 bytes per row, in 16-byte by 8-line blocks.
+		const int bxc = 2048 / 16;
+		const int byc = 512 / 8;
+		DoUnswizzleTex16Basic(src, (u32 *)dstBasic, bxc, byc, 2048);
+		DoUnswizzleTex16(src, (u32 *)dstPicked, bxc, byc, 2048);
+		EXPECT_TRUE(memcmp(dstBasic, dstPicked, KERNEL_PIXELS * sizeof(u32)) == 0);
+		// And an odd number of blocks across.
+		DoUnswizzleTex16Basic(src, (u32 *)dstBasic, 3, 5, 48);
+		DoUnswizzleTex16(src, (u32 *)dstPicked, 3, 5, 48);
+		EXPECT_TRUE(memcmp(dstBasic, dstPicked, 48 * 40) == 0);
+
+		BenchKernel("UnswizzleTex16 (basic)", KERNEL_PIXELS * sizeof(u32), [&] { DoUnswizzleTex16Basic(src, (u32 *)dstBasic, bxc, byc, 2048); });
+		BenchKernel("UnswizzleTex16", KERNEL_PIXELS * sizeof(u32), [&] { DoUnswizzleTex16(src, (u32 *)dstPicked, bxc, byc, 2048); });
+	}
+
+	if (success) {
+		const u32 *clut = (const u32 *)(src + KERNEL_PIXELS);
+		u32 *dst32 = (u32 *)dstBasic;
+		for (u32 size : kernelCheckSizes) {
+			DoDeIndexTexture8To32((u32 *)dstPicked, src + 3, size, clut);
+			for (u32 i = 0; i < size; ++i) {
+				dst32[i] = clut[src[3 + i]];
+			}
+			EXPECT_TRUE(memcmp(dstBasic, dstPicked, size * sizeof(u32)) == 0);
+		}
+
+		BenchKernel("DeIndexTexture8To32 (basic)", KERNEL_PIXELS, [&] {
+			for (int i = 0; i < KERNEL_PIXELS; ++i) {
+				dst32[i] = clut[src[i]];
+			}
+		});
+		BenchKernel("DeIndexTexture8To32", KERNEL_PIXELS, [&] { DoDeIndexTexture8To32((u32 *)dstPicked, src, KERNEL_PIXELS, clut); });
+	}
+
+	if (success) {
+		const u16 *clut = (const u16 *)(src + KERNEL_PIXELS);
+		u16 *dst16 = (u16 *)dstBasic;
+		for (u32 size : kernelCheckSizes) {
+			DoDeIndexTexture8To16((u16 *)dstPicked, src + 3, size, clut);
+			for (u32 i = 0; i < size; ++i) {
+				dst16[i] = clut[src[3 + i]];
+			}
+			EXPECT_TRUE(memcmp(dstBasic, dstPicked, size * sizeof(u16)) == 0);
+		}
+
+		BenchKernel("DeIndexTexture8To16 (basic)", KERNEL_PIXELS, [&] {
+			for (int i = 0; i < KERNEL_PIXELS; ++i) {
+				dst16[i] = clut[src[i]];
+			}
+		});
+		BenchKernel("DeIndexTexture8To16", KERNEL_PIXELS, [&] { DoDeIndexTexture8To16((u16 *)dstPicked, src, KERNEL_PIXELS, clut); });
+	}
+#endif
+
+	if (success) {
+		// The picked hash may differ from the stable one, but must be consistent and notice changes.
+		const u32 size = KERNEL_PIXELS * sizeof(u32);
+		const u32 hash = DoQuickTexHash(src, size);
+		EXPECT_EQ_INT(DoQuickTexHash(src, size), hash);
+		src[size / 2] ^= 0x10;
+		EXPECT_TRUE(DoQuickTexHash(src, size) != hash);
+		src[size / 2] ^= 0x10;
+
+		u32 sum = 0;
+		BenchKernel("StableQuickTexHash", size, [&] { sum += StableQuickTexHash(src, size); });
+		BenchKernel("QuickTexHash", size, [&] { sum += DoQuickTexHash(src, size); });
+	}
+
+	return success;
+}
+
+bool TestTextureKernels() {
+	SetupColorConv();
+	SetupTextureDecoder();
+	printf("Texture kernels, AVX2 %s\n", cpu_info.bAVX2 ? "available" : "not available");
+
+	const size_t bufSize = KERNEL_PIXELS * sizeof(u32) + 64;
+	u8 *src = (u8 *)AllocateAlignedMemory(bufSize, 32);
+	u8 *dstBasic = (u8 *)AllocateAlignedMemory(bufSize, 32);
+	u8 *dstPicked = (u8 *)AllocateAlignedMemory(bufSize, 32);
+	FillPattern(src, bufSize);
+
+	// The checks bail out early on failure, so the buffers are freed out here.
+	bool success = CheckTextureKernels(src, dstBasic, dstPicked);
+
+	FreeAlignedMemory(src);
+	FreeAlignedMemory(dstBasic);
+	FreeAlignedMemory(dstPicked);
+	return success;
+}
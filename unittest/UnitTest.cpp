@@ -32,6 +32,7 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cmath>
+#include <cstring>
 #include <vector>
 #include <string>
 #include <sstream>
@@ -58,7 +59,14 @@
 #include "Core/FileSystems/ISOFileSystem.h"
 #include "Core/MemMap.h"
 #include "Core/MIPS/MIPSVFPUUtils.h"
+#include "GPU/Common/SplineCommon.h"
+#include "GPU/Common/TextureCacheCommon.h"
 #include "GPU/Common/TextureDecoder.h"
+#include "GPU/GPU.h"
+#include "GPU/GPUState.h"
+#include "GPU/Software/Rasterizer.h"
+#include "GPU/Software/SoftGpu.h"
+#include "GPU/Software/TransformUnit.h"
 
 #include "android/jni/AndroidContentURI.h"
 
@@ -348,6 +356,60 @@ bool TestVFPUSinCos() {
 	return true;
 }
 
+static u32 FloatBitsOf(float f) {
+	u32 u;
+	memcpy(&u, &f, sizeof(u));
+	return u;
+}
+
+bool TestVFPUSequentialMath() {
+	// Small integers and signed zeros make exact rounding and -0.0 handling matter.
+	auto randomValue = []() {
+		switch (rand() % 4) {
+		case 0: return 0.0f;
+		case 1: return -0.0f;
+		case 2: return (float)(rand() % 17 - 8);
+		default: return (float)(rand() - RAND_MAX / 2) / 1337.0f;
+		}
+	};
+
+	for (int iter = 0; iter < 1000; ++iter) {
+		float s[16], t[16], d[16], d2[4];
+		for (int i = 0; i < 16; ++i) {
+			s[i] = randomValue();
+			t[i] = randomValue();
+		}
+
+		float dot = 0.0f;
+		for (int i = 0; i < 4; ++i)
+			dot += s[i] * t[i];
+		EXPECT_EQ_HEX(FloatBitsOf(0.0f + vfpu_dot_sequential(s, t)), FloatBitsOf(dot));
+
+		int n = 1 + iter % 4;
+		vfpu_mmul_sequential(d, s, t, n);
+		for (int a = 0; a < n; ++a) {
+			for (int b = 0; b < n; ++b) {
+				float sum = 0.0f;
+				for (int c = 0; c < n; ++c)
+					sum += s[b * 4 + c] * t[a * 4 + c];
+				EXPECT_EQ_HEX(FloatBitsOf(d[a * 4 + b]), FloatBitsOf(sum));
+			}
+		}
+
+		int extraCol = iter % 3 == 0 ? n - 1 : -1;
+		vfpu_mvmul_sequential(d2, s, t, n, extraCol);
+		for (int i = 0; i < 4; ++i) {
+			float sum = s[i * 4] * t[0];
+			for (int k = 1; k < n; ++k)
+				sum += s[i * 4 + k] * t[k];
+			if (extraCol >= 0)
+				sum += s[i * 4 + extraCol];
+			EXPECT_EQ_HEX(FloatBitsOf(d2[i]), FloatBitsOf(sum));
+		}
+	}
+	return true;
+}
+
 bool TestMatrixTranspose() {
 	MatrixSize sz = M_4x4;
 	int matrix = 0;  // M000
@@ -510,6 +572,394 @@ bool TestQuickTexHash() {
 	return true;
 }
 
+bool TestTexCacheRanges() {
+	TexCache cache;
+	auto add = [&](u32 addr, u32 low) {
+		u64 key = ((u64)addr << 32) | low;
+		cache[key].reset(new TexCacheEntry{});
+		cache[key]->addr = addr;
+		cache[key]->cluthash = low;
+	};
+	add(0x04000000, 0x00000000);
+	add(0x04000000, 0x12345678);
+	add(0x04000000, 0x00200000);
+	add(0x04008000, 0x00000000);
+	add(0x04010000, 0x00000000);
+	add(0x08800000, 0x00000000);
+	add(0x09FFF000, 0xFFFFFFFF);
+	EXPECT_EQ_INT((int)cache.size(), 7);
+
+	std::vector<u64> keys;
+	auto collect = [&](TexCacheEntry *entry) {
+		keys.push_back(((u64)entry->addr << 32) | entry->cluthash);
+	};
+
+	// Same address, any clut, in key order.
+	cache.ForEachInRange(0x0400000000000000ULL, 0x0400000100000000ULL, collect);
+	EXPECT_EQ_INT((int)keys.size(), 3);
+	EXPECT_TRUE(keys[0] == 0x0400000000000000ULL);
+	EXPECT_TRUE(keys[1] == 0x0400000000200000ULL);
+	EXPECT_TRUE(keys[2] == 0x0400000012345678ULL);
+
+	// Inclusive on both ends, across pages.
+	keys.clear();
+	cache.ForEachInRange(0x0400000000200000ULL, 0x0401000000000000ULL, collect);
+	EXPECT_EQ_INT((int)keys.size(), 4);
+	EXPECT_TRUE(keys[3] == 0x0401000000000000ULL);
+
+	// Wide ranges take the other path, but must find the same things.
+	keys.clear();
+	cache.ForEachInRange(0x0400800000000000ULL, (u64)-1, collect);
+	EXPECT_EQ_INT((int)keys.size(), 4);
+	EXPECT_TRUE(keys[3] == 0x09FFF000FFFFFFFFULL);
+
+	keys.clear();
+	cache.ForEachInRange(0x0401000000000001ULL, 0x0400000000000000ULL, collect);
+	EXPECT_EQ_INT((int)keys.size(), 0);
+
+	// Erased entries drop out of the address index too.
+	cache.erase(cache.find(0x0400000000200000ULL));
+	cache.erase(cache.find(0x0401000000000000ULL));
+	EXPECT_TRUE(cache.find(0x0401000000000000ULL) == cache.end());
+	keys.clear();
+	cache.ForEachInRange(0, (u64)-1, collect);
+	EXPECT_EQ_INT((int)keys.size(), 5);
+	for (size_t i = 1; i < keys.size(); ++i) {
+		EXPECT_TRUE(keys[i - 1] < keys[i]);
+	}
+
+	cache.clear();
+	keys.clear();
+	cache.ForEachInRange(0, (u64)-1, collect);
+	EXPECT_EQ_INT((int)keys.size(), 0);
+	return true;
+}
+
+bool TestTessCache() {
+	SimpleVertex points[16]{};
+	for (int i = 0; i < 16; ++i) {
+		points[i].pos = Vec3Packedf((float)(i & 3), (float)(i >> 2), (float)(i * 7 % 5));
+		points[i].color_32 = 0xFF000000 | (i * 0x10101);
+	}
+
+	Spline::BezierSurface bezier;
+	bezier.tess_u = 4;
+	bezier.tess_v = 4;
+	bezier.num_points_u = 4;
+	bezier.num_points_v = 4;
+	bezier.num_patches_u = 1;
+	bezier.num_patches_v = 1;
+	bezier.primType = GE_PATCHPRIM_TRIANGLES;
+	bezier.patchFacing = false;
+
+	// The same spline patch, which tessellates differently.
+	Spline::SplineSurface spline;
+	spline.tess_u = 4;
+	spline.tess_v = 4;
+	spline.num_points_u = 4;
+	spline.num_points_v = 4;
+	spline.num_patches_u = 1;
+	spline.num_patches_v = 1;
+	spline.primType = GE_PATCHPRIM_TRIANGLES;
+	spline.patchFacing = false;
+
+	const u32 vertType = GE_VTYPE_POS_FLOAT | GE_VTYPE_COL_8888;
+	u64 key1 = Spline::ComputeTessCacheKey(bezier, vertType, points, 16, nullptr, 0);
+	u64 key2 = Spline::ComputeTessCacheKey(bezier, vertType, points, 16, nullptr, 0);
+	EXPECT_TRUE(key1 == key2);
+	EXPECT_FALSE(key1 == Spline::ComputeTessCacheKey(spline, vertType, points, 16, nullptr, 0));
+	points[5].pos.y += 1.0f;
+	EXPECT_FALSE(key1 == Spline::ComputeTessCacheKey(bezier, vertType, points, 16, nullptr, 0));
+
+	SimpleVertex outVerts[25]{};
+	u16 outIndices[96];
+	for (int i = 0; i < 96; ++i)
+		outIndices[i] = (u16)(i % 25);
+	Spline::OutputBuffers output{ outVerts, outIndices, 96 };
+
+	// Only the second draw of a patch is stored, and the third one hits.
+	Spline::TessellationCache cache;
+	bool store = true;
+	EXPECT_TRUE(cache.Get(key1, &store) == nullptr);
+	EXPECT_FALSE(store);
+	EXPECT_TRUE(cache.Get(key1, &store) == nullptr);
+	EXPECT_TRUE(store);
+	cache.Store(key1, output, 25);
+
+	const Spline::TessellationCache::Entry *entry = cache.Get(key2, &store);
+	EXPECT_TRUE(entry != nullptr);
+	EXPECT_FALSE(store);
+	EXPECT_EQ_INT(entry->count, 96);
+	EXPECT_EQ_INT((int)entry->vertices.size(), 25);
+	EXPECT_TRUE(memcmp(entry->indices.data(), outIndices, sizeof(outIndices)) == 0);
+
+	cache.Clear();
+	EXPECT_TRUE(cache.Get(key1, &store) == nullptr);
+	return true;
+}
+
+// Draws random triangles with and without the early quad depth tests, which must never change the result.
+bool TestEarlyDepthTest() {
+	const int STATES = 2000;
+	const int TRIANGLES_PER_STATE = 8;
+	const int BUF_STRIDE = 64;
+	const int BUF_HEIGHT = 64;
+
+	Sampler::Init();
+	Rasterizer::Init();
+
+	u32 seed = 0x1234567;
+	auto rand = [&]() {
+		seed = seed * 1103515245 + 12345;
+		return seed >> 8;
+	};
+	auto randBits = [&](int bits) {
+		return rand() & ((1 << bits) - 1);
+	};
+
+	memset(&gstate, 0, sizeof(gstate));
+	gstate.fbwidth = BUF_STRIDE;
+	gstate.zbwidth = BUF_STRIDE;
+	gstate.framebufpixformat = GE_FORMAT_8888;
+	gstate.scissor1 = 0;
+	gstate.scissor2 = (BUF_STRIDE - 1) | ((BUF_HEIGHT - 1) << 10);
+
+	const size_t colorSize = BUF_STRIDE * BUF_HEIGHT * sizeof(u32);
+	const size_t depthSize = BUF_STRIDE * BUF_HEIGHT * sizeof(u16);
+	std::vector<u8> colorInit(colorSize), colorEarly(colorSize), colorLate(colorSize);
+	std::vector<u8> depthInit(depthSize), depthEarly(depthSize), depthLate(depthSize);
+
+	bool success = true;
+	int earlyStates = 0;
+	for (int state = 0; state < STATES && success; ++state) {
+		gstate.vertType = randBits(2) == 0 ? GE_VTYPE_THROUGH : 0;
+		gstate.shademodel = randBits(1);
+		gstate.minz = randBits(16);
+		gstate.maxz = randBits(2) == 0 ? 0xFFFF : randBits(16);
+		gstate.zTestEnable = randBits(2) != 0;
+		gstate.ztestfunc = randBits(3);
+		gstate.zmsk = randBits(1);
+		// Stencil keeps depth failures going to the pixel stage, so check that too.
+		gstate.stencilTestEnable = randBits(3) == 0;
+		gstate.stenciltest = randBits(24);
+		gstate.stencilop = randBits(12);
+
+		for (size_t i = 0; i < colorSize; ++i)
+			colorInit[i] = (u8)rand();
+		for (size_t i = 0; i < depthSize; ++i)
+			depthInit[i] = (u8)rand();
+
+		VertexData verts[TRIANGLES_PER_STATE][3]{};
+		BinCoords ranges[TRIANGLES_PER_STATE];
+		bool drawable[TRIANGLES_PER_STATE];
+		const bool flatZ = randBits(2) == 0;
+		const u16 flatDepth = (u16)randBits(16);
+		for (int t = 0; t < TRIANGLES_PER_STATE; ++t) {
+			for (int i = 0; i < 3; ++i) {
+				VertexData &v = verts[t][i];
+				v.screenpos = ScreenCoords(rand() % (BUF_STRIDE * 16), rand() % (BUF_HEIGHT * 16), flatZ ? flatDepth : (u16)randBits(16));
+				v.color0 = Vec4<int>(randBits(8), randBits(8), randBits(8), randBits(8));
+				v.color1 = Vec3<int>(randBits(8), randBits(8), randBits(8));
+				v.fogdepth = 1.0f;
+				v.clippos.w = 1.0f;
+			}
+			// Only counter-clockwise triangles are drawn.
+			if (!Rasterizer::GetTriangleRange(verts[t][0], verts[t][1], verts[t][2], ranges[t]))
+				std::swap(verts[t][1], verts[t][2]);
+			drawable[t] = Rasterizer::GetTriangleRange(verts[t][0], verts[t][1], verts[t][2], ranges[t]);
+		}
+
+		Rasterizer::RasterizerState early;
+		Rasterizer::ComputeRasterizerState(&early);
+		if (early.earlyDepthRange || early.earlyDepthTest != GE_COMP_ALWAYS)
+			++earlyStates;
+		Rasterizer::RasterizerState late = early;
+		late.earlyDepthRange = false;
+		late.earlyDepthTest = GE_COMP_ALWAYS;
+
+		colorEarly = colorInit;
+		depthEarly = depthInit;
+		fb.data = colorEarly.data();
+		depthbuf.data = depthEarly.data();
+		for (int t = 0; t < TRIANGLES_PER_STATE; ++t) {
+			if (drawable[t])
+				Rasterizer::DrawTriangle(verts[t][0], verts[t][1], verts[t][2], ranges[t], ranges[t], early);
+		}
+
+		colorLate = colorInit;
+		depthLate = depthInit;
+		fb.data = colorLate.data();
+		depthbuf.data = depthLate.data();
+		for (int t = 0; t < TRIANGLES_PER_STATE; ++t) {
+			if (drawable[t])
+				Rasterizer::DrawTriangle(verts[t][0], verts[t][1], verts[t][2], ranges[t], ranges[t], late);
+		}
+
+		if (colorEarly != colorLate || depthEarly != depthLate) {
+			printf("Early depth test mismatch at state %d: through=%d ztest=%d/%d range=%04x-%04x zmsk=%d stencil=%d\n", state, gstate.isModeThrough() ? 1 : 0, gstate.zTestEnable & 1, gstate.ztestfunc & 7, gstate.minz & 0xFFFF, gstate.maxz & 0xFFFF, gstate.zmsk & 1, gstate.stencilTestEnable & 1);
+			success = false;
+		}
+	}
+	fb.data = nullptr;
+	depthbuf.data = nullptr;
+
+	printf("Early depth test: compared %d states, %d of them with early tests\n", STATES, earlyStates);
+
+	Rasterizer::Shutdown();
+	Sampler::Shutdown();
+	return success;
+}
+
+// Draws a lit mesh through the software transform both indexed and expanded, so the transformed
+// vertex cache is used for one and not the other.  Both must draw exactly the same pixels.
+bool TestSoftwareTransform() {
+	const int GRID = 9;
+	// Unused vertices at the start, so the index lower bound isn't zero.
+	const int SKIPPED_VERTS = 5;
+	const int INDEX_COUNT = (GRID - 1) * (GRID - 1) * 6;
+	const int BUF_STRIDE = 64;
+	const int BUF_HEIGHT = 64;
+
+	Sampler::Init();
+	Rasterizer::Init();
+	SoftwareDrawEngine *drawEngine = new SoftwareDrawEngine();
+	drawEngine->Init();
+
+	u32 seed = 0x7654321;
+	auto randFloat = [&](float minValue, float maxValue) {
+		seed = seed * 1103515245 + 12345;
+		return minValue + (maxValue - minValue) * (float)(seed >> 8) / (float)0xFFFFFF;
+	};
+
+	memset(&gstate, 0, sizeof(gstate));
+	gstate.fbwidth = BUF_STRIDE;
+	gstate.zbwidth = BUF_STRIDE;
+	gstate.framebufpixformat = GE_FORMAT_8888;
+	gstate.scissor1 = 0;
+	gstate.scissor2 = (BUF_STRIDE - 1) | ((BUF_HEIGHT - 1) << 10);
+	// Clip space -1 to 1 maps to the whole buffer.
+	gstate.viewportxscale = toFloat24((float)BUF_STRIDE / 2);
+	gstate.viewportyscale = toFloat24(-(float)BUF_HEIGHT / 2);
+	gstate.viewportzscale = toFloat24(-30000.0f);
+	gstate.viewportxcenter = toFloat24(2048.0f);
+	gstate.viewportycenter = toFloat24(2048.0f);
+	gstate.viewportzcenter = toFloat24(32768.0f);
+	gstate.offsetx = (2048 - BUF_STRIDE / 2) * 16;
+	gstate.offsety = (2048 - BUF_HEIGHT / 2) * 16;
+	gstate.shademodel = GE_SHADE_GOURAUD;
+	gstate.zTestEnable = 1;
+	gstate.ztestfunc = GE_COMP_GEQUAL;
+	gstate.maxz = 0xFFFF;
+
+	// A slightly scaled and moved world, and a view that tilts it a little.
+	const float world[12] = { 0.9f, 0.05f, 0.0f, -0.05f, 0.9f, 0.1f, 0.0f, -0.1f, 0.9f, 0.02f, -0.03f, 0.0f };
+	const float view[12] = { 1.0f, 0.0f, 0.0f, 0.0f, 0.98f, -0.2f, 0.0f, 0.2f, 0.98f, 0.0f, 0.0f, 0.1f };
+	memcpy(gstate.worldMatrix, world, sizeof(world));
+	memcpy(gstate.viewMatrix, view, sizeof(view));
+	for (int i = 0; i < 4; ++i)
+		gstate.projMatrix[i * 5] = 1.0f;
+
+	gstate.lightingEnable = 1;
+	gstate.materialupdate = 2;
+	gstate.materialambient = 0x404040;
+	gstate.materialalpha = 0xFF;
+	gstate.materialspecular = 0x808080;
+	gstate.materialspecularcoef = toFloat24(4.0f);
+	gstate.ambientcolor = 0x202020;
+	gstate.ambientalpha = 0xFF;
+	// A directional diffuse light and a point light with specular.
+	gstate.lightEnable[0] = 1;
+	gstate.ltype[0] = (GE_LIGHTTYPE_DIRECTIONAL << 8) | GE_LIGHTCOMP_ONLYDIFFUSE;
+	gstate.lpos[0] = toFloat24(0.3f);
+	gstate.lpos[1] = toFloat24(0.4f);
+	gstate.lpos[2] = toFloat24(0.866f);
+	gstate.lcolor[1] = 0xC0E0FF;
+	gstate.lightEnable[1] = 1;
+	gstate.ltype[1] = (GE_LIGHTTYPE_POINT << 8) | GE_LIGHTCOMP_BOTH;
+	gstate.lpos[3] = toFloat24(-0.5f);
+	gstate.lpos[4] = toFloat24(0.5f);
+	gstate.lpos[5] = toFloat24(1.0f);
+	gstate.latt[3] = toFloat24(0.5f);
+	gstate.latt[4] = toFloat24(0.5f);
+	gstate.lcolor[4] = 0x8080FF;
+	gstate.lcolor[5] = 0xFFFFFF;
+
+	struct MeshVertex {
+		u32 color;
+		float nrm[3];
+		float pos[3];
+	};
+	std::vector<MeshVertex> verts(SKIPPED_VERTS + GRID * GRID);
+	for (int y = 0; y < GRID; ++y) {
+		for (int x = 0; x < GRID; ++x) {
+			MeshVertex &v = verts[SKIPPED_VERTS + y * GRID + x];
+			v.color = 0xFF000000 | (((x * 29) & 0xFF) << 16) | (((y * 31) & 0xFF) << 8) | ((x * y * 3) & 0xFF);
+			v.nrm[0] = randFloat(-0.5f, 0.5f);
+			v.nrm[1] = randFloat(-0.5f, 0.5f);
+			v.nrm[2] = 1.0f;
+			v.pos[0] = -0.9f + 1.8f * x / (GRID - 1);
+			v.pos[1] = -0.9f + 1.8f * y / (GRID - 1);
+			v.pos[2] = randFloat(-0.5f, 0.5f);
+		}
+	}
+	// Way off screen, so the triangles using this vertex get culled wherever it's referenced.
+	verts[SKIPPED_VERTS + GRID + 4].pos[0] = 100.0f;
+
+	std::vector<u16> indices;
+	for (int y = 0; y < GRID - 1; ++y) {
+		for (int x = 0; x < GRID - 1; ++x) {
+			u16 i = (u16)(SKIPPED_VERTS + y * GRID + x);
+			const u16 quad[6] = { i, (u16)(i + 1), (u16)(i + GRID), (u16)(i + GRID), (u16)(i + 1), (u16)(i + GRID + 1) };
+			indices.insert(indices.end(), quad, quad + 6);
+		}
+	}
+	std::vector<MeshVertex> expanded;
+	for (u16 index : indices)
+		expanded.push_back(verts[index]);
+
+	const size_t colorSize = BUF_STRIDE * BUF_HEIGHT * sizeof(u32);
+	const size_t depthSize = BUF_STRIDE * BUF_HEIGHT * sizeof(u16);
+	std::vector<u8> colorIndexed(colorSize), colorExpanded(colorSize);
+	std::vector<u8> depthIndexed(depthSize), depthExpanded(depthSize);
+
+	const u32 vertType = GE_VTYPE_COL_8888 | GE_VTYPE_NRM_FLOAT | GE_VTYPE_POS_FLOAT;
+	TransformUnit &transformUnit = drawEngine->transformUnit;
+
+	// Two draws sharing vertices with different index ranges, so the cache has to start over.
+	fb.data = colorIndexed.data();
+	depthbuf.data = depthIndexed.data();
+	gstate.vertType = vertType | GE_VTYPE_IDX_16BIT;
+	transformUnit.SubmitPrimitive(verts.data(), indices.data(), GE_PRIM_TRIANGLES, INDEX_COUNT / 2, gstate.vertType, nullptr, drawEngine);
+	transformUnit.SubmitPrimitive(verts.data(), indices.data() + INDEX_COUNT / 2, GE_PRIM_TRIANGLES, INDEX_COUNT / 2, gstate.vertType, nullptr, drawEngine);
+	transformUnit.Flush();
+
+	fb.data = colorExpanded.data();
+	depthbuf.data = depthExpanded.data();
+	gstate.vertType = vertType;
+	transformUnit.SubmitPrimitive(expanded.data(), nullptr, GE_PRIM_TRIANGLES, INDEX_COUNT, gstate.vertType, nullptr, drawEngine);
+	transformUnit.Flush();
+
+	fb.data = nullptr;
+	depthbuf.data = nullptr;
+
+	int drawnPixels = 0;
+	for (size_t i = 0; i < depthSize / sizeof(u16); ++i) {
+		if (((const u16 *)depthExpanded.data())[i] != 0)
+			++drawnPixels;
+	}
+
+	delete drawEngine;
+	Rasterizer::Shutdown();
+	Sampler::Shutdown();
+
+	// The mesh covers a good part of the buffer, but not the edges or around the culled vertex.
+	EXPECT_TRUE(drawnPixels > BUF_STRIDE * BUF_HEIGHT / 4);
+	EXPECT_TRUE(drawnPixels < BUF_STRIDE * BUF_HEIGHT);
+	EXPECT_TRUE(colorIndexed == colorExpanded);
+	EXPECT_TRUE(depthIndexed == depthExpanded);
+	return true;
+}
+
 bool TestCLZ() {
 	static const uint32_t input[] = {
 		0xFFFFFFFF,
@@ -740,6 +1190,8 @@ static bool TestWrapText() {
 	return true;
 }
 
+bool g_benchmarkTests = false;
+
 typedef bool (*TestFunc)();
 struct TestItem {
 	const char *name;
@@ -753,6 +1205,9 @@ bool TestArm64Emitter();
 bool TestX64Emitter();
 bool TestShaderGenerators();
 bool TestThreadManager();
+bool TestIRPassSimplify();
+bool TestTextureKernels();
+bool TestPixelJit();
 
 TestItem availableTests[] = {
 #if PPSSPP_ARCH(ARM64) || PPSSPP_ARCH(AMD64) || PPSSPP_ARCH(X86)
@@ -765,21 +1220,30 @@ TestItem availableTests[] = {
 	TEST_ITEM(X64Emitter),
 #endif
 	TEST_ITEM(VertexJit),
+	TEST_ITEM(PixelJit),
 	TEST_ITEM(Asin),
 	TEST_ITEM(SinCos),
 	TEST_ITEM(VFPUSinCos),
+	TEST_ITEM(VFPUSequentialMath),
 	TEST_ITEM(MathUtil),
 	TEST_ITEM(Parsers),
 	TEST_ITEM(Jit),
+	TEST_ITEM(SpinWaitLoop),
 	TEST_ITEM(MatrixTranspose),
 	TEST_ITEM(ParseLBN),
 	TEST_ITEM(QuickTexHash),
+	TEST_ITEM(TexCacheRanges),
+	TEST_ITEM(TessCache),
+	TEST_ITEM(EarlyDepthTest),
+	TEST_ITEM(SoftwareTransform),
 	TEST_ITEM(CLZ),
 	TEST_ITEM(MemMap),
 	TEST_ITEM(ShaderGenerators),
 	TEST_ITEM(Path),
 	TEST_ITEM(AndroidContentURI),
 	TEST_ITEM(ThreadManager),
+	TEST_ITEM(IRPassSimplify),
+	TEST_ITEM(TextureKernels),
 	TEST_ITEM(WrapText),
 };
 
@@ -792,6 +1256,11 @@ int main(int argc, const char *argv[]) {
 
 	bool allTests = false;
 	TestFunc testFunc = nullptr;
+	for (int i = 2; i < argc; ++i) {
+		if (!strcasecmp(argv[i], "--bench")) {
+			g_benchmarkTests = true;
+		}
+	}
 	if (argc >= 2) {
 		if (!strcasecmp(argv[1], "all")) {
 			allTests = true;
@@ -823,6 +1292,7 @@ int main(int argc, const char *argv[]) {
 		}
 	} else if (testFunc == nullptr) {
 		fprintf(stderr, "You may select a test to run by passing an argument.\n");
+		fprintf(stderr, "Add --bench after it to also print timings, where a test has them.\n");
 		fprintf(stderr, "\n");
 		fprintf(stderr, "Available tests:\n");
 		for (auto f : availableTests) {
@@ -9,3 +9,6 @@
 #define EXPECT_EQ_STR(a, b) if (a != b) { printf("%s: Test Fail\n%s\nvs\n%s\n", __FUNCTION__, a.c_str(), b.c_str()); return false; }
 
 #define RET(a) if (!(a)) { return false; }
+
+// Set by passing --bench after the test name, for tests that can also print timings.
+extern bool g_benchmarkTests;